@@ -0,0 +1,186 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-18 10:12:36
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-18 15:47:03
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/stmt.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/runtime/core.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    // the reduction tree is fixed by the item indices, never by the launch: a run folds
+    // RUN_ITEMS consecutive items left to right, a chunk combines CHUNK_RUNS runs
+    static constexpr uint DETERMINISTIC_RUN_ITEMS   = 8;
+    static constexpr uint DETERMINISTIC_CHUNK_RUNS  = 1024;
+    static constexpr uint DETERMINISTIC_CHUNK_ITEMS = DETERMINISTIC_RUN_ITEMS * DETERMINISTIC_CHUNK_RUNS;
+
+    /// Partials of every level above the items, chunks of chunks until one chunk is left
+    inline size_t deterministic_partial_count(size_t num_items)
+    {
+        size_t count = 0;
+        while(num_items > DETERMINISTIC_CHUNK_ITEMS)
+        {
+            num_items = ceil_div(num_items, size_t{DETERMINISTIC_CHUNK_ITEMS});
+            count += num_items;
+        }
+        return std::max<size_t>(1, count);
+    }
+
+    /// One block per chunk. Floating point results only depend on num_items and the op,
+    /// so they match bit for bit across BLOCK_SIZE, ITEMS_PER_THREAD, backends and runs.
+    /// load_op widens the InputT items to the Type accumulator as they are read.
+    template <typename Type, typename ReduceOp, size_t BLOCK_SIZE, typename InputT = Type, typename LoadOp = IdentityOp>
+    class AgentDeterministic : public LuisaModule
+    {
+      public:
+        static constexpr uint RUN_ITEMS       = DETERMINISTIC_RUN_ITEMS;
+        static constexpr uint CHUNK_RUNS      = DETERMINISTIC_CHUNK_RUNS;
+        static constexpr uint CHUNK_ITEMS     = DETERMINISTIC_CHUNK_ITEMS;
+        static constexpr uint RUNS_PER_THREAD = (CHUNK_RUNS + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        AgentDeterministic(const BufferVar<InputT>& d_in, ReduceOp reduce_op, const UInt& num_items, LoadOp load_op = LoadOp())
+            : m_in(d_in)
+            , m_reduce_op(reduce_op)
+            , m_load_op(load_op)
+            , m_num_items(num_items)
+            , m_chunk(block_id().x)
+            , m_chunk_offset(block_id().x * UInt(CHUNK_ITEMS))
+        {
+            UInt chunk_items = select(UInt(0u), min(num_items - m_chunk_offset, UInt(CHUNK_ITEMS)), m_chunk_offset < num_items);
+            m_valid_runs     = (chunk_items + UInt(RUN_ITEMS - 1)) / UInt(RUN_ITEMS);
+            m_runs           = new SmemType<Type>{CHUNK_RUNS};
+        }
+
+        /// Pairwise tree over the runs of the chunk, a missing right child passes the left one up
+        void ReduceChunk(BufferVar<Type>& d_out, const Var<Type>& init, const UInt& fold_init)
+        {
+            LoadRuns();
+            for(auto stride = 1u; stride < CHUNK_RUNS; stride *= 2u)
+            {
+                $for(left, thread_id().x * UInt(2u * stride), UInt(CHUNK_RUNS), UInt(BLOCK_SIZE * 2u * stride))
+                {
+                    $if(left + UInt(stride) < m_valid_runs)
+                    {
+                        (*m_runs)[left] = m_reduce_op((*m_runs)[left], (*m_runs)[left + UInt(stride)]);
+                    };
+                };
+                sync_block();
+            }
+
+            $if(thread_id().x == 0u)
+            {
+                Var<Type> result = (*m_runs)[0];
+                $if(fold_init != 0u)
+                {
+                    result = select(m_reduce_op(init, result), init, m_valid_runs == 0u);
+                };
+                d_out.write(m_chunk, result);
+            };
+        }
+
+        /// Inclusive scan of the chunk on top of init (first chunk) or the scanned chunk totals,
+        /// the run prefixes come from a Kogge-Stone scan indexed by run, never by thread.
+        /// store_op narrows every inclusive prefix to the OutputT written to d_out
+        template <typename OutputT, typename StoreOp = IdentityOp>
+        void ScanChunk(BufferVar<OutputT>& d_out, const BufferVar<Type>& d_prefix, const Var<Type>& init, StoreOp store_op = StoreOp())
+        {
+            LoadRuns();
+            for(auto offset = 1u; offset < CHUNK_RUNS; offset *= 2u)
+            {
+                ArrayVar<Type, RUNS_PER_THREAD> sums;
+                for(auto u = 0u; u < RUNS_PER_THREAD; ++u)
+                {
+                    UInt run = thread_id().x + UInt(u * BLOCK_SIZE);
+                    $if(run >= UInt(offset) & run < m_valid_runs)
+                    {
+                        sums[u] = m_reduce_op((*m_runs)[run - UInt(offset)], (*m_runs)[run]);
+                    };
+                }
+                sync_block();
+                for(auto u = 0u; u < RUNS_PER_THREAD; ++u)
+                {
+                    UInt run = thread_id().x + UInt(u * BLOCK_SIZE);
+                    $if(run >= UInt(offset) & run < m_valid_runs)
+                    {
+                        (*m_runs)[run] = sums[u];
+                    };
+                }
+                sync_block();
+            }
+
+            Var<Type> chunk_prefix = init;
+            $if(m_chunk > 0u)
+            {
+                chunk_prefix = d_prefix.read(m_chunk - 1u);
+            };
+
+            // every run belongs to one thread, so d_out may alias d_in
+            $for(run, thread_id().x, m_valid_runs, UInt(BLOCK_SIZE))
+            {
+                Var<Type> acc = chunk_prefix;
+                $if(run > 0u)
+                {
+                    acc = m_reduce_op(acc, (*m_runs)[run - 1u]);
+                };
+                UInt begin = m_chunk_offset + run * UInt(RUN_ITEMS);
+                for(auto u = 0u; u < RUN_ITEMS; ++u)
+                {
+                    UInt idx = begin + UInt(u);
+                    $if(idx < m_num_items)
+                    {
+                        acc = m_reduce_op(acc, m_load_op(m_in.read(idx)));
+                        d_out.write(idx, store_op(acc));
+                    };
+                }
+            };
+        }
+
+      private:
+        void LoadRuns()
+        {
+            $for(run, thread_id().x, m_valid_runs, UInt(BLOCK_SIZE))
+            {
+                UInt      begin = m_chunk_offset + run * UInt(RUN_ITEMS);
+                Var<Type> acc   = m_load_op(m_in.read(begin));
+                for(auto u = 1u; u < RUN_ITEMS; ++u)
+                {
+                    UInt idx = begin + UInt(u);
+                    $if(idx < m_num_items)
+                    {
+                        acc = m_reduce_op(acc, m_load_op(m_in.read(idx)));
+                    };
+                }
+                (*m_runs)[run] = acc;
+            };
+            sync_block();
+        }
+
+        const BufferVar<InputT>& m_in;
+        ReduceOp                 m_reduce_op;
+        LoadOp                   m_load_op;
+        UInt                     m_num_items;
+        UInt                     m_chunk;
+        UInt                     m_chunk_offset;
+        UInt                     m_valid_runs;
+        SmemTypePtr<Type>        m_runs;
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
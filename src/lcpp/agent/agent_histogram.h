@@ -0,0 +1,316 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-10 10:12:31
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-10 17:40:05
+ */
+
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/stmt.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/agent/policy.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    // bins per channel that fit in the block-privatized shared memory histogram
+    static constexpr uint MAX_PRIVATIZED_SMEM_BINS = 256;
+    // marks samples falling outside [lower, upper)
+    static constexpr uint HISTOGRAM_INVALID_BIN = ~0u;
+
+    // Even binning: bin = (sample - lower) * num_bins / (upper - lower)
+    template <NumericT SampleT>
+    struct HistogramScaleTransform
+    {
+        const Var<uint4>&              num_bins;
+        const Var<Vector<SampleT, 4>>& lower;
+        const Var<Vector<SampleT, 4>>& upper;
+
+        UInt BinIndex(const Var<SampleT>& sample, uint channel) const
+        {
+            UInt         bin  = UInt(HISTOGRAM_INVALID_BIN);
+            UInt         bins = num_bins[channel];
+            Var<SampleT> lo   = lower[channel];
+            Var<SampleT> hi   = upper[channel];
+            $if(sample >= lo & sample < hi)
+            {
+                if constexpr(std::is_floating_point_v<SampleT>)
+                {
+                    Var<SampleT> scale = cast<SampleT>(bins) / (hi - lo);
+                    bin = min(cast<uint>((sample - lo) * scale), bins - 1u);
+                }
+                else
+                {
+                    // widen to avoid overflow of (sample - lower) * num_bins
+                    bin = cast<uint>((cast<ulong>(sample - lo) * cast<ulong>(bins)) / cast<ulong>(hi - lo));
+                }
+            };
+            return bin;
+        }
+    };
+
+    // Range binning: binary search over the (sorted) per-channel levels
+    template <NumericT SampleT>
+    struct HistogramSearchTransform
+    {
+        const BufferVar<SampleT>& d_levels;
+        const Var<uint4>&         num_bins;
+        const Var<uint4>&         level_offsets;
+
+        UInt BinIndex(const Var<SampleT>& sample, uint channel) const
+        {
+            UInt bin    = UInt(HISTOGRAM_INVALID_BIN);
+            UInt bins   = num_bins[channel];
+            UInt offset = level_offsets[channel];
+            $if(sample >= d_levels.read(offset) & sample < d_levels.read(offset + bins))
+            {
+                // invariant: levels[lo] <= sample < levels[hi]
+                UInt lo = 0u;
+                UInt hi = bins;
+                $while(hi - lo > 1u)
+                {
+                    UInt mid = (lo + hi) >> 1u;
+                    $if(d_levels.read(offset + mid) <= sample)
+                    {
+                        lo = mid;
+                    }
+                    $else
+                    {
+                        hi = mid;
+                    };
+                };
+                bin = lo;
+            };
+            return bin;
+        }
+    };
+
+    template <NumericT SampleT, uint NUM_CHANNELS, uint NUM_ACTIVE_CHANNELS, bool IS_PRIVATIZED, typename AgentHistogramPolicyT, typename DecodeOpT>
+    class AgentHistogram : public LuisaModule
+    {
+        static_assert(NUM_CHANNELS >= 1 && NUM_CHANNELS <= 4, "histogram supports 1-4 channels");
+        static_assert(NUM_ACTIVE_CHANNELS >= 1 && NUM_ACTIVE_CHANNELS <= NUM_CHANNELS,
+                      "active channels must be a subset of the input channels");
+
+      public:
+        static constexpr uint BLOCK_THREADS      = AgentHistogramPolicyT::BLOCK_THREADS;
+        static constexpr uint PIXELS_PER_THREAD  = AgentHistogramPolicyT::PIXELS_PER_THREAD;
+        static constexpr uint TILE_PIXELS        = BLOCK_THREADS * PIXELS_PER_THREAD;
+        static constexpr uint SAMPLES_PER_THREAD = PIXELS_PER_THREAD * NUM_CHANNELS;
+        static constexpr bool IS_RLE_COMPRESS    = AgentHistogramPolicyT::IS_RLE_COMPRESS;
+        static constexpr bool IS_WORK_STEALING   = AgentHistogramPolicyT::IS_WORK_STEALING;
+
+        AgentHistogram(const BufferVar<SampleT>& samples_in,
+                       BufferVar<uint>&          histogram_out,
+                       BufferVar<uint>&          tile_queue,
+                       UInt                      num_pixels,
+                       const Var<uint4>&         num_bins,
+                       const Var<uint4>&         bin_offsets,
+                       const DecodeOpT&          decode_op)
+            : d_samples_in(samples_in)
+            , d_histogram_out(histogram_out)
+            , d_tile_queue(tile_queue)
+            , num_pixels(num_pixels)
+            , num_bins(num_bins)
+            , bin_offsets(bin_offsets)
+            , decode_op(decode_op)
+        {
+            if constexpr(IS_PRIVATIZED)
+            {
+                m_shared_bins = new SmemType<uint>{NUM_ACTIVE_CHANNELS * MAX_PRIVATIZED_SMEM_BINS};
+            }
+            if constexpr(IS_WORK_STEALING)
+            {
+                m_shared_tile = new SmemType<uint>{1};
+            }
+        }
+
+        void InitBinCounters()
+        {
+            if constexpr(IS_PRIVATIZED)
+            {
+                $for(bin, thread_id().x, UInt(NUM_ACTIVE_CHANNELS * MAX_PRIVATIZED_SMEM_BINS), UInt(BLOCK_THREADS))
+                {
+                    m_shared_bins->write(bin, 0u);
+                };
+                sync_block();
+            }
+        }
+
+        void StoreOutput()
+        {
+            if constexpr(IS_PRIVATIZED)
+            {
+                sync_block();
+                for(auto channel = 0u; channel < NUM_ACTIVE_CHANNELS; ++channel)
+                {
+                    $for(bin, thread_id().x, num_bins[channel], UInt(BLOCK_THREADS))
+                    {
+                        UInt count = m_shared_bins->read(channel * MAX_PRIVATIZED_SMEM_BINS + bin);
+                        $if(count > 0u)
+                        {
+                            d_histogram_out.atomic(bin_offsets[channel] + bin).fetch_add(count);
+                        };
+                    };
+                }
+            }
+        }
+
+        void AccumulateBin(uint channel, const UInt& bin, const UInt& count)
+        {
+            $if(bin != UInt(HISTOGRAM_INVALID_BIN))
+            {
+                if constexpr(IS_PRIVATIZED)
+                {
+                    m_shared_bins->atomic(channel * MAX_PRIVATIZED_SMEM_BINS + bin).fetch_add(count);
+                }
+                else
+                {
+                    d_histogram_out.atomic(bin_offsets[channel] + bin).fetch_add(count);
+                }
+            };
+        }
+
+        void LoadTile(UInt tile_offset, UInt valid_pixels, ArrayVar<SampleT, SAMPLES_PER_THREAD>& samples)
+        {
+            // blocked arrangement: each thread owns PIXELS_PER_THREAD consecutive pixels so that
+            // runs of equal samples stay within one thread for the RLE pass
+            UInt thread_pixel = thread_id().x * UInt(PIXELS_PER_THREAD);
+            UInt sample_base  = (tile_offset + thread_pixel) * UInt(NUM_CHANNELS);
+            $if(valid_pixels == UInt(TILE_PIXELS))
+            {
+                for(auto i = 0u; i < SAMPLES_PER_THREAD; ++i)
+                {
+                    samples[i] = d_samples_in.read(sample_base + i);
+                }
+            }
+            $else
+            {
+                for(auto i = 0u; i < SAMPLES_PER_THREAD; ++i)
+                {
+                    $if(thread_pixel + UInt(i / NUM_CHANNELS) < valid_pixels)
+                    {
+                        samples[i] = d_samples_in.read(sample_base + i);
+                    };
+                }
+            };
+        }
+
+        void AccumulatePixels(UInt valid_pixels, const ArrayVar<SampleT, SAMPLES_PER_THREAD>& samples)
+        {
+            UInt thread_pixel = thread_id().x * UInt(PIXELS_PER_THREAD);
+            for(auto channel = 0u; channel < NUM_ACTIVE_CHANNELS; ++channel)
+            {
+                ArrayVar<uint, PIXELS_PER_THREAD> bins;
+                for(auto pixel = 0u; pixel < PIXELS_PER_THREAD; ++pixel)
+                {
+                    bins[pixel] = UInt(HISTOGRAM_INVALID_BIN);
+                    $if(thread_pixel + UInt(pixel) < valid_pixels)
+                    {
+                        bins[pixel] = decode_op.BinIndex(samples[pixel * NUM_CHANNELS + channel], channel);
+                    };
+                }
+
+                if constexpr(IS_RLE_COMPRESS)
+                {
+                    // accumulate each run of equal bins with a single atomic
+                    UInt run_bin   = bins[0];
+                    UInt run_count = 1u;
+                    for(auto pixel = 1u; pixel < PIXELS_PER_THREAD; ++pixel)
+                    {
+                        $if(bins[pixel] == run_bin)
+                        {
+                            run_count += 1u;
+                        }
+                        $else
+                        {
+                            AccumulateBin(channel, run_bin, run_count);
+                            run_bin   = bins[pixel];
+                            run_count = 1u;
+                        };
+                    }
+                    AccumulateBin(channel, run_bin, run_count);
+                }
+                else
+                {
+                    for(auto pixel = 0u; pixel < PIXELS_PER_THREAD; ++pixel)
+                    {
+                        AccumulateBin(channel, bins[pixel], UInt(1u));
+                    }
+                }
+            }
+        }
+
+        void ConsumeTile(UInt tile_idx)
+        {
+            UInt tile_offset  = tile_idx * UInt(TILE_PIXELS);
+            UInt valid_pixels = min(num_pixels - tile_offset, UInt(TILE_PIXELS));
+
+            ArrayVar<SampleT, SAMPLES_PER_THREAD> samples;
+            LoadTile(tile_offset, valid_pixels, samples);
+            AccumulatePixels(valid_pixels, samples);
+        }
+
+        void ConsumeTiles(UInt num_tiles)
+        {
+            UInt grid_size = dispatch_size().x / UInt(BLOCK_THREADS);
+            if constexpr(IS_WORK_STEALING)
+            {
+                // the first grid_size tiles are statically assigned, the rest are dequeued
+                UInt tile_idx = block_id().x;
+                $while(tile_idx < num_tiles)
+                {
+                    ConsumeTile(tile_idx);
+                    sync_block();
+                    $if(thread_id().x == 0u)
+                    {
+                        m_shared_tile->write(0u, d_tile_queue.atomic(0u).fetch_add(1u) + grid_size);
+                    };
+                    sync_block();
+                    tile_idx = m_shared_tile->read(0u);
+                };
+            }
+            else
+            {
+                $for(tile_idx, block_id().x, num_tiles, grid_size)
+                {
+                    ConsumeTile(tile_idx);
+                };
+            }
+        }
+
+        void Process(UInt num_tiles)
+        {
+            InitBinCounters();
+            ConsumeTiles(num_tiles);
+            StoreOutput();
+        }
+
+      private:
+        SmemTypePtr<uint> m_shared_bins = nullptr;
+        SmemTypePtr<uint> m_shared_tile = nullptr;
+
+        const BufferVar<SampleT>& d_samples_in;
+        BufferVar<uint>&          d_histogram_out;
+        BufferVar<uint>&          d_tile_queue;
+
+        UInt              num_pixels;
+        const Var<uint4>& num_bins;
+        const Var<uint4>& bin_offsets;
+        const DecodeOpT&  decode_op;
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
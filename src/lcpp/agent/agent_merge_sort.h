@@ -0,0 +1,289 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-15 11:20:37
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-15 16:40:02
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/stmt.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/block/block_merge_sort.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    // Keys are arbitrary structs ordered only by compare_op, so loads and stores here never
+    // synthesize a default key: out of range slots are left untouched and masked by counts.
+
+    /// Sorts every tile of keys_in into keys_out with BlockMergeSort
+    template <typename KeyType, typename ValueType, bool KEY_ONLY, typename CompareOpT, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD>
+    class AgentBlockSort : public LuisaModule
+    {
+      public:
+        static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+        AgentBlockSort(const BufferVar<KeyType>&   keys_in,
+                       BufferVar<KeyType>&         keys_out,
+                       const BufferVar<ValueType>& values_in,
+                       BufferVar<ValueType>&       values_out,
+                       const CompareOpT&           compare_op,
+                       UInt                        num_items)
+            : d_keys_in(keys_in)
+            , d_keys_out(keys_out)
+            , d_values_in(values_in)
+            , d_values_out(values_out)
+            , m_compare_op(compare_op)
+            , m_num_items(num_items)
+        {
+        }
+
+        void ConsumeTile()
+        {
+            UInt tile_start     = block_id().x * UInt(TILE_ITEMS);
+            UInt num_tile_items = min(m_num_items - tile_start, UInt(TILE_ITEMS));
+            UInt item_offset    = thread_id().x * UInt(ITEMS_PER_THREAD);
+
+            ArrayVar<KeyType, ITEMS_PER_THREAD>   keys;
+            ArrayVar<ValueType, ITEMS_PER_THREAD> values;
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                $if(item_offset + i < num_tile_items)
+                {
+                    keys[i] = d_keys_in.read(tile_start + item_offset + i);
+                    if constexpr(!KEY_ONLY)
+                    {
+                        values[i] = d_values_in.read(tile_start + item_offset + i);
+                    }
+                };
+            }
+
+            if constexpr(KEY_ONLY)
+            {
+                BlockMergeSort<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>().Sort(keys, m_compare_op, num_tile_items);
+            }
+            else
+            {
+                BlockMergeSort<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>().Sort(keys, values, m_compare_op, num_tile_items);
+            }
+
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                $if(item_offset + i < num_tile_items)
+                {
+                    d_keys_out.write(tile_start + item_offset + i, keys[i]);
+                    if constexpr(!KEY_ONLY)
+                    {
+                        d_values_out.write(tile_start + item_offset + i, values[i]);
+                    }
+                };
+            }
+        }
+
+      private:
+        const BufferVar<KeyType>&   d_keys_in;
+        BufferVar<KeyType>&         d_keys_out;
+        const BufferVar<ValueType>& d_values_in;
+        BufferVar<ValueType>&       d_values_out;
+        const CompareOpT&           m_compare_op;
+        UInt                        m_num_items;
+    };
+
+    /// One thread per tile boundary: finds where the merge of the two sorted runs of its tile
+    /// group crosses the tile boundary, so every merge tile knows its input ranges up front
+    template <typename KeyType, typename CompareOpT, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD>
+    class AgentMergePartition : public LuisaModule
+    {
+      public:
+        static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+        AgentMergePartition(const BufferVar<KeyType>& keys, const CompareOpT& compare_op, UInt num_items, UInt target_merged_tiles)
+            : d_keys(keys)
+            , m_compare_op(compare_op)
+            , m_num_items(num_items)
+            , m_target_merged_tiles(target_merged_tiles)
+        {
+        }
+
+        void Partition(BufferVar<uint>& d_merge_partitions, const UInt& num_partitions)
+        {
+            UInt partition_idx = dispatch_id().x;
+            $if(partition_idx < num_partitions)
+            {
+                UInt mask           = m_target_merged_tiles - 1u;
+                UInt local_tile_idx = partition_idx & mask;
+                UInt start          = UInt(TILE_ITEMS) * (partition_idx - local_tile_idx);
+                UInt size           = UInt(TILE_ITEMS) * (m_target_merged_tiles >> 1u);
+
+                UInt keys1_beg    = min(m_num_items, start);
+                UInt keys1_end    = min(m_num_items, start + size);
+                UInt keys2_beg    = keys1_end;
+                UInt keys2_end    = min(m_num_items, keys2_beg + size);
+                UInt partition_at = min(keys2_end - keys1_beg, UInt(TILE_ITEMS) * local_tile_idx);
+
+                UInt partition_diag = MergePath([&](const UInt& i) { return d_keys.read(keys1_beg + i); },
+                                                [&](const UInt& i) { return d_keys.read(keys2_beg + i); },
+                                                keys1_end - keys1_beg,
+                                                keys2_end - keys2_beg,
+                                                partition_at,
+                                                m_compare_op);
+                d_merge_partitions.write(partition_idx, keys1_beg + partition_diag);
+            };
+        }
+
+      private:
+        const BufferVar<KeyType>& d_keys;
+        const CompareOpT&         m_compare_op;
+        UInt                      m_num_items;
+        UInt                      m_target_merged_tiles;
+    };
+
+    /// Merges one output tile of two sorted runs of target_merged_tiles / 2 tiles each
+    template <typename KeyType, typename ValueType, bool KEY_ONLY, typename CompareOpT, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD>
+    class AgentMerge : public LuisaModule
+    {
+      public:
+        static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+        AgentMerge(const BufferVar<KeyType>&   keys_in,
+                   BufferVar<KeyType>&         keys_out,
+                   const BufferVar<ValueType>& values_in,
+                   BufferVar<ValueType>&       values_out,
+                   const BufferVar<uint>&      merge_partitions,
+                   const CompareOpT&           compare_op,
+                   UInt                        num_items,
+                   UInt                        target_merged_tiles)
+            : d_keys_in(keys_in)
+            , d_keys_out(keys_out)
+            , d_values_in(values_in)
+            , d_values_out(values_out)
+            , d_merge_partitions(merge_partitions)
+            , m_compare_op(compare_op)
+            , m_num_items(num_items)
+            , m_target_merged_tiles(target_merged_tiles)
+        {
+        }
+
+        void ConsumeTile()
+        {
+            UInt tile_idx       = block_id().x;
+            UInt thid           = thread_id().x;
+            UInt tile_base      = tile_idx * UInt(TILE_ITEMS);
+            UInt num_tile_items = min(m_num_items - tile_base, UInt(TILE_ITEMS));
+
+            UInt partition_beg = d_merge_partitions.read(tile_idx);
+            UInt partition_end = d_merge_partitions.read(tile_idx + 1u);
+
+            UInt mask  = m_target_merged_tiles - 1u;
+            UInt start = UInt(TILE_ITEMS) * (tile_idx - (tile_idx & mask));
+            UInt size  = UInt(TILE_ITEMS) * (m_target_merged_tiles >> 1u);
+            UInt diag  = tile_base - start;
+
+            // keys taken from the first run so far decide where the second run resumes
+            UInt keys1_beg = partition_beg;
+            UInt keys1_end = partition_end;
+            UInt keys2_beg = min(m_num_items, 2u * start + size + diag - partition_beg);
+            UInt keys2_end = min(m_num_items, 2u * start + size + diag + UInt(TILE_ITEMS) - partition_end);
+            // the last tile of a group drains both runs
+            $if((tile_idx & mask) == mask)
+            {
+                keys1_end = min(m_num_items, start + size);
+                keys2_end = min(m_num_items, start + 2u * size);
+            };
+            UInt num_keys1 = keys1_end - keys1_beg;
+            UInt num_keys2 = keys2_end - keys2_beg;
+
+            BlockMergeSort<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD> block_merge;
+            SmemTypePtr<KeyType> s_keys = block_merge.shared_keys();
+            LoadToShared(d_keys_in, s_keys, keys1_beg, keys2_beg, num_keys1, num_keys2);
+            sync_block();
+
+            UInt diag0_loc     = min(num_keys1 + num_keys2, UInt(ITEMS_PER_THREAD) * thid);
+            UInt keys1_beg_loc = MergePath([&](const UInt& i) -> Var<KeyType> { return (*s_keys)[i]; },
+                                           [&](const UInt& i) -> Var<KeyType> { return (*s_keys)[num_keys1 + i]; },
+                                           num_keys1,
+                                           num_keys2,
+                                           diag0_loc,
+                                           m_compare_op);
+            UInt keys2_beg_loc = diag0_loc - keys1_beg_loc;
+
+            ArrayVar<KeyType, ITEMS_PER_THREAD> keys;
+            ArrayVar<uint, ITEMS_PER_THREAD>    indices;
+            block_merge.SerialMerge(keys1_beg_loc,
+                                    keys2_beg_loc + num_keys1,
+                                    num_keys1 - keys1_beg_loc,
+                                    num_keys2 - keys2_beg_loc,
+                                    keys,
+                                    indices,
+                                    m_compare_op);
+
+            UInt item_offset = thid * UInt(ITEMS_PER_THREAD);
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                $if(item_offset + i < num_tile_items)
+                {
+                    d_keys_out.write(tile_base + item_offset + i, keys[i]);
+                };
+            }
+
+            if constexpr(!KEY_ONLY)
+            {
+                SmemTypePtr<ValueType> s_values = new SmemType<ValueType>{TILE_ITEMS};
+                LoadToShared(d_values_in, s_values, keys1_beg, keys2_beg, num_keys1, num_keys2);
+                sync_block();
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    $if(item_offset + i < num_tile_items)
+                    {
+                        d_values_out.write(tile_base + item_offset + i, (*s_values)[indices[i]]);
+                    };
+                }
+            }
+        }
+
+      private:
+        // striped loads of [in1 | in2] into shared memory
+        template <typename T>
+        void LoadToShared(const BufferVar<T>& d_in,
+                          SmemTypePtr<T>      s_out,
+                          const UInt&         keys1_beg,
+                          const UInt&         keys2_beg,
+                          const UInt&         num_keys1,
+                          const UInt&         num_keys2)
+        {
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                UInt idx = UInt(i * BLOCK_SIZE) + thread_id().x;
+                $if(idx < num_keys1)
+                {
+                    (*s_out)[idx] = d_in.read(keys1_beg + idx);
+                }
+                $elif(idx < num_keys1 + num_keys2)
+                {
+                    (*s_out)[idx] = d_in.read(keys2_beg + idx - num_keys1);
+                };
+            }
+        }
+
+        const BufferVar<KeyType>&   d_keys_in;
+        BufferVar<KeyType>&         d_keys_out;
+        const BufferVar<ValueType>& d_values_in;
+        BufferVar<ValueType>&       d_values_out;
+        const BufferVar<uint>&      d_merge_partitions;
+        const CompareOpT&           m_compare_op;
+        UInt                        m_num_items;
+        UInt                        m_target_merged_tiles;
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,262 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-17 09:48:22
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-17 14:25:51
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/stmt.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/agent/radix_rank_sort_operations.h>
+#include <lcpp/agent/agent_radix_sort_histogram.h>
+#include <lcpp/block/block_scan.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    // slots of the select state buffer
+    enum RadixSelectState : uint
+    {
+        SELECT_REMAINING_K = 0,  // winners still to take among the keys equal to the current prefix
+        SELECT_NUM_LESS    = 1,  // compaction counter of the keys ahead of the k-th key
+        SELECT_NUM_EQUAL   = 2,  // compaction counter of the keys equal to the k-th key
+        SELECT_STATE_SIZE,
+    };
+
+    /// Radix select: finds the k-th key digit by digit from the most significant end.
+    /// Every pass counts the digits of the keys that still share the decided prefix and
+    /// moves into the bin holding the k-th key, the last step compacts the winners.
+    /// Keys are mapped so the k winners are always the k smallest bit ordered keys.
+    template <NumericT KeyType, typename ValueType, bool KEYS_ONLY, bool SELECT_MAX, size_t RADIX_BITS, size_t BLOCK_SIZE, size_t WARP_SIZE, size_t ITEMS_PER_THREAD>
+    class AgentRadixSelect : public LuisaModule
+    {
+      public:
+        static constexpr uint TILE_ITEMS      = BLOCK_SIZE * ITEMS_PER_THREAD;
+        static constexpr uint RADIX_DIGITS    = 1 << RADIX_BITS;
+        static constexpr uint BINS_PER_THREAD = (RADIX_DIGITS + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        using HistogramPolicy = AgentRadixSortHistogramPolicy<BLOCK_SIZE, ITEMS_PER_THREAD, 1u, KeyType, RADIX_BITS>;
+        static constexpr uint NUM_PARTS = HistogramPolicy::NUM_PARTS;
+
+        using traits            = radix::traits_t<KeyType>;
+        using bit_ordered_type  = typename traits::bit_ordered_type;
+        using digit_extractor_t = typename traits::template digit_extractor_t<ShiftDigitExtractor<KeyType>>;
+        using Twiddle           = RadixSortTwiddle<false, KeyType>;
+
+        static constexpr uint KEY_BITS = sizeof(bit_ordered_type) * 8;
+
+        AgentRadixSelect(const ByteBufferVar& keys_in, UInt num_items)
+            : d_keys_in(keys_in)
+            , m_num_items(num_items)
+        {
+        }
+
+        /// Digit histogram of [current_bit, current_bit + num_bits) over the keys matching the decided prefix
+        void Histogram(BufferVar<uint>& d_bins, const ByteBufferVar& d_prefix, const UInt& current_bit, const UInt& num_bits)
+        {
+            SmemTypePtr<uint> s_bins = new SmemType<uint>{RADIX_DIGITS * NUM_PARTS};
+            $for(bin, thread_id().x, UInt(RADIX_DIGITS * NUM_PARTS), UInt(BLOCK_SIZE))
+            {
+                (*s_bins)[bin] = 0u;
+            };
+            sync_block();
+
+            Var<bit_ordered_type> prefix       = d_prefix.read<bit_ordered_type>(0u);
+            Var<bit_ordered_type> decided_mask = DecidedMask(current_bit + num_bits);
+            digit_extractor_t     digit_extractor(current_bit, num_bits);
+
+            // spread lanes over NUM_PARTS copies to ease contention on the hot bins
+            UInt part       = warp_lane_id() % UInt(NUM_PARTS);
+            UInt num_blocks = dispatch_size().x / UInt(BLOCK_SIZE);
+            $for(tile_offset, block_id().x * UInt(TILE_ITEMS), m_num_items, UInt(TILE_ITEMS) * num_blocks)
+            {
+                for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+                {
+                    UInt idx = tile_offset + UInt(u * BLOCK_SIZE) + thread_id().x;
+                    $if(idx < m_num_items)
+                    {
+                        Var<bit_ordered_type> key = OrderedKey(idx);
+                        $if((key & decided_mask) == prefix)
+                        {
+                            s_bins->atomic(digit_extractor.Digit(key) * UInt(NUM_PARTS) + part).fetch_add(1u);
+                        };
+                    };
+                }
+            };
+            sync_block();
+
+            $for(bin, thread_id().x, UInt(RADIX_DIGITS), UInt(BLOCK_SIZE))
+            {
+                UInt count = 0u;
+                for(auto p = 0u; p < NUM_PARTS; ++p)
+                {
+                    count += (*s_bins)[bin * UInt(NUM_PARTS) + UInt(p)];
+                }
+                $if(count > 0u)
+                {
+                    d_bins.atomic(bin).fetch_add(count);
+                };
+            };
+        }
+
+        /// One block: moves the prefix into the bin that holds the k-th key
+        static void SelectDigit(const BufferVar<uint>& d_bins, BufferVar<uint>& d_state, ByteBufferVar& d_prefix, const UInt& current_bit)
+        {
+            UInt remaining_k = d_state.read(UInt(SELECT_REMAINING_K));
+
+            ArrayVar<uint, BINS_PER_THREAD> counts;
+            ArrayVar<uint, BINS_PER_THREAD> exclusive_counts;
+            for(auto u = 0u; u < BINS_PER_THREAD; ++u)
+            {
+                UInt bin  = thread_id().x * UInt(BINS_PER_THREAD) + UInt(u);
+                counts[u] = 0u;
+                $if(bin < UInt(RADIX_DIGITS))
+                {
+                    counts[u] = d_bins.read(bin);
+                };
+            }
+            BlockScan<uint, BLOCK_SIZE, BINS_PER_THREAD, WARP_SIZE>().ExclusiveSum(counts, exclusive_counts);
+
+            // exactly one bin covers the remaining_k-th candidate
+            for(auto u = 0u; u < BINS_PER_THREAD; ++u)
+            {
+                UInt bin = thread_id().x * UInt(BINS_PER_THREAD) + UInt(u);
+                $if(bin < UInt(RADIX_DIGITS) & exclusive_counts[u] < remaining_k
+                    & remaining_k <= exclusive_counts[u] + counts[u])
+                {
+                    d_state.write(UInt(SELECT_REMAINING_K), remaining_k - exclusive_counts[u]);
+                    Var<bit_ordered_type> prefix = d_prefix.read<bit_ordered_type>(0u);
+                    d_prefix.write(0u, prefix | (cast<bit_ordered_type>(bin) << cast<bit_ordered_type>(current_bit)));
+                };
+            }
+        }
+
+        /// Writes every key ahead of the k-th key and the first remaining_k keys equal to it,
+        /// each block reserves its output range with one atomic per tile
+        void Compact(const BufferVar<ValueType>& d_values_in,
+                     ByteBufferVar&              d_keys_out,
+                     BufferVar<ValueType>&       d_values_out,
+                     BufferVar<uint>&            d_state,
+                     const ByteBufferVar&        d_prefix,
+                     const UInt&                 k)
+        {
+            Var<bit_ordered_type> kth_key     = d_prefix.read<bit_ordered_type>(0u);
+            UInt                  remaining_k = d_state.read(UInt(SELECT_REMAINING_K));
+            UInt                  num_less    = k - remaining_k;
+
+            SmemTypePtr<uint> s_tile_base = new SmemType<uint>{2};
+
+            UInt num_blocks = dispatch_size().x / UInt(BLOCK_SIZE);
+            $for(tile_offset, block_id().x * UInt(TILE_ITEMS), m_num_items, UInt(TILE_ITEMS) * num_blocks)
+            {
+                ArrayVar<uint, ITEMS_PER_THREAD> less_flags;
+                ArrayVar<uint, ITEMS_PER_THREAD> equal_flags;
+                for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+                {
+                    UInt idx       = tile_offset + UInt(u * BLOCK_SIZE) + thread_id().x;
+                    less_flags[u]  = 0u;
+                    equal_flags[u] = 0u;
+                    $if(idx < m_num_items)
+                    {
+                        Var<bit_ordered_type> key = OrderedKey(idx);
+                        less_flags[u]             = cast<uint>(key < kth_key);
+                        equal_flags[u]            = cast<uint>(key == kth_key);
+                    };
+                }
+
+                ArrayVar<uint, ITEMS_PER_THREAD> less_ranks;
+                ArrayVar<uint, ITEMS_PER_THREAD> equal_ranks;
+                UInt                             num_tile_less;
+                UInt                             num_tile_equal;
+                BlockScan<uint, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE>().ExclusiveSum(less_flags, less_ranks, num_tile_less);
+                BlockScan<uint, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE>().ExclusiveSum(equal_flags, equal_ranks, num_tile_equal);
+
+                $if(thread_id().x == 0u)
+                {
+                    $if(num_tile_less > 0u)
+                    {
+                        (*s_tile_base)[0] = d_state.atomic(UInt(SELECT_NUM_LESS)).fetch_add(num_tile_less);
+                    };
+                    $if(num_tile_equal > 0u)
+                    {
+                        (*s_tile_base)[1] = d_state.atomic(UInt(SELECT_NUM_EQUAL)).fetch_add(num_tile_equal);
+                    };
+                };
+                sync_block();
+
+                for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+                {
+                    UInt idx = tile_offset + UInt(u * BLOCK_SIZE) + thread_id().x;
+                    $if(less_flags[u] == 1u)
+                    {
+                        WriteWinner(d_values_in, d_keys_out, d_values_out, idx, (*s_tile_base)[0] + less_ranks[u]);
+                    }
+                    $elif(equal_flags[u] == 1u)
+                    {
+                        UInt tie = (*s_tile_base)[1] + equal_ranks[u];
+                        $if(tie < remaining_k)
+                        {
+                            WriteWinner(d_values_in, d_keys_out, d_values_out, idx, num_less + tie);
+                        };
+                    };
+                }
+                sync_block();
+            };
+        }
+
+      private:
+        // the bits above hi_bit, the ones earlier passes already decided
+        static Var<bit_ordered_type> DecidedMask(const UInt& hi_bit)
+        {
+            Var<bit_ordered_type> one = 1;
+            return select(~((one << cast<bit_ordered_type>(hi_bit)) - one), Var<bit_ordered_type>(0), hi_bit >= UInt(KEY_BITS));
+        }
+
+        // -0.0 and +0.0 compare equal, the raw key is what gets written out; a max select
+        // inverts after folding the zeros, since the fold only knows the ascending bit order
+        Var<bit_ordered_type> OrderedKey(const UInt& idx)
+        {
+            Var<bit_ordered_type> key = digit_extractor_t::ProcessFloatMinusZero(Twiddle::In(RawKey(idx)));
+            if constexpr(SELECT_MAX)
+            {
+                key = ~key;
+            }
+            return key;
+        }
+
+        Var<bit_ordered_type> RawKey(const UInt& idx)
+        {
+            return d_keys_in.read<bit_ordered_type>(idx * (uint)sizeof(bit_ordered_type));
+        }
+
+        void WriteWinner(const BufferVar<ValueType>& d_values_in,
+                         ByteBufferVar&              d_keys_out,
+                         BufferVar<ValueType>&       d_values_out,
+                         const UInt&                 idx,
+                         const UInt&                 dst)
+        {
+            d_keys_out.write(dst * (uint)sizeof(bit_ordered_type), RawKey(idx));
+            if constexpr(!KEYS_ONLY)
+            {
+                d_values_out.write(dst, d_values_in.read(idx));
+            }
+        }
+
+        const ByteBufferVar& d_keys_in;
+        UInt                 m_num_items;
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -40,7 +40,9 @@ struct AgentRadixSortOneSweepPolicy : RegBoundScaling<NominalBlockThreads4B, Nom
 namespace details
 {
     using namespace luisa::compute;
-    template <NumericT KeyType, NumericT ValueType, bool KEYS_ONLY, size_t RADIX_BITS, size_t RANK_NUM_PARTS, bool IS_DESCENDING, size_t BLOCK_SIZE, size_t WARP_SIZE, size_t ITEMS_PER_THREAD>
+    /// ValuesInIt is a BufferVar or any device iterator with read(index), the first pass reads
+    /// fancy values through it and the later passes read the ping-pong buffers
+    template <NumericT KeyType, NumericT ValueType, bool KEYS_ONLY, size_t RADIX_BITS, size_t RANK_NUM_PARTS, bool IS_DESCENDING, size_t BLOCK_SIZE, size_t WARP_SIZE, size_t ITEMS_PER_THREAD, typename ValuesInIt = BufferVar<ValueType>>
     class AgentRadixSortOneSweep : public LuisaModule
     {
       public:
@@ -84,7 +86,7 @@ namespace details
         {
             using RadixSortOneSweepPolicy = AgentRadixSortOneSweepPolicy<1u, 8u, KeyType, 1u, RADIX_BITS>;
             using AgentT =
-                AgentRadixSortOneSweep<KeyType, ValueType, KEYS_ONLY, RADIX_BITS, RadixSortOneSweepPolicy::RANK_NUM_PARTS, IS_DESCENDING, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD>;
+                AgentRadixSortOneSweep<KeyType, ValueType, KEYS_ONLY, RADIX_BITS, RadixSortOneSweepPolicy::RANK_NUM_PARTS, IS_DESCENDING, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD, ValuesInIt>;
             AgentT&                                       agent;
             ArrayVar<uint, BINS_PER_THREAD>&              bins;
             ArrayVar<bit_ordered_type, ITEMS_PER_THREAD>& keys;
@@ -113,7 +115,7 @@ namespace details
                                BufferVar<uint>&            d_bins_out,
                                const ByteBufferVar&        keys_in,
                                ByteBufferVar&              keys_out,
-                               const BufferVar<ValueType>& values_in,
+                               const ValuesInIt&           values_in,
                                BufferVar<ValueType>&       values_out,
                                UInt                        num_items,
                                UInt                        current_bit,
@@ -486,7 +488,7 @@ namespace details
 
         const ByteBufferVar&        d_keys_in;
         ByteBufferVar&              d_keys_out;
-        const BufferVar<ValueType>& d_values_in;
+        const ValuesInIt&           d_values_in;
         BufferVar<ValueType>&       d_values_out;
 
         UInt num_items;
@@ -28,7 +28,9 @@ namespace luisa::parallel_primitive
 namespace details
 {
     using namespace luisa::compute;
-    template <typename Type4Byte, typename ReduceOp, typename TransformOp, typename CollectiveReduceT, bool IsWarpReduction, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD>
+    /// InputIt is a BufferVar or any device iterator with read(index), TransformOp maps its items
+    /// to the Type4Byte accumulator while loading
+    template <typename Type4Byte, typename ReduceOp, typename TransformOp, typename CollectiveReduceT, bool IsWarpReduction, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD, typename InputIt = BufferVar<Type4Byte>>
     class AgentReduceImpl : public LuisaModule
     {
         static_assert(std::is_invocable_r_v<Var<Type4Byte>, ReduceOp, const Var<Type4Byte>&, const Var<Type4Byte>&>,
@@ -38,7 +40,7 @@ namespace details
 
       public:
         AgentReduceImpl(SmemTypePtr<Type4Byte>& smem_data,
-                        BufferVar<Type4Byte>&   d_in,
+                        const InputIt&          d_in,
                         ReduceOp                reduce_op,
                         TransformOp             transform_op,
                         UInt                    land_id)
@@ -103,8 +105,7 @@ namespace details
             $while(thread_offset < valid_items)
             {
                 // load data
-                Var<Type4Byte> data = m_in_data.read(thread_offset + block_offset);
-                thread_aggregate    = m_reduce_op(thread_aggregate, m_transform_op(data));
+                thread_aggregate = m_reduce_op(thread_aggregate, m_transform_op(m_in_data.read(thread_offset + block_offset)));
                 thread_offset += UInt(BLOCK_SIZE);
             };
         }
@@ -162,32 +163,32 @@ namespace details
         ReduceOp               m_reduce_op;
         UInt                   m_land_id;
 
-        BufferVar<Type4Byte>& m_in_data;
+        const InputIt& m_in_data;
     };
 
-    template <typename Type4Byte, typename ReduceOp, typename TransformOp, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD, size_t WARP_SIZE = details::WARP_SIZE, BlockReduceAlgorithm BLOCK_ALGORITHM = BlockReduceAlgorithm::WARP_SHUFFLE>
+    template <typename Type4Byte, typename ReduceOp, typename TransformOp, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD, size_t WARP_SIZE = details::WARP_SIZE, BlockReduceAlgorithm BLOCK_ALGORITHM = BlockReduceAlgorithm::WARP_SHUFFLE, typename InputIt = BufferVar<Type4Byte>>
     class AgentReduce
-        : public AgentReduceImpl<Type4Byte, ReduceOp, TransformOp, BlockReduce<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE, BLOCK_ALGORITHM>, false, BLOCK_SIZE, ITEMS_PER_THREAD>
+        : public AgentReduceImpl<Type4Byte, ReduceOp, TransformOp, BlockReduce<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE, BLOCK_ALGORITHM>, false, BLOCK_SIZE, ITEMS_PER_THREAD, InputIt>
     {
       public:
         using Base =
-            AgentReduceImpl<Type4Byte, ReduceOp, TransformOp, BlockReduce<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE, BLOCK_ALGORITHM>, false, BLOCK_SIZE, ITEMS_PER_THREAD>;
+            AgentReduceImpl<Type4Byte, ReduceOp, TransformOp, BlockReduce<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE, BLOCK_ALGORITHM>, false, BLOCK_SIZE, ITEMS_PER_THREAD, InputIt>;
         AgentReduce(SmemTypePtr<Type4Byte>& smem_data,
-                    BufferVar<Type4Byte>&   in,
+                    const InputIt&          in,
                     ReduceOp                reduce_op,
                     TransformOp             transform_op = IdentityOp())
             : Base(smem_data, in, reduce_op, transform_op, thread_id().x) {};
     };
 
-    template <typename Type4Byte, typename ReduceOp, typename TransformOp, size_t ITEMS_PER_THREAD, size_t WARP_SIZE = details::WARP_SIZE, WarpReduceAlgorithm WARP_ALGORITHM = WarpReduceAlgorithm::WARP_SHUFFLE>
+    template <typename Type4Byte, typename ReduceOp, typename TransformOp, size_t ITEMS_PER_THREAD, size_t WARP_SIZE = details::WARP_SIZE, WarpReduceAlgorithm WARP_ALGORITHM = WarpReduceAlgorithm::WARP_SHUFFLE, typename InputIt = BufferVar<Type4Byte>>
     class AgentWarpReduce
-        : public AgentReduceImpl<Type4Byte, ReduceOp, TransformOp, WarpReduce<Type4Byte, WARP_SIZE, WARP_ALGORITHM>, true, WARP_SIZE, ITEMS_PER_THREAD>
+        : public AgentReduceImpl<Type4Byte, ReduceOp, TransformOp, WarpReduce<Type4Byte, WARP_SIZE, WARP_ALGORITHM>, true, WARP_SIZE, ITEMS_PER_THREAD, InputIt>
     {
       public:
         using Base =
-            AgentReduceImpl<Type4Byte, ReduceOp, TransformOp, WarpReduce<Type4Byte, WARP_SIZE, WARP_ALGORITHM>, true, WARP_SIZE, ITEMS_PER_THREAD>;
+            AgentReduceImpl<Type4Byte, ReduceOp, TransformOp, WarpReduce<Type4Byte, WARP_SIZE, WARP_ALGORITHM>, true, WARP_SIZE, ITEMS_PER_THREAD, InputIt>;
         AgentWarpReduce(SmemTypePtr<Type4Byte>& smem_data,
-                        BufferVar<Type4Byte>&   in,
+                        const InputIt&          in,
                         ReduceOp                reduce_op,
                         TransformOp             transform_op = IdentityOp())
             : Base(smem_data, in, reduce_op, transform_op, thread_id().x % UInt(WARP_SIZE)) {};
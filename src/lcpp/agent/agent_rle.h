@@ -0,0 +1,225 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-14 10:11:26
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-07 11:08:44
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/stmt.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/block/block_load.h>
+#include <lcpp/block/block_scan.h>
+#include <lcpp/block/block_discontinuity.h>
+#include <lcpp/device/details/single_pass_scan_operator.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    enum class RleMode : uint
+    {
+        Encode,         // unique key + length of every run
+        NonTrivialRuns  // offset + length of every run longer than 1
+    };
+
+    // key: number of runs opened so far, value: offset of the most recent run head.
+    // Run heads appear at increasing offsets, so max() carries the start of the current run.
+    struct RunOffsetScanOp
+    {
+        template <KeyValuePairType KeyValuePairT>
+        Var<KeyValuePairT> operator()(const Var<KeyValuePairT>& a, const Var<KeyValuePairT>& b) const noexcept
+        {
+            Var<KeyValuePairT> result;
+            result.key   = a.key + b.key;
+            result.value = max(a.value, b.value);
+            return result;
+        }
+    };
+
+    // Single pass run-length encoding: runs are found with head/tail flags, and a decoupled
+    // look-back scan of (run count, run offset) pairs gives every run tail its run index and
+    // start, so the length needs no values buffer and no second kernel. DelayPolicy paces the
+    // look-back polls.
+    template <NumericT KeyType, RleMode MODE, typename EqualityOpT, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
+    class AgentRle : public LuisaModule
+    {
+      public:
+        using RunPairT         = KeyValuePair<uint, uint>;
+        using TileStatusViewer = ScanTileStateViewer<RunPairT>;
+        using TilePrefixOpT =
+            TilePrefixCallbackOp<RunPairT, RunOffsetScanOp, TileStatusViewer, typename DelayPolicy::template constructor<RunPairT>>;
+
+        static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+        AgentRle(TileStatusViewer&         tile_state,
+                 const BufferVar<KeyType>& in,
+                 BufferVar<KeyType>&       unique_out,
+                 BufferVar<uint>&          offsets_out,
+                 BufferVar<uint>&          lengths_out,
+                 const EqualityOpT&        equality_op,
+                 UInt                      num_items)
+            : m_tile_state(tile_state)
+            , d_in(in)
+            , d_unique_out(unique_out)
+            , d_offsets_out(offsets_out)
+            , d_lengths_out(lengths_out)
+            , m_equality_op(equality_op)
+            , m_num_items(num_items)
+        {
+        }
+
+        /// Runs the tile owned by this block; the last tile writes the run count to d_num_runs_out[0]
+        void ConsumeTile(BufferVar<uint>& d_num_runs_out)
+        {
+            UInt tile_id        = block_id().x;
+            UInt tile_start     = tile_id * UInt(TILE_ITEMS);
+            UInt num_remaining  = m_num_items - tile_start;
+            Bool is_last_tile   = num_remaining <= UInt(TILE_ITEMS);
+            UInt num_tile_items = min(num_remaining, UInt(TILE_ITEMS));
+
+            ArrayVar<KeyType, ITEMS_PER_THREAD> keys;
+            $if(is_last_tile)
+            {
+                BlockLoad<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>().Load(d_in, keys, tile_start, num_remaining);
+            }
+            $else
+            {
+                BlockLoad<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>().Load(d_in, keys, tile_start);
+            };
+
+            Var<KeyType> tile_predecessor = keys[0];
+            Var<KeyType> tile_successor   = keys[ITEMS_PER_THREAD - 1];
+            $if(thread_id().x == 0u & tile_id > 0u)
+            {
+                tile_predecessor = d_in.read(tile_start - 1u);
+            };
+            $if(thread_id().x == UInt(BLOCK_SIZE - 1) & !is_last_tile)
+            {
+                tile_successor = d_in.read(tile_start + UInt(TILE_ITEMS));
+            };
+
+            ArrayVar<int, ITEMS_PER_THREAD> head_flags;
+            ArrayVar<int, ITEMS_PER_THREAD> tail_flags;
+            BlockDiscontinuity<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>().FlagHeadsAndTails(
+                head_flags,
+                tile_predecessor,
+                tail_flags,
+                tile_successor,
+                keys,
+                [&](const Var<KeyType>& a, const Var<KeyType>& b) { return !m_equality_op(a, b); });
+
+            ArrayVar<uint, ITEMS_PER_THREAD>     item_offsets;
+            ArrayVar<uint, ITEMS_PER_THREAD>     is_head;
+            ArrayVar<uint, ITEMS_PER_THREAD>     is_tail;
+            ArrayVar<RunPairT, ITEMS_PER_THREAD> scan_items;
+            UInt                                 local_offset = thread_id().x * UInt(ITEMS_PER_THREAD);
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                Bool valid      = local_offset + i < num_tile_items;
+                item_offsets[i] = tile_start + local_offset + i;
+                // the input boundaries always close a run, whatever the flag op saw there
+                is_head[i] = cast<uint>(valid & (head_flags[i] != 0 | item_offsets[i] == 0u));
+                is_tail[i] = cast<uint>(valid & (tail_flags[i] != 0 | item_offsets[i] == m_num_items - 1u));
+
+                Var<RunPairT> scan_item;
+                if constexpr(MODE == RleMode::Encode)
+                {
+                    scan_item.key = is_head[i];
+                }
+                else
+                {
+                    scan_item.key = is_head[i] & (1u - is_tail[i]);
+                }
+                scan_item.value = is_head[i] * item_offsets[i];
+                scan_items[i]   = scan_item;
+            }
+
+            ArrayVar<RunPairT, ITEMS_PER_THREAD> scan_output;
+            Var<RunPairT>                        tile_aggregate{0u, 0u};
+            Var<RunPairT>                        tile_prefix{0u, 0u};
+            $if(tile_id == 0u)
+            {
+                BlockScan<RunPairT, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
+                    scan_items, scan_output, tile_aggregate, RunOffsetScanOp());
+                $if(thread_id().x == 0u)
+                {
+                    scan_output[0] = tile_prefix;
+                };
+
+                $if(!is_last_tile & thread_id().x == 0u)
+                {
+                    m_tile_state.SetInclusive(0, tile_aggregate);
+                };
+            }
+            $else
+            {
+                auto          temp_storage = new SmemType<TilePrefixTempStorage<RunPairT>>{1};
+                TilePrefixOpT prefix_op(m_tile_state, temp_storage, RunOffsetScanOp(), tile_id);
+
+                BlockScan<RunPairT, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
+                    scan_items, scan_output, RunOffsetScanOp(), prefix_op);
+
+                tile_aggregate = prefix_op.GetBlockAggregate();
+                tile_prefix    = prefix_op.GetExclusivePrefix();
+            };
+
+            // every run tail knows its run index and start, scatter directly
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                Var<RunPairT> inclusive = RunOffsetScanOp()(scan_output[i], scan_items[i]);
+                UInt          run       = inclusive.key - 1u;
+                if constexpr(MODE == RleMode::Encode)
+                {
+                    // the unique key is the first of its run, equality_op may match keys that differ
+                    $if(is_head[i] == 1u)
+                    {
+                        d_unique_out.write(run, keys[i]);
+                    };
+                }
+
+                Bool emit = is_tail[i] == 1u;
+                if constexpr(MODE == RleMode::NonTrivialRuns)
+                {
+                    emit = emit & is_head[i] == 0u;
+                }
+                $if(emit)
+                {
+                    UInt length = item_offsets[i] - inclusive.value + 1u;
+                    if constexpr(MODE == RleMode::NonTrivialRuns)
+                    {
+                        d_offsets_out.write(run, inclusive.value);
+                    }
+                    d_lengths_out.write(run, length);
+                };
+            }
+
+            $if(is_last_tile & thread_id().x == 0u)
+            {
+                d_num_runs_out.write(0u, tile_prefix.key + tile_aggregate.key);
+            };
+        }
+
+      private:
+        TileStatusViewer&         m_tile_state;
+        const BufferVar<KeyType>& d_in;
+        BufferVar<KeyType>&       d_unique_out;
+        BufferVar<uint>&          d_offsets_out;
+        BufferVar<uint>&          d_lengths_out;
+        const EqualityOpT&        m_equality_op;
+        UInt                      m_num_items;
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,365 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-16 10:12:40
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-04 15:42:10
+ */
+
+#pragma once
+#include <cstddef>
+#include <lcpp/agent/radix_rank_sort_operations.h>
+#include <lcpp/block/block_radix_rank.h>
+#include <lcpp/block/block_scan.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/runtime/core.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/stmt.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    // Every segment is sorted on its own by a worker sized to it:
+    //  - up to WARP_TILE_ITEMS keys: one warp ranks the keys by counting, one read and one write
+    //  - up to TILE_ITEMS keys:      one block runs all digit passes on its tile in shared memory
+    //  - larger segments:            per digit pass, every tile counts its digits, one block per segment
+    //                                 scans the counts, then every tile scatters; a block per tile
+    // Keys stay in their segment, so the cost never depends on how many segments there are.
+    template <NumericT KeyType, typename ValueType, bool KEYS_ONLY, bool IS_DESCENDING, size_t RADIX_BITS, size_t BLOCK_SIZE, size_t WARP_SIZE, size_t ITEMS_PER_THREAD>
+    class AgentSegmentedRadixSort : public LuisaModule
+    {
+      public:
+        static constexpr uint TILE_ITEMS      = BLOCK_SIZE * ITEMS_PER_THREAD;
+        static constexpr uint WARP_TILE_ITEMS = WARP_SIZE * ITEMS_PER_THREAD;
+        static constexpr uint RADIX_DIGITS    = 1 << RADIX_BITS;
+        static constexpr uint BINS_PER_THREAD = (RADIX_DIGITS + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        using traits            = radix::traits_t<KeyType>;
+        using bit_ordered_type  = typename traits::bit_ordered_type;
+        using digit_extractor_t = typename traits::template digit_extractor_t<ShiftDigitExtractor<KeyType>>;
+        using Twiddle           = RadixSortTwiddle<IS_DESCENDING, KeyType>;
+
+        // Twiddle already flips the keys of a descending sort, so digits are always ranked ascending
+        using BlockRadixRankT =
+            BlockRadixRankMatchEarlyCounts<BLOCK_SIZE, RADIX_BITS, false, WarpMatchAlgorithm::WARP_MATCH_ANY, 1u, ITEMS_PER_THREAD, WARP_SIZE>;
+
+        AgentSegmentedRadixSort(const ByteBufferVar&        keys_in,
+                                ByteBufferVar&              keys_out,
+                                const BufferVar<ValueType>& values_in,
+                                BufferVar<ValueType>&       values_out,
+                                UInt                        begin_bit,
+                                UInt                        end_bit)
+            : d_keys_in(keys_in)
+            , d_keys_out(keys_out)
+            , d_values_in(values_in)
+            , d_values_out(values_out)
+            , m_begin_bit(begin_bit)
+            , m_end_bit(end_bit)
+        {
+        }
+
+        /// One warp sorts a segment of at most WARP_TILE_ITEMS keys over [begin_bit, end_bit)
+        void SortWarpSegment(const UInt& segment_begin, const UInt& num_segment_items)
+        {
+            UInt lane = warp_lane_id();
+
+            // item u of lane l is segment item u * WARP_SIZE + l
+            ArrayVar<bit_ordered_type, ITEMS_PER_THREAD> keys;
+            ArrayVar<bit_ordered_type, ITEMS_PER_THREAD> sort_bits;
+            ArrayVar<ValueType, ITEMS_PER_THREAD>        values;
+            ArrayVar<uint, ITEMS_PER_THREAD>             ranks;
+            for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+            {
+                UInt idx = UInt(u * WARP_SIZE) + lane;
+                keys[u]  = Twiddle::DefaultKey();
+                $if(idx < num_segment_items)
+                {
+                    keys[u] = ReadKey(segment_begin + idx);
+                    if constexpr(!KEYS_ONLY)
+                    {
+                        values[u] = d_values_in.read(segment_begin + idx);
+                    }
+                };
+                keys[u]      = Twiddle::In(keys[u]);
+                sort_bits[u] = SortBits(keys[u]);
+                ranks[u]     = 0u;
+            }
+
+            // the rank of a key is the number of keys that go before it: smaller ones, and equal ones
+            // further up the segment, which keeps the sort stable
+            $for(other, 0u, num_segment_items)
+            {
+                Var<bit_ordered_type> other_bits =
+                    warp_read_lane(sort_bits[other / UInt(WARP_SIZE)], other & UInt(WARP_SIZE - 1));
+                for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+                {
+                    UInt idx = UInt(u * WARP_SIZE) + lane;
+                    ranks[u] += cast<uint>(other_bits < sort_bits[u] | (other_bits == sort_bits[u] & other < idx));
+                }
+            };
+
+            for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+            {
+                $if(UInt(u * WARP_SIZE) + lane < num_segment_items)
+                {
+                    WriteKey(segment_begin + ranks[u], Twiddle::Out(keys[u]));
+                    if constexpr(!KEYS_ONLY)
+                    {
+                        d_values_out.write(segment_begin + ranks[u], values[u]);
+                    }
+                };
+            }
+        }
+
+        /// One block sorts a segment of at most TILE_ITEMS keys, every digit pass stays in shared memory
+        void SortBlockSegment(const UInt& segment_begin, const UInt& num_segment_items)
+        {
+            SmemTypePtr<bit_ordered_type> s_keys   = new SmemType<bit_ordered_type>{TILE_ITEMS};
+            SmemTypePtr<ValueType>        s_values = nullptr;
+            if constexpr(!KEYS_ONLY)
+            {
+                s_values = new SmemType<ValueType>{TILE_ITEMS};
+            }
+
+            ArrayVar<bit_ordered_type, ITEMS_PER_THREAD> keys;
+            ArrayVar<ValueType, ITEMS_PER_THREAD>        values;
+            LoadTile(segment_begin, num_segment_items, keys, values);
+
+            $for(current_bit, m_begin_bit, m_end_bit, UInt(RADIX_BITS))
+            {
+                UInt num_bits = min(m_end_bit - current_bit, UInt(RADIX_BITS));
+
+                ArrayVar<uint, ITEMS_PER_THREAD> ranks;
+                ArrayVar<uint, BINS_PER_THREAD>  exclusive_digit_prefix;
+                BlockRadixRankT().template RankKeys<bit_ordered_type, ITEMS_PER_THREAD, digit_extractor_t>(
+                    keys, ranks, digit_extractor_t(current_bit, num_bits), exclusive_digit_prefix);
+
+                sync_block();
+                for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+                {
+                    (*s_keys)[ranks[u]] = keys[u];
+                    if constexpr(!KEYS_ONLY)
+                    {
+                        (*s_values)[ranks[u]] = values[u];
+                    }
+                }
+                sync_block();
+                for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+                {
+                    UInt idx = WarpStripedIndex(u);
+                    keys[u]  = (*s_keys)[idx];
+                    if constexpr(!KEYS_ONLY)
+                    {
+                        values[u] = (*s_values)[idx];
+                    }
+                }
+            };
+
+            // the padding ranks behind every valid key, so the first num_segment_items slots are the result
+            for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+            {
+                UInt idx = WarpStripedIndex(u);
+                $if(idx < num_segment_items)
+                {
+                    WriteKey(segment_begin + idx, Twiddle::Out(keys[u]));
+                    if constexpr(!KEYS_ONLY)
+                    {
+                        d_values_out.write(segment_begin + idx, values[u]);
+                    }
+                };
+            }
+        }
+
+        /// Digit counts of one tile of a large segment for the digit pass [begin_bit, end_bit),
+        /// written to d_tile_digits[tile_slot * RADIX_DIGITS + digit]
+        void CountLargeTile(const UInt& tile_begin, const UInt& num_tile_items, BufferVar<uint>& d_tile_digits, const UInt& tile_slot)
+        {
+            digit_extractor_t digit_extractor(m_begin_bit, m_end_bit - m_begin_bit);
+            SmemTypePtr<uint> s_digit_counts = new SmemType<uint>{RADIX_DIGITS};
+
+            $for(bin, thread_id().x, UInt(RADIX_DIGITS), UInt(BLOCK_SIZE))
+            {
+                (*s_digit_counts)[bin] = 0u;
+            };
+            sync_block();
+            $for(idx, thread_id().x, num_tile_items, UInt(BLOCK_SIZE))
+            {
+                Var<bit_ordered_type> key = Twiddle::In(ReadKey(tile_begin + idx));
+                s_digit_counts->atomic(digit_extractor.Digit(key)).fetch_add(1u);
+            };
+            sync_block();
+            $for(bin, thread_id().x, UInt(RADIX_DIGITS), UInt(BLOCK_SIZE))
+            {
+                d_tile_digits.write(tile_slot * UInt(RADIX_DIGITS) + bin, (*s_digit_counts)[bin]);
+            };
+        }
+
+        /// Turns the digit counts of the num_tiles tiles of a large segment, from tile_base on, into
+        /// the first output slot of every (tile, digit): the keys of a digit follow all smaller
+        /// digits of the segment and the same digit of the earlier tiles
+        void ScanLargeSegment(const UInt& segment_begin, const UInt& tile_base, const UInt& num_tiles, BufferVar<uint>& d_tile_digits)
+        {
+            ArrayVar<uint, BINS_PER_THREAD> digit_totals;
+            ArrayVar<uint, BINS_PER_THREAD> digit_prefix;
+            for(auto u = 0u; u < BINS_PER_THREAD; ++u)
+            {
+                UInt bin        = ThreadBin(u);
+                digit_totals[u] = 0u;
+                $if(bin < UInt(RADIX_DIGITS))
+                {
+                    $for(tile, tile_base, tile_base + num_tiles)
+                    {
+                        digit_totals[u] += d_tile_digits.read(tile * UInt(RADIX_DIGITS) + bin);
+                    };
+                };
+            }
+            BlockScan<uint, BLOCK_SIZE, BINS_PER_THREAD, WARP_SIZE>().ExclusiveSum(digit_totals, digit_prefix);
+
+            for(auto u = 0u; u < BINS_PER_THREAD; ++u)
+            {
+                UInt bin = ThreadBin(u);
+                $if(bin < UInt(RADIX_DIGITS))
+                {
+                    UInt offset = segment_begin + digit_prefix[u];
+                    $for(tile, tile_base, tile_base + num_tiles)
+                    {
+                        UInt slot  = tile * UInt(RADIX_DIGITS) + bin;
+                        UInt count = d_tile_digits.read(slot);
+                        d_tile_digits.write(slot, offset);
+                        offset += count;
+                    };
+                };
+            }
+        }
+
+        /// Ranks one tile of a large segment and scatters it to the slots ScanLargeSegment left in
+        /// d_tile_digits[tile_slot * RADIX_DIGITS + digit]
+        void ScatterLargeTile(const UInt& tile_begin, const UInt& num_tile_items, BufferVar<uint>& d_tile_digits, const UInt& tile_slot)
+        {
+            digit_extractor_t digit_extractor(m_begin_bit, m_end_bit - m_begin_bit);
+
+            SmemTypePtr<uint>             s_digit_offsets = new SmemType<uint>{RADIX_DIGITS};
+            SmemTypePtr<bit_ordered_type> s_keys          = new SmemType<bit_ordered_type>{TILE_ITEMS};
+            SmemTypePtr<ValueType>        s_values        = nullptr;
+            if constexpr(!KEYS_ONLY)
+            {
+                s_values = new SmemType<ValueType>{TILE_ITEMS};
+            }
+
+            ArrayVar<bit_ordered_type, ITEMS_PER_THREAD> keys;
+            ArrayVar<ValueType, ITEMS_PER_THREAD>        values;
+            LoadTile(tile_begin, num_tile_items, keys, values);
+
+            ArrayVar<uint, ITEMS_PER_THREAD> ranks;
+            ArrayVar<uint, BINS_PER_THREAD>  tile_prefix;
+            BlockRadixRankT().template RankKeys<bit_ordered_type, ITEMS_PER_THREAD, digit_extractor_t>(
+                keys, ranks, digit_extractor, tile_prefix);
+
+            sync_block();
+            for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+            {
+                (*s_keys)[ranks[u]] = keys[u];
+                if constexpr(!KEYS_ONLY)
+                {
+                    (*s_values)[ranks[u]] = values[u];
+                }
+            }
+            // the global slot of a digit minus where the digit starts in the ranked tile
+            for(auto u = 0u; u < BINS_PER_THREAD; ++u)
+            {
+                UInt bin = ThreadBin(u);
+                $if(bin < UInt(RADIX_DIGITS))
+                {
+                    (*s_digit_offsets)[bin] = d_tile_digits.read(tile_slot * UInt(RADIX_DIGITS) + bin) - tile_prefix[u];
+                };
+            }
+            sync_block();
+
+            for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+            {
+                UInt idx = thread_id().x + UInt(u * BLOCK_SIZE);
+                $if(idx < num_tile_items)
+                {
+                    Var<bit_ordered_type> key = (*s_keys)[idx];
+                    UInt                  dst = (*s_digit_offsets)[digit_extractor.Digit(key)] + idx;
+                    WriteKey(dst, Twiddle::Out(key));
+                    if constexpr(!KEYS_ONLY)
+                    {
+                        d_values_out.write(dst, (*s_values)[idx]);
+                    }
+                };
+            }
+        }
+
+      private:
+        static UInt ThreadBin(uint u) { return thread_id().x * UInt(BINS_PER_THREAD) + UInt(u); }
+
+        // the layout BlockRadixRankMatchEarlyCounts ranks stably
+        static UInt WarpStripedIndex(uint u)
+        {
+            UInt warp = thread_id().x / UInt(WARP_SIZE);
+            return warp * UInt(WARP_TILE_ITEMS) + UInt(u * WARP_SIZE) + warp_lane_id();
+        }
+
+        Var<bit_ordered_type> ReadKey(const UInt& idx)
+        {
+            return d_keys_in.read<bit_ordered_type>(idx * (uint)sizeof(bit_ordered_type));
+        }
+
+        void WriteKey(const UInt& idx, const Var<bit_ordered_type>& key)
+        {
+            d_keys_out.write(idx * (uint)sizeof(bit_ordered_type), key);
+        }
+
+        // twiddled keys of the tile in warp-striped order, padded with keys that rank last
+        void LoadTile(const UInt&                                   tile_begin,
+                      const UInt&                                   num_tile_items,
+                      ArrayVar<bit_ordered_type, ITEMS_PER_THREAD>& keys,
+                      ArrayVar<ValueType, ITEMS_PER_THREAD>&        values)
+        {
+            for(auto u = 0u; u < ITEMS_PER_THREAD; ++u)
+            {
+                UInt idx = WarpStripedIndex(u);
+                keys[u]  = Twiddle::DefaultKey();
+                $if(idx < num_tile_items)
+                {
+                    keys[u] = ReadKey(tile_begin + idx);
+                    if constexpr(!KEYS_ONLY)
+                    {
+                        values[u] = d_values_in.read(tile_begin + idx);
+                    }
+                };
+                keys[u] = Twiddle::In(keys[u]);
+            }
+        }
+
+        // the bits [begin_bit, end_bit) of a twiddled key, compared as one number
+        Var<bit_ordered_type> SortBits(const Var<bit_ordered_type>& key)
+        {
+            constexpr uint        KEY_BITS = sizeof(bit_ordered_type) * 8;
+            UInt                  num_bits = m_end_bit - m_begin_bit;
+            Var<bit_ordered_type> one      = 1;
+            Var<bit_ordered_type> mask     = select((one << cast<bit_ordered_type>(num_bits)) - one,
+                                                ~Var<bit_ordered_type>(0),
+                                                num_bits >= UInt(KEY_BITS));
+            Var<bit_ordered_type> bits = digit_extractor_t::ProcessFloatMinusZero(key);
+            return (bits >> cast<bit_ordered_type>(m_begin_bit)) & mask;
+        }
+
+        const ByteBufferVar&        d_keys_in;
+        ByteBufferVar&              d_keys_out;
+        const BufferVar<ValueType>& d_values_in;
+        BufferVar<ValueType>&       d_values_out;
+        UInt                        m_begin_bit;
+        UInt                        m_end_bit;
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,298 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-12 10:21:37
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-05 16:31:40
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/stmt.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/block/block_load.h>
+#include <lcpp/block/block_scan.h>
+#include <lcpp/block/block_discontinuity.h>
+#include <lcpp/device/details/single_pass_scan_operator.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    enum class SelectMode : uint
+    {
+        If,       // select_op(item) decides
+        Flagged,  // d_flags[i] != 0 decides
+        Unique    // first item of every run of equal items
+    };
+
+    // One tile per block: compute selection flags, scan them with decoupled look-back over
+    // the uint tile state and compact the selected items, all in a single pass over d_in.
+    // KEEP_REJECTS turns the selection into a partition: rejected items are written to the
+    // back of d_out in reverse order, so d_out must hold num_items elements.
+    // DelayPolicy paces the look-back polls.
+    template <NumericT Type, NumericT FlagT, SelectMode MODE, bool KEEP_REJECTS, typename SelectOpT, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
+    class AgentSelectIf : public LuisaModule
+    {
+      public:
+        using TileStatusViewer = ScanTileStateViewer<uint>;
+        using TilePrefixOpT =
+            TilePrefixCallbackOp<uint, SumOp, TileStatusViewer, typename DelayPolicy::template constructor<uint>>;
+
+        static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+        AgentSelectIf(TileStatusViewer&        tile_state,
+                      const BufferVar<Type>&   in,
+                      const BufferVar<FlagT>&  flags,
+                      BufferVar<Type>&         out,
+                      const SelectOpT&         select_op,
+                      UInt                     num_items)
+            : m_tile_state(tile_state)
+            , d_in(in)
+            , d_flags(flags)
+            , d_out(out)
+            , m_select_op(select_op)
+            , m_num_items(num_items)
+        {
+        }
+
+        /// Runs the tile owned by this block; the last tile writes the total to d_num_selected_out[0]
+        void ConsumeTile(BufferVar<uint>& d_num_selected_out)
+        {
+            UInt tile_id       = block_id().x;
+            UInt tile_start    = tile_id * UInt(TILE_ITEMS);
+            UInt num_remaining = m_num_items - tile_start;
+            Bool is_last_tile  = num_remaining <= UInt(TILE_ITEMS);
+
+            ArrayVar<Type, ITEMS_PER_THREAD> items;
+            $if(is_last_tile)
+            {
+                BlockLoad<Type, BLOCK_SIZE, ITEMS_PER_THREAD>().Load(d_in, items, tile_start, num_remaining);
+            }
+            $else
+            {
+                BlockLoad<Type, BLOCK_SIZE, ITEMS_PER_THREAD>().Load(d_in, items, tile_start);
+            };
+
+            ArrayVar<uint, ITEMS_PER_THREAD> selection_flags;
+            InitializeSelections(tile_id, tile_start, num_remaining, items, selection_flags);
+
+            ArrayVar<uint, ITEMS_PER_THREAD> selection_indices;
+            UInt                             num_tile_selections;
+            UInt                             num_selections_prefix;
+            ScanSelections(tile_id, is_last_tile, selection_flags, selection_indices, num_tile_selections, num_selections_prefix);
+
+            if constexpr(KEEP_REJECTS)
+            {
+                ScatterPartition(
+                    items, selection_flags, selection_indices, tile_start, num_remaining, num_tile_selections, num_selections_prefix);
+            }
+            else
+            {
+                Scatter(items, selection_flags, selection_indices, num_tile_selections, num_selections_prefix);
+            }
+
+            $if(is_last_tile & thread_id().x == 0u)
+            {
+                d_num_selected_out.write(0u, num_selections_prefix + num_tile_selections);
+            };
+        }
+
+      private:
+        void InitializeSelections(const UInt&                             tile_id,
+                                  const UInt&                             tile_start,
+                                  const UInt&                             num_remaining,
+                                  const ArrayVar<Type, ITEMS_PER_THREAD>& items,
+                                  ArrayVar<uint, ITEMS_PER_THREAD>&       selection_flags)
+        {
+            if constexpr(MODE == SelectMode::If)
+            {
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    selection_flags[i] = cast<uint>(m_select_op(items[i]));
+                }
+            }
+            else if constexpr(MODE == SelectMode::Flagged)
+            {
+                ArrayVar<FlagT, ITEMS_PER_THREAD> flags;
+                BlockLoad<FlagT, BLOCK_SIZE, ITEMS_PER_THREAD>().Load(
+                    d_flags, flags, tile_start, min(num_remaining, UInt(TILE_ITEMS)));
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    selection_flags[i] = cast<uint>(flags[i] != FlagT(0));
+                }
+            }
+            else
+            {
+                Var<Type> tile_predecessor = items[0];
+                $if(tile_id > 0u & thread_id().x == 0u)
+                {
+                    tile_predecessor = d_in.read(tile_start - 1u);
+                };
+
+                ArrayVar<int, ITEMS_PER_THREAD> head_flags;
+                BlockDiscontinuity<Type, BLOCK_SIZE, ITEMS_PER_THREAD>().FlagHeads(
+                    head_flags,
+                    items,
+                    [&](const Var<Type>& a, const Var<Type>& b) { return !m_select_op(a, b); },
+                    tile_predecessor);
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    selection_flags[i] = cast<uint>(head_flags[i] != 0);
+                }
+                // the very first item always starts a run
+                $if(tile_id == 0u & thread_id().x == 0u)
+                {
+                    selection_flags[0] = 1u;
+                };
+            }
+
+            // items past the end of the input are never selected
+            UInt item_offset = thread_id().x * UInt(ITEMS_PER_THREAD);
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                $if(item_offset + i >= num_remaining)
+                {
+                    selection_flags[i] = 0u;
+                };
+            }
+        }
+
+        void ScanSelections(const UInt&                             tile_id,
+                            const Bool&                             is_last_tile,
+                            const ArrayVar<uint, ITEMS_PER_THREAD>& selection_flags,
+                            ArrayVar<uint, ITEMS_PER_THREAD>&       selection_indices,
+                            UInt&                                   num_tile_selections,
+                            UInt&                                   num_selections_prefix)
+        {
+            $if(tile_id == 0u)
+            {
+                Var<uint> block_aggregate;
+                BlockScan<uint, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
+                    selection_flags, selection_indices, block_aggregate, SumOp());
+                // the scan without an initial value leaves the very first exclusive output undefined
+                $if(thread_id().x == 0u)
+                {
+                    selection_indices[0] = 0u;
+                };
+                num_tile_selections   = block_aggregate;
+                num_selections_prefix = 0u;
+
+                $if(!is_last_tile & thread_id().x == 0u)
+                {
+                    m_tile_state.SetInclusive(0, block_aggregate);
+                };
+            }
+            $else
+            {
+                auto          temp_storage = new SmemType<TilePrefixTempStorage<uint>>{1};
+                TilePrefixOpT prefix_op(m_tile_state, temp_storage, SumOp(), tile_id);
+
+                BlockScan<uint, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
+                    selection_flags, selection_indices, SumOp(), prefix_op);
+
+                num_tile_selections   = prefix_op.GetBlockAggregate();
+                num_selections_prefix = prefix_op.GetExclusivePrefix();
+            };
+        }
+
+        void Scatter(const ArrayVar<Type, ITEMS_PER_THREAD>& items,
+                     const ArrayVar<uint, ITEMS_PER_THREAD>& selection_flags,
+                     const ArrayVar<uint, ITEMS_PER_THREAD>& selection_indices,
+                     const UInt&                             num_tile_selections,
+                     const UInt&                             num_selections_prefix)
+        {
+            $if(UInt(ITEMS_PER_THREAD) > 1u & num_tile_selections > UInt(BLOCK_SIZE))
+            {
+                // two phase scatter: compact into shared memory, then write consecutive addresses
+                SmemTypePtr<Type> s_compacted = new SmemType<Type>{TILE_ITEMS};
+                sync_block();
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    $if(selection_flags[i] == 1u)
+                    {
+                        (*s_compacted)[selection_indices[i] - num_selections_prefix] = items[i];
+                    };
+                }
+                sync_block();
+                $for(item, thread_id().x, num_tile_selections, UInt(BLOCK_SIZE))
+                {
+                    d_out.write(num_selections_prefix + item, (*s_compacted)[item]);
+                };
+            }
+            $else
+            {
+                // direct scatter
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    $if(selection_flags[i] == 1u)
+                    {
+                        d_out.write(selection_indices[i], items[i]);
+                    };
+                }
+            };
+        }
+
+        void ScatterPartition(const ArrayVar<Type, ITEMS_PER_THREAD>& items,
+                              const ArrayVar<uint, ITEMS_PER_THREAD>& selection_flags,
+                              const ArrayVar<uint, ITEMS_PER_THREAD>& selection_indices,
+                              const UInt&                             tile_start,
+                              const UInt&                             num_remaining,
+                              const UInt&                             num_tile_selections,
+                              const UInt&                             num_selections_prefix)
+        {
+            // every item is written, so always go through shared memory:
+            // [selected | rejected] locally, then selected forward and rejected from the back
+            SmemTypePtr<Type> s_partitioned = new SmemType<Type>{TILE_ITEMS};
+            UInt              num_tile_items      = min(num_remaining, UInt(TILE_ITEMS));
+            UInt              num_rejected_prefix = tile_start - num_selections_prefix;
+
+            sync_block();
+            UInt item_offset = thread_id().x * UInt(ITEMS_PER_THREAD);
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                UInt local_item = item_offset + i;
+                $if(local_item < num_tile_items)
+                {
+                    UInt local_selection = selection_indices[i] - num_selections_prefix;
+                    UInt local_rejection = local_item - local_selection;
+                    UInt local_index =
+                        select(num_tile_selections + local_rejection, local_selection, selection_flags[i] == 1u);
+                    (*s_partitioned)[local_index] = items[i];
+                };
+            }
+            sync_block();
+            $for(item, thread_id().x, num_tile_items, UInt(BLOCK_SIZE))
+            {
+                Var<Type> value = (*s_partitioned)[item];
+                $if(item < num_tile_selections)
+                {
+                    d_out.write(num_selections_prefix + item, value);
+                }
+                $else
+                {
+                    UInt rejected_index = num_rejected_prefix + (item - num_tile_selections);
+                    d_out.write(m_num_items - 1u - rejected_index, value);
+                };
+            };
+        }
+
+        TileStatusViewer&       m_tile_state;
+        const BufferVar<Type>&  d_in;
+        const BufferVar<FlagT>& d_flags;
+        BufferVar<Type>&        d_out;
+        const SelectOpT&        m_select_op;
+        UInt                    m_num_items;
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
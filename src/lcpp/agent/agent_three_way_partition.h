@@ -0,0 +1,202 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-13 10:02:44
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-05 16:31:40
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/stmt.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/block/block_load.h>
+#include <lcpp/block/block_scan.h>
+#include <lcpp/device/details/single_pass_scan_operator.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    // Splits every tile into [first part | second part | unselected] with one decoupled look-back
+    // scan over a packed pair of counters; all three outputs keep the input order. DelayPolicy
+    // paces the look-back polls.
+    template <NumericT Type, typename SelectFirstPartOpT, typename SelectSecondPartOpT, size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
+    class AgentThreeWayPartition : public LuisaModule
+    {
+      public:
+        // key counts first-part items, value counts second-part items
+        using AccumPackT       = KeyValuePair<uint, uint>;
+        using TileStatusViewer = ScanTileStateViewer<AccumPackT>;
+        using TilePrefixOpT =
+            TilePrefixCallbackOp<AccumPackT, KeyValueSumOp, TileStatusViewer, typename DelayPolicy::template constructor<AccumPackT>>;
+
+        static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+        AgentThreeWayPartition(TileStatusViewer&          tile_state,
+                               const BufferVar<Type>&     in,
+                               BufferVar<Type>&           first_part_out,
+                               BufferVar<Type>&           second_part_out,
+                               BufferVar<Type>&           unselected_out,
+                               const SelectFirstPartOpT&  select_first_part_op,
+                               const SelectSecondPartOpT& select_second_part_op,
+                               UInt                       num_items)
+            : m_tile_state(tile_state)
+            , d_in(in)
+            , d_first_part_out(first_part_out)
+            , d_second_part_out(second_part_out)
+            , d_unselected_out(unselected_out)
+            , m_select_first_part_op(select_first_part_op)
+            , m_select_second_part_op(select_second_part_op)
+            , m_num_items(num_items)
+        {
+        }
+
+        /// Runs the tile owned by this block; the last tile writes both part sizes to d_num_selected_out[0..1]
+        void ConsumeTile(BufferVar<uint>& d_num_selected_out)
+        {
+            UInt tile_id        = block_id().x;
+            UInt tile_start     = tile_id * UInt(TILE_ITEMS);
+            UInt num_remaining  = m_num_items - tile_start;
+            Bool is_last_tile   = num_remaining <= UInt(TILE_ITEMS);
+            UInt num_tile_items = min(num_remaining, UInt(TILE_ITEMS));
+
+            ArrayVar<Type, ITEMS_PER_THREAD> items;
+            $if(is_last_tile)
+            {
+                BlockLoad<Type, BLOCK_SIZE, ITEMS_PER_THREAD>().Load(d_in, items, tile_start, num_remaining);
+            }
+            $else
+            {
+                BlockLoad<Type, BLOCK_SIZE, ITEMS_PER_THREAD>().Load(d_in, items, tile_start);
+            };
+
+            // first part wins when both predicates hold
+            ArrayVar<AccumPackT, ITEMS_PER_THREAD> part_flags;
+            UInt                                   item_offset = thread_id().x * UInt(ITEMS_PER_THREAD);
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                Bool is_valid  = item_offset + i < num_tile_items;
+                Bool is_first  = is_valid & m_select_first_part_op(items[i]);
+                Bool is_second = is_valid & !is_first & m_select_second_part_op(items[i]);
+
+                Var<AccumPackT> flag;
+                flag.key      = cast<uint>(is_first);
+                flag.value    = cast<uint>(is_second);
+                part_flags[i] = flag;
+            }
+
+            ArrayVar<AccumPackT, ITEMS_PER_THREAD> part_indices;
+            Var<AccumPackT>                        tile_aggregate{0u, 0u};
+            Var<AccumPackT>                        tile_prefix{0u, 0u};
+            $if(tile_id == 0u)
+            {
+                BlockScan<AccumPackT, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
+                    part_flags, part_indices, tile_aggregate, KeyValueSumOp());
+                $if(thread_id().x == 0u)
+                {
+                    part_indices[0] = tile_prefix;
+                };
+
+                $if(!is_last_tile & thread_id().x == 0u)
+                {
+                    m_tile_state.SetInclusive(0, tile_aggregate);
+                };
+            }
+            $else
+            {
+                auto          temp_storage = new SmemType<TilePrefixTempStorage<AccumPackT>>{1};
+                TilePrefixOpT prefix_op(m_tile_state, temp_storage, KeyValueSumOp(), tile_id);
+
+                BlockScan<AccumPackT, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
+                    part_flags, part_indices, KeyValueSumOp(), prefix_op);
+
+                tile_aggregate = prefix_op.GetBlockAggregate();
+                tile_prefix    = prefix_op.GetExclusivePrefix();
+            };
+
+            Scatter(items, part_flags, part_indices, tile_start, num_tile_items, tile_aggregate, tile_prefix);
+
+            $if(is_last_tile & thread_id().x == 0u)
+            {
+                d_num_selected_out.write(0u, tile_prefix.key + tile_aggregate.key);
+                d_num_selected_out.write(1u, tile_prefix.value + tile_aggregate.value);
+            };
+        }
+
+      private:
+        void Scatter(const ArrayVar<Type, ITEMS_PER_THREAD>&       items,
+                     const ArrayVar<AccumPackT, ITEMS_PER_THREAD>& part_flags,
+                     const ArrayVar<AccumPackT, ITEMS_PER_THREAD>& part_indices,
+                     const UInt&                                   tile_start,
+                     const UInt&                                   num_tile_items,
+                     const Var<AccumPackT>&                        tile_aggregate,
+                     const Var<AccumPackT>&                        tile_prefix)
+        {
+            SmemTypePtr<Type> s_partitioned = new SmemType<Type>{TILE_ITEMS};
+
+            UInt num_tile_first        = tile_aggregate.key;
+            UInt num_tile_selected     = tile_aggregate.key + tile_aggregate.value;
+            UInt num_unselected_prefix = tile_start - tile_prefix.key - tile_prefix.value;
+
+            sync_block();
+            UInt item_offset = thread_id().x * UInt(ITEMS_PER_THREAD);
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                UInt local_item = item_offset + i;
+                $if(local_item < num_tile_items)
+                {
+                    UInt local_first  = part_indices[i].key - tile_prefix.key;
+                    UInt local_second = part_indices[i].value - tile_prefix.value;
+                    UInt local_index  = num_tile_selected + (local_item - local_first - local_second);
+                    $if(part_flags[i].key == 1u)
+                    {
+                        local_index = local_first;
+                    }
+                    $elif(part_flags[i].value == 1u)
+                    {
+                        local_index = num_tile_first + local_second;
+                    };
+                    (*s_partitioned)[local_index] = items[i];
+                };
+            }
+            sync_block();
+            $for(item, thread_id().x, num_tile_items, UInt(BLOCK_SIZE))
+            {
+                Var<Type> value = (*s_partitioned)[item];
+                $if(item < num_tile_first)
+                {
+                    d_first_part_out.write(tile_prefix.key + item, value);
+                }
+                $elif(item < num_tile_selected)
+                {
+                    d_second_part_out.write(tile_prefix.value + (item - num_tile_first), value);
+                }
+                $else
+                {
+                    d_unselected_out.write(num_unselected_prefix + (item - num_tile_selected), value);
+                };
+            };
+        }
+
+        TileStatusViewer&          m_tile_state;
+        const BufferVar<Type>&     d_in;
+        BufferVar<Type>&           d_first_part_out;
+        BufferVar<Type>&           d_second_part_out;
+        BufferVar<Type>&           d_unselected_out;
+        const SelectFirstPartOpT&  m_select_first_part_op;
+        const SelectSecondPartOpT& m_select_second_part_op;
+        UInt                       m_num_items;
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
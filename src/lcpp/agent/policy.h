@@ -10,6 +10,7 @@
 
 #include <luisa/core/basic_traits.h>
 #include <algorithm>
+#include <type_traits>
 namespace luisa::parallel_primitive
 {
 // shared memory per block limit 48KB
@@ -75,6 +76,22 @@ struct OneSweepSmallKeyTunedPolicy
     static constexpr uint ONESWEEP_RADIX_BITS = 8;
 };
 
+// onesweep tile of a key/value pair: 8-byte keys or values scale the items per thread down
+// so the shared key and value tiles and the per-thread registers stay at the 4-byte budget
+template <typename KeyType, typename ValueType, uint BlockThreads, uint Nominal4ByteItemsPerThread>
+struct OneSweepTilePolicy
+{
+    using ScalingT = std::conditional_t<(sizeof(KeyType) >= sizeof(ValueType)), KeyType, ValueType>;
+
+    static constexpr uint RADIX_BITS       = OneSweepSmallKeyTunedPolicy<KeyType>::ONESWEEP_RADIX_BITS;
+    static constexpr uint ITEMS_PER_THREAD = RegBoundScaling<BlockThreads, Nominal4ByteItemsPerThread, ScalingT>::ITEMS_PER_THREAD;
+    static constexpr uint TILE_ITEMS       = BlockThreads * ITEMS_PER_THREAD;
+    // lookback counts keep 30 bits, a portion stays below that whatever the key size
+    static constexpr uint PORTION_SIZE = ((1u << 28u) - 1u) / TILE_ITEMS * TILE_ITEMS;
+    // keys are scattered through 32-bit byte offsets of the whole output buffer
+    static constexpr size_t MAX_NUM_ITEMS = (size_t{1} << 32u) / sizeof(KeyType);
+};
+
 
 template <int BlockThreads, int PixelsPerThread, bool RleCompress, bool WorkStealing, int VecSize = 4>
 struct AgentHistogramPolicy
@@ -58,7 +58,8 @@ struct ShiftDigitExtractor : BaseDigitExtractor<KeyT>
 
     compute::UInt Digit(compute::Var<UnsignedBits> key) const
     {
-        return compute::UInt(this->ProcessFloatMinusZero(key) >> compute::Var<UnsignedBits>(bit_start)) & mask;
+        // cast rather than construct, so 8-byte keys shift in their own width before narrowing
+        return compute::cast<uint>(this->ProcessFloatMinusZero(key) >> compute::cast<UnsignedBits>(bit_start)) & mask;
     }
 };
 
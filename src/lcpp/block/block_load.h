@@ -7,9 +7,12 @@
 #pragma once
 
 #include <cstddef>
+#include <type_traits>
+#include <utility>
 #include <luisa/dsl/var.h>
 #include <luisa/dsl/sugar.h>
 #include <luisa/dsl/resource.h>
+#include <luisa/dsl/expr_traits.h>
 #include <lcpp/common/type_trait.h>
 #include <lcpp/runtime/core.h>
 
@@ -229,6 +232,48 @@ void LoadDirectWarpStriped(compute::UInt                         linear_tid,
 }
 
 
+// any device iterator with read(index), e.g. fancy values fed to the first radix sort pass;
+// the BufferVar and ByteBufferVar overloads above stay the more specialized match
+template <typename T, size_t ItemsPerThread, size_t WARP_SIZE = details::WARP_SIZE, typename InputIt>
+void LoadDirectWarpStriped(compute::UInt                         linear_tid,
+                           const InputIt&                        block_src_it,
+                           compute::UInt                         tile_offset,
+                           compute::ArrayVar<T, ItemsPerThread>& dst_items)
+{
+    compute::UInt tid         = linear_tid & compute::UInt(WARP_SIZE - 1);
+    compute::UInt wid         = linear_tid >> details::LOG_WARP_SIZE;
+    compute::UInt warp_offset = wid * compute::UInt(WARP_SIZE * ItemsPerThread);
+
+    for(auto i = 0u; i < ItemsPerThread; i++)
+    {
+        UInt src_pos = tile_offset + warp_offset + tid + (i * compute::UInt(WARP_SIZE));
+        dst_items[i] = block_src_it.read(src_pos);
+    }
+}
+
+template <typename T, size_t ItemsPerThread, size_t WARP_SIZE = details::WARP_SIZE, typename InputIt>
+void LoadDirectWarpStriped(compute::UInt                         linear_tid,
+                           const InputIt&                        block_src_it,
+                           compute::UInt                         tile_offset,
+                           compute::ArrayVar<T, ItemsPerThread>& dst_items,
+                           compute::UInt                         block_item_end)
+{
+    compute::UInt tid         = linear_tid & compute::UInt(WARP_SIZE - 1);
+    compute::UInt wid         = linear_tid >> details::LOG_WARP_SIZE;
+    compute::UInt warp_offset = wid * compute::UInt(WARP_SIZE * ItemsPerThread);
+
+    for(auto i = 0u; i < ItemsPerThread; i++)
+    {
+        UInt src_pos = warp_offset + tid + (i * compute::UInt(WARP_SIZE));
+        $if(src_pos < block_item_end)
+        {
+            src_pos += tile_offset;
+            dst_items[i] = block_src_it.read(src_pos);
+        };
+    }
+}
+
+
 template <typename Type4Byte, size_t BlockSize = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = 2, BlockLoadAlgorithm DefaultLoadAlgorithm = BlockLoadAlgorithm::BLOCK_LOAD_DIRECT>
 class BlockLoad : public LuisaModule
 {
@@ -242,14 +287,18 @@ class BlockLoad : public LuisaModule
     ~BlockLoad() = default;
 
   public:
-    void Load(const compute::BufferVar<Type4Byte>&            d_in,
+    // d_in is a BufferVar or any device iterator with read(index), its items are converted to
+    // Type4Byte as they are read, narrow inputs stay narrow in memory
+    template <typename InputIt>
+    void Load(const InputIt&                                  d_in,
               compute::ArrayVar<Type4Byte, ITEMS_PER_THREAD>& thread_data,
               compute::UInt                                   block_item_start)
     {
         Load(d_in, thread_data, block_item_start, compute::UInt(BlockSize * ITEMS_PER_THREAD), Type4Byte(0));
     }
 
-    void Load(const compute::BufferVar<Type4Byte>&            d_in,
+    template <typename InputIt>
+    void Load(const InputIt&                                  d_in,
               compute::ArrayVar<Type4Byte, ITEMS_PER_THREAD>& thread_data,
               compute::UInt                                   block_item_start,
               compute::UInt                                   block_item_end)
@@ -257,7 +306,8 @@ class BlockLoad : public LuisaModule
         Load(d_in, thread_data, block_item_start, block_item_end, Type4Byte(0));
     }
 
-    void Load(const compute::BufferVar<Type4Byte>&            d_in,
+    template <typename InputIt>
+    void Load(const InputIt&                                  d_in,
               compute::ArrayVar<Type4Byte, ITEMS_PER_THREAD>& thread_data,
               compute::UInt                                   block_item_start,
               compute::UInt                                   block_item_end,
@@ -274,19 +324,28 @@ class BlockLoad : public LuisaModule
 
 
   private:
+    template <typename InputIt>
     void LoadDirectedBlocked(compute::UInt                                   linear_tid,
-                             const compute::BufferVar<Type4Byte>&            d_in,
+                             const InputIt&                                  d_in,
                              compute::ArrayVar<Type4Byte, ITEMS_PER_THREAD>& thread_data,
                              compute::UInt                                   block_item_start,
                              compute::UInt                                   block_item_end,
                              Var<Type4Byte>                                  default_value)
     {
+        using InputT = compute::expr_value_t<decltype(d_in.read(std::declval<compute::UInt>()))>;
         for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
         {
             UInt index = linear_tid + i;
             $if(index < block_item_end)
             {
-                thread_data[i] = d_in.read(block_item_start + index);
+                if constexpr(std::is_same_v<InputT, Type4Byte>)
+                {
+                    thread_data[i] = d_in.read(block_item_start + index);
+                }
+                else
+                {
+                    thread_data[i] = compute::cast<Type4Byte>(d_in.read(block_item_start + index));
+                }
             }
             $else
             {
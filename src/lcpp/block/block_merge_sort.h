@@ -0,0 +1,245 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-15 10:04:51
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-15 16:22:13
+ */
+
+#pragma once
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/runtime/core.h>
+
+namespace luisa::parallel_primitive
+{
+/// Binary search along the cross diagonal `diag` of the merge of two sorted ranges,
+/// returns how many items of the first range come before the diagonal.
+/// read1 / read2 map a local index to a key, so both shared and global ranges work.
+template <typename Read1, typename Read2, typename CompareOp>
+compute::UInt MergePath(Read1                read1,
+                        Read2                read2,
+                        const compute::UInt& keys1_count,
+                        const compute::UInt& keys2_count,
+                        const compute::UInt& diag,
+                        CompareOp            compare_op)
+{
+    using namespace luisa::compute;
+    UInt keys1_begin = select(diag - keys2_count, UInt(0u), diag < keys2_count);
+    UInt keys1_end   = min(diag, keys1_count);
+    $while(keys1_begin < keys1_end)
+    {
+        UInt mid = (keys1_begin + keys1_end) >> 1u;
+        // ties go to the first range, which keeps the merge stable
+        $if(compare_op(read2(diag - 1u - mid), read1(mid)))
+        {
+            keys1_end = mid;
+        }
+        $else
+        {
+            keys1_begin = mid + 1u;
+        };
+    };
+    return keys1_begin;
+}
+
+template <typename KeyType, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+class BlockMergeSort : public LuisaModule
+{
+  public:
+    static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+  public:
+    BlockMergeSort()
+    {
+        m_keys_shared = new SmemType<KeyType>{TILE_ITEMS};
+    };
+    BlockMergeSort(SmemTypePtr<KeyType> keys_shared)
+        : m_keys_shared(keys_shared) {};
+    ~BlockMergeSort() = default;
+
+    /// Stable sort of a blocked arrangement; only the first valid_items keys of the tile take part
+    template <typename CompareOp>
+    void Sort(compute::ArrayVar<KeyType, ITEMS_PER_THREAD>& keys, CompareOp compare_op, const compute::UInt& valid_items)
+    {
+        compute::ArrayVar<KeyType, ITEMS_PER_THREAD> values;
+        SortImpl<true, KeyType>(keys, values, compare_op, valid_items);
+    }
+
+    /// Stable sort of keys, values follow their key
+    template <typename ValueType, typename CompareOp>
+    void Sort(compute::ArrayVar<KeyType, ITEMS_PER_THREAD>&   keys,
+              compute::ArrayVar<ValueType, ITEMS_PER_THREAD>& values,
+              CompareOp                                       compare_op,
+              const compute::UInt&                            valid_items)
+    {
+        SortImpl<false, ValueType>(keys, values, compare_op, valid_items);
+    }
+
+    /// Merges keys[keys1_beg, +keys1_count) and keys[keys2_beg, +keys2_count) of the shared tile
+    /// into ITEMS_PER_THREAD outputs; indices receive the shared position every output came from
+    template <typename CompareOp>
+    void SerialMerge(compute::UInt                                 keys1_beg,
+                     compute::UInt                                 keys2_beg,
+                     const compute::UInt&                          keys1_count,
+                     const compute::UInt&                          keys2_count,
+                     compute::ArrayVar<KeyType, ITEMS_PER_THREAD>& output,
+                     compute::ArrayVar<uint, ITEMS_PER_THREAD>&    indices,
+                     CompareOp                                     compare_op)
+    {
+        using namespace luisa::compute;
+        UInt keys1_end = keys1_beg + keys1_count;
+        UInt keys2_end = keys2_beg + keys2_count;
+
+        Var<KeyType> key1 = read_shared(keys1_beg);
+        Var<KeyType> key2 = read_shared(keys2_beg);
+        for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+        {
+            Bool take2 = keys2_beg < keys2_end & (keys1_beg >= keys1_end | compare_op(key2, key1));
+            $if(take2)
+            {
+                output[i]  = key2;
+                indices[i] = keys2_beg;
+                keys2_beg += 1u;
+                key2 = read_shared(keys2_beg);
+            }
+            $else
+            {
+                output[i]  = key1;
+                indices[i] = keys1_beg;
+                keys1_beg += 1u;
+                key1 = read_shared(keys1_beg);
+            };
+        }
+    }
+
+    [[nodiscard]] SmemTypePtr<KeyType> shared_keys() const noexcept { return m_keys_shared; }
+
+  private:
+    // the merge reads one past its range, keep it inside the tile
+    compute::Var<KeyType> read_shared(const compute::UInt& index)
+    {
+        return (*m_keys_shared)[compute::min(index, compute::UInt(TILE_ITEMS - 1))];
+    }
+
+    template <bool KEY_ONLY, typename ValueType, typename CompareOp>
+    void StableOddEvenSort(compute::ArrayVar<KeyType, ITEMS_PER_THREAD>&   keys,
+                           compute::ArrayVar<ValueType, ITEMS_PER_THREAD>& values,
+                           CompareOp                                       compare_op)
+    {
+        using namespace luisa::compute;
+        for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+        {
+            for(auto j = 1u & i; j + 1u < ITEMS_PER_THREAD; j += 2u)
+            {
+                $if(compare_op(keys[j + 1], keys[j]))
+                {
+                    Var<KeyType> tmp_key = keys[j];
+                    keys[j]              = keys[j + 1];
+                    keys[j + 1]          = tmp_key;
+                    if constexpr(!KEY_ONLY)
+                    {
+                        Var<ValueType> tmp_value = values[j];
+                        values[j]                = values[j + 1];
+                        values[j + 1]            = tmp_value;
+                    }
+                };
+            }
+        }
+    }
+
+    template <bool KEY_ONLY, typename ValueType, typename CompareOp>
+    void SortImpl(compute::ArrayVar<KeyType, ITEMS_PER_THREAD>&   keys,
+                  compute::ArrayVar<ValueType, ITEMS_PER_THREAD>& values,
+                  CompareOp                                       compare_op,
+                  const compute::UInt&                            valid_items)
+    {
+        using namespace luisa::compute;
+        luisa::compute::set_block_size(BLOCK_SIZE);
+        UInt thid        = thread_id().x;
+        UInt item_offset = thid * UInt(ITEMS_PER_THREAD);
+
+        // pad the partial thread with its largest valid key, so the padding sorts behind it
+        Var<KeyType> max_key = keys[0];
+        for(auto i = 1u; i < ITEMS_PER_THREAD; ++i)
+        {
+            $if(item_offset + i < valid_items)
+            {
+                $if(compare_op(max_key, keys[i]))
+                {
+                    max_key = keys[i];
+                };
+            }
+            $else
+            {
+                keys[i] = max_key;
+            };
+        }
+        $if(item_offset < valid_items)
+        {
+            StableOddEvenSort<KEY_ONLY>(keys, values, compare_op);
+        };
+
+        SmemTypePtr<ValueType> values_shared = nullptr;
+        if constexpr(!KEY_ONLY)
+        {
+            values_shared = new SmemType<ValueType>{TILE_ITEMS};
+        }
+
+        // merge sorted runs of 1, 2, 4 ... threads through shared memory
+        for(auto target_merged_threads = 2u; target_merged_threads <= BLOCK_SIZE; target_merged_threads *= 2u)
+        {
+            uint merged_threads = target_merged_threads / 2u;
+            uint mask           = target_merged_threads - 1u;
+
+            sync_block();
+            for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+            {
+                (*m_keys_shared)[item_offset + i] = keys[i];
+            }
+            sync_block();
+
+            UInt start       = UInt(ITEMS_PER_THREAD) * (thid & UInt(~mask));
+            UInt size        = UInt(ITEMS_PER_THREAD * merged_threads);
+            UInt diag        = min(valid_items, UInt(ITEMS_PER_THREAD) * (thid & UInt(mask)));
+            UInt keys1_beg   = min(valid_items, start);
+            UInt keys1_end   = min(valid_items, keys1_beg + size);
+            UInt keys2_beg   = keys1_end;
+            UInt keys2_end   = min(valid_items, keys2_beg + size);
+            UInt keys1_count = keys1_end - keys1_beg;
+            UInt keys2_count = keys2_end - keys2_beg;
+
+            UInt partition_diag = MergePath([&](const UInt& i) { return read_shared(keys1_beg + i); },
+                                            [&](const UInt& i) { return read_shared(keys2_beg + i); },
+                                            keys1_count,
+                                            keys2_count,
+                                            diag,
+                                            compare_op);
+
+            UInt keys1_beg_loc = keys1_beg + partition_diag;
+            UInt keys2_beg_loc = keys2_beg + diag - partition_diag;
+
+            ArrayVar<uint, ITEMS_PER_THREAD> indices;
+            SerialMerge(keys1_beg_loc, keys2_beg_loc, keys1_end - keys1_beg_loc, keys2_end - keys2_beg_loc, keys, indices, compare_op);
+
+            if constexpr(!KEY_ONLY)
+            {
+                sync_block();
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    (*values_shared)[item_offset + i] = values[i];
+                }
+                sync_block();
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    values[i] = (*values_shared)[min(indices[i], UInt(TILE_ITEMS - 1))];
+                }
+            }
+        }
+    }
+
+  private:
+    SmemTypePtr<KeyType> m_keys_shared;
+};
+}  // namespace luisa::parallel_primitive
@@ -7,6 +7,7 @@
 
 
 #pragma once
+#include <type_traits>
 #include <luisa/dsl/var.h>
 #include <luisa/dsl/sugar.h>
 #include <lcpp/common/type_trait.h>
@@ -118,15 +119,18 @@ class BlockStore : public LuisaModule
     ~BlockStore() = default;
 
   public:
+    // Type4Byte items are converted to OutputT as they are written
+    template <typename OutputT = Type4Byte>
     void Store(const compute::ArrayVar<Type4Byte, ITEMS_PER_THREAD>& thread_data,
-               const compute::BufferVar<Type4Byte>&                  d_out,
+               const compute::BufferVar<OutputT>&                    d_out,
                compute::UInt                                         block_item_start)
     {
         Store(thread_data, d_out, block_item_start, compute::UInt(BlockSize * ITEMS_PER_THREAD));
     }
 
+    template <typename OutputT = Type4Byte>
     void Store(const compute::ArrayVar<Type4Byte, ITEMS_PER_THREAD>& thread_data,
-               const compute::BufferVar<Type4Byte>&                  d_out,
+               const compute::BufferVar<OutputT>&                    d_out,
                compute::UInt                                         block_item_start,
                compute::UInt                                         block_item_end)
     {
@@ -141,9 +145,10 @@ class BlockStore : public LuisaModule
     };
 
   private:
+    template <typename OutputT>
     void StoreDirectedBlocked(compute::UInt                                         linear_tid,
                               const compute::ArrayVar<Type4Byte, ITEMS_PER_THREAD>& thread_data,
-                              const compute::BufferVar<Type4Byte>&                  d_out,
+                              const compute::BufferVar<OutputT>&                    d_out,
                               compute::UInt block_item_start,
                               compute::UInt block_item_end)
     {
@@ -153,7 +158,14 @@ class BlockStore : public LuisaModule
             UInt index = linear_tid + i;
             $if(index < block_item_end)
             {
-                d_out.write(block_item_start + index, thread_data[i]);
+                if constexpr(std::is_same_v<OutputT, Type4Byte>)
+                {
+                    d_out.write(block_item_start + index, thread_data[i]);
+                }
+                else
+                {
+                    d_out.write(block_item_start + index, cast<OutputT>(thread_data[i]));
+                }
             };
         };
     };
@@ -2,15 +2,17 @@
  * @Author: Ligo 
  * @Date: 2025-10-20 16:29:10 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-06 21:09:23
+ * @Last Modified time: 2026-02-24 10:32:17
  */
 
 #pragma once
+#include <type_traits>
 #include <luisa/dsl/sugar.h>
 #include <luisa/dsl/func.h>
 #include <luisa/dsl/var.h>
 #include <luisa/dsl/builtin.h>
 #include <lcpp/common/util_type.h>
+#include <lcpp/runtime/kernel_identity.h>
 
 namespace luisa::parallel_primitive
 {
@@ -18,6 +20,8 @@ using namespace luisa::compute;
 
 struct ArgMaxOp
 {
+    static luisa::string kernel_name() noexcept { return "arg_max"; }
+
     template <NumericT Type4Byte>
     Var<IndexValuePairT<Type4Byte>> operator()(const Var<IndexValuePairT<Type4Byte>>& a,
                                                const Var<IndexValuePairT<Type4Byte>>& b) const noexcept
@@ -33,6 +37,8 @@ struct ArgMaxOp
 
 struct ArgMinOp
 {
+    static luisa::string kernel_name() noexcept { return "arg_min"; }
+
     template <NumericT Type4Byte>
     Var<IndexValuePairT<Type4Byte>> operator()(const Var<IndexValuePairT<Type4Byte>>& a,
                                                const Var<IndexValuePairT<Type4Byte>>& b) const noexcept
@@ -48,6 +54,8 @@ struct ArgMinOp
 
 struct SumOp
 {
+    static luisa::string kernel_name() noexcept { return "sum"; }
+
     template <NumericT Type4Byte>
     Var<Type4Byte> operator()(const Var<Type4Byte>& a, const Var<Type4Byte>& b) const noexcept
     {
@@ -55,8 +63,58 @@ struct SumOp
     }
 };
 
+// Neumaier summation over CompensatedSumT: the error of every addition is recovered
+// from the larger operand and carried in value, so the order of combination barely matters
+struct CompensatedSumOp
+{
+    static luisa::string kernel_name() noexcept { return "compensated_sum"; }
+
+    template <NumericT Type4Byte>
+    Var<CompensatedSumT<Type4Byte>> operator()(const Var<CompensatedSumT<Type4Byte>>& a,
+                                               const Var<CompensatedSumT<Type4Byte>>& b) const noexcept
+    {
+        Bool           a_larger = abs(a.key) >= abs(b.key);
+        Var<Type4Byte> larger   = select(b.key, a.key, a_larger);
+        Var<Type4Byte> smaller  = select(a.key, b.key, a_larger);
+
+        Var<CompensatedSumT<Type4Byte>> result;
+        result.key   = a.key + b.key;
+        result.value = a.value + b.value + ((larger - result.key) + smaller);
+        return result;
+    }
+};
+
+// widens an item into a CompensatedSumT accumulator, used as the load transform
+struct ToCompensatedSumOp
+{
+    static luisa::string kernel_name() noexcept { return "to_compensated_sum"; }
+
+    template <NumericT Type4Byte>
+    Var<CompensatedSumT<Type4Byte>> operator()(const Var<Type4Byte>& data) const noexcept
+    {
+        Var<CompensatedSumT<Type4Byte>> result;
+        result.key   = data;
+        result.value = Type4Byte(0);
+        return result;
+    }
+};
+
+// folds the compensation back into the sum when the result is stored
+struct FromCompensatedSumOp
+{
+    static luisa::string kernel_name() noexcept { return "from_compensated_sum"; }
+
+    template <NumericT Type4Byte>
+    Var<Type4Byte> operator()(const Var<CompensatedSumT<Type4Byte>>& data) const noexcept
+    {
+        return data.key + data.value;
+    }
+};
+
 struct MaxOp
 {
+    static luisa::string kernel_name() noexcept { return "max"; }
+
     template <NumericT Type4Byte>
     Var<Type4Byte> operator()(const Var<Type4Byte>& a, const Var<Type4Byte>& b) const noexcept
     {
@@ -66,6 +124,8 @@ struct MaxOp
 
 struct MinOp
 {
+    static luisa::string kernel_name() noexcept { return "min"; }
+
     template <NumericT Type4Byte>
     Var<Type4Byte> operator()(const Var<Type4Byte>& a, const Var<Type4Byte>& b) const noexcept
     {
@@ -75,6 +135,8 @@ struct MinOp
 
 struct IdentityOp
 {
+    static luisa::string kernel_name() noexcept { return "identity"; }
+
     template <typename T>
     Var<T> operator()(const Var<T>& data) const noexcept
     {
@@ -82,9 +144,57 @@ struct IdentityOp
     }
 };
 
+// converts an item to the accumulator (or output) type, fused into a load or a store
+template <typename TargetT>
+struct CastOp
+{
+    static luisa::string kernel_name() noexcept { return make_kernel_name<TargetT>("cast"); }
+
+    template <typename T>
+    Var<TargetT> operator()(const Var<T>& data) const noexcept
+    {
+        if constexpr(std::is_same_v<T, TargetT>)
+        {
+            return data;
+        }
+        else
+        {
+            return compute::cast<TargetT>(data);
+        }
+    }
+};
+
+struct EqualityOp
+{
+    static luisa::string kernel_name() noexcept { return "equality"; }
+
+    template <typename T>
+    Bool operator()(const Var<T>& a, const Var<T>& b) const noexcept
+    {
+        return a == b;
+    }
+};
+
+// sums key and value independently, used to scan two counters in one pass
+struct KeyValueSumOp
+{
+    static luisa::string kernel_name() noexcept { return "key_value_sum"; }
+
+    template <KeyValuePairType KeyValuePairT>
+    Var<KeyValuePairT> operator()(const Var<KeyValuePairT>& a, const Var<KeyValuePairT>& b) const noexcept
+    {
+        Var<KeyValuePairT> result;
+        result.key   = a.key + b.key;
+        result.value = a.value + b.value;
+        return result;
+    }
+};
+
 template <typename ReduceOpT>
 struct ReduceBySegmentOp
 {
+    static luisa::string kernel_name() noexcept { return make_kernel_name<ReduceOpT>("reduce_by_segment"); }
+
     ReduceOpT reduce_op;
 
     template <KeyValuePairType KeyValuePairT>
@@ -107,6 +217,8 @@ struct ReduceBySegmentOp
 template <typename ScanOpT>
 struct ScanBySegmentOp
 {
+    static luisa::string kernel_name() noexcept { return make_kernel_name<ScanOpT>("scan_by_segment"); }
+
     ScanOpT scan_op;
 
     template <KeyValuePairType KeyValuePairT>
@@ -130,6 +242,8 @@ struct ScanBySegmentOp
 template <typename ReduceOpT>
 struct ReduceByKeyOp
 {
+    static luisa::string kernel_name() noexcept { return make_kernel_name<ReduceOpT>("reduce_by_key"); }
+
     ReduceOpT reduce_op;
 
     template <KeyValuePairType KeyValuePairT>
@@ -147,6 +261,8 @@ struct ReduceByKeyOp
 template <typename ScanOp>
 struct SwizzleScanOp
 {
+    static luisa::string kernel_name() noexcept { return make_kernel_name<ScanOp>("swizzle_scan"); }
+
     ScanOp scan_op;
 
   public:
@@ -51,6 +51,9 @@ template <typename T>
 concept NumericTOrKeyValuePairT = NumericT<T> || KeyValuePairType<T>;
 template <NumericT Type4Byte>
 using IndexValuePairT = KeyValuePair<luisa::uint, Type4Byte>;
+// running sum (key) and the rounding error its additions lost so far (value)
+template <NumericT Type4Byte>
+using CompensatedSumT = KeyValuePair<Type4Byte, Type4Byte>;
 
 
 // Double Buffer(device) for Ping-Pong Buffering
@@ -236,7 +239,7 @@ struct NumericTraits<float> : BaseTraits<Category::FLOATING_POINT, true, unsigne
 {
 };
 template <>
-struct NumericTraits<double> : BaseTraits<Category::FLOATING_POINT, true, unsigned long long, double>
+struct NumericTraits<double> : BaseTraits<Category::FLOATING_POINT, true, ulong, double>
 {
 };
 
@@ -2,14 +2,13 @@
  * @Author: Ligo 
  * @Date: 2025-10-22 17:17:43 
  * @Last Modified by: Ligo
- * @Last Modified time: 2026-02-06 14:53:46
+ * @Last Modified time: 2026-02-24 11:02:35
  */
 
 
 #pragma once
 #include <cmath>
 #include <cstddef>
-#include <typeindex>
 #include <luisa/dsl/builtin.h>
 #include <luisa/dsl/var.h>
 #include <lcpp/common/util_type.h>
@@ -65,76 +64,6 @@ struct Log2<N, 0, COUNT>
 };
 
 
-template <NumericT Type4Byte, typename ReduceOp>
-luisa::string get_type_and_op_desc(ReduceOp op)
-{
-    luisa::string_view key_desc       = luisa::compute::Type::of<Type4Byte>()->description();
-    luisa::string_view reduce_op_desc = std::type_index(typeid(op)).name();
-
-    return luisa::string(key_desc) + "+" + luisa::string(reduce_op_desc);
-}
-
-template <KeyValuePairType KeyValueType, typename ReduceOp>
-luisa::string get_type_and_op_desc(ReduceOp op)
-{
-    using ValueType                   = value_type_of_t<KeyValueType>;
-    luisa::string_view key_desc       = luisa::compute::Type::of<ValueType>()->description();
-    luisa::string_view reduce_op_desc = std::type_index(typeid(op)).name();
-
-    return luisa::string(key_desc) + "+" + luisa::string(reduce_op_desc);
-}
-
-template <KeyValuePairType KeyValueType, typename ReduceOp, typename TransformOp>
-luisa::string get_type_and_op_desc(ReduceOp op, TransformOp transform_op)
-{
-    using ValueType                      = value_type_of_t<KeyValueType>;
-    luisa::string_view key_desc          = luisa::compute::Type::of<ValueType>()->description();
-    luisa::string_view reduce_op_desc    = std::type_index(typeid(op)).name();
-    luisa::string_view transform_op_desc = std::type_index(typeid(transform_op)).name();
-
-    return luisa::string(key_desc) + "+" + luisa::string(reduce_op_desc) + "+" + luisa::string(transform_op_desc);
-}
-
-template <typename KeyType, typename ValueType>
-luisa::string get_type_and_op_desc()
-{
-    luisa::string_view key_desc   = luisa::compute::Type::of<KeyType>()->description();
-    luisa::string_view value_desc = luisa::compute::Type::of<ValueType>()->description();
-
-    return luisa::string(key_desc) + "+" + luisa::string(value_desc);
-}
-
-template <typename KeyType, typename ValueType, typename ReduceOp>
-luisa::string get_type_and_op_desc(ReduceOp op)
-{
-    luisa::string_view key_desc   = luisa::compute::Type::of<KeyType>()->description();
-    luisa::string_view value_desc = luisa::compute::Type::of<ValueType>()->description();
-
-    return luisa::string(key_desc) + "+" + luisa::string(value_desc) + "+"
-           + std::type_index(typeid(op)).name();
-}
-
-template <NumericT Type4Byte, typename ReduceOp, typename TransformOp>
-luisa::string get_type_and_op_desc(ReduceOp op, TransformOp transform_op)
-{
-    luisa::string_view reduce_op_desc    = std::type_index(typeid(op)).name();
-    luisa::string_view key_desc          = luisa::compute::Type::of<Type4Byte>()->description();
-    luisa::string_view transform_op_desc = std::type_index(typeid(transform_op)).name();
-
-    return luisa::string(key_desc) + "+" + luisa::string(reduce_op_desc) + "+" + luisa::string(transform_op_desc);
-}
-
-
-template <typename KeyType, typename ValueType, typename ReduceOp, typename TransformOp>
-luisa::string get_type_and_op_desc(ReduceOp op, TransformOp transform_op)
-{
-    luisa::string_view key_desc   = luisa::compute::Type::of<KeyType>()->description();
-    luisa::string_view value_desc = luisa::compute::Type::of<ValueType>()->description();
-
-    return luisa::string(key_desc) + "+" + luisa::string(value_desc) + "+"
-           + std::type_index(typeid(op)).name() + "+" + std::type_index(typeid(transform_op)).name();
-}
-
 static void get_temp_size_scan(size_t& temp_storage_size, size_t m_block_size, size_t items_per_thread, size_t num_items)
 {
     auto         block_size       = m_block_size;
@@ -0,0 +1,78 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-18 11:30:52
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-24 13:47:05
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/agent/agent_deterministic.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    /// Type is the accumulator of the chunk totals, InputT the items and OutputT the scan output
+    template <NumericTOrKeyValuePairT Type, size_t BLOCK_SIZE = details::BLOCK_SIZE, typename InputT = Type, typename OutputT = Type>
+    class DeterministicModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<Type, InputT, OutputT>("DeterministicModule", BLOCK_SIZE);
+        }
+
+        template <typename ReduceOp, typename LoadOp>
+        using AgentT = AgentDeterministic<Type, ReduceOp, BLOCK_SIZE, InputT, LoadOp>;
+
+        // d_in, d_out (one partial per chunk), num_items, init, fold_init
+        using ReduceChunksKernel = Shader<1, Buffer<InputT>, Buffer<Type>, uint, Type, uint>;
+        // d_in, d_out, d_prefix (scanned chunk totals), num_items, init
+        using ScanChunksKernel = Shader<1, Buffer<InputT>, Buffer<OutputT>, Buffer<Type>, uint, Type>;
+
+        template <typename ReduceOp, typename LoadOp = IdentityOp>
+        U<ReduceChunksKernel> compile_reduce_chunks(Device& device, ReduceOp reduce_op, LoadOp load_op = IdentityOp())
+        {
+            U<ReduceChunksKernel> ms_reduce_chunks_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_reduce_chunks_shader,
+                         [&](BufferVar<InputT> d_in, BufferVar<Type> d_out, UInt num_items, Var<Type> init, UInt fold_init) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             AgentT<ReduceOp, LoadOp>(d_in, reduce_op, num_items, load_op).ReduceChunk(d_out, init, fold_init);
+                         });
+
+            return ms_reduce_chunks_shader;
+        }
+
+        template <typename ReduceOp, typename LoadOp = IdentityOp, typename StoreOp = IdentityOp>
+        U<ScanChunksKernel> compile_scan_chunks(Device& device, ReduceOp reduce_op, LoadOp load_op = IdentityOp(), StoreOp store_op = IdentityOp())
+        {
+            U<ScanChunksKernel> ms_scan_chunks_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_scan_chunks_shader,
+                         [&](BufferVar<InputT> d_in, BufferVar<OutputT> d_out, BufferVar<Type> d_prefix, UInt num_items, Var<Type> init) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             AgentT<ReduceOp, LoadOp>(d_in, reduce_op, num_items, load_op).ScanChunk(d_out, d_prefix, init, store_op);
+                         });
+
+            return ms_scan_chunks_shader;
+        }
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
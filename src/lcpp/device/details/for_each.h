@@ -0,0 +1,177 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-11 10:26:17
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-07 10:02:48
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/runtime/core.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    // Tiles of BLOCK_SIZE * ITEMS_PER_THREAD indices are walked grid-stride; inside a tile
+    // thread t visits t, t + BLOCK_SIZE, ... so that every warp touches consecutive addresses.
+    template <size_t BLOCK_SIZE, size_t ITEMS_PER_THREAD, typename TileOpT>
+    void ForEachTiles(UInt num_items, TileOpT&& tile_op)
+    {
+        constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+        // not (num_items + TILE_ITEMS - 1) / TILE_ITEMS, that wraps close to the uint range
+        UInt num_tiles = num_items / UInt(TILE_ITEMS) + select(0u, 1u, num_items % UInt(TILE_ITEMS) != 0u);
+        UInt grid_size = dispatch_size().x / UInt(BLOCK_SIZE);
+        $for(tile, block_id().x, num_tiles, grid_size)
+        {
+            UInt tile_offset = tile * UInt(TILE_ITEMS);
+            UInt item_offset = tile_offset + thread_id().x;
+            $if(num_items - tile_offset >= UInt(TILE_ITEMS))
+            {
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    tile_op(item_offset + UInt(i * BLOCK_SIZE));
+                }
+            }
+            $else
+            {
+                for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                {
+                    UInt idx = item_offset + UInt(i * BLOCK_SIZE);
+                    $if(idx < num_items)
+                    {
+                        tile_op(idx);
+                    };
+                }
+            };
+        };
+    }
+
+    template <typename Type, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    class ForEachModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<Type>("ForEachModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
+        using ForEachKernel = Shader<1, Buffer<Type>, uint>;
+
+        template <typename ForEachOp>
+        U<ForEachKernel> compile(Device& device, ForEachOp op)
+        {
+            U<ForEachKernel> ms_for_each_shader = nullptr;
+            lazy_compile(device,
+                         ms_for_each_shader,
+                         [&](BufferVar<Type> d_data, UInt num_items) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+                             UInt num_tiles =
+                                 num_items / UInt(TILE_ITEMS) + select(0u, 1u, num_items % UInt(TILE_ITEMS) != 0u);
+                             UInt grid_size = dispatch_size().x / UInt(BLOCK_SIZE);
+                             $for(tile, block_id().x, num_tiles, grid_size)
+                             {
+                                 UInt tile_offset = tile * UInt(TILE_ITEMS);
+                                 UInt item_offset = tile_offset + thread_id().x;
+                                 $if(num_items - tile_offset >= UInt(TILE_ITEMS))
+                                 {
+                                     // full tile: issue all striped loads before running the op
+                                     ArrayVar<Type, ITEMS_PER_THREAD> items;
+                                     for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                                     {
+                                         items[i] = d_data.read(item_offset + UInt(i * BLOCK_SIZE));
+                                     }
+                                     for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                                     {
+                                         Var<Type> item = items[i];
+                                         op(item);
+                                         d_data.write(item_offset + UInt(i * BLOCK_SIZE), item);
+                                     }
+                                 }
+                                 $else
+                                 {
+                                     for(auto i = 0u; i < ITEMS_PER_THREAD; ++i)
+                                     {
+                                         UInt idx = item_offset + UInt(i * BLOCK_SIZE);
+                                         $if(idx < num_items)
+                                         {
+                                             Var<Type> item = d_data.read(idx);
+                                             op(item);
+                                             d_data.write(idx, item);
+                                         };
+                                     }
+                                 };
+                             };
+                         });
+            return ms_for_each_shader;
+        };
+    };
+
+    template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    class BulkModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name("BulkModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
+        // the buffers passed to the op trail the fixed arguments
+        template <typename... Ts>
+        using BulkKernel = Shader<1, uint, Buffer<Ts>...>;
+        template <typename... Ts>
+        using ExtentsKernel = Shader<1, uint3, Buffer<Ts>...>;
+
+        template <typename... Ts, typename BulkOp>
+        U<BulkKernel<Ts...>> compile(Device& device, BulkOp op)
+        {
+            U<BulkKernel<Ts...>> ms_bulk_shader = nullptr;
+            lazy_compile(device,
+                         ms_bulk_shader,
+                         [&](UInt num_items, BufferVar<Ts>... buffers) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             ForEachTiles<BLOCK_SIZE, ITEMS_PER_THREAD>(num_items, [&](UInt idx) { op(idx, buffers...); });
+                         });
+            return ms_bulk_shader;
+        };
+
+        template <typename... Ts, typename ExtentsOp>
+        U<ExtentsKernel<Ts...>> compile_extents(Device& device, ExtentsOp op)
+        {
+            U<ExtentsKernel<Ts...>> ms_extents_shader = nullptr;
+            lazy_compile(device,
+                         ms_extents_shader,
+                         [&](Var<uint3> extents, BufferVar<Ts>... buffers) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             UInt num_items = extents.x * extents.y * extents.z;
+                             // row-major: x is the fastest varying dimension
+                             ForEachTiles<BLOCK_SIZE, ITEMS_PER_THREAD>(
+                                 num_items,
+                                 [&](UInt idx)
+                                 {
+                                     UInt x = idx % extents.x;
+                                     UInt y = (idx / extents.x) % extents.y;
+                                     UInt z = idx / (extents.x * extents.y);
+                                     op(idx, make_uint3(x, y, z), buffers...);
+                                 });
+                         });
+            return ms_extents_shader;
+        };
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,142 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-10 11:03:52
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-24 13:47:05
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <lcpp/agent/agent_histogram.h>
+#include <lcpp/agent/policy.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/runtime/core.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    template <size_t BLOCK_SIZE = details::BLOCK_SIZE>
+    class HistogramInitModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name("HistogramInitModule", BLOCK_SIZE);
+        }
+
+        using HistogramInitKernel = Shader<1, Buffer<uint>, Buffer<uint>, uint>;
+
+        U<HistogramInitKernel> compile(Device& device)
+        {
+            U<HistogramInitKernel> ms_histogram_init_shader = nullptr;
+            lazy_compile(device,
+                         ms_histogram_init_shader,
+                         [&](BufferVar<uint> d_histogram, BufferVar<uint> d_tile_queue, UInt num_bins) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             UInt tid = dispatch_id().x;
+                             $if(tid < num_bins)
+                             {
+                                 d_histogram.write(tid, 0u);
+                             };
+                             $if(tid == 0u)
+                             {
+                                 d_tile_queue.write(0u, 0u);
+                             };
+                         });
+            return ms_histogram_init_shader;
+        };
+    };
+
+    template <NumericT SampleT, uint NUM_CHANNELS, uint NUM_ACTIVE_CHANNELS, bool IS_PRIVATIZED, typename AgentHistogramPolicyT>
+    class HistogramModule : public LuisaModule
+    {
+        using SampleVecT = Vector<SampleT, 4>;
+
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<SampleT>("HistogramModule",
+                                             NUM_CHANNELS,
+                                             NUM_ACTIVE_CHANNELS,
+                                             IS_PRIVATIZED,
+                                             AgentHistogramPolicyT::BLOCK_THREADS,
+                                             AgentHistogramPolicyT::PIXELS_PER_THREAD,
+                                             AgentHistogramPolicyT::IS_RLE_COMPRESS,
+                                             AgentHistogramPolicyT::IS_WORK_STEALING,
+                                             AgentHistogramPolicyT::VEC_SIZE);
+        }
+
+        // d_samples, d_histogram, d_tile_queue, num_pixels, num_tiles, num_bins, bin_offsets, lower, upper
+        using HistogramEvenKernel =
+            Shader<1, Buffer<SampleT>, Buffer<uint>, Buffer<uint>, uint, uint, uint4, uint4, SampleVecT, SampleVecT>;
+        // d_samples, d_levels, d_histogram, d_tile_queue, num_pixels, num_tiles, num_bins, bin_offsets, level_offsets
+        using HistogramRangeKernel =
+            Shader<1, Buffer<SampleT>, Buffer<SampleT>, Buffer<uint>, Buffer<uint>, uint, uint, uint4, uint4, uint4>;
+
+        U<HistogramEvenKernel> compile_even(Device& device)
+        {
+            U<HistogramEvenKernel> ms_histogram_even_shader = nullptr;
+            lazy_compile(device,
+                         ms_histogram_even_shader,
+                         [&](BufferVar<SampleT> d_samples,
+                             BufferVar<uint>    d_histogram,
+                             BufferVar<uint>    d_tile_queue,
+                             UInt               num_pixels,
+                             UInt               num_tiles,
+                             Var<uint4>         num_bins,
+                             Var<uint4>         bin_offsets,
+                             Var<SampleVecT>    lower,
+                             Var<SampleVecT>    upper) noexcept
+                         {
+                             set_block_size(AgentHistogramPolicyT::BLOCK_THREADS);
+                             using DecodeOpT = HistogramScaleTransform<SampleT>;
+                             using AgentT =
+                                 AgentHistogram<SampleT, NUM_CHANNELS, NUM_ACTIVE_CHANNELS, IS_PRIVATIZED, AgentHistogramPolicyT, DecodeOpT>;
+
+                             DecodeOpT decode_op{num_bins, lower, upper};
+                             AgentT(d_samples, d_histogram, d_tile_queue, num_pixels, num_bins, bin_offsets, decode_op)
+                                 .Process(num_tiles);
+                         });
+            return ms_histogram_even_shader;
+        };
+
+        U<HistogramRangeKernel> compile_range(Device& device)
+        {
+            U<HistogramRangeKernel> ms_histogram_range_shader = nullptr;
+            lazy_compile(device,
+                         ms_histogram_range_shader,
+                         [&](BufferVar<SampleT> d_samples,
+                             BufferVar<SampleT> d_levels,
+                             BufferVar<uint>    d_histogram,
+                             BufferVar<uint>    d_tile_queue,
+                             UInt               num_pixels,
+                             UInt               num_tiles,
+                             Var<uint4>         num_bins,
+                             Var<uint4>         bin_offsets,
+                             Var<uint4>         level_offsets) noexcept
+                         {
+                             set_block_size(AgentHistogramPolicyT::BLOCK_THREADS);
+                             using DecodeOpT = HistogramSearchTransform<SampleT>;
+                             using AgentT =
+                                 AgentHistogram<SampleT, NUM_CHANNELS, NUM_ACTIVE_CHANNELS, IS_PRIVATIZED, AgentHistogramPolicyT, DecodeOpT>;
+
+                             DecodeOpT decode_op{d_levels, num_bins, level_offsets};
+                             AgentT(d_samples, d_histogram, d_tile_queue, num_pixels, num_bins, bin_offsets, decode_op)
+                                 .Process(num_tiles);
+                         });
+            return ms_histogram_range_shader;
+        };
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,110 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-15 13:02:18
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-24 13:47:05
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/agent/agent_merge_sort.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    template <typename KeyType, typename ValueType, bool KEY_ONLY, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    class MergeSortModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<KeyType, ValueType>("MergeSortModule", KEY_ONLY, BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
+        // d_keys_in, d_keys_out, d_values_in, d_values_out, num_items
+        using BlockSortKernel = Shader<1, Buffer<KeyType>, Buffer<KeyType>, Buffer<ValueType>, Buffer<ValueType>, uint>;
+        // d_keys, d_merge_partitions, num_items, num_partitions, target_merged_tiles
+        using MergePartitionKernel = Shader<1, Buffer<KeyType>, Buffer<uint>, uint, uint, uint>;
+        // d_keys_in, d_keys_out, d_values_in, d_values_out, d_merge_partitions, num_items, target_merged_tiles
+        using MergeKernel =
+            Shader<1, Buffer<KeyType>, Buffer<KeyType>, Buffer<ValueType>, Buffer<ValueType>, Buffer<uint>, uint, uint>;
+
+        template <typename CompareOp>
+        U<BlockSortKernel> compile_block_sort(Device& device, CompareOp compare_op)
+        {
+            U<BlockSortKernel> ms_block_sort_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_block_sort_shader,
+                         [&](BufferVar<KeyType>   d_keys_in,
+                             BufferVar<KeyType>   d_keys_out,
+                             BufferVar<ValueType> d_values_in,
+                             BufferVar<ValueType> d_values_out,
+                             UInt                 num_items) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             using AgentT = AgentBlockSort<KeyType, ValueType, KEY_ONLY, CompareOp, BLOCK_SIZE, ITEMS_PER_THREAD>;
+                             AgentT(d_keys_in, d_keys_out, d_values_in, d_values_out, compare_op, num_items).ConsumeTile();
+                         });
+
+            return ms_block_sort_shader;
+        }
+
+        template <typename CompareOp>
+        U<MergePartitionKernel> compile_merge_partition(Device& device, CompareOp compare_op)
+        {
+            U<MergePartitionKernel> ms_merge_partition_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_merge_partition_shader,
+                         [&](BufferVar<KeyType> d_keys,
+                             BufferVar<uint>    d_merge_partitions,
+                             UInt               num_items,
+                             UInt               num_partitions,
+                             UInt               target_merged_tiles) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             using AgentT = AgentMergePartition<KeyType, CompareOp, BLOCK_SIZE, ITEMS_PER_THREAD>;
+                             AgentT(d_keys, compare_op, num_items, target_merged_tiles).Partition(d_merge_partitions, num_partitions);
+                         });
+
+            return ms_merge_partition_shader;
+        }
+
+        template <typename CompareOp>
+        U<MergeKernel> compile_merge(Device& device, CompareOp compare_op)
+        {
+            U<MergeKernel> ms_merge_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_merge_shader,
+                         [&](BufferVar<KeyType>   d_keys_in,
+                             BufferVar<KeyType>   d_keys_out,
+                             BufferVar<ValueType> d_values_in,
+                             BufferVar<ValueType> d_values_out,
+                             BufferVar<uint>      d_merge_partitions,
+                             UInt                 num_items,
+                             UInt                 target_merged_tiles) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             using AgentT = AgentMerge<KeyType, ValueType, KEY_ONLY, CompareOp, BLOCK_SIZE, ITEMS_PER_THREAD>;
+                             AgentT(d_keys_in, d_keys_out, d_values_in, d_values_out, d_merge_partitions, compare_op, num_items, target_merged_tiles)
+                                 .ConsumeTile();
+                         });
+
+            return ms_merge_shader;
+        }
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,107 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-17 11:06:40
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-24 13:47:05
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/agent/agent_radix_select.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    template <NumericT KeyType, typename ValueType, bool KEYS_ONLY, bool SELECT_MAX, size_t RADIX_BITS = 8u, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_SIZE = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    class RadixSelectModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<KeyType, ValueType>(
+                "RadixSelectModule", KEYS_ONLY, SELECT_MAX, RADIX_BITS, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD);
+        }
+
+        using AgentT = AgentRadixSelect<KeyType, ValueType, KEYS_ONLY, SELECT_MAX, RADIX_BITS, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD>;
+
+        // d_keys_in, d_bins, d_prefix, num_items, current_bit, num_bits
+        using HistogramKernel = Shader<1, ByteBuffer, Buffer<uint>, ByteBuffer, uint, uint, uint>;
+        // d_bins, d_state, d_prefix, current_bit
+        using SelectDigitKernel = Shader<1, Buffer<uint>, Buffer<uint>, ByteBuffer, uint>;
+        // d_keys_in, d_values_in, d_keys_out, d_values_out, d_state, d_prefix, num_items, k
+        using CompactKernel =
+            Shader<1, ByteBuffer, Buffer<ValueType>, ByteBuffer, Buffer<ValueType>, Buffer<uint>, ByteBuffer, uint, uint>;
+
+        U<HistogramKernel> compile_histogram(Device& device)
+        {
+            U<HistogramKernel> ms_histogram_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_histogram_shader,
+                         [&](ByteBufferVar   d_keys_in,
+                             BufferVar<uint> d_bins,
+                             ByteBufferVar   d_prefix,
+                             UInt            num_items,
+                             UInt            current_bit,
+                             UInt            num_bits) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             set_warp_size(WARP_SIZE);
+                             AgentT(d_keys_in, num_items).Histogram(d_bins, d_prefix, current_bit, num_bits);
+                         });
+
+            return ms_histogram_shader;
+        }
+
+        U<SelectDigitKernel> compile_select_digit(Device& device)
+        {
+            U<SelectDigitKernel> ms_select_digit_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_select_digit_shader,
+                         [&](BufferVar<uint> d_bins, BufferVar<uint> d_state, ByteBufferVar d_prefix, UInt current_bit) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             set_warp_size(WARP_SIZE);
+                             AgentT::SelectDigit(d_bins, d_state, d_prefix, current_bit);
+                         });
+
+            return ms_select_digit_shader;
+        }
+
+        U<CompactKernel> compile_compact(Device& device)
+        {
+            U<CompactKernel> ms_compact_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_compact_shader,
+                         [&](ByteBufferVar        d_keys_in,
+                             BufferVar<ValueType> d_values_in,
+                             ByteBufferVar        d_keys_out,
+                             BufferVar<ValueType> d_values_out,
+                             BufferVar<uint>      d_state,
+                             ByteBufferVar        d_prefix,
+                             UInt                 num_items,
+                             UInt                 k) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             set_warp_size(WARP_SIZE);
+                             AgentT(d_keys_in, num_items).Compact(d_values_in, d_keys_out, d_values_out, d_state, d_prefix, k);
+                         });
+
+            return ms_compact_shader;
+        }
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -2,12 +2,13 @@
  * @Author: Ligo 
  * @Date: 2025-11-12 14:58:11 
  * @Last Modified by: Ligo
- * @Last Modified time: 2026-02-06 09:59:23
+ * @Last Modified time: 2026-02-24 13:47:05
  */
 
 
 #pragma once
 #include <cstddef>
+#include <tuple>
 #include <luisa/dsl/sugar.h>
 #include <luisa/dsl/func.h>
 #include <luisa/dsl/var.h>
@@ -23,6 +24,8 @@
 #include <lcpp/common/thread_operators.h>
 #include <lcpp/common/type_trait.h>
 #include <lcpp/runtime/core.h>
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
 #include <lcpp/block/block_scan.h>
 
 namespace luisa::parallel_primitive
@@ -34,6 +37,11 @@ namespace details
     class RadixSortResetModule : public LuisaModule
     {
       public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<KeyType>("RadixSortResetModule");
+        }
+
         using RadixSortResetKernel = Shader<1, Buffer<KeyType>, KeyType>;
 
         U<RadixSortResetKernel> compile(Device& device)
@@ -53,6 +61,12 @@ namespace details
     class RadixSortHistogramModule : public LuisaModule
     {
       public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<KeyType>(
+                "RadixSortHistogramModule", IS_DESCENDING, RADIX_BIT, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD);
+        }
+
         using RadixSortHistogramKernel = Shader<1, Buffer<uint>, ByteBuffer, uint, uint, uint>;
 
         U<RadixSortHistogramKernel> compile(Device& device)
@@ -83,6 +97,11 @@ namespace details
     class RadixSortExclusiveSumModule : public LuisaModule
     {
       public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name("RadixSortExclusiveSumModule", RADIX_DIGIT, BLOCK_SIZE, WARP_SIZE);
+        }
+
         using RadixSortExclusiveSumKernel = Shader<1, Buffer<uint>>;
 
         U<RadixSortExclusiveSumKernel> compile(Device& device)
@@ -123,15 +142,30 @@ namespace details
     };
 
 
-    template <NumericT KeyType, typename ValueType, bool KEY_ONLY, bool IS_DESCENDING, size_t RADIX_BIT = 8u, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_SIZE = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    /// ValuesInIt is the iterator the values are read from, a BufferIterator for every pass but
+    /// the first one of a SortPairs over fancy values
+    template <NumericT KeyType, typename ValueType, bool KEY_ONLY, bool IS_DESCENDING, size_t RADIX_BIT = 8u, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_SIZE = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, IteratorT ValuesInIt = BufferIterator<ValueType>>
     class RadixSortOneSweepModule : public LuisaModule
     {
       public:
-        // key value pair
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<KeyType, ValueType, ValuesInIt>(
+                "RadixSortOneSweepModule", KEY_ONLY, IS_DESCENDING, RADIX_BIT, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD);
+        }
+
+        // key value pair, the arguments of ValuesInIt trail the fixed ones
         using RadixSortOneSweepKernel =
-            Shader<1, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, ByteBuffer, ByteBuffer, Buffer<ValueType>, Buffer<ValueType>, uint, uint, uint>;
+            shader_with_args_t<typename ValuesInIt::kernel_args, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, ByteBuffer, ByteBuffer, Buffer<ValueType>, uint, uint, uint>;
+
+        U<RadixSortOneSweepKernel> compile(Device& device, const ValuesInIt& d_values_in_it)
+        {
+            return compile(device, d_values_in_it, kernel_args_tag<typename ValuesInIt::kernel_args>());
+        }
 
-        U<RadixSortOneSweepKernel> compile(Device& device)
+      private:
+        template <typename... ValuesArgs>
+        U<RadixSortOneSweepKernel> compile(Device& device, const ValuesInIt& d_values_in_it, std::tuple<ValuesArgs...>*)
         {
             U<RadixSortOneSweepKernel> ms_radix_sort_onesweep_kernel = nullptr;
             lazy_compile(
@@ -143,18 +177,19 @@ namespace details
                     BufferVar<uint>      d_bins_out,
                     ByteBufferVar        d_keys_in,
                     ByteBufferVar        d_keys_out,
-                    BufferVar<ValueType> d_values_in,
                     BufferVar<ValueType> d_values_out,
                     compute::UInt        num_items,
                     compute::UInt        current_bit,
-                    compute::UInt        num_bits) noexcept
+                    compute::UInt        num_bits,
+                    Var<ValuesArgs>... values_args) noexcept
                 {
                     set_block_size(BLOCK_SIZE);
                     set_warp_size(WARP_SIZE);
+                    auto d_values_in = d_values_in_it.make_device(std::forward_as_tuple(values_args...));
 
                     using RadixSortOneSweepPolicy = AgentRadixSortOneSweepPolicy<1u, 8u, KeyType, 1u, RADIX_BIT>;
                     using AgentT =
-                        AgentRadixSortOneSweep<KeyType, ValueType, KEY_ONLY, RADIX_BIT, RadixSortOneSweepPolicy::RANK_NUM_PARTS, IS_DESCENDING, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD>;
+                        AgentRadixSortOneSweep<KeyType, ValueType, KEY_ONLY, RADIX_BIT, RadixSortOneSweepPolicy::RANK_NUM_PARTS, IS_DESCENDING, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD, typename ValuesInIt::DeviceIterator>;
 
                     AgentT agent(
                         d_lookback, d_ctrs, d_bins_in, d_bins_out, d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, current_bit, num_bits);
@@ -2,13 +2,14 @@
  * @Author: Ligo 
  * @Date: 2025-10-21 23:03:40 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-07 14:37:09
+ * @Last Modified time: 2026-02-24 13:47:05
  */
 
 #pragma once
 #include "lcpp/agent/agent_reduce.h"
 #include "lcpp/common/grid_even_shared.h"
 #include <cstddef>
+#include <tuple>
 #include <luisa/dsl/sugar.h>
 #include <luisa/dsl/func.h>
 #include <luisa/dsl/var.h>
@@ -17,6 +18,8 @@
 #include <lcpp/common/utils.h>
 #include <lcpp/common/thread_operators.h>
 #include <lcpp/common/type_trait.h>
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
 #include <lcpp/runtime/core.h>
 
 namespace luisa::parallel_primitive
@@ -25,55 +28,63 @@ namespace details
 {
     using namespace luisa::compute;
 
-    template <NumericT Type4Byte, size_t BLOCK_SIZE = details::BLOCK_SIZE>
+    /// Splits the reduced IndexValuePairT into its value and index, either output may be a
+    /// DiscardOutput; the pairs themselves are read through a ZipIterator and never stored
+    template <NumericT Type4Byte, size_t BLOCK_SIZE = details::BLOCK_SIZE, IteratorT ValueOutIt = BufferIterator<Type4Byte>, IteratorT IndexOutIt = BufferIterator<uint>>
     class ArgReduce : public LuisaModule
     {
       public:
-        using ArgConstructShaderT = Shader<1, Buffer<Type4Byte>, Buffer<IndexValuePairT<Type4Byte>>>;
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<Type4Byte, ValueOutIt, IndexOutIt>("ArgReduce", BLOCK_SIZE);
+        }
 
         using ArgAssignShaderT =
-            Shader<1, Buffer<IndexValuePairT<Type4Byte>>, Buffer<Type4Byte>, Buffer<uint>>;
+            shader_with_args_t<tuple_cat_t<typename ValueOutIt::kernel_args, typename IndexOutIt::kernel_args>, Buffer<IndexValuePairT<Type4Byte>>>;
 
-        U<ArgConstructShaderT> compile_arg_construct_shader(Device& device)
+        U<ArgAssignShaderT> compile_arg_assign_shader(Device& device, const ValueOutIt& value_out, const IndexOutIt& index_out)
         {
-            U<ArgConstructShaderT> ms_arg_construct_shader = nullptr;
-            lazy_compile(device,
-                         ms_arg_construct_shader,
-                         [&](BufferVar<Type4Byte> arr_in, BufferVar<IndexValuePairT<Type4Byte>> g_kv_out)
-                         {
-                             set_block_size(BLOCK_SIZE);
-                             Int global_id = dispatch_id().x;
-
-                             Var<IndexValuePairT<Type4Byte>> initial{0, 0};
-                             initial.key   = global_id;
-                             initial.value = arr_in.read(global_id);
-                             g_kv_out.write(global_id, initial);
-                         });
-            return ms_arg_construct_shader;
+            return compile_arg_assign_shader(
+                device,
+                value_out,
+                index_out,
+                kernel_args_tag<tuple_cat_t<typename ValueOutIt::kernel_args, typename IndexOutIt::kernel_args>>());
         }
 
-        U<ArgAssignShaderT> compile_arg_assign_shader(Device& device)
+      private:
+        template <typename... OutArgs>
+        U<ArgAssignShaderT> compile_arg_assign_shader(Device&              device,
+                                                      const ValueOutIt&    value_out,
+                                                      const IndexOutIt&    index_out,
+                                                      std::tuple<OutArgs...>*)
         {
+            constexpr size_t VALUE_ARGS = std::tuple_size_v<typename ValueOutIt::kernel_args>;
+            constexpr size_t INDEX_ARGS = std::tuple_size_v<typename IndexOutIt::kernel_args>;
+
             U<ArgAssignShaderT> ms_arg_assign_shader = nullptr;
             lazy_compile(device,
                          ms_arg_assign_shader,
-                         [&](BufferVar<IndexValuePairT<Type4Byte>> kvp_in,
-                             BufferVar<Type4Byte>                  value_out,
-                             BufferVar<uint>                       index_out)
+                         [&](BufferVar<IndexValuePairT<Type4Byte>> kvp_in, Var<OutArgs>... out_args)
                          {
                              set_block_size(BLOCK_SIZE);
                              UInt global_id = dispatch_id().x;
 
+                             auto args      = std::forward_as_tuple(out_args...);
+                             auto d_value   = value_out.make_device(tuple_slice<0, VALUE_ARGS>(args));
+                             auto d_index   = index_out.make_device(tuple_slice<VALUE_ARGS, INDEX_ARGS>(args));
+
                              Var<IndexValuePairT<Type4Byte>> kvp = kvp_in.read(global_id);
-                             index_out.write(global_id, kvp.key);
-                             value_out.write(global_id, kvp.value);
+                             d_index.write(global_id, kvp.key);
+                             d_value.write(global_id, kvp.value);
                          });
             return ms_arg_assign_shader;
         }
     };
 
 
-    template <NumericTOrKeyValuePairT DataType, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    /// DataType is the accumulator, the items come from the InputIt iterator (a BufferIterator for
+    /// plain buffers) and OutputT is written to d_out
+    template <NumericTOrKeyValuePairT DataType, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, IteratorT InputIt = BufferIterator<DataType>, typename OutputT = DataType>
     class ReduceModule : public LuisaModule
     {
         //   public:
@@ -181,23 +192,55 @@ namespace details
         //     }
 
       public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<DataType, InputIt, OutputT>("ReduceModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
         template <typename ReduceOp, typename TransformOp>
-        using AgentReduceT =
-            AgentReduce<DataType, ReduceOp, TransformOp, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE>;
+        using AgentReduceT = AgentReduce<DataType, ReduceOp, TransformOp, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE, BlockReduceAlgorithm::WARP_SHUFFLE, typename InputIt::DeviceIterator>;
 
-        using ReduceShaderKernel = Shader<1, Buffer<DataType>, Buffer<DataType>, uint, GridEvenShared>;
+        // the arguments of InputIt trail the fixed ones
+        using ReduceShaderKernel = shader_with_args_t<typename InputIt::kernel_args, Buffer<DataType>, uint, GridEvenShared>;
 
-        using ReduceSingleTileShaderKernel = Shader<1, Buffer<DataType>, Buffer<DataType>, uint, DataType>;
+        using ReduceSingleTileShaderKernel = shader_with_args_t<typename InputIt::kernel_args, Buffer<OutputT>, uint, DataType>;
 
         template <typename ReduceOp, typename TransformOp>
-        U<ReduceShaderKernel> compile(Device& device, size_t shared_mem_size, ReduceOp reduce_op, TransformOp transform_op)
+        U<ReduceShaderKernel> compile(Device& device, size_t shared_mem_size, ReduceOp reduce_op, TransformOp transform_op, const InputIt& d_in_it)
+        {
+            return compile(device, shared_mem_size, reduce_op, transform_op, d_in_it, kernel_args_tag<typename InputIt::kernel_args>());
+        }
+
+        /// output_op maps the final DataType aggregate to the OutputT stored in d_out
+        template <typename ReduceOp, typename TransformOp, typename OutputOp = IdentityOp>
+        U<ReduceSingleTileShaderKernel> compile_single_tile(Device&        device,
+                                                            size_t         shared_mem_size,
+                                                            ReduceOp       reduce_op,
+                                                            TransformOp    transform_op,
+                                                            const InputIt& d_in_it,
+                                                            OutputOp       output_op = IdentityOp())
+        {
+            return compile_single_tile(
+                device, shared_mem_size, reduce_op, transform_op, d_in_it, output_op, kernel_args_tag<typename InputIt::kernel_args>());
+        }
+
+      private:
+        template <typename ReduceOp, typename TransformOp, typename... InArgs>
+        U<ReduceShaderKernel> compile(Device&        device,
+                                      size_t         shared_mem_size,
+                                      ReduceOp       reduce_op,
+                                      TransformOp    transform_op,
+                                      const InputIt& d_in_it,
+                                      std::tuple<InArgs...>*)
         {
             U<ReduceShaderKernel> ms_reduce_shader = nullptr;
             lazy_compile(device,
                          ms_reduce_shader,
-                         [&](BufferVar<DataType> d_in, BufferVar<DataType> d_out, UInt num_items, Var<GridEvenShared> even_shared) noexcept
+                         [&](BufferVar<DataType> d_out, UInt num_items, Var<GridEvenShared> even_shared, Var<InArgs>... in_args) noexcept
                          {
                              set_block_size(BLOCK_SIZE);
+                             auto d_in = d_in_it.make_device(std::forward_as_tuple(in_args...));
+
                              SmemTypePtr<DataType> smem_data = new SmemType<DataType>{shared_mem_size};
                              Var<DataType> block_aggregate =
                                  AgentReduceT<ReduceOp, TransformOp>(smem_data, d_in, reduce_op, transform_op)
@@ -211,18 +254,23 @@ namespace details
             return ms_reduce_shader;
         };
 
-        template <typename ReduceOp, typename TransformOp>
-        U<ReduceSingleTileShaderKernel> compile_single_tile(Device&     device,
-                                                            size_t      shared_mem_size,
-                                                            ReduceOp    reduce_op,
-                                                            TransformOp transform_op)
+        template <typename ReduceOp, typename TransformOp, typename OutputOp, typename... InArgs>
+        U<ReduceSingleTileShaderKernel> compile_single_tile(Device&        device,
+                                                            size_t         shared_mem_size,
+                                                            ReduceOp       reduce_op,
+                                                            TransformOp    transform_op,
+                                                            const InputIt& d_in_it,
+                                                            OutputOp       output_op,
+                                                            std::tuple<InArgs...>*)
         {
             U<ReduceSingleTileShaderKernel> ms_reduce_single_tile_shader = nullptr;
             lazy_compile(device,
                          ms_reduce_single_tile_shader,
-                         [&](BufferVar<DataType> d_in, BufferVar<DataType> d_out, UInt num_items, Var<DataType> init) noexcept
+                         [&](BufferVar<OutputT> d_out, UInt num_items, Var<DataType> init, Var<InArgs>... in_args) noexcept
                          {
                              set_block_size(BLOCK_SIZE);
+                             auto d_in = d_in_it.make_device(std::forward_as_tuple(in_args...));
+
                              SmemTypePtr<DataType> smem_data = new SmemType<DataType>{shared_mem_size};
                              Var<DataType> block_aggregate =
                                  AgentReduceT<ReduceOp, TransformOp>(smem_data, d_in, reduce_op, transform_op)
@@ -230,7 +278,7 @@ namespace details
 
                              $if(thread_id().x == 0)
                              {
-                                 d_out.write(0, reduce_op(init, block_aggregate));
+                                 d_out.write(0, output_op(reduce_op(init, block_aggregate)));
                              };
                          });
             return ms_reduce_single_tile_shader;
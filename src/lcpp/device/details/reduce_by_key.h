@@ -2,7 +2,7 @@
  * @Author: Ligo 
  * @Date: 2025-10-21 22:12:15 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-07 14:40:05
+ * @Last Modified time: 2026-03-05 16:31:40
  */
 
 #pragma once
@@ -29,10 +29,15 @@ namespace details
 {
     using namespace luisa::compute;
 
-    template <NumericT KeyType, NumericT ValueType, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    template <NumericT KeyType, NumericT ValueType, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
     class ReduceByKeyModule : public LuisaModule
     {
       public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<KeyType, ValueType, DelayPolicy>("ReduceByKeyModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
         using FlagValuePairT = KeyValuePair<int, ValueType>;
 
         using TileStatusViewer = ScanTileStateViewer<FlagValuePairT>;
@@ -40,7 +45,7 @@ namespace details
         using ScanTileStateInitKernel =
             Shader<1, Buffer<uint>, uint>;
         using ReduceByKeyKernel =
-            Shader<1, Buffer<uint>, Buffer<FlagValuePairT>, Buffer<FlagValuePairT>, Buffer<KeyType>, Buffer<ValueType>, Buffer<KeyType>, Buffer<ValueType>, Buffer<uint>, uint>;
+            Shader<1, Buffer<uint>, Buffer<FlagValuePairT>, Buffer<FlagValuePairT>, Buffer<KeyType>, Buffer<ValueType>, Buffer<KeyType>, Buffer<ValueType>, Buffer<uint>, uint, uint>;
 
         U<ScanTileStateInitKernel> compile_scan_tile_state_init(Device& device)
         {
@@ -63,7 +68,10 @@ namespace details
         {
             ReduceBySegmentOp scan_op{reduce_op};
 
-            using TilePrefixOpT = TilePrefixCallbackOp<FlagValuePairT, ReduceBySegmentOp<ReduceOp>>;
+            using TilePrefixOpT = TilePrefixCallbackOp<FlagValuePairT,
+                                                       ReduceBySegmentOp<ReduceOp>,
+                                                       TileStatusViewer,
+                                                       typename DelayPolicy::template constructor<FlagValuePairT>>;
 
             auto scatter = [&](const ArrayVar<FlagValuePairT, ITEMS_PER_THREAD> scatter_items,
                                const ArrayVar<int, ITEMS_PER_THREAD>            segment_flags,
@@ -130,7 +138,8 @@ namespace details
                     BufferVar<KeyType>        unique_out,
                     BufferVar<ValueType>      aggregated_out,
                     BufferVar<uint>           num_runs_out,
-                    UInt                      num_item) noexcept
+                    UInt                      num_item,
+                    UInt                      epoch) noexcept
                 {
                     set_block_size(BLOCK_SIZE);
                     UInt thid       = thread_id().x;
@@ -141,7 +150,7 @@ namespace details
                     UInt num_remaining = num_item - tile_start;
                     Bool is_last_tile  = num_remaining <= tile_items;
 
-                    TileStatusViewer tile_state_viewer(tile_state, tile_partial, tile_inclusive);
+                    TileStatusViewer tile_state_viewer(tile_state, tile_partial, tile_inclusive, epoch);
 
                     SmemTypePtr<KeyType>   s_keys   = new SmemType<KeyType>{shared_mem_size};
                     SmemTypePtr<ValueType> s_values = new SmemType<ValueType>{shared_mem_size};
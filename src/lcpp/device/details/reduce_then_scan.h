@@ -0,0 +1,204 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-03-03 09:41:15
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-03 16:08:52
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
+#include <lcpp/thread/thread_reduce.h>
+#include <lcpp/block/block_reduce.h>
+#include <lcpp/block/block_scan.h>
+#include <lcpp/block/block_load.h>
+#include <lcpp/block/block_store.h>
+
+namespace luisa::parallel_primitive
+{
+/// How DeviceScan carries the prefix of a tile to the next ones
+enum class ScanAlgorithm : uint
+{
+    AUTO,                 // decoupled look-back on backends with forward progress, reduce-then-scan elsewhere
+    DECOUPLED_LOOK_BACK,  // one pass, tiles wait for the prefixes their predecessors publish
+    REDUCE_THEN_SCAN,     // tile totals, their scan, then every tile on top of its prefix; no tile waits
+};
+
+namespace details
+{
+    using namespace luisa::compute;
+
+    /// Whether the blocks of a dispatch on backend_name run concurrently enough for a block to
+    /// spin until an earlier one publishes. CPU executors run blocks in any order on a few threads,
+    /// Apple GPUs make no forward progress promise either
+    inline bool backend_has_forward_progress(luisa::string_view backend_name) noexcept
+    {
+        return backend_name != "cpu" && backend_name != "fallback" && backend_name != "metal";
+    }
+
+    /// Tile totals of every level of a reduce-then-scan over num_items: each level scans the
+    /// totals of the one below until they fit in one tile
+    inline size_t reduce_then_scan_partial_count(size_t num_items, size_t tile_items)
+    {
+        size_t count = 0;
+        while(num_items > tile_items)
+        {
+            num_items = ceil_div(num_items, tile_items);
+            count += num_items;
+        }
+        return std::max<size_t>(1, count);
+    }
+
+    /// Type4Byte is the accumulator of the tile totals and the block scan, the items of InputIt
+    /// are widened to it by the tile load and the prefixes narrowed to OutputT by the tile store
+    template <NumericT Type4Byte, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, IteratorT InputIt = BufferIterator<Type4Byte>, NumericT OutputT = Type4Byte>
+    class ReduceThenScanModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<Type4Byte, InputIt, OutputT>("ReduceThenScanModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
+        // the arguments of InputIt trail the fixed ones
+        // d_tile_totals, num_items
+        using UpsweepKernel = shader_with_args_t<typename InputIt::kernel_args, Buffer<Type4Byte>, uint>;
+        // d_out, d_tile_prefix (the exclusive scan of the tile totals), init_value, num_items, use_prefix
+        using DownsweepKernel =
+            shader_with_args_t<typename InputIt::kernel_args, Buffer<OutputT>, Buffer<Type4Byte>, Type4Byte, uint, uint>;
+
+        template <typename ScanOp>
+        U<UpsweepKernel> compile_upsweep(Device& device, size_t shared_mem_size, ScanOp scan_op, const InputIt& d_in_it)
+        {
+            return compile_upsweep(device, shared_mem_size, scan_op, d_in_it, kernel_args_tag<typename InputIt::kernel_args>());
+        }
+
+        template <bool is_inclusive, typename ScanOp>
+        U<DownsweepKernel> compile_downsweep(Device& device, size_t shared_mem_size, ScanOp scan_op, const InputIt& d_in_it)
+        {
+            return compile_downsweep<is_inclusive>(
+                device, shared_mem_size, scan_op, d_in_it, kernel_args_tag<typename InputIt::kernel_args>());
+        }
+
+      private:
+        template <typename ScanOp, typename... InArgs>
+        U<UpsweepKernel> compile_upsweep(Device& device, size_t shared_mem_size, ScanOp scan_op, const InputIt& d_in_it, std::tuple<InArgs...>*)
+        {
+            U<UpsweepKernel> upsweep_shader = nullptr;
+            lazy_compile(device,
+                         upsweep_shader,
+                         [&](BufferVar<Type4Byte> d_tile_totals, UInt num_elements, Var<InArgs>... in_args)
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             auto d_in          = d_in_it.make_device(std::forward_as_tuple(in_args...));
+                             UInt tile_id       = block_id().x;
+                             UInt tile_items    = UInt(ITEMS_PER_THREAD) * block_size_x();
+                             UInt tile_start    = tile_id * tile_items;
+                             UInt num_remaining = num_elements - tile_start;
+
+                             // the total of the last tile is never a prefix, its padding does not matter
+                             ArrayVar<Type4Byte, ITEMS_PER_THREAD> items;
+                             SmemTypePtr<Type4Byte> s_data = new SmemType<Type4Byte>{shared_mem_size};
+                             $if(num_remaining < tile_items)
+                             {
+                                 BlockLoad<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Load(
+                                     d_in, items, tile_start, num_remaining);
+                             }
+                             $else
+                             {
+                                 BlockLoad<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Load(d_in, items, tile_start);
+                             };
+                             sync_block();
+
+                             Var<Type4Byte> thread_total = ThreadReduce<Type4Byte, ITEMS_PER_THREAD>().Reduce(items, scan_op);
+                             Var<Type4Byte> tile_total   = BlockReduce<Type4Byte, BLOCK_SIZE>().Reduce(thread_total, scan_op);
+                             $if(thread_id().x == 0)
+                             {
+                                 d_tile_totals.write(tile_id, tile_total);
+                             };
+                         });
+            return upsweep_shader;
+        }
+
+        template <bool is_inclusive, typename ScanOp, typename... InArgs>
+        U<DownsweepKernel> compile_downsweep(Device& device, size_t shared_mem_size, ScanOp scan_op, const InputIt& d_in_it, std::tuple<InArgs...>*)
+        {
+            U<DownsweepKernel> downsweep_shader = nullptr;
+            lazy_compile(
+                device,
+                downsweep_shader,
+                [&](BufferVar<OutputT>   d_out,
+                    BufferVar<Type4Byte> d_tile_prefix,
+                    Var<Type4Byte>       init_value,
+                    UInt                 num_elements,
+                    UInt                 use_prefix,
+                    Var<InArgs>... in_args)
+                {
+                    set_block_size(BLOCK_SIZE);
+                    auto d_in          = d_in_it.make_device(std::forward_as_tuple(in_args...));
+                    UInt tile_id       = block_id().x;
+                    UInt tile_items    = UInt(ITEMS_PER_THREAD) * block_size_x();
+                    UInt tile_start    = tile_id * tile_items;
+                    UInt num_remaining = num_elements - tile_start;
+                    Bool is_last_tile  = num_remaining <= tile_items;
+
+                    // init_value is already folded into the scanned tile totals
+                    Var<Type4Byte> tile_prefix = init_value;
+                    $if(use_prefix != 0u)
+                    {
+                        tile_prefix = d_tile_prefix.read(tile_id);
+                    };
+
+                    ArrayVar<Type4Byte, ITEMS_PER_THREAD> items;
+                    SmemTypePtr<Type4Byte> s_data = new SmemType<Type4Byte>{shared_mem_size};
+                    $if(is_last_tile)
+                    {
+                        BlockLoad<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Load(
+                            d_in, items, tile_start, num_remaining);
+                    }
+                    $else
+                    {
+                        BlockLoad<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Load(d_in, items, tile_start);
+                    };
+                    sync_block();
+
+                    ArrayVar<Type4Byte, ITEMS_PER_THREAD>              output_items;
+                    Var<Type4Byte>                                     block_aggregate;
+                    BlockScan<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD> block_scan;
+                    if constexpr(is_inclusive)
+                    {
+                        block_scan.InclusiveScan(items, output_items, block_aggregate, scan_op, tile_prefix);
+                    }
+                    else
+                    {
+                        block_scan.ExclusiveScan(items, output_items, block_aggregate, scan_op, tile_prefix);
+                    }
+
+                    sync_block();
+                    $if(is_last_tile)
+                    {
+                        BlockStore<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Store(
+                            output_items, d_out, tile_start, num_remaining);
+                    }
+                    $else
+                    {
+                        BlockStore<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Store(output_items, d_out, tile_start);
+                    };
+                });
+            return downsweep_shader;
+        }
+    };
+}  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,98 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-14 11:02:57
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-05 16:31:40
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/agent/agent_rle.h>
+#include <lcpp/device/details/single_pass_scan_operator.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    template <NumericT KeyType, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
+    class RunLengthEncodeModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<KeyType, DelayPolicy>("RunLengthEncodeModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
+        using RunPairT         = KeyValuePair<uint, uint>;
+        using TileStatusViewer = ScanTileStateViewer<RunPairT>;
+
+        using ScanTileStateInitKernel = Shader<1, Buffer<uint>, uint>;
+        // tile_status, tile_partial, tile_inclusive, d_in, d_unique_out, d_offsets_out, d_lengths_out, d_num_runs_out, num_items
+        using RunLengthEncodeKernel = Shader<1,
+                                             Buffer<uint>,
+                                             Buffer<RunPairT>,
+                                             Buffer<RunPairT>,
+                                             Buffer<KeyType>,
+                                             Buffer<KeyType>,
+                                             Buffer<uint>,
+                                             Buffer<uint>,
+                                             Buffer<uint>,
+                                             uint>;
+
+        U<ScanTileStateInitKernel> compile_scan_tile_state_init(Device& device)
+        {
+            U<ScanTileStateInitKernel> ms_scan_tile_state_init_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_scan_tile_state_init_shader,
+                         [](BufferVar<uint> tile_state, UInt num_tiles) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             InitializeWardStatus(num_tiles, tile_state);
+                         });
+
+            return ms_scan_tile_state_init_shader;
+        }
+
+        /// MODE == Encode writes d_unique_out and ignores d_offsets_out, NonTrivialRuns the other way round
+        template <RleMode MODE, typename EqualityOpT>
+        U<RunLengthEncodeKernel> compile(Device& device, EqualityOpT equality_op)
+        {
+            U<RunLengthEncodeKernel> ms_rle_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_rle_shader,
+                         [&](BufferVar<uint>     tile_status,
+                             BufferVar<RunPairT> tile_partial,
+                             BufferVar<RunPairT> tile_inclusive,
+                             BufferVar<KeyType>  d_in,
+                             BufferVar<KeyType>  d_unique_out,
+                             BufferVar<uint>     d_offsets_out,
+                             BufferVar<uint>     d_lengths_out,
+                             BufferVar<uint>     d_num_runs_out,
+                             UInt                num_items) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             using AgentT = AgentRle<KeyType, MODE, EqualityOpT, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
+
+                             TileStatusViewer tile_state(tile_status, tile_partial, tile_inclusive);
+                             AgentT(tile_state, d_in, d_unique_out, d_offsets_out, d_lengths_out, equality_op, num_items)
+                                 .ConsumeTile(d_num_runs_out);
+                         });
+
+            return ms_rle_shader;
+        }
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -2,11 +2,13 @@
  * @Author: Ligo 
  * @Date: 2025-10-21 23:03:40 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-06 16:33:11
+ * @Last Modified time: 2026-03-02 14:26:41
  */
 
 #pragma once
 #include <cstddef>
+#include <tuple>
+#include <type_traits>
 #include <luisa/dsl/sugar.h>
 #include <luisa/dsl/func.h>
 #include <luisa/dsl/var.h>
@@ -16,6 +18,8 @@
 #include <lcpp/common/thread_operators.h>
 #include <lcpp/common/type_trait.h>
 #include <lcpp/runtime/core.h>
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
 #include <lcpp/block/block_scan.h>
 #include <lcpp/block/block_load.h>
 #include <lcpp/block/block_store.h>
@@ -27,123 +31,205 @@ namespace details
 {
     using namespace luisa::compute;
 
-    template <NumericT Type4Byte, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    /// Type4Byte is the accumulator held by the tile states and the block scan, the items of the
+    /// InputIt iterator are widened to it by the tile load and the prefixes narrowed to OutputT by
+    /// the tile store. DelayPolicy paces the look-back polls of the tiles
+    template <NumericT Type4Byte, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, IteratorT InputIt = BufferIterator<Type4Byte>, NumericT OutputT = Type4Byte, typename DelayPolicy = NoDelayPolicy>
     class ScanModule : public LuisaModule
     {
       public:
-        using TileStateViewer = ScanTileStateViewer<Type4Byte>;
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<Type4Byte, InputIt, OutputT, DelayPolicy>("ScanModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
+        /// 4-byte accumulators publish a packed status and value descriptor per tile, the
+        /// others a status word and a value in tile_partial or tile_inclusive
+        static constexpr bool PACKED_TILE_STATE = is_packed_tile_state_v<Type4Byte>;
+
+        using TileStateViewer =
+            std::conditional_t<PACKED_TILE_STATE, ScanTilePackedStateViewer<Type4Byte>, ScanTileStateViewer<Type4Byte>>;
+        using TileWordT = std::conditional_t<PACKED_TILE_STATE, ulong, uint>;
 
-        using ScanTileStateInitKernel = Shader<1, Buffer<uint>, Buffer<Type4Byte>, Buffer<Type4Byte>, uint>;
+        using ScanTileStateInitKernel =
+            std::conditional_t<PACKED_TILE_STATE, Shader<1, Buffer<ulong>, uint>, Shader<1, Buffer<uint>, Buffer<Type4Byte>, Buffer<Type4Byte>, uint>>;
 
-        using ScanKernel =
-            Shader<1, Buffer<uint>, Buffer<Type4Byte>, Buffer<Type4Byte>, Buffer<Type4Byte>, Buffer<Type4Byte>, Type4Byte, uint>;
+        // the arguments of InputIt trail the fixed ones; epoch tags the tile status words, 0 when
+        // they were initialized for this call
+        using ScanKernel = std::conditional_t<
+            PACKED_TILE_STATE,
+            shader_with_args_t<typename InputIt::kernel_args, Buffer<ulong>, Buffer<OutputT>, Type4Byte, uint, uint>,
+            shader_with_args_t<typename InputIt::kernel_args, Buffer<uint>, Buffer<Type4Byte>, Buffer<Type4Byte>, Buffer<OutputT>, Type4Byte, uint, uint>>;
 
         template <typename ScanOP>
-        using TilePrefixOpT = TilePrefixCallbackOp<Type4Byte, ScanOP>;
+        using TilePrefixOpT =
+            TilePrefixCallbackOp<Type4Byte, ScanOP, TileStateViewer, typename DelayPolicy::template constructor<Type4Byte>>;
 
         U<ScanTileStateInitKernel> compile_scan_tile_state_init(Device& device)
         {
             U<ScanTileStateInitKernel> scan_tile_state_init_shader = nullptr;
-            lazy_compile(device,
-                         scan_tile_state_init_shader,
-                         [](BufferVar<uint>      tile_status,
-                            BufferVar<Type4Byte> tile_partial,
-                            BufferVar<Type4Byte> tile_inclusive,
-                            UInt                 num_tiles) noexcept
-                         {
-                             InitializeWardStatus(num_tiles, tile_status);
-                         });
+            if constexpr(PACKED_TILE_STATE)
+            {
+                lazy_compile(device,
+                             scan_tile_state_init_shader,
+                             [](BufferVar<ulong> tile_descriptor, UInt num_tiles) noexcept
+                             {
+                                 InitializeWardStatus(num_tiles, tile_descriptor);
+                             });
+            }
+            else
+            {
+                lazy_compile(device,
+                             scan_tile_state_init_shader,
+                             [](BufferVar<uint>      tile_status,
+                                BufferVar<Type4Byte> tile_partial,
+                                BufferVar<Type4Byte> tile_inclusive,
+                                UInt                 num_tiles) noexcept
+                             {
+                                 InitializeWardStatus(num_tiles, tile_status);
+                             });
+            }
             return scan_tile_state_init_shader;
         }
 
         template <bool is_inclusive, typename ScanOp>
-        U<ScanKernel> compile(Device& device, size_t shared_mem_size, ScanOp scan_op)
+        U<ScanKernel> compile(Device& device, size_t shared_mem_size, ScanOp scan_op, const InputIt& d_in_it)
+        {
+            return compile<is_inclusive>(device, shared_mem_size, scan_op, d_in_it, kernel_args_tag<typename InputIt::kernel_args>());
+        }
+
+      private:
+        template <bool is_inclusive, typename ScanOp, typename... InArgs>
+        U<ScanKernel> compile(Device& device, size_t shared_mem_size, ScanOp scan_op, const InputIt& d_in_it, std::tuple<InArgs...>*)
         {
             U<ScanKernel> scan_shader = nullptr;
-            lazy_compile(
-                device,
-                scan_shader,
-                [&](BufferVar<uint>      tile_status,
-                    BufferVar<Type4Byte> tile_partial,
-                    BufferVar<Type4Byte> tile_inclusive,
-                    BufferVar<Type4Byte> d_in,
-                    BufferVar<Type4Byte> d_out,
-                    Var<Type4Byte>       init_value,
-                    UInt                 num_elements)
-                {
-                    set_block_size(BLOCK_SIZE);
-                    UInt thid       = thread_id().x;
-                    UInt tile_id    = block_id().x;
-                    UInt tile_items = UInt(ITEMS_PER_THREAD) * block_size_x();
-                    UInt tile_start = tile_id * tile_items;
+            if constexpr(PACKED_TILE_STATE)
+            {
+                lazy_compile(
+                    device,
+                    scan_shader,
+                    [&](BufferVar<ulong>   tile_descriptor,
+                        BufferVar<OutputT> d_out,
+                        Var<Type4Byte>     init_value,
+                        UInt               num_elements,
+                        UInt               epoch,
+                        Var<InArgs>... in_args)
+                    {
+                        TileStateViewer tile_state_viewer(tile_descriptor, epoch);
+                        scan_tile<is_inclusive>(tile_state_viewer,
+                                                d_in_it.make_device(std::forward_as_tuple(in_args...)),
+                                                d_out,
+                                                init_value,
+                                                num_elements,
+                                                shared_mem_size,
+                                                scan_op);
+                    });
+            }
+            else
+            {
+                lazy_compile(
+                    device,
+                    scan_shader,
+                    [&](BufferVar<uint>      tile_status,
+                        BufferVar<Type4Byte> tile_partial,
+                        BufferVar<Type4Byte> tile_inclusive,
+                        BufferVar<OutputT>   d_out,
+                        Var<Type4Byte>       init_value,
+                        UInt                 num_elements,
+                        UInt                 epoch,
+                        Var<InArgs>... in_args)
+                    {
+                        TileStateViewer tile_state_viewer(tile_status, tile_partial, tile_inclusive, epoch);
+                        scan_tile<is_inclusive>(tile_state_viewer,
+                                                d_in_it.make_device(std::forward_as_tuple(in_args...)),
+                                                d_out,
+                                                init_value,
+                                                num_elements,
+                                                shared_mem_size,
+                                                scan_op);
+                    });
+            }
+            return scan_shader;
+        }
 
-                    UInt num_remaining = num_elements - tile_start;
-                    Bool is_last_tile  = num_remaining <= tile_items;
+        // one tile of the scan kernel, whichever tile state layout it publishes to
+        template <bool is_inclusive, typename DeviceIt, typename ScanOp>
+        static void scan_tile(TileStateViewer&    tile_state_viewer,
+                              DeviceIt            d_in,
+                              BufferVar<OutputT>& d_out,
+                              Var<Type4Byte>&     init_value,
+                              UInt&               num_elements,
+                              size_t              shared_mem_size,
+                              ScanOp              scan_op)
+        {
+            set_block_size(BLOCK_SIZE);
+            UInt thid       = thread_id().x;
+            UInt tile_id    = block_id().x;
+            UInt tile_items = UInt(ITEMS_PER_THREAD) * block_size_x();
+            UInt tile_start = tile_id * tile_items;
 
-                    TileStateViewer tile_state_viewer(tile_status, tile_partial, tile_inclusive);
+            UInt num_remaining = num_elements - tile_start;
+            Bool is_last_tile  = num_remaining <= tile_items;
 
-                    ArrayVar<Type4Byte, ITEMS_PER_THREAD> items;
-                    SmemTypePtr<Type4Byte> s_data = new SmemType<Type4Byte>{shared_mem_size};
-                    $if(is_last_tile)
-                    {
-                        BlockLoad<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Load(
-                            d_in, items, tile_start, num_remaining);
-                    }
-                    $else
-                    {
-                        BlockLoad<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Load(d_in, items, tile_start);
-                    };
-                    sync_block();
+            ArrayVar<Type4Byte, ITEMS_PER_THREAD> items;
+            SmemTypePtr<Type4Byte> s_data = new SmemType<Type4Byte>{shared_mem_size};
+            $if(is_last_tile)
+            {
+                BlockLoad<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Load(
+                    d_in, items, tile_start, num_remaining);
+            }
+            $else
+            {
+                BlockLoad<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Load(d_in, items, tile_start);
+            };
+            sync_block();
 
-                    ArrayVar<Type4Byte, ITEMS_PER_THREAD> output_items;
-                    $if(tile_id == 0)
-                    {
-                        Var<Type4Byte>                                     block_aggregate;
-                        BlockScan<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD> block_scan;
-                        if constexpr(is_inclusive)
-                        {
-                            block_scan.InclusiveScan(items, output_items, block_aggregate, scan_op, init_value);
-                            block_aggregate = scan_op(block_aggregate, init_value);
-                        }
-                        else
-                        {
-                            block_scan.ExclusiveScan(items, output_items, block_aggregate, scan_op, init_value);
-                            block_aggregate = scan_op(block_aggregate, init_value);
-                        }
-                        $if(!is_last_tile & thread_id().x == 0)
-                        {
-                            // first tile
-                            tile_state_viewer.SetInclusive(0, block_aggregate);
-                        };
-                    }
-                    $else
-                    {
-                        auto temp_storage = new SmemType<TilePrefixTempStorage<Type4Byte>>{1};
-                        TilePrefixCallbackOp prefix_op(tile_state_viewer, temp_storage, scan_op, tile_id);
-                        BlockScan<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD> block_scan;
-                        if constexpr(is_inclusive)
-                        {
-                            block_scan.InclusiveScan(items, output_items, scan_op, prefix_op);
-                        }
-                        else
-                        {
-                            block_scan.ExclusiveScan(items, output_items, scan_op, prefix_op);
-                        }
-                    };
-
-                    sync_block();
-                    $if(is_last_tile)
-                    {
-                        BlockStore<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Store(
-                            output_items, d_out, tile_start, num_remaining);
-                    }
-                    $else
-                    {
-                        BlockStore<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Store(output_items, d_out, tile_start);
-                    };
-                });
+            ArrayVar<Type4Byte, ITEMS_PER_THREAD> output_items;
+            $if(tile_id == 0)
+            {
+                Var<Type4Byte>                                     block_aggregate;
+                BlockScan<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD> block_scan;
+                if constexpr(is_inclusive)
+                {
+                    block_scan.InclusiveScan(items, output_items, block_aggregate, scan_op, init_value);
+                    block_aggregate = scan_op(block_aggregate, init_value);
+                }
+                else
+                {
+                    block_scan.ExclusiveScan(items, output_items, block_aggregate, scan_op, init_value);
+                    block_aggregate = scan_op(block_aggregate, init_value);
+                }
+                $if(!is_last_tile & thread_id().x == 0)
+                {
+                    // first tile
+                    tile_state_viewer.SetInclusive(0, block_aggregate);
+                };
+            }
+            $else
+            {
+                auto temp_storage = new SmemType<TilePrefixTempStorage<Type4Byte>>{1};
+                TilePrefixOpT<ScanOp> prefix_op(tile_state_viewer, temp_storage, scan_op, tile_id);
+                BlockScan<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD> block_scan;
+                if constexpr(is_inclusive)
+                {
+                    block_scan.InclusiveScan(items, output_items, scan_op, prefix_op);
+                }
+                else
+                {
+                    block_scan.ExclusiveScan(items, output_items, scan_op, prefix_op);
+                }
+            };
 
-            return scan_shader;
+            sync_block();
+            $if(is_last_tile)
+            {
+                BlockStore<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Store(
+                    output_items, d_out, tile_start, num_remaining);
+            }
+            $else
+            {
+                BlockStore<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>(s_data).Store(output_items, d_out, tile_start);
+            };
         }
     };
 };  // namespace details
@@ -2,7 +2,7 @@
  * @Author: Ligo 
  * @Date: 2025-11-06 14:59:56 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-07 00:27:10
+ * @Last Modified time: 2026-03-06 10:12:37
  */
 
 #pragma once
@@ -31,19 +31,35 @@ namespace details
 {
     using namespace luisa::compute;
 
-    template <NumericT KeyType, NumericT ValueType, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    template <NumericT KeyType, NumericT ValueType, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
     class ScanByKeyModule : public LuisaModule
     {
       public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<KeyType, ValueType, DelayPolicy>("ScanByKeyModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
         using FlagValuePairT = KeyValuePair<int, ValueType>;
 
         using TileStatusViewer = ScanTileStateViewer<FlagValuePairT>;
 
-        using ScanTileStateInitKernel =
-            Shader<1, Buffer<uint>, Buffer<FlagValuePairT>, Buffer<FlagValuePairT>, Buffer<KeyType>, Buffer<KeyType>, int>;
+        using ScanTileStateInitKernel = Shader<1, Buffer<uint>, uint>;
 
+        static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+        // epoch tags the tile status words, 0 when they were initialized for this call
         using ScanByKeyKernel =
-            Shader<1, Buffer<uint>, Buffer<FlagValuePairT>, Buffer<FlagValuePairT>, Buffer<KeyType>, Buffer<KeyType>, Buffer<ValueType>, Buffer<ValueType>, ValueType, uint>;
+            Shader<1, Buffer<uint>, Buffer<FlagValuePairT>, Buffer<FlagValuePairT>, Buffer<KeyType>, Buffer<ValueType>, Buffer<ValueType>, ValueType, uint, uint>;
+
+        // reduce-then-scan, no tile waits on another
+        // d_keys_in, d_values_in, d_tile_totals, num_item
+        using UpsweepKernel = Shader<1, Buffer<KeyType>, Buffer<ValueType>, Buffer<FlagValuePairT>, uint>;
+        // d_tile_totals, num_tiles
+        using SpineKernel = Shader<1, Buffer<FlagValuePairT>, uint>;
+        // d_tile_prefix (the inclusive scan of the tile totals), d_keys_in, d_values_in, d_values_out, init_value, num_item
+        using DownsweepKernel =
+            Shader<1, Buffer<FlagValuePairT>, Buffer<KeyType>, Buffer<ValueType>, Buffer<ValueType>, ValueType, uint>;
 
 
         U<ScanTileStateInitKernel> compile_scan_tile_state_init(Device& device)
@@ -51,24 +67,10 @@ namespace details
             U<ScanTileStateInitKernel> ms_scan_tile_state_init_shader = nullptr;
             lazy_compile(device,
                          ms_scan_tile_state_init_shader,
-                         [](BufferVar<uint>           tile_state,
-                            BufferVar<FlagValuePairT> tile_partial,
-                            BufferVar<FlagValuePairT> tile_inclusive,
-                            BufferVar<KeyType>        d_keys_in,
-                            BufferVar<KeyType>        d_prev_keys_output,
-                            Int                       num_tiles) noexcept
+                         [](BufferVar<uint> tile_state, UInt num_tiles) noexcept
                          {
                              set_block_size(BLOCK_SIZE);
-
                              InitializeWardStatus(num_tiles, tile_state);
-                             UInt tid        = dispatch_id().x;
-                             UInt tile_items = UInt(ITEMS_PER_THREAD) * block_size_x();
-                             UInt tile_start = tid * tile_items;
-
-                             $if(tid > 0 & tid < num_tiles)
-                             {
-                                 d_prev_keys_output.write(tid, d_keys_in.read(tile_start - 1));
-                             };
                          });
 
             return ms_scan_tile_state_init_shader;
@@ -79,50 +81,10 @@ namespace details
         {
             ScanBySegmentOp<ScanOp> pair_scan_op{scan_op};
 
-            using TilePrefixOpT = TilePrefixCallbackOp<FlagValuePairT, ScanBySegmentOp<ScanOp>>;
-
-            Callable ZipValueAndFlags = [](UInt num_remaining,
-                                           const ArrayVar<ValueType, ITEMS_PER_THREAD>& values,
-                                           ArrayVar<int, ITEMS_PER_THREAD>& segment_flags,
-                                           ArrayVar<FlagValuePairT, ITEMS_PER_THREAD>& scan_items,
-                                           Bool is_last_tile) noexcept
-            {
-                for(auto item = 0; item < ITEMS_PER_THREAD; item++)
-                {
-                    $if(is_last_tile & (thread_id().x * UInt(ITEMS_PER_THREAD)) + item == num_remaining)
-                    {
-                        segment_flags[item] = 1;
-                    };
-                    scan_items[item].key   = segment_flags[item];
-                    scan_items[item].value = values[item];
-                }
-            };
-
-            Callable UnzipValues = [](ArrayVar<ValueType, ITEMS_PER_THREAD>& values,
-                                      const ArrayVar<FlagValuePairT, ITEMS_PER_THREAD>& scan_items) noexcept
-            {
-                for(auto item = 0; item < ITEMS_PER_THREAD; item++)
-                {
-                    values[item] = scan_items[item].value;
-                }
-            };
-
-            Callable AddInitToScan = [&](ArrayVar<ValueType, ITEMS_PER_THREAD>& scan_values,
-                                         const ArrayVar<int, ITEMS_PER_THREAD>& segment_flags,
-                                         const Var<ValueType>&                  init_value) noexcept
-            {
-                for(auto item = 0; item < ITEMS_PER_THREAD; item++)
-                {
-                    $if(segment_flags[item] == 1)
-                    {
-                        scan_values[item] = init_value;
-                    }
-                    $else
-                    {
-                        scan_values[item] = scan_op(scan_values[item], init_value);
-                    };
-                }
-            };
+            using TilePrefixOpT = TilePrefixCallbackOp<FlagValuePairT,
+                                                       ScanBySegmentOp<ScanOp>,
+                                                       TileStatusViewer,
+                                                       typename DelayPolicy::template constructor<FlagValuePairT>>;
 
             U<ScanByKeyKernel> scan_by_key_shader = nullptr;
             lazy_compile(
@@ -132,129 +94,323 @@ namespace details
                     BufferVar<FlagValuePairT> tile_partial,
                     BufferVar<FlagValuePairT> tile_inclusive,
                     BufferVar<KeyType>        d_keys_in,
-                    BufferVar<KeyType>        d_prev_keys_in,
                     BufferVar<ValueType>      d_values_in,
                     BufferVar<ValueType>      d_values_out,
                     Var<ValueType>            init_value,
-                    UInt                      num_item) noexcept
+                    UInt                      num_item,
+                    UInt                      epoch) noexcept
                 {
                     set_block_size(BLOCK_SIZE);
-                    UInt thid       = thread_id().x;
-                    UInt tile_id    = block_id().x;
-                    UInt tile_items = UInt(ITEMS_PER_THREAD) * block_size_x();
-                    UInt tile_start = tile_id * tile_items;
-
-                    UInt num_remaining = num_item - tile_start;
-                    Bool is_last_tile  = num_remaining <= tile_items;
+                    UInt tile_id      = block_id().x;
+                    Bool is_last_tile = num_item - tile_id * UInt(TILE_ITEMS) <= UInt(TILE_ITEMS);
 
-                    TileStatusViewer tile_state_viewer(tile_state, tile_partial, tile_inclusive);
+                    TileStatusViewer tile_state_viewer(tile_state, tile_partial, tile_inclusive, epoch);
 
                     SmemTypePtr<KeyType>   s_keys   = new SmemType<KeyType>{shared_mem_size};
                     SmemTypePtr<ValueType> s_values = new SmemType<ValueType>{shared_mem_size};
 
-                    ArrayVar<KeyType, ITEMS_PER_THREAD>        local_keys;
-                    ArrayVar<ValueType, ITEMS_PER_THREAD>      local_values;
                     ArrayVar<int, ITEMS_PER_THREAD>            local_segment_flags;
                     ArrayVar<FlagValuePairT, ITEMS_PER_THREAD> local_scan_items;
-
-                    $if(is_last_tile)
-                    {
-                        BlockLoad<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_keys).Load(
-                            d_keys_in, local_keys, tile_start, num_item - tile_start);
-                        BlockLoad<ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_values).Load(
-                            d_values_in, local_values, tile_start, num_item - tile_start);
-                    }
-                    $else
-                    {
-                        BlockLoad<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_keys).Load(d_keys_in, local_keys, tile_start);
-                        BlockLoad<ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_values).Load(
-                            d_values_in, local_values, tile_start);
-                    };
-
-                    sync_block();
+                    LoadScanItems(s_keys, s_values, d_keys_in, d_values_in, num_item, local_segment_flags, local_scan_items);
 
                     ArrayVar<FlagValuePairT, ITEMS_PER_THREAD> output_scan_items;
-                    ArrayVar<KeyType, ITEMS_PER_THREAD>        local_prev_keys;
                     Var<FlagValuePairT>                        tile_aggregate;
                     $if(tile_id == 0)
                     {
-                        BlockDiscontinuity<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>().FlagHeads(
-                            local_segment_flags,
-                            local_prev_keys,
-                            local_keys,
-                            [](const Var<KeyType>& a, const Var<KeyType>& b) { return a != b; });
-
-                        ZipValueAndFlags(num_remaining, local_values, local_segment_flags, local_scan_items, is_last_tile);
-
-                        if constexpr(is_inclusive)
-                        {
-                            BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().InclusiveScan(
-                                local_scan_items, output_scan_items, tile_aggregate, pair_scan_op);
-                        }
-                        else
-                        {
-                            BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
-                                local_scan_items, output_scan_items, tile_aggregate, pair_scan_op);
-                        }
-                        $if(thread_id().x == 0)
+                        ScanFirstTile<is_inclusive>(local_scan_items, output_scan_items, tile_aggregate, pair_scan_op);
+                        $if(thread_id().x == 0 & !is_last_tile)
                         {
-                            $if(!is_last_tile)
-                            {
-                                // first tile
-                                tile_state_viewer.SetInclusive(0, tile_aggregate);
-                            };
-                            output_scan_items[0].key = 0;
+                            // first tile
+                            tile_state_viewer.SetInclusive(0, tile_aggregate);
                         };
                     }
                     $else
                     {
-                        Var<KeyType> tile_pred_key =
-                            select(KeyType(0), d_prev_keys_in.read(tile_id), thread_id().x == 0);
-                        BlockDiscontinuity<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>().FlagHeads(
-                            local_segment_flags,
-                            local_prev_keys,
-                            local_keys,
-                            [](const Var<KeyType>& a, const Var<KeyType>& b) { return a != b; },
-                            tile_pred_key);
-
-                        ZipValueAndFlags(num_remaining, local_values, local_segment_flags, local_scan_items, is_last_tile);
-
                         auto temp_storage = new SmemType<TilePrefixTempStorage<FlagValuePairT>>{1};
                         TilePrefixOpT prefix_op(tile_state_viewer, temp_storage, pair_scan_op, tile_id);
                         if constexpr(is_inclusive)
                         {
                             BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().InclusiveScan(
                                 local_scan_items, output_scan_items, pair_scan_op, prefix_op);
-                            tile_aggregate = prefix_op.GetBlockAggregate();
                         }
                         else
                         {
                             BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
                                 local_scan_items, output_scan_items, pair_scan_op, prefix_op);
-                            tile_aggregate = prefix_op.GetBlockAggregate();
                         }
                     };
 
                     sync_block();
+                    StoreValues(s_values, d_values_out, output_scan_items, local_segment_flags, init_value, scan_op, num_item);
+                });
+
+            return scan_by_key_shader;
+        }
+
+        // the segment aggregate of every tile: its flags or-ed, the values of its last segment reduced
+        template <typename ScanOp>
+        U<UpsweepKernel> compile_upsweep(Device& device, size_t shared_mem_size, ScanOp scan_op)
+        {
+            ScanBySegmentOp<ScanOp> pair_scan_op{scan_op};
 
-                    ArrayVar<ValueType, ITEMS_PER_THREAD> value_output;
-                    UnzipValues(value_output, output_scan_items);
+            U<UpsweepKernel> upsweep_shader = nullptr;
+            lazy_compile(device,
+                         upsweep_shader,
+                         [&](BufferVar<KeyType>        d_keys_in,
+                             BufferVar<ValueType>      d_values_in,
+                             BufferVar<FlagValuePairT> d_tile_totals,
+                             UInt                      num_item) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             SmemTypePtr<KeyType>   s_keys   = new SmemType<KeyType>{shared_mem_size};
+                             SmemTypePtr<ValueType> s_values = new SmemType<ValueType>{shared_mem_size};
+
+                             ArrayVar<int, ITEMS_PER_THREAD>            local_segment_flags;
+                             ArrayVar<FlagValuePairT, ITEMS_PER_THREAD> local_scan_items;
+                             LoadScanItems(s_keys, s_values, d_keys_in, d_values_in, num_item, local_segment_flags, local_scan_items);
+
+                             // the total of the last tile is never a prefix, its padding does not matter
+                             ArrayVar<FlagValuePairT, ITEMS_PER_THREAD> output_scan_items;
+                             Var<FlagValuePairT>                        tile_aggregate;
+                             BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().InclusiveScan(
+                                 local_scan_items, output_scan_items, tile_aggregate, pair_scan_op);
+                             $if(thread_id().x == 0)
+                             {
+                                 d_tile_totals.write(block_id().x, tile_aggregate);
+                             };
+                         });
+            return upsweep_shader;
+        }
 
-                    AddInitToScan(value_output, local_segment_flags, init_value);
+        // one block walks the tile totals a tile at a time and scans them in place, inclusive: a
+        // downsweep tile reads its prefix from the total before it
+        template <typename ScanOp>
+        U<SpineKernel> compile_spine(Device& device, ScanOp scan_op)
+        {
+            ScanBySegmentOp<ScanOp> pair_scan_op{scan_op};
 
-                    $if(is_last_tile)
+            U<SpineKernel> spine_shader = nullptr;
+            lazy_compile(device,
+                         spine_shader,
+                         [&](BufferVar<FlagValuePairT> d_tile_totals, UInt num_tiles) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             Var<FlagValuePairT> running_total;
+                             $for(chunk_start, 0u, num_tiles, UInt(TILE_ITEMS))
+                             {
+                                 UInt item_start = chunk_start + thread_id().x * UInt(ITEMS_PER_THREAD);
+
+                                 // blocked like the block scan wants them, padded with the last total
+                                 ArrayVar<FlagValuePairT, ITEMS_PER_THREAD> totals;
+                                 for(auto item = 0u; item < ITEMS_PER_THREAD; ++item)
+                                 {
+                                     totals[item] = d_tile_totals.read(min(item_start + item, num_tiles - 1u));
+                                 }
+
+                                 ArrayVar<FlagValuePairT, ITEMS_PER_THREAD> scanned;
+                                 Var<FlagValuePairT>                        chunk_aggregate;
+                                 BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().InclusiveScan(
+                                     totals, scanned, chunk_aggregate, pair_scan_op);
+                                 $if(chunk_start != 0u)
+                                 {
+                                     for(auto item = 0u; item < ITEMS_PER_THREAD; ++item)
+                                     {
+                                         scanned[item] = pair_scan_op(running_total, scanned[item]);
+                                     }
+                                     chunk_aggregate = pair_scan_op(running_total, chunk_aggregate);
+                                 };
+                                 running_total = chunk_aggregate;
+
+                                 for(auto item = 0u; item < ITEMS_PER_THREAD; ++item)
+                                 {
+                                     $if(item_start + item < num_tiles)
+                                     {
+                                         d_tile_totals.write(item_start + item, scanned[item]);
+                                     };
+                                 }
+                                 // the next chunk reuses the shared memory of the block scan
+                                 sync_block();
+                             };
+                         });
+            return spine_shader;
+        }
+
+        // every tile scans itself on top of the scanned total of the tiles before it
+        template <bool is_inclusive, typename ScanOp>
+        U<DownsweepKernel> compile_downsweep(Device& device, size_t shared_mem_size, ScanOp scan_op)
+        {
+            ScanBySegmentOp<ScanOp> pair_scan_op{scan_op};
+
+            U<DownsweepKernel> downsweep_shader = nullptr;
+            lazy_compile(
+                device,
+                downsweep_shader,
+                [&](BufferVar<FlagValuePairT> d_tile_prefix,
+                    BufferVar<KeyType>        d_keys_in,
+                    BufferVar<ValueType>      d_values_in,
+                    BufferVar<ValueType>      d_values_out,
+                    Var<ValueType>            init_value,
+                    UInt                      num_item) noexcept
+                {
+                    set_block_size(BLOCK_SIZE);
+                    UInt tile_id = block_id().x;
+
+                    SmemTypePtr<KeyType>   s_keys   = new SmemType<KeyType>{shared_mem_size};
+                    SmemTypePtr<ValueType> s_values = new SmemType<ValueType>{shared_mem_size};
+
+                    ArrayVar<int, ITEMS_PER_THREAD>            local_segment_flags;
+                    ArrayVar<FlagValuePairT, ITEMS_PER_THREAD> local_scan_items;
+                    LoadScanItems(s_keys, s_values, d_keys_in, d_values_in, num_item, local_segment_flags, local_scan_items);
+
+                    ArrayVar<FlagValuePairT, ITEMS_PER_THREAD> output_scan_items;
+                    $if(tile_id == 0)
                     {
-                        BlockStore<ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_values).Store(
-                            value_output, d_values_out, tile_start, num_remaining);
+                        Var<FlagValuePairT> tile_aggregate;
+                        ScanFirstTile<is_inclusive>(local_scan_items, output_scan_items, tile_aggregate, pair_scan_op);
                     }
                     $else
                     {
-                        BlockStore<ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_values).Store(
-                            value_output, d_values_out, tile_start);
+                        auto prefix_op = [&](const Var<FlagValuePairT>&) noexcept
+                        { return d_tile_prefix.read(tile_id - 1u); };
+                        if constexpr(is_inclusive)
+                        {
+                            BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().InclusiveScan(
+                                local_scan_items, output_scan_items, pair_scan_op, prefix_op);
+                        }
+                        else
+                        {
+                            BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
+                                local_scan_items, output_scan_items, pair_scan_op, prefix_op);
+                        }
                     };
+
+                    sync_block();
+                    StoreValues(s_values, d_values_out, output_scan_items, local_segment_flags, init_value, scan_op, num_item);
                 });
 
-            return scan_by_key_shader;
+            return downsweep_shader;
+        }
+
+      private:
+        // loads the tile of block_id(), flags the head of every segment and zips the flags with the
+        // values; the first item past the end is flagged too, the padding of the last tile starts
+        // a segment of its own
+        void LoadScanItems(SmemTypePtr<KeyType>                        s_keys,
+                           SmemTypePtr<ValueType>                      s_values,
+                           BufferVar<KeyType>&                         d_keys_in,
+                           BufferVar<ValueType>&                       d_values_in,
+                           UInt                                        num_item,
+                           ArrayVar<int, ITEMS_PER_THREAD>&            segment_flags,
+                           ArrayVar<FlagValuePairT, ITEMS_PER_THREAD>& scan_items)
+        {
+            UInt tile_id       = block_id().x;
+            UInt tile_start    = tile_id * UInt(TILE_ITEMS);
+            UInt num_remaining = num_item - tile_start;
+            Bool is_last_tile  = num_remaining <= UInt(TILE_ITEMS);
+
+            ArrayVar<KeyType, ITEMS_PER_THREAD>   local_keys;
+            ArrayVar<ValueType, ITEMS_PER_THREAD> local_values;
+            $if(is_last_tile)
+            {
+                BlockLoad<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_keys).Load(d_keys_in, local_keys, tile_start, num_remaining);
+                BlockLoad<ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_values).Load(
+                    d_values_in, local_values, tile_start, num_remaining);
+            }
+            $else
+            {
+                BlockLoad<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_keys).Load(d_keys_in, local_keys, tile_start);
+                BlockLoad<ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_values).Load(d_values_in, local_values, tile_start);
+            };
+
+            sync_block();
+
+            ArrayVar<KeyType, ITEMS_PER_THREAD> local_prev_keys;
+            $if(tile_id == 0)
+            {
+                BlockDiscontinuity<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>().FlagHeads(
+                    segment_flags, local_prev_keys, local_keys, [](const Var<KeyType>& a, const Var<KeyType>& b) { return a != b; });
+            }
+            $else
+            {
+                // the last key of the previous tile, read here instead of gathered by the init kernel
+                Var<KeyType> tile_pred_key = select(KeyType(0), d_keys_in.read(tile_start - 1u), thread_id().x == 0);
+                BlockDiscontinuity<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD>().FlagHeads(
+                    segment_flags,
+                    local_prev_keys,
+                    local_keys,
+                    [](const Var<KeyType>& a, const Var<KeyType>& b) { return a != b; },
+                    tile_pred_key);
+            };
+
+            for(auto item = 0; item < ITEMS_PER_THREAD; item++)
+            {
+                $if(is_last_tile & (thread_id().x * UInt(ITEMS_PER_THREAD)) + item == num_remaining)
+                {
+                    segment_flags[item] = 1;
+                };
+                scan_items[item].key   = segment_flags[item];
+                scan_items[item].value = local_values[item];
+            }
+        }
+
+        // the first tile has no prefix, its first item heads a segment
+        template <bool is_inclusive, typename PairScanOp>
+        void ScanFirstTile(const ArrayVar<FlagValuePairT, ITEMS_PER_THREAD>& scan_items,
+                           ArrayVar<FlagValuePairT, ITEMS_PER_THREAD>&       output_scan_items,
+                           Var<FlagValuePairT>&                              tile_aggregate,
+                           PairScanOp                                        pair_scan_op)
+        {
+            if constexpr(is_inclusive)
+            {
+                BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().InclusiveScan(
+                    scan_items, output_scan_items, tile_aggregate, pair_scan_op);
+            }
+            else
+            {
+                BlockScan<FlagValuePairT, BLOCK_SIZE, ITEMS_PER_THREAD>().ExclusiveScan(
+                    scan_items, output_scan_items, tile_aggregate, pair_scan_op);
+            }
+            $if(thread_id().x == 0)
+            {
+                output_scan_items[0].key = 0;
+            };
+        }
+
+        // head items start from init_value, the others add it to their scanned value
+        template <typename ScanOp>
+        void StoreValues(SmemTypePtr<ValueType>                            s_values,
+                         BufferVar<ValueType>&                             d_values_out,
+                         const ArrayVar<FlagValuePairT, ITEMS_PER_THREAD>& output_scan_items,
+                         const ArrayVar<int, ITEMS_PER_THREAD>&            segment_flags,
+                         const Var<ValueType>&                             init_value,
+                         ScanOp                                            scan_op,
+                         UInt                                              num_item)
+        {
+            UInt tile_start    = block_id().x * UInt(TILE_ITEMS);
+            UInt num_remaining = num_item - tile_start;
+
+            ArrayVar<ValueType, ITEMS_PER_THREAD> value_output;
+            for(auto item = 0; item < ITEMS_PER_THREAD; item++)
+            {
+                $if(segment_flags[item] == 1)
+                {
+                    value_output[item] = init_value;
+                }
+                $else
+                {
+                    value_output[item] = scan_op(output_scan_items[item].value, init_value);
+                };
+            }
+
+            $if(num_remaining <= UInt(TILE_ITEMS))
+            {
+                BlockStore<ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_values).Store(
+                    value_output, d_values_out, tile_start, num_remaining);
+            }
+            $else
+            {
+                BlockStore<ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>(s_values).Store(value_output, d_values_out, tile_start);
+            };
         }
     };
 };  // namespace details
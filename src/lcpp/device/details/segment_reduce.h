@@ -2,12 +2,13 @@
  * @Author: Ligo 
  * @Date: 2025-11-07 14:37:01 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-12 14:59:19
+ * @Last Modified time: 2026-02-24 13:47:05
  */
 
 
 #pragma once
 #include <cstddef>
+#include <tuple>
 #include <luisa/dsl/sugar.h>
 #include <luisa/dsl/func.h>
 #include <luisa/dsl/var.h>
@@ -19,6 +20,8 @@
 #include <lcpp/common/utils.h>
 #include <lcpp/common/thread_operators.h>
 #include <lcpp/common/type_trait.h>
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
 #include <lcpp/runtime/core.h>
 
 namespace luisa::parallel_primitive
@@ -26,36 +29,67 @@ namespace luisa::parallel_primitive
 namespace details
 {
     using namespace luisa::compute;
-    template <typename Type4Byte, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_SIZE = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    template <typename Type4Byte, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_SIZE = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, IteratorT InputIt = BufferIterator<Type4Byte>>
     class SegmentReduceModule : public LuisaModule
     {
       public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<Type4Byte, InputIt>("SegmentReduceModule", BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD);
+        }
+
+        // the arguments of InputIt trail the fixed ones
         using SegmentReduceKernel =
-            Shader<1, Buffer<Type4Byte>, Buffer<Type4Byte>, Buffer<uint>, Buffer<uint>, uint, Type4Byte>;
+            shader_with_args_t<typename InputIt::kernel_args, Buffer<Type4Byte>, Buffer<uint>, Buffer<uint>, uint, Type4Byte>;
 
         using FixedSizeSegmentReduceKernel =
-            Shader<1, Buffer<Type4Byte>, Buffer<Type4Byte>, uint, uint, Type4Byte>;
+            shader_with_args_t<typename InputIt::kernel_args, Buffer<Type4Byte>, uint, uint, Type4Byte>;
 
         template <typename ReduceOp, typename TransformOp = IdentityOp>
         using AgentReduceT =
-            AgentReduce<Type4Byte, ReduceOp, TransformOp, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE>;
+            AgentReduce<Type4Byte, ReduceOp, TransformOp, BLOCK_SIZE, ITEMS_PER_THREAD, WARP_SIZE, BlockReduceAlgorithm::WARP_SHUFFLE, typename InputIt::DeviceIterator>;
 
         template <typename ReduceOp>
-        U<SegmentReduceKernel> compile(Device& device, size_t shared_mem_size, ReduceOp reduce_op)
+        U<SegmentReduceKernel> compile(Device& device, size_t shared_mem_size, ReduceOp reduce_op, const InputIt& d_in_it)
+        {
+            return compile(device, shared_mem_size, reduce_op, d_in_it, kernel_args_tag<typename InputIt::kernel_args>());
+        }
+
+        static constexpr auto segments_per_small_block = Policy_hub<Type4Byte>::SmallReducePolicy::SEGMENTS_PER_BLOCK;
+        static constexpr auto small_threads_per_warp = Policy_hub<Type4Byte>::SmallReducePolicy::WARP_THREADS;
+        static constexpr auto small_items_per_tile = Policy_hub<Type4Byte>::SmallReducePolicy::ITEMS_PER_TILE;
+        static constexpr auto small_items_per_threads = Policy_hub<Type4Byte>::SmallReducePolicy::ITEMS_PER_THREAD;
+
+        template <typename ReduceOp, typename TransformOp = IdentityOp>
+        using AgentSmallReduceT =
+            AgentWarpReduce<Type4Byte, ReduceOp, TransformOp, ITEMS_PER_THREAD, small_threads_per_warp, WarpReduceAlgorithm::WARP_SHUFFLE, typename InputIt::DeviceIterator>;
+
+        template <typename ReduceOp>
+        U<FixedSizeSegmentReduceKernel> compile_fixed_size(Device& device, size_t shared_mem_size, ReduceOp reduce_op, const InputIt& d_in_it)
+        {
+            return compile_fixed_size(
+                device, shared_mem_size, reduce_op, d_in_it, kernel_args_tag<typename InputIt::kernel_args>());
+        }
+
+      private:
+        template <typename ReduceOp, typename... InArgs>
+        U<SegmentReduceKernel> compile(
+            Device& device, size_t shared_mem_size, ReduceOp reduce_op, const InputIt& d_in_it, std::tuple<InArgs...>*)
         {
             U<SegmentReduceKernel> ms_segment_reduce_shader = nullptr;
 
             lazy_compile(device,
                          ms_segment_reduce_shader,
-                         [&](BufferVar<Type4Byte> d_arr_in,
-                             BufferVar<Type4Byte> d_arr_out,
+                         [&](BufferVar<Type4Byte> d_arr_out,
                              BufferVar<uint>      d_begin_offsets,
                              BufferVar<uint>      d_end_offsets,
                              UInt                 d_num_segments,
-                             Var<Type4Byte>       initial_value) noexcept
+                             Var<Type4Byte>       initial_value,
+                             Var<InArgs>... in_args) noexcept
                          {
                              set_block_size(BLOCK_SIZE);
                              set_warp_size(WARP_SIZE);
+                             auto d_arr_in = d_in_it.make_device(std::forward_as_tuple(in_args...));
 
                              UInt segment_begin = d_begin_offsets.read(block_id().x);
                              UInt segment_end   = d_end_offsets.read(block_id().x);
@@ -85,31 +119,23 @@ namespace details
             return ms_segment_reduce_shader;
         }
 
-        static constexpr auto segments_per_small_block = Policy_hub<Type4Byte>::SmallReducePolicy::SEGMENTS_PER_BLOCK;
-        static constexpr auto small_threads_per_warp = Policy_hub<Type4Byte>::SmallReducePolicy::WARP_THREADS;
-        static constexpr auto small_items_per_tile = Policy_hub<Type4Byte>::SmallReducePolicy::ITEMS_PER_TILE;
-        static constexpr auto small_items_per_threads = Policy_hub<Type4Byte>::SmallReducePolicy::ITEMS_PER_THREAD;
-
-        template <typename ReduceOp, typename TransformOp = IdentityOp>
-        using AgentSmallReduceT =
-            AgentWarpReduce<Type4Byte, ReduceOp, TransformOp, ITEMS_PER_THREAD, small_threads_per_warp>;
-
-
-        template <typename ReduceOp>
-        U<FixedSizeSegmentReduceKernel> compile_fixed_size(Device& device, size_t shared_mem_size, ReduceOp reduce_op)
+        template <typename ReduceOp, typename... InArgs>
+        U<FixedSizeSegmentReduceKernel> compile_fixed_size(
+            Device& device, size_t shared_mem_size, ReduceOp reduce_op, const InputIt& d_in_it, std::tuple<InArgs...>*)
         {
             U<FixedSizeSegmentReduceKernel> ms_fixed_size_segment_reduce_shader = nullptr;
 
             lazy_compile(
                 device,
                 ms_fixed_size_segment_reduce_shader,
-                [&](BufferVar<Type4Byte> d_arr_in,
-                    BufferVar<Type4Byte> d_arr_out,
+                [&](BufferVar<Type4Byte> d_arr_out,
                     UInt                 d_num_segments,
                     UInt                 d_segment_size,
-                    Var<Type4Byte>       initial_value) noexcept
+                    Var<Type4Byte>       initial_value,
+                    Var<InArgs>... in_args) noexcept
                 {
                     set_block_size(BLOCK_SIZE);
+                    auto d_arr_in = d_in_it.make_device(std::forward_as_tuple(in_args...));
                     UInt bid  = block_id().x;
                     UInt thid = thread_id().x;
 
@@ -169,7 +195,10 @@ namespace details
     class ArgSegmentReduceModule : public LuisaModule
     {
       public:
-        using ArgConstructShaderT = Shader<1, Buffer<Type4Byte>, Buffer<IndexValuePairT<Type4Byte>>>;
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<Type4Byte>("ArgSegmentReduceModule", BLOCK_SIZE);
+        }
 
         using ArgAssignShaderT =
             Shader<1, Buffer<IndexValuePairT<Type4Byte>>, Buffer<uint>, Buffer<uint>, Buffer<Type4Byte>>;
@@ -178,24 +207,6 @@ namespace details
             Shader<1, Buffer<IndexValuePairT<Type4Byte>>, uint, Buffer<uint>, Buffer<Type4Byte>>;
 
 
-        U<ArgConstructShaderT> compile_arg_construct_shader(Device& device)
-        {
-            U<ArgConstructShaderT> ms_arg_construct_shader = nullptr;
-            lazy_compile(device,
-                         ms_arg_construct_shader,
-                         [&](BufferVar<Type4Byte> arr_in, BufferVar<IndexValuePairT<Type4Byte>> g_kv_out)
-                         {
-                             set_block_size(BLOCK_SIZE);
-                             UInt global_id = block_id().x * block_size().x + thread_id().x;
-
-                             Var<IndexValuePairT<Type4Byte>> initial{0, 0};
-                             initial.key   = global_id;
-                             initial.value = arr_in.read(global_id);
-                             g_kv_out.write(global_id, initial);
-                         });
-            return ms_arg_construct_shader;
-        }
-
         U<ArgAssignShaderT> compile_arg_assign_shader(Device& device)
         {
             U<ArgAssignShaderT> ms_arg_assign_shader = nullptr;
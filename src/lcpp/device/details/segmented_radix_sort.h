@@ -0,0 +1,326 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-16 13:40:18
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-04 15:42:10
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/agent/agent_segmented_radix_sort.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    // segment groups, in the order they are laid out in d_group_lists
+    enum SegmentSizeGroup : uint
+    {
+        LARGE_SEGMENTS  = 0,
+        MEDIUM_SEGMENTS = 1,
+        SMALL_SEGMENTS  = 2,
+        NUM_SEGMENT_GROUPS,
+    };
+
+    // d_group_sizes holds the tiles of all large segments after the group sizes
+    constexpr uint LARGE_TILE_COUNT   = NUM_SEGMENT_GROUPS;
+    constexpr uint NUM_GROUP_COUNTERS = NUM_SEGMENT_GROUPS + 1;
+
+    template <NumericT KeyType, typename ValueType, bool KEYS_ONLY, bool IS_DESCENDING, size_t RADIX_BITS = 8u, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_SIZE = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+    class SegmentedRadixSortModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<KeyType, ValueType>(
+                "SegmentedRadixSortModule", KEYS_ONLY, IS_DESCENDING, RADIX_BITS, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD);
+        }
+
+        using AgentT =
+            AgentSegmentedRadixSort<KeyType, ValueType, KEYS_ONLY, IS_DESCENDING, RADIX_BITS, BLOCK_SIZE, WARP_SIZE, ITEMS_PER_THREAD>;
+
+        // d_begin_offsets, d_end_offsets, d_group_sizes, d_group_lists, d_large_tile_base, num_segments
+        using ClassifyKernel = Shader<1, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, uint>;
+        // d_keys_in, d_keys_out, d_values_in, d_values_out, d_begin_offsets, d_end_offsets,
+        // d_group_sizes, d_group_lists, num_segments, begin_bit, end_bit
+        using SegmentSortKernel =
+            Shader<1, ByteBuffer, ByteBuffer, Buffer<ValueType>, Buffer<ValueType>, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, uint, uint, uint>;
+        // the arguments of SegmentSortKernel with d_large_tile_base, d_large_tile_map and
+        // d_tile_digits after d_group_lists; the steps of a large pass share it
+        using LargeSegmentKernel =
+            Shader<1, ByteBuffer, ByteBuffer, Buffer<ValueType>, Buffer<ValueType>, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<uint>, uint, uint, uint>;
+
+        U<ClassifyKernel> compile_classify(Device& device)
+        {
+            U<ClassifyKernel> ms_classify_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_classify_shader,
+                         [&](BufferVar<uint> d_begin_offsets,
+                             BufferVar<uint> d_end_offsets,
+                             BufferVar<uint> d_group_sizes,
+                             BufferVar<uint> d_group_lists,
+                             BufferVar<uint> d_large_tile_base,
+                             UInt            num_segments) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             UInt segment_id = dispatch_id().x;
+                             $if(segment_id < num_segments)
+                             {
+                                 UInt num_segment_items = d_end_offsets.read(segment_id) - d_begin_offsets.read(segment_id);
+                                 // empty segments have nothing to sort and are dropped here
+                                 $if(num_segment_items > UInt(AgentT::TILE_ITEMS))
+                                 {
+                                     UInt slot = d_group_sizes.atomic(UInt(LARGE_SEGMENTS)).fetch_add(1u);
+                                     d_group_lists.write(UInt(LARGE_SEGMENTS) * num_segments + slot, segment_id);
+                                     // the tiles of the segment get a contiguous range of tile slots
+                                     UInt num_tiles = (num_segment_items + UInt(AgentT::TILE_ITEMS - 1)) / UInt(AgentT::TILE_ITEMS);
+                                     d_large_tile_base.write(slot, d_group_sizes.atomic(UInt(LARGE_TILE_COUNT)).fetch_add(num_tiles));
+                                 }
+                                 $elif(num_segment_items > UInt(AgentT::WARP_TILE_ITEMS))
+                                 {
+                                     UInt slot = d_group_sizes.atomic(UInt(MEDIUM_SEGMENTS)).fetch_add(1u);
+                                     d_group_lists.write(UInt(MEDIUM_SEGMENTS) * num_segments + slot, segment_id);
+                                 }
+                                 $elif(num_segment_items > 0u)
+                                 {
+                                     UInt slot = d_group_sizes.atomic(UInt(SMALL_SEGMENTS)).fetch_add(1u);
+                                     d_group_lists.write(UInt(SMALL_SEGMENTS) * num_segments + slot, segment_id);
+                                 };
+                             };
+                         });
+
+            return ms_classify_shader;
+        }
+
+        /// every warp sorts small segments until the group runs out
+        U<SegmentSortKernel> compile_small(Device& device)
+        {
+            U<SegmentSortKernel> ms_small_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_small_shader,
+                         [&](ByteBufferVar        d_keys_in,
+                             ByteBufferVar        d_keys_out,
+                             BufferVar<ValueType> d_values_in,
+                             BufferVar<ValueType> d_values_out,
+                             BufferVar<uint>      d_begin_offsets,
+                             BufferVar<uint>      d_end_offsets,
+                             BufferVar<uint>      d_group_sizes,
+                             BufferVar<uint>      d_group_lists,
+                             UInt                 num_segments,
+                             UInt                 begin_bit,
+                             UInt                 end_bit) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             set_warp_size(WARP_SIZE);
+
+                             AgentT agent(d_keys_in, d_keys_out, d_values_in, d_values_out, begin_bit, end_bit);
+
+                             UInt num_warps  = dispatch_size().x / UInt(WARP_SIZE);
+                             UInt warp_id    = dispatch_id().x / UInt(WARP_SIZE);
+                             UInt group_size = d_group_sizes.read(UInt(SMALL_SEGMENTS));
+                             $for(i, warp_id, group_size, num_warps)
+                             {
+                                 UInt segment_id    = d_group_lists.read(UInt(SMALL_SEGMENTS) * num_segments + i);
+                                 UInt segment_begin = d_begin_offsets.read(segment_id);
+                                 agent.SortWarpSegment(segment_begin, d_end_offsets.read(segment_id) - segment_begin);
+                             };
+                         });
+
+            return ms_small_shader;
+        }
+
+        /// every block sorts medium segments until the group runs out
+        U<SegmentSortKernel> compile_medium(Device& device)
+        {
+            U<SegmentSortKernel> ms_medium_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_medium_shader,
+                         [&](ByteBufferVar        d_keys_in,
+                             ByteBufferVar        d_keys_out,
+                             BufferVar<ValueType> d_values_in,
+                             BufferVar<ValueType> d_values_out,
+                             BufferVar<uint>      d_begin_offsets,
+                             BufferVar<uint>      d_end_offsets,
+                             BufferVar<uint>      d_group_sizes,
+                             BufferVar<uint>      d_group_lists,
+                             UInt                 num_segments,
+                             UInt                 begin_bit,
+                             UInt                 end_bit) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             set_warp_size(WARP_SIZE);
+
+                             AgentT agent(d_keys_in, d_keys_out, d_values_in, d_values_out, begin_bit, end_bit);
+
+                             UInt grid_size  = dispatch_size().x / UInt(BLOCK_SIZE);
+                             UInt group_size = d_group_sizes.read(UInt(MEDIUM_SEGMENTS));
+                             $for(i, block_id().x, group_size, grid_size)
+                             {
+                                 UInt segment_id    = d_group_lists.read(UInt(MEDIUM_SEGMENTS) * num_segments + i);
+                                 UInt segment_begin = d_begin_offsets.read(segment_id);
+                                 agent.SortBlockSegment(segment_begin, d_end_offsets.read(segment_id) - segment_begin);
+                                 sync_block();
+                             };
+                         });
+
+            return ms_medium_shader;
+        }
+
+        /// d_large_tile_map[tile slot] = the slot of its segment in the large group, a block per segment
+        U<LargeSegmentKernel> compile_large_tile_map(Device& device)
+        {
+            return compile_large(device,
+                                 [](AgentT&, LargeSegments& large)
+                                 {
+                                     UInt grid_size  = dispatch_size().x / UInt(BLOCK_SIZE);
+                                     UInt group_size = large.group_sizes.read(UInt(LARGE_SEGMENTS));
+                                     $for(slot, block_id().x, group_size, grid_size)
+                                     {
+                                         UInt segment_begin, num_tiles;
+                                         large.segment(slot, segment_begin, num_tiles);
+                                         UInt tile_base = large.tile_base.read(slot);
+                                         $for(tile, thread_id().x, num_tiles, UInt(BLOCK_SIZE))
+                                         {
+                                             large.tile_map.write(tile_base + tile, slot);
+                                         };
+                                     };
+                                 });
+        }
+
+        /// upsweep of a digit pass: the digit counts of every large segment tile, a block per tile
+        U<LargeSegmentKernel> compile_large_count(Device& device)
+        {
+            return compile_large(device,
+                                 [](AgentT& agent, LargeSegments& large)
+                                 {
+                                     large.for_each_tile(
+                                         [&](const UInt& tile, const UInt& tile_begin, const UInt& num_tile_items)
+                                         { agent.CountLargeTile(tile_begin, num_tile_items, large.tile_digits, tile); });
+                                 });
+        }
+
+        /// spine of a digit pass: the tile digit counts of every large segment turned into output
+        /// slots, a block per segment
+        U<LargeSegmentKernel> compile_large_scan(Device& device)
+        {
+            return compile_large(device,
+                                 [](AgentT& agent, LargeSegments& large)
+                                 {
+                                     UInt grid_size  = dispatch_size().x / UInt(BLOCK_SIZE);
+                                     UInt group_size = large.group_sizes.read(UInt(LARGE_SEGMENTS));
+                                     $for(slot, block_id().x, group_size, grid_size)
+                                     {
+                                         UInt segment_begin, num_tiles;
+                                         large.segment(slot, segment_begin, num_tiles);
+                                         agent.ScanLargeSegment(segment_begin, large.tile_base.read(slot), num_tiles, large.tile_digits);
+                                         sync_block();
+                                     };
+                                 });
+        }
+
+        /// downsweep of a digit pass: every large segment tile ranked and scattered, a block per tile
+        U<LargeSegmentKernel> compile_large_scatter(Device& device)
+        {
+            return compile_large(device,
+                                 [](AgentT& agent, LargeSegments& large)
+                                 {
+                                     large.for_each_tile(
+                                         [&](const UInt& tile, const UInt& tile_begin, const UInt& num_tile_items)
+                                         { agent.ScatterLargeTile(tile_begin, num_tile_items, large.tile_digits, tile); });
+                                 });
+        }
+
+      private:
+        // the large group and its tile slots, as seen by the steps of a large pass
+        struct LargeSegments
+        {
+            BufferVar<uint>& begin_offsets;
+            BufferVar<uint>& end_offsets;
+            BufferVar<uint>& group_sizes;
+            BufferVar<uint>& group_lists;
+            BufferVar<uint>& tile_base;
+            BufferVar<uint>& tile_map;
+            BufferVar<uint>& tile_digits;
+            UInt&            num_segments;
+
+            void segment(const UInt& slot, UInt& segment_begin, UInt& num_tiles)
+            {
+                UInt segment_id = group_lists.read(UInt(LARGE_SEGMENTS) * num_segments + slot);
+                segment_begin   = begin_offsets.read(segment_id);
+                num_tiles = (end_offsets.read(segment_id) - segment_begin + UInt(AgentT::TILE_ITEMS - 1)) / UInt(AgentT::TILE_ITEMS);
+            }
+
+            // every block takes tile slots until the large segments run out of tiles
+            template <typename TileOp>
+            void for_each_tile(TileOp&& tile_op)
+            {
+                UInt grid_size = dispatch_size().x / UInt(BLOCK_SIZE);
+                UInt num_tiles = group_sizes.read(UInt(LARGE_TILE_COUNT));
+                $for(tile, block_id().x, num_tiles, grid_size)
+                {
+                    UInt slot        = tile_map.read(tile);
+                    UInt segment_id  = group_lists.read(UInt(LARGE_SEGMENTS) * num_segments + slot);
+                    UInt segment_end = end_offsets.read(segment_id);
+                    UInt tile_begin =
+                        begin_offsets.read(segment_id) + (tile - tile_base.read(slot)) * UInt(AgentT::TILE_ITEMS);
+                    tile_op(tile, tile_begin, min(segment_end - tile_begin, UInt(AgentT::TILE_ITEMS)));
+                    sync_block();
+                };
+            }
+        };
+
+        template <typename LargeOp>
+        U<LargeSegmentKernel> compile_large(Device& device, LargeOp large_op)
+        {
+            U<LargeSegmentKernel> ms_large_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_large_shader,
+                         [&](ByteBufferVar        d_keys_in,
+                             ByteBufferVar        d_keys_out,
+                             BufferVar<ValueType> d_values_in,
+                             BufferVar<ValueType> d_values_out,
+                             BufferVar<uint>      d_begin_offsets,
+                             BufferVar<uint>      d_end_offsets,
+                             BufferVar<uint>      d_group_sizes,
+                             BufferVar<uint>      d_group_lists,
+                             BufferVar<uint>      d_large_tile_base,
+                             BufferVar<uint>      d_large_tile_map,
+                             BufferVar<uint>      d_tile_digits,
+                             UInt                 num_segments,
+                             UInt                 begin_bit,
+                             UInt                 end_bit) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             set_warp_size(WARP_SIZE);
+
+                             AgentT        agent(d_keys_in, d_keys_out, d_values_in, d_values_out, begin_bit, end_bit);
+                             LargeSegments large{d_begin_offsets,
+                                                 d_end_offsets,
+                                                 d_group_sizes,
+                                                 d_group_lists,
+                                                 d_large_tile_base,
+                                                 d_large_tile_map,
+                                                 d_tile_digits,
+                                                 num_segments};
+                             large_op(agent, large);
+                         });
+
+            return ms_large_shader;
+        }
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
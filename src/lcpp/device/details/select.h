@@ -0,0 +1,88 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-12 11:05:12
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-05 16:31:40
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/agent/agent_select_if.h>
+#include <lcpp/device/details/single_pass_scan_operator.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    template <NumericT Type, NumericT FlagT = uint, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
+    class SelectModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<Type, FlagT, DelayPolicy>("SelectModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
+        using TileStatusViewer = ScanTileStateViewer<uint>;
+
+        using ScanTileStateInitKernel = Shader<1, Buffer<uint>, uint>;
+        // tile_status, tile_partial, tile_inclusive, d_in, d_flags, d_out, d_num_selected_out, num_items
+        using SelectKernel =
+            Shader<1, Buffer<uint>, Buffer<uint>, Buffer<uint>, Buffer<Type>, Buffer<FlagT>, Buffer<Type>, Buffer<uint>, uint>;
+
+        U<ScanTileStateInitKernel> compile_scan_tile_state_init(Device& device)
+        {
+            U<ScanTileStateInitKernel> ms_scan_tile_state_init_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_scan_tile_state_init_shader,
+                         [](BufferVar<uint> tile_state, UInt num_tiles) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             InitializeWardStatus(num_tiles, tile_state);
+                         });
+
+            return ms_scan_tile_state_init_shader;
+        }
+
+        /// MODE == If: select_op(Var<Type>) -> Bool; MODE == Unique: select_op(a, b) -> Bool tests equality;
+        /// MODE == Flagged ignores select_op. KEEP_REJECTS builds the DevicePartition kernel
+        template <SelectMode MODE, bool KEEP_REJECTS, typename SelectOp>
+        U<SelectKernel> compile(Device& device, SelectOp select_op)
+        {
+            U<SelectKernel> ms_select_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_select_shader,
+                         [&](BufferVar<uint>  tile_status,
+                             BufferVar<uint>  tile_partial,
+                             BufferVar<uint>  tile_inclusive,
+                             BufferVar<Type>  d_in,
+                             BufferVar<FlagT> d_flags,
+                             BufferVar<Type>  d_out,
+                             BufferVar<uint>  d_num_selected_out,
+                             UInt             num_items) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             using AgentT = AgentSelectIf<Type, FlagT, MODE, KEEP_REJECTS, SelectOp, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
+
+                             TileStatusViewer tile_state(tile_status, tile_partial, tile_inclusive);
+                             AgentT(tile_state, d_in, d_flags, d_out, select_op, num_items).ConsumeTile(d_num_selected_out);
+                         });
+
+            return ms_select_shader;
+        }
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
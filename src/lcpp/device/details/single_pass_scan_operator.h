@@ -2,7 +2,7 @@
  * @Author: Ligo 
  * @Date: 2025-10-22 11:24:49 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-07 00:09:45
+ * @Last Modified time: 2026-03-05 16:31:40
  */
 #pragma once
 #include <cstddef>
@@ -49,6 +49,140 @@ struct no_delay_constructor
     [[nodiscard]] delay_t operator()() const noexcept { return delay_t{}; };
 };
 
+namespace details
+{
+    // LC has no sleep or clock builtin: a delay is count steps of ALU work, its result stored to
+    // shared memory so the backend keeps it, during which the warp leaves the status words alone
+    inline void spin_delay(compute::UInt count, SmemTypePtr<compute::uint> sink) noexcept
+    {
+        compute::UInt state = count;
+        $for(step, count)
+        {
+            state = state * 1664525u + 1013904223u;
+        };
+        (*sink)[0] = state;
+    }
+}  // namespace details
+
+// the same DELAY between all polls
+template <typename T, compute::uint DELAY = 256>
+struct fixed_delay_constructor
+{
+    SmemTypePtr<compute::uint> sink;
+
+    fixed_delay_constructor(compute::UInt) noexcept
+        : sink{new SmemType<compute::uint>{1}} {};
+
+    struct delay_t
+    {
+        SmemTypePtr<compute::uint> sink;
+
+        void operator()() const noexcept { details::spin_delay(compute::UInt(DELAY), sink); };
+    };
+
+    [[nodiscard]] delay_t operator()() const noexcept { return delay_t{sink}; };
+};
+
+// INITIAL_DELAY before the second poll of a window, twice as long before every further one, up to MAX_DELAY
+template <typename T, compute::uint INITIAL_DELAY = 32, compute::uint MAX_DELAY = 4096>
+struct exponential_backoff_constructor
+{
+    SmemTypePtr<compute::uint> sink;
+
+    exponential_backoff_constructor(compute::UInt) noexcept
+        : sink{new SmemType<compute::uint>{1}} {};
+
+    struct delay_t
+    {
+        SmemTypePtr<compute::uint> sink;
+        compute::UInt              delay;
+
+        void operator()() noexcept
+        {
+            details::spin_delay(delay, sink);
+            delay = compute::min(delay * 2u, compute::UInt(MAX_DELAY));
+        };
+    };
+
+    [[nodiscard]] delay_t operator()() const noexcept { return delay_t{sink, compute::UInt(INITIAL_DELAY)}; };
+};
+
+// exponential backoff with a delay drawn below the current bound, seeded by the tile: warps that
+// wait on the same predecessors poll out of step instead of together
+template <typename T, compute::uint INITIAL_DELAY = 32, compute::uint MAX_DELAY = 4096>
+struct jittered_backoff_constructor
+{
+    SmemTypePtr<compute::uint> sink;
+    compute::UInt              seed;
+
+    jittered_backoff_constructor(compute::UInt tile_index) noexcept
+        : sink{new SmemType<compute::uint>{1}}
+        , seed{tile_index * 0x9e3779b9u} {};
+
+    struct delay_t
+    {
+        SmemTypePtr<compute::uint> sink;
+        compute::UInt              state;
+        compute::UInt              bound;
+
+        void operator()() noexcept
+        {
+            state = state * 1664525u + 1013904223u;
+            details::spin_delay(bound / 2u + (state >> 16u) % (bound / 2u + 1u), sink);
+            bound = compute::min(bound * 2u, compute::UInt(MAX_DELAY));
+        };
+    };
+
+    [[nodiscard]] delay_t operator()() const noexcept
+    {
+        return delay_t{sink, seed ^ compute::thread_x(), compute::UInt(INITIAL_DELAY)};
+    };
+};
+
+/// Look-back delay policies of DeviceScan and the other single-pass Device algorithms:
+/// constructor<T> is the DelayConstructorT the TilePrefixCallbackOp of a T scan waits for its
+/// predecessors with
+struct NoDelayPolicy
+{
+    static luisa::string kernel_name() noexcept { return "NoDelay"; }
+
+    template <typename T>
+    using constructor = no_delay_constructor<T>;
+};
+
+template <compute::uint DELAY = 256>
+struct FixedDelayPolicy
+{
+    static luisa::string kernel_name() noexcept { return make_kernel_name("FixedDelay", DELAY); }
+
+    template <typename T>
+    using constructor = fixed_delay_constructor<T, DELAY>;
+};
+
+template <compute::uint INITIAL_DELAY = 32, compute::uint MAX_DELAY = 4096>
+struct ExponentialBackoffPolicy
+{
+    static luisa::string kernel_name() noexcept
+    {
+        return make_kernel_name("ExponentialBackoff", INITIAL_DELAY, MAX_DELAY);
+    }
+
+    template <typename T>
+    using constructor = exponential_backoff_constructor<T, INITIAL_DELAY, MAX_DELAY>;
+};
+
+template <compute::uint INITIAL_DELAY = 32, compute::uint MAX_DELAY = 4096>
+struct JitteredBackoffPolicy
+{
+    static luisa::string kernel_name() noexcept
+    {
+        return make_kernel_name("JitteredBackoff", INITIAL_DELAY, MAX_DELAY);
+    }
+
+    template <typename T>
+    using constructor = jittered_backoff_constructor<T, INITIAL_DELAY, MAX_DELAY>;
+};
+
 
 template <typename T>
 struct ScanTileState
@@ -57,24 +191,57 @@ struct ScanTileState
     T             value;
 };
 
+// a status word is the ScanTileStatus in the low byte and the epoch of the call that wrote it
+// above; words of any other epoch read as SCAN_TILE_INVALID. Epoch 0 is the plain status of
+// a status buffer initialized before every call
+struct TileStatusWord
+{
+    using StatusWordT = compute::uint;
+
+    constexpr static size_t      TILE_STATUS_PADDING = details::WARP_SIZE;
+    constexpr static StatusWordT EPOCH_SHIFT         = 8u;
+    constexpr static StatusWordT STATUS_MASK         = (1u << EPOCH_SHIFT) - 1u;
+    constexpr static StatusWordT MAX_EPOCH           = ~StatusWordT{0} >> EPOCH_SHIFT;
+
+    [[nodiscard]] static compute::Var<StatusWordT> encode(ScanTileStatus status, const compute::UInt& epoch) noexcept
+    {
+        return compute::def(StatusWordT(status)) | (epoch << EPOCH_SHIFT);
+    }
+
+    // tiles before the first are out of bounds whatever the padding holds
+    [[nodiscard]] static compute::Var<StatusWordT> decode(const compute::Var<StatusWordT>& word,
+                                                          const compute::UInt&             epoch,
+                                                          const compute::Int&              tile_index) noexcept
+    {
+        compute::Var<StatusWordT> status = compute::select(word & STATUS_MASK,
+                                                           StatusWordT(ScanTileStatus::SCAN_TILE_INVALID),
+                                                           (word >> EPOCH_SHIFT) != epoch);
+        return compute::select(status, StatusWordT(ScanTileStatus::SCAN_TILE_OBB), tile_index < 0);
+    }
+};
+
 template <typename T>
 struct ScanTileStateViewer
 {
 
     using StatusWordT = compute::uint;
 
-    constexpr static size_t TILE_STATUS_PADDING = details::WARP_SIZE;
+    constexpr static size_t      TILE_STATUS_PADDING = TileStatusWord::TILE_STATUS_PADDING;
+    constexpr static StatusWordT MAX_EPOCH           = TileStatusWord::MAX_EPOCH;
 
     compute::BufferVar<compute::uint>& d_tile_status;
     compute::BufferVar<T>&             d_tile_partial;
     compute::BufferVar<T>&             d_tile_inclusive;
+    compute::UInt                      epoch;
 
     ScanTileStateViewer(compute::BufferVar<StatusWordT>& tile_status,
                         compute::BufferVar<T>&           tile_partial,
-                        compute::BufferVar<T>&           tile_inclusive)
+                        compute::BufferVar<T>&           tile_inclusive,
+                        compute::UInt                    epoch = 0u)
         : d_tile_status(tile_status)
         , d_tile_partial(tile_partial)
-        , d_tile_inclusive(tile_inclusive) {};
+        , d_tile_inclusive(tile_inclusive)
+        , epoch(epoch) {};
 
 
 
@@ -82,24 +249,24 @@ struct ScanTileStateViewer
     {
         d_tile_inclusive.volatile_write(compute::Int(TILE_STATUS_PADDING) + tile_index, tile_inclusive);
         d_tile_status.volatile_write(compute::Int(TILE_STATUS_PADDING) + tile_index,
-                                     compute::def(StatusWordT(ScanTileStatus::SCAN_TILE_INCLUSIVE)));
+                                     status_word(ScanTileStatus::SCAN_TILE_INCLUSIVE));
     };
 
     void SetPartial(compute::Int tile_index, const compute::Var<T>& tile_partial) noexcept
     {
         d_tile_partial.volatile_write(compute::Int(TILE_STATUS_PADDING) + tile_index, tile_partial);
         d_tile_status.volatile_write(compute::Int(TILE_STATUS_PADDING) + tile_index,
-                                     compute::def(StatusWordT(ScanTileStatus::SCAN_TILE_PARTIAL)));
+                                     status_word(ScanTileStatus::SCAN_TILE_PARTIAL));
     };
 
     template <typename DelayT>
     void WaitForValid(compute::Int tile_index, compute::Var<StatusWordT>& out_status, compute::Var<T>& out_value, DelayT delay) noexcept
     {
-        out_status = d_tile_status.volatile_read(compute::Int(TILE_STATUS_PADDING) + tile_index);
+        out_status = read_status(tile_index);
         $while(compute::warp_active_any(out_status == StatusWordT(ScanTileStatus::SCAN_TILE_INVALID)))
         {
             delay();
-            out_status = d_tile_status.volatile_read(compute::Int(TILE_STATUS_PADDING) + tile_index);
+            out_status = read_status(tile_index);
         };
         $if(out_status == StatusWordT(ScanTileStatus::SCAN_TILE_PARTIAL))
         {
@@ -110,7 +277,84 @@ struct ScanTileStateViewer
             out_value = d_tile_inclusive.volatile_read(compute::Int(TILE_STATUS_PADDING) + tile_index);
         };
     };
+
+  private:
+    [[nodiscard]] compute::Var<StatusWordT> status_word(ScanTileStatus status) const noexcept
+    {
+        return TileStatusWord::encode(status, epoch);
+    }
+
+    [[nodiscard]] compute::Var<StatusWordT> read_status(compute::Int tile_index) noexcept
+    {
+        return TileStatusWord::decode(
+            d_tile_status.volatile_read(compute::Int(TILE_STATUS_PADDING) + tile_index), epoch, tile_index);
+    }
+};
+
+// CUB's ScanTileState<T, true>: the status word in the high half of one 64-bit descriptor and the
+// bits of the 4-byte value in the low half, a tile is published by one store and its status and
+// value are observed by one load, no second dependent read of a value buffer
+template <typename T>
+struct ScanTilePackedStateViewer
+{
+    static_assert(sizeof(T) == sizeof(compute::uint), "ScanTilePackedStateViewer packs 4-byte values only");
+
+    using StatusWordT = compute::uint;
+    using DescriptorT = compute::ulong;
+
+    constexpr static size_t      TILE_STATUS_PADDING = TileStatusWord::TILE_STATUS_PADDING;
+    constexpr static StatusWordT MAX_EPOCH           = TileStatusWord::MAX_EPOCH;
+    constexpr static DescriptorT STATUS_SHIFT        = 32u;
+
+    compute::BufferVar<DescriptorT>& d_tile_descriptor;
+    compute::UInt                    epoch;
+
+    ScanTilePackedStateViewer(compute::BufferVar<DescriptorT>& tile_descriptor, compute::UInt epoch = 0u)
+        : d_tile_descriptor(tile_descriptor)
+        , epoch(epoch) {};
+
+    void SetInclusive(compute::Int tile_index, const compute::Var<T>& tile_inclusive) noexcept
+    {
+        d_tile_descriptor.volatile_write(compute::Int(TILE_STATUS_PADDING) + tile_index,
+                                         descriptor(ScanTileStatus::SCAN_TILE_INCLUSIVE, tile_inclusive));
+    };
+
+    void SetPartial(compute::Int tile_index, const compute::Var<T>& tile_partial) noexcept
+    {
+        d_tile_descriptor.volatile_write(compute::Int(TILE_STATUS_PADDING) + tile_index,
+                                         descriptor(ScanTileStatus::SCAN_TILE_PARTIAL, tile_partial));
+    };
+
+    template <typename DelayT>
+    void WaitForValid(compute::Int tile_index, compute::Var<StatusWordT>& out_status, compute::Var<T>& out_value, DelayT delay) noexcept
+    {
+        compute::Var<DescriptorT> word = d_tile_descriptor.volatile_read(compute::Int(TILE_STATUS_PADDING) + tile_index);
+        out_status                     = status_of(word, tile_index);
+        $while(compute::warp_active_any(out_status == StatusWordT(ScanTileStatus::SCAN_TILE_INVALID)))
+        {
+            delay();
+            word       = d_tile_descriptor.volatile_read(compute::Int(TILE_STATUS_PADDING) + tile_index);
+            out_status = status_of(word, tile_index);
+        };
+        out_value = compute::as<T>(compute::cast<StatusWordT>(word));
+    };
+
+  private:
+    [[nodiscard]] compute::Var<DescriptorT> descriptor(ScanTileStatus status, const compute::Var<T>& value) const noexcept
+    {
+        return (compute::cast<DescriptorT>(TileStatusWord::encode(status, epoch)) << STATUS_SHIFT)
+               | compute::cast<DescriptorT>(compute::as<StatusWordT>(value));
+    }
+
+    [[nodiscard]] compute::Var<StatusWordT> status_of(const compute::Var<DescriptorT>& word, const compute::Int& tile_index) const noexcept
+    {
+        return TileStatusWord::decode(compute::cast<StatusWordT>(word >> STATUS_SHIFT), epoch, tile_index);
+    }
 };
+
+/// The 4-byte scan types publish packed descriptors, the others a status word and separate values
+template <typename T>
+constexpr bool is_packed_tile_state_v = sizeof(T) == sizeof(compute::uint);
 static void InitializeWardStatus(compute::UInt num_tile, compute::BufferVar<compute::uint>& d_tile_status) noexcept
 {
     compute::UInt tile_idx = compute::dispatch_id().x;
@@ -124,6 +368,22 @@ static void InitializeWardStatus(compute::UInt num_tile, compute::BufferVar<comp
         d_tile_status.write(compute::thread_x(), compute::def(ScanTileStateViewer<int>::StatusWordT(ScanTileStatus::SCAN_TILE_OBB)));
     };
 };
+static void InitializeWardStatus(compute::UInt num_tile, compute::BufferVar<compute::ulong>& d_tile_descriptor) noexcept
+{
+    using PackedViewer = ScanTilePackedStateViewer<compute::uint>;
+
+    compute::UInt tile_idx = compute::dispatch_id().x;
+    $if(tile_idx < num_tile)
+    {
+        d_tile_descriptor.write(compute::UInt(PackedViewer::TILE_STATUS_PADDING) + tile_idx,
+                                compute::def(PackedViewer::DescriptorT(ScanTileStatus::SCAN_TILE_INVALID) << PackedViewer::STATUS_SHIFT));
+    };
+    $if(compute::block_id().x == 0 & compute::thread_x() < compute::UInt(PackedViewer::TILE_STATUS_PADDING))
+    {
+        d_tile_descriptor.write(compute::thread_x(),
+                                compute::def(PackedViewer::DescriptorT(ScanTileStatus::SCAN_TILE_OBB) << PackedViewer::STATUS_SHIFT));
+    };
+};
 
 template <typename T>
 struct TilePrefixTempStorage
@@ -0,0 +1,104 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-13 11:14:08
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-05 16:31:40
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/agent/agent_three_way_partition.h>
+#include <lcpp/device/details/single_pass_scan_operator.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    template <NumericT Type, size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
+    class ThreeWayPartitionModule : public LuisaModule
+    {
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<Type, DelayPolicy>("ThreeWayPartitionModule", BLOCK_SIZE, ITEMS_PER_THREAD);
+        }
+
+        using AccumPackT       = KeyValuePair<uint, uint>;
+        using TileStatusViewer = ScanTileStateViewer<AccumPackT>;
+
+        using ScanTileStateInitKernel = Shader<1, Buffer<uint>, uint>;
+        // tile_status, tile_partial, tile_inclusive, d_in, d_first_part_out, d_second_part_out, d_unselected_out, d_num_selected_out, num_items
+        using ThreeWayPartitionKernel = Shader<1,
+                                               Buffer<uint>,
+                                               Buffer<AccumPackT>,
+                                               Buffer<AccumPackT>,
+                                               Buffer<Type>,
+                                               Buffer<Type>,
+                                               Buffer<Type>,
+                                               Buffer<Type>,
+                                               Buffer<uint>,
+                                               uint>;
+
+        U<ScanTileStateInitKernel> compile_scan_tile_state_init(Device& device)
+        {
+            U<ScanTileStateInitKernel> ms_scan_tile_state_init_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_scan_tile_state_init_shader,
+                         [](BufferVar<uint> tile_state, UInt num_tiles) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             InitializeWardStatus(num_tiles, tile_state);
+                         });
+
+            return ms_scan_tile_state_init_shader;
+        }
+
+        template <typename SelectFirstPartOp, typename SelectSecondPartOp>
+        U<ThreeWayPartitionKernel> compile(Device& device, SelectFirstPartOp select_first_part_op, SelectSecondPartOp select_second_part_op)
+        {
+            U<ThreeWayPartitionKernel> ms_three_way_partition_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_three_way_partition_shader,
+                         [&](BufferVar<uint>       tile_status,
+                             BufferVar<AccumPackT> tile_partial,
+                             BufferVar<AccumPackT> tile_inclusive,
+                             BufferVar<Type>       d_in,
+                             BufferVar<Type>       d_first_part_out,
+                             BufferVar<Type>       d_second_part_out,
+                             BufferVar<Type>       d_unselected_out,
+                             BufferVar<uint>       d_num_selected_out,
+                             UInt                  num_items) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             using AgentT = AgentThreeWayPartition<Type, SelectFirstPartOp, SelectSecondPartOp, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
+
+                             TileStatusViewer tile_state(tile_status, tile_partial, tile_inclusive);
+                             AgentT(tile_state,
+                                    d_in,
+                                    d_first_part_out,
+                                    d_second_part_out,
+                                    d_unselected_out,
+                                    select_first_part_op,
+                                    select_second_part_op,
+                                    num_items)
+                                 .ConsumeTile(d_num_selected_out);
+                         });
+
+            return ms_three_way_partition_shader;
+        }
+    };
+};  // namespace details
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,96 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-28 10:12:40
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-01 11:05:26
+ */
+
+#pragma once
+#include <cstddef>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/func.h>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/core/stl/vector.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/device/details/single_pass_scan_operator.h>
+
+namespace luisa::parallel_primitive
+{
+namespace details
+{
+    using namespace luisa::compute;
+
+    /// Look-back tile status words a Device module keeps across calls instead of taking them from
+    /// temp storage. Every call tags the words it writes with an epoch of its own and reads the
+    /// words of earlier calls as invalid, so the buffer is only initialized when it grows or the
+    /// epoch wraps and a scan is a single dispatch.
+    /// The calls of one module share the words: they have to run one after another, on one stream.
+    /// WordT is uint for status words, ulong for the packed descriptors of 4-byte scans
+    template <size_t BLOCK_SIZE = details::BLOCK_SIZE, typename WordT = uint>
+    class PersistentTileStatus : public LuisaModule
+    {
+        using Viewer = ScanTileStateViewer<uint>;
+
+      public:
+        static luisa::string kernel_name() noexcept
+        {
+            return make_kernel_name<WordT>("PersistentTileStatus", BLOCK_SIZE);
+        }
+
+        using TileStatusInitKernel = Shader<1, Buffer<WordT>, uint>;
+
+        struct Lease
+        {
+            BufferView<WordT> tile_status;
+            uint              epoch;
+        };
+
+        static U<TileStatusInitKernel> compile_init(Device& device)
+        {
+            U<TileStatusInitKernel> ms_tile_status_init_shader = nullptr;
+
+            lazy_compile(device,
+                         ms_tile_status_init_shader,
+                         [](BufferVar<WordT> tile_status, UInt num_tiles) noexcept
+                         {
+                             set_block_size(BLOCK_SIZE);
+                             InitializeWardStatus(num_tiles, tile_status);
+                         });
+
+            return ms_tile_status_init_shader;
+        }
+
+        /// Status words of num_tiles tiles and the epoch that tags them in this call; the
+        /// initialization is recorded to cmdlist ahead of the call when the buffer grows or the
+        /// epoch wraps
+        [[nodiscard]] Lease acquire(Device& device, CommandList& cmdlist, const TileStatusInitKernel& init, uint num_tiles)
+        {
+            const size_t num_words = Viewer::TILE_STATUS_PADDING + num_tiles;
+            const bool   grow      = m_tile_status.size() < num_words;
+            if(grow || m_epoch == Viewer::MAX_EPOCH)
+            {
+                if(grow)
+                {
+                    // commands recorded earlier may still use the old buffer, it lives as long as the module
+                    if(m_tile_status) { m_retired.emplace_back(std::move(m_tile_status)); }
+                    m_tile_status = device.create_buffer<WordT>(Viewer::TILE_STATUS_PADDING + 2 * size_t{num_tiles});
+                }
+                uint capacity = static_cast<uint>(m_tile_status.size() - Viewer::TILE_STATUS_PADDING);
+                cmdlist << init(m_tile_status, capacity).dispatch(ceil_div(capacity, uint(BLOCK_SIZE)) * BLOCK_SIZE);
+                m_epoch = 0;
+            }
+            return Lease{m_tile_status.view(0, num_words), ++m_epoch};
+        }
+
+      private:
+        Buffer<WordT>                m_tile_status;
+        luisa::vector<Buffer<WordT>> m_retired;
+        uint                         m_epoch = 0;
+    };
+}  // namespace details
+}  // namespace luisa::parallel_primitive
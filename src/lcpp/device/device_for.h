@@ -1,72 +1,192 @@
 /*
- * @Author: Ligo 
- * @Date: 2025-09-19 23:06:17 
+ * @Author: Ligo
+ * @Date: 2025-09-19 23:06:17
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-10-22 23:52:50
+ * @Last Modified time: 2026-03-07 10:02:48
  */
 #pragma once
 
+#include <algorithm>
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/memory.h>
+#include <luisa/runtime/stream.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
 #include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
 #include <lcpp/common/type_trait.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/device/details/for_each.h>
 
 namespace luisa::parallel_primitive
 {
 using namespace luisa::compute;
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
 class DeviceFor : public LuisaModule
 {
+  private:
+    uint m_block_size = BLOCK_SIZE;
+    uint m_warp_nums  = WARP_NUMS;
 
-    // using namespace luisa::compute;
-
-  public:
-    int  m_block_size    = 256;
-    int  m_num_banks     = 32;
-    int  m_log_mem_banks = 5;
-    bool m_created       = false;
+    Device m_device;
+    bool   m_created = false;
 
+    static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
 
   public:
     DeviceFor()  = default;
     ~DeviceFor() = default;
 
-
-    void create(Device& device)
+#ifndef NDEBUG
+    Stream* m_debug_stream; // bind debug stream for sync
+#endif
+    inline Stream* debug_stream() noexcept
     {
-        int num_elements_per_block = m_block_size * 2;
-        int extra_space            = num_elements_per_block / m_num_banks;
-        m_created                  = true;
+#ifndef NDEBUG
+        return m_debug_stream;
+#else
+        return nullptr;
+#endif
     }
+    void create(Device& device, Stream* debug_stream = nullptr)
+    {
+        m_device = device;
+        m_shader_cache.bind(device);
+#ifndef NDEBUG
+        m_debug_stream = debug_stream;
+#endif
+        m_created = true;
+    }
+
+    // ============================================================
+    // Dispatch APIs (no temp storage needed)
+    // ============================================================
 
+    /// Applies op(Var<Type>& item) to the first num_items elements of d_data in place
+    template <NumericT Type, typename ForEachOp>
+    void ForEachN(CommandList& cmdlist, BufferView<Type> d_data, uint num_items, ForEachOp op)
+    {
+        lcpp_check(for_each_array<Type>(cmdlist, d_data, num_items, op), cmdlist, debug_stream());
+    }
 
-    template <NumericT Type4Byte>
-    void for_each(CommandList&          cmdlist,
-                  BufferView<Type4Byte> temp_buffer,
-                  size_t                num_item,
-                  Callable<Type4Byte>   op)
+    /// Applies op(Var<Type>& item) to every element of d_data in place
+    template <NumericT Type, typename ForEachOp>
+    void ForEach(CommandList& cmdlist, BufferView<Type> d_data, ForEachOp op)
     {
+        LUISA_ASSERT(d_data.size() <= std::numeric_limits<uint>::max(),
+                     "DeviceFor::ForEach: {} items do not fit the uint index",
+                     d_data.size());
+        ForEachN(cmdlist, d_data, static_cast<uint>(d_data.size()), op);
     }
 
-    template <NumericT Type4Byte>
-    void for_each_n(CommandList&          cmdlist,
-                    BufferView<Type4Byte> temp_buffer,
-                    size_t                num_item,
-                    Callable<Type4Byte>   op)
+    /// Calls op(UInt idx, BufferVar<Ts>&... buffers) for idx in [0, num_items). The buffers are
+    /// kernel arguments, so an op that captures nothing compiles once for any buffers; an op with
+    /// captures has them baked into its kernel, which is then compiled on every call
+    template <typename BulkOp, typename... Ts>
+    void Bulk(CommandList& cmdlist, uint num_items, BulkOp op, BufferView<Ts>... buffers)
     {
+        lcpp_check(bulk_array(cmdlist, num_items, op, buffers...), cmdlist, debug_stream());
     }
 
+    /// Calls op(UInt idx, UInt3 coord, BufferVar<Ts>&... buffers) for every coord in extents,
+    /// x varying fastest; the product of extents has to fit in uint. Buffers go as in Bulk
+    template <typename ExtentsOp, typename... Ts>
+    void ForEachInExtents(CommandList& cmdlist, uint3 extents, ExtentsOp op, BufferView<Ts>... buffers)
+    {
+        LUISA_ASSERT(size_t{extents.x} * extents.y * extents.z <= std::numeric_limits<uint>::max(),
+                     "DeviceFor::ForEachInExtents: {}x{}x{} items do not fit the uint index",
+                     extents.x,
+                     extents.y,
+                     extents.z);
+        lcpp_check(extents_array(cmdlist, extents, op, buffers...), cmdlist, debug_stream());
+    }
 
-    template <NumericT Type4Byte>
-    void for_each_extents(CommandList&          cmdlist,
-                          BufferView<Type4Byte> temp_buffer,
-                          size_t                num_item,
-                          Callable<Type4Byte>   op)
+    template <typename ExtentsOp, typename... Ts>
+    void ForEachInExtents(CommandList& cmdlist, uint2 extents, ExtentsOp op, BufferView<Ts>... buffers)
     {
+        ForEachInExtents(cmdlist, make_uint3(extents, 1u), op, buffers...);
     }
 
   private:
-    template <NumericT Type4Byte>
-    void compile(Device& device)
+    uint grid_threads(uint num_items) const noexcept
+    {
+        // reduce_device_occupancy × subscription_factor, same budget as DeviceReduce;
+        // the kernels are grid-stride so larger inputs just loop over more tiles
+        constexpr uint max_blocks = BLOCK_SIZE * 8 * 5;
+        size_t         num_tiles  = ceil_div<size_t>(num_items, TILE_ITEMS);
+        return static_cast<uint>(std::min<size_t>(num_tiles, max_blocks)) * m_block_size;
+    }
+
+    // Ops are compiled into their kernel. One without state is cached by its type, while the
+    // resources and values captured by another one are baked into a kernel only good for this
+    // call, which the command list keeps alive until it has run
+    template <typename ShaderT, typename Module, typename Op, typename CompileF, typename DispatchF>
+    [[nodiscard]] int dispatch_op(CommandList& cmdlist, CompileF&& compile, DispatchF&& dispatch) noexcept
     {
-        const auto n_blocks = m_block_size;
+        if constexpr(std::is_empty_v<Op>)
+        {
+            auto ms_op_ptr = m_shader_cache.get_or_compile<ShaderT, Module, Op>(compile);
+            if(!ms_op_ptr) { return -1; }
+            dispatch(*ms_op_ptr);
+        }
+        else
+        {
+            auto ms_op_shader = compile();
+            if(!ms_op_shader) { return -1; }
+            dispatch(*ms_op_shader);
+            cmdlist.add_callback([ms_op_shader = std::move(ms_op_shader)] {});
+        }
+        return 0;
     }
+
+    template <NumericT Type, typename ForEachOp>
+    [[nodiscard]] int for_each_array(CommandList& cmdlist, BufferView<Type> d_data, uint num_items, ForEachOp op) noexcept
+    {
+        if(num_items == 0) { return 0; }
+        using ForEach       = details::ForEachModule<Type, BLOCK_SIZE, ITEMS_PER_THREAD>;
+        using ForEachKernel = ForEach::ForEachKernel;
+
+        return dispatch_op<ForEachKernel, ForEach, ForEachOp>(
+            cmdlist,
+            [&] { return ForEach().compile(m_device, op); },
+            [&](ForEachKernel& shader) { cmdlist << shader(d_data, num_items).dispatch(grid_threads(num_items)); });
+    }
+
+    template <typename BulkOp, typename... Ts>
+    [[nodiscard]] int bulk_array(CommandList& cmdlist, uint num_items, BulkOp op, BufferView<Ts>... buffers) noexcept
+    {
+        if(num_items == 0) { return 0; }
+        using Bulk       = details::BulkModule<BLOCK_SIZE, ITEMS_PER_THREAD>;
+        using BulkKernel = typename Bulk::template BulkKernel<Ts...>;
+
+        return dispatch_op<BulkKernel, Bulk, BulkOp>(
+            cmdlist,
+            [&] { return Bulk().template compile<Ts...>(m_device, op); },
+            [&](BulkKernel& shader) { cmdlist << shader(num_items, buffers...).dispatch(grid_threads(num_items)); });
+    }
+
+    template <typename ExtentsOp, typename... Ts>
+    [[nodiscard]] int extents_array(CommandList& cmdlist, uint3 extents, ExtentsOp op, BufferView<Ts>... buffers) noexcept
+    {
+        // the product is taken in 64 bits, ForEachInExtents asserts it fits the uint idx of op
+        size_t num_items = size_t{extents.x} * extents.y * extents.z;
+        if(num_items == 0) { return 0; }
+        using Bulk          = details::BulkModule<BLOCK_SIZE, ITEMS_PER_THREAD>;
+        using ExtentsKernel = typename Bulk::template ExtentsKernel<Ts...>;
+
+        return dispatch_op<ExtentsKernel, Bulk, ExtentsOp>(
+            cmdlist,
+            [&] { return Bulk().template compile_extents<Ts...>(m_device, op); },
+            [&](ExtentsKernel& shader)
+            { cmdlist << shader(extents, buffers...).dispatch(grid_threads(static_cast<uint>(num_items))); });
+    }
+
+    ShaderCache m_shader_cache{make_kernel_name("DeviceFor", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
 };
-}  // namespace luisa::parallel_primitive
\ No newline at end of file
+}  // namespace luisa::parallel_primitive
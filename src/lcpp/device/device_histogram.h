@@ -1,12 +1,13 @@
 /*
- * @Author: Ligo 
- * @Date: 2025-11-12 14:42:25 
+ * @Author: Ligo
+ * @Date: 2025-11-12 14:42:25
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-12 16:43:49
+ * @Last Modified time: 2026-02-26 17:20:46
  */
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <luisa/core/mathematics.h>
 #include <luisa/dsl/local.h>
 #include <limits>
@@ -16,24 +17,388 @@
 #include <luisa/dsl/struct.h>
 #include <luisa/core/logging.h>
 #include <luisa/core/stl/memory.h>
+#include <luisa/core/stl/format.h>
 #include <luisa/dsl/builtin.h>
 #include <luisa/dsl/resource.h>
 #include <luisa/dsl/sugar.h>
 #include <luisa/dsl/var.h>
 #include <cstddef>
 #include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
 #include <lcpp/common/type_trait.h>
 #include <lcpp/common/util_type.h>
 #include <lcpp/common/thread_operators.h>
 #include <lcpp/common/utils.h>
 #include <lcpp/agent/policy.h>
+#include <lcpp/agent/agent_histogram.h>
+#include <lcpp/device/details/histogram.h>
 
 namespace luisa::parallel_primitive
 {
 
 using namespace luisa::compute;
-template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
-class DeviceDeviceHistogram : public LuisaModule
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename HistogramPolicy = AgentHistogramPolicy<BLOCK_SIZE, ITEMS_PER_THREAD, true, false>>
+class DeviceHistogram : public LuisaModule
 {
+  private:
+    uint m_block_size = HistogramPolicy::BLOCK_THREADS;
+    uint m_warp_nums  = WARP_NUMS;
+
+    Device m_device;
+    bool   m_created = false;
+
+    static constexpr uint TILE_PIXELS = HistogramPolicy::BLOCK_THREADS * HistogramPolicy::PIXELS_PER_THREAD;
+
+  public:
+    DeviceHistogram()  = default;
+    ~DeviceHistogram() = default;
+
+#ifndef NDEBUG
+    Stream* m_debug_stream; // bind debug stream for sync
+#endif
+    inline Stream* debug_stream() noexcept
+    {
+#ifndef NDEBUG
+        return m_debug_stream;
+#else
+        return nullptr;
+#endif
+    }
+    void create(Device& device, Stream* debug_stream = nullptr)
+    {
+        m_device = device;
+        m_shader_cache.bind(device);
+#ifndef NDEBUG
+        m_debug_stream = debug_stream;
+#endif
+        m_created = true;
+    }
+
+    // ============================================================
+    // GetTempStorageBytes: compute required temp buffer size (in bytes)
+    // ============================================================
+
+    /// Temp storage bytes for HistogramEven / HistogramRange (single channel)
+    /// Needs: tile queue counter only, bins are accumulated straight into d_histogram
+    template <NumericT SampleT>
+    static size_t GetTempStorageBytes(uint num_levels)
+    {
+        return GetMultiTempStorageBytes<1, 1, SampleT>(std::array<uint, 1>{num_levels});
+    }
+
+    /// Temp storage bytes for MultiHistogramEven / MultiHistogramRange
+    /// Needs: tile queue counter + concatenated bins of all active channels + concatenated levels
+    template <size_t NUM_CHANNELS, size_t NUM_ACTIVE_CHANNELS, NumericT SampleT>
+    static size_t GetMultiTempStorageBytes(const std::array<uint, NUM_ACTIVE_CHANNELS>& num_levels)
+    {
+        size_t total_bins   = 0;
+        size_t total_levels = 0;
+        for(auto channel = 0u; channel < NUM_ACTIVE_CHANNELS; ++channel)
+        {
+            total_levels += num_levels[channel];
+            total_bins += num_levels[channel] > 0 ? num_levels[channel] - 1 : 0;
+        }
+
+        size_t bytes = 0;
+        bytes += details::WARP_SIZE * sizeof(uint);  // tile queue (padded)
+        if constexpr(NUM_ACTIVE_CHANNELS > 1)
+        {
+            bytes += total_bins * sizeof(uint);  // concatenated histograms
+            bytes = align_up_uint(bytes, alignof(SampleT));
+            bytes += total_levels * sizeof(SampleT);  // concatenated levels (range binning)
+        }
+        return bytes;
+    }
+
+    // ============================================================
+    // Dispatch APIs (CUB-style: caller provides temp_storage)
+    // ============================================================
+
+    /// Evenly-spaced bins: num_levels - 1 bins of width (upper - lower) / (num_levels - 1);
+    /// samples outside [lower_level, upper_level) are ignored
+    template <NumericT SampleT>
+    void HistogramEven(CommandList&        cmdlist,
+                       BufferView<uint>    temp_storage,
+                       BufferView<SampleT> d_samples,
+                       BufferView<uint>    d_histogram,
+                       uint                num_levels,
+                       SampleT             lower_level,
+                       SampleT             upper_level,
+                       uint                num_samples)
+    {
+        MultiHistogramEven<1, 1, SampleT>(cmdlist,
+                                          temp_storage,
+                                          d_samples,
+                                          {d_histogram},
+                                          {num_levels},
+                                          {lower_level},
+                                          {upper_level},
+                                          num_samples);
+    }
+
+    /// Custom bins: bin i covers [d_levels[i], d_levels[i + 1]), d_levels must be sorted
+    template <NumericT SampleT>
+    void HistogramRange(CommandList&        cmdlist,
+                        BufferView<uint>    temp_storage,
+                        BufferView<SampleT> d_samples,
+                        BufferView<uint>    d_histogram,
+                        uint                num_levels,
+                        BufferView<SampleT> d_levels,
+                        uint                num_samples)
+    {
+        MultiHistogramRange<1, 1, SampleT>(
+            cmdlist, temp_storage, d_samples, {d_histogram}, {num_levels}, {d_levels}, num_samples);
+    }
+
+    /// d_samples holds num_pixels interleaved pixels of NUM_CHANNELS samples (e.g. RGBA),
+    /// the first NUM_ACTIVE_CHANNELS channels are histogrammed
+    template <size_t NUM_CHANNELS, size_t NUM_ACTIVE_CHANNELS, NumericT SampleT>
+    void MultiHistogramEven(CommandList&                                         cmdlist,
+                            BufferView<uint>                                     temp_storage,
+                            BufferView<SampleT>                                  d_samples,
+                            const std::array<BufferView<uint>, NUM_ACTIVE_CHANNELS>& d_histogram,
+                            const std::array<uint, NUM_ACTIVE_CHANNELS>&         num_levels,
+                            const std::array<SampleT, NUM_ACTIVE_CHANNELS>&      lower_level,
+                            const std::array<SampleT, NUM_ACTIVE_CHANNELS>&      upper_level,
+                            uint                                                 num_pixels)
+    {
+        Vector<SampleT, 4> lower{};
+        Vector<SampleT, 4> upper{};
+        for(auto channel = 0u; channel < NUM_ACTIVE_CHANNELS; ++channel)
+        {
+            lower[channel] = lower_level[channel];
+            upper[channel] = upper_level[channel];
+        }
+        lcpp_check(histogram_array<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, SampleT, true>(
+                       cmdlist, temp_storage, d_samples, d_histogram, num_levels, {}, lower, upper, num_pixels),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    template <size_t NUM_CHANNELS, size_t NUM_ACTIVE_CHANNELS, NumericT SampleT>
+    void MultiHistogramRange(CommandList&                                            cmdlist,
+                             BufferView<uint>                                        temp_storage,
+                             BufferView<SampleT>                                     d_samples,
+                             const std::array<BufferView<uint>, NUM_ACTIVE_CHANNELS>&    d_histogram,
+                             const std::array<uint, NUM_ACTIVE_CHANNELS>&            num_levels,
+                             const std::array<BufferView<SampleT>, NUM_ACTIVE_CHANNELS>& d_levels,
+                             uint                                                    num_pixels)
+    {
+        lcpp_check(histogram_array<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, SampleT, false>(
+                       cmdlist, temp_storage, d_samples, d_histogram, num_levels, d_levels, {}, {}, num_pixels),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT SampleT>
+    void HistogramEven(CommandList&        cmdlist,
+                       CachingAllocator&   allocator,
+                       const Stream&       stream,
+                       BufferView<SampleT> d_samples,
+                       BufferView<uint>    d_histogram,
+                       uint                num_levels,
+                       SampleT             lower_level,
+                       SampleT             upper_level,
+                       uint                num_samples)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<SampleT>(num_levels));
+        HistogramEven(cmdlist, temp.view(), d_samples, d_histogram, num_levels, lower_level, upper_level, num_samples);
+    }
+
+    template <NumericT SampleT>
+    void HistogramRange(CommandList&        cmdlist,
+                        CachingAllocator&   allocator,
+                        const Stream&       stream,
+                        BufferView<SampleT> d_samples,
+                        BufferView<uint>    d_histogram,
+                        uint                num_levels,
+                        BufferView<SampleT> d_levels,
+                        uint                num_samples)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<SampleT>(num_levels));
+        HistogramRange(cmdlist, temp.view(), d_samples, d_histogram, num_levels, d_levels, num_samples);
+    }
+
+    template <size_t NUM_CHANNELS, size_t NUM_ACTIVE_CHANNELS, NumericT SampleT>
+    void MultiHistogramEven(CommandList&                                             cmdlist,
+                            CachingAllocator&                                        allocator,
+                            const Stream&                                            stream,
+                            BufferView<SampleT>                                      d_samples,
+                            const std::array<BufferView<uint>, NUM_ACTIVE_CHANNELS>& d_histogram,
+                            const std::array<uint, NUM_ACTIVE_CHANNELS>&             num_levels,
+                            const std::array<SampleT, NUM_ACTIVE_CHANNELS>&          lower_level,
+                            const std::array<SampleT, NUM_ACTIVE_CHANNELS>&          upper_level,
+                            uint                                                     num_pixels)
+    {
+        auto temp = allocator.allocate(stream, GetMultiTempStorageBytes<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, SampleT>(num_levels));
+        MultiHistogramEven<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, SampleT>(
+            cmdlist, temp.view(), d_samples, d_histogram, num_levels, lower_level, upper_level, num_pixels);
+    }
+
+    template <size_t NUM_CHANNELS, size_t NUM_ACTIVE_CHANNELS, NumericT SampleT>
+    void MultiHistogramRange(CommandList&                                                cmdlist,
+                             CachingAllocator&                                           allocator,
+                             const Stream&                                               stream,
+                             BufferView<SampleT>                                         d_samples,
+                             const std::array<BufferView<uint>, NUM_ACTIVE_CHANNELS>&    d_histogram,
+                             const std::array<uint, NUM_ACTIVE_CHANNELS>&                num_levels,
+                             const std::array<BufferView<SampleT>, NUM_ACTIVE_CHANNELS>& d_levels,
+                             uint                                                        num_pixels)
+    {
+        auto temp = allocator.allocate(stream, GetMultiTempStorageBytes<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, SampleT>(num_levels));
+        MultiHistogramRange<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, SampleT>(
+            cmdlist, temp.view(), d_samples, d_histogram, num_levels, d_levels, num_pixels);
+    }
+
+  private:
+    template <size_t NUM_CHANNELS, size_t NUM_ACTIVE_CHANNELS, NumericT SampleT, bool IS_EVEN>
+    [[nodiscard]] int histogram_array(CommandList&                                             cmdlist,
+                                      BufferView<uint>                                         temp_storage,
+                                      BufferView<SampleT>                                      d_samples,
+                                      const std::array<BufferView<uint>, NUM_ACTIVE_CHANNELS>& d_histogram,
+                                      const std::array<uint, NUM_ACTIVE_CHANNELS>&             num_levels,
+                                      const std::array<BufferView<SampleT>, NUM_ACTIVE_CHANNELS>& d_levels,
+                                      Vector<SampleT, 4>                                       lower,
+                                      Vector<SampleT, 4>                                       upper,
+                                      uint                                                     num_pixels) noexcept
+    {
+        uint4 num_bins      = make_uint4(0u);
+        uint4 bin_offsets   = make_uint4(0u);
+        uint4 level_offsets = make_uint4(0u);
+        uint  total_bins    = 0;
+        uint  total_levels  = 0;
+        bool  is_privatized = true;
+        for(auto channel = 0u; channel < NUM_ACTIVE_CHANNELS; ++channel)
+        {
+            if(num_levels[channel] < 2) { return -1; }
+            num_bins[channel]      = num_levels[channel] - 1;
+            bin_offsets[channel]   = total_bins;
+            level_offsets[channel] = total_levels;
+            total_bins += num_bins[channel];
+            total_levels += num_levels[channel];
+            is_privatized &= num_bins[channel] <= details::MAX_PRIVATIZED_SMEM_BINS;
+        }
+
+        // Carve out sub-buffers from temp_storage
+        size_t offset_bytes = 0;
+        auto   d_tile_queue = temp_storage.subview(0, details::WARP_SIZE);
+        offset_bytes += details::WARP_SIZE * sizeof(uint);
+
+        // a single channel accumulates straight into the output, several channels share one
+        // concatenated histogram (and level table) that is split up afterwards
+        BufferView<uint>    d_histogram_all = d_histogram[0];
+        BufferView<SampleT> d_levels_all;
+        if constexpr(!IS_EVEN)
+        {
+            d_levels_all = d_levels[0];
+        }
+        if constexpr(NUM_ACTIVE_CHANNELS > 1)
+        {
+            d_histogram_all = temp_storage.subview(offset_bytes / sizeof(uint), total_bins);
+            offset_bytes += total_bins * sizeof(uint);
+            offset_bytes = align_up_uint(offset_bytes, alignof(SampleT));
+
+            if constexpr(!IS_EVEN)
+            {
+                size_t levels_uint_count = bytes_to_uint_count((size_t)total_levels * sizeof(SampleT));
+                d_levels_all = temp_storage.subview(offset_bytes / sizeof(uint), levels_uint_count)
+                                   .template as<SampleT>()
+                                   .subview(0, total_levels);
+                for(auto channel = 0u; channel < NUM_ACTIVE_CHANNELS; ++channel)
+                {
+                    cmdlist << d_levels_all.subview(level_offsets[channel], num_levels[channel])
+                                   .copy_from(d_levels[channel].subview(0, num_levels[channel]));
+                }
+            }
+        }
+
+        // zero bins and tile queue
+        using HistogramInit       = details::HistogramInitModule<BLOCK_SIZE>;
+        using HistogramInitKernel = HistogramInit::HistogramInitKernel;
+        auto ms_histogram_init_ptr = m_shader_cache.get_or_compile<HistogramInitKernel, HistogramInit>(
+            [&] { return HistogramInit().compile(m_device); });
+        if(!ms_histogram_init_ptr) { return -1; }
+        cmdlist << (*ms_histogram_init_ptr)(d_histogram_all, d_tile_queue, total_bins).dispatch(total_bins);
+
+        uint num_tiles = ceil_div(num_pixels, TILE_PIXELS);
+        if(num_tiles > 0)
+        {
+            // histogram_device_occupancy × subscription_factor, same budget as DeviceReduce
+            constexpr uint max_blocks = BLOCK_SIZE * 8 * 5;
+            uint           num_blocks = std::min(num_tiles, max_blocks);
+
+            int result = is_privatized ?
+                             histogram_dispatch<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, SampleT, IS_EVEN, true>(
+                                 cmdlist, d_samples, d_levels_all, d_histogram_all, d_tile_queue, num_pixels, num_tiles, num_blocks, num_bins, bin_offsets, level_offsets, lower, upper) :
+                             histogram_dispatch<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, SampleT, IS_EVEN, false>(
+                                 cmdlist, d_samples, d_levels_all, d_histogram_all, d_tile_queue, num_pixels, num_tiles, num_blocks, num_bins, bin_offsets, level_offsets, lower, upper);
+            if(result != 0) { return result; }
+        }
+
+        if constexpr(NUM_ACTIVE_CHANNELS > 1)
+        {
+            for(auto channel = 0u; channel < NUM_ACTIVE_CHANNELS; ++channel)
+            {
+                cmdlist << d_histogram[channel].subview(0, num_bins[channel])
+                               .copy_from(d_histogram_all.subview(bin_offsets[channel], num_bins[channel]));
+            }
+        }
+        return 0;
+    }
+
+    template <size_t NUM_CHANNELS, size_t NUM_ACTIVE_CHANNELS, NumericT SampleT, bool IS_EVEN, bool IS_PRIVATIZED>
+    [[nodiscard]] int histogram_dispatch(CommandList&        cmdlist,
+                                         BufferView<SampleT> d_samples,
+                                         BufferView<SampleT> d_levels,
+                                         BufferView<uint>    d_histogram,
+                                         BufferView<uint>    d_tile_queue,
+                                         uint                num_pixels,
+                                         uint                num_tiles,
+                                         uint                num_blocks,
+                                         uint4               num_bins,
+                                         uint4               bin_offsets,
+                                         uint4               level_offsets,
+                                         Vector<SampleT, 4>  lower,
+                                         Vector<SampleT, 4>  upper) noexcept
+    {
+        using Histogram =
+            details::HistogramModule<SampleT, NUM_CHANNELS, NUM_ACTIVE_CHANNELS, IS_PRIVATIZED, HistogramPolicy>;
+
+        if constexpr(IS_EVEN)
+        {
+            using HistogramKernel = Histogram::HistogramEvenKernel;
+            auto ms_histogram_ptr = m_shader_cache.get_or_compile<HistogramKernel, Histogram>(
+                [&] { return Histogram().compile_even(m_device); });
+            if(!ms_histogram_ptr) { return -1; }
+            cmdlist << (*ms_histogram_ptr)(d_samples, d_histogram, d_tile_queue, num_pixels, num_tiles, num_bins, bin_offsets, lower, upper)
+                           .dispatch(num_blocks * m_block_size);
+        }
+        else
+        {
+            using HistogramKernel = Histogram::HistogramRangeKernel;
+            auto ms_histogram_ptr = m_shader_cache.get_or_compile<HistogramKernel, Histogram>(
+                [&] { return Histogram().compile_range(m_device); });
+            if(!ms_histogram_ptr) { return -1; }
+            cmdlist << (*ms_histogram_ptr)(d_samples, d_levels, d_histogram, d_tile_queue, num_pixels, num_tiles, num_bins, bin_offsets, level_offsets)
+                           .dispatch(num_blocks * m_block_size);
+        }
+        return 0;
+    }
+
+    ShaderCache m_shader_cache{make_kernel_name("DeviceHistogram",
+                                                 BLOCK_SIZE,
+                                                 WARP_NUMS,
+                                                 ITEMS_PER_THREAD,
+                                                 HistogramPolicy::BLOCK_THREADS,
+                                                 HistogramPolicy::PIXELS_PER_THREAD,
+                                                 HistogramPolicy::IS_RLE_COMPRESS,
+                                                 HistogramPolicy::IS_WORK_STEALING,
+                                                 HistogramPolicy::VEC_SIZE)};
 };
-}  // namespace luisa::parallel_primitive
\ No newline at end of file
+}  // namespace luisa::parallel_primitive
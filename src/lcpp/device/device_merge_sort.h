@@ -0,0 +1,256 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-15 14:10:42
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-26 17:20:46
+ */
+#pragma once
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/memory.h>
+#include <luisa/runtime/stream.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <algorithm>
+#include <cstddef>
+#include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/device/details/merge_sort.h>
+
+namespace luisa::parallel_primitive
+{
+using namespace luisa::compute;
+
+/// Comparison based sort: keys may be any struct type, ordered by a user
+/// compare_op(const Var<KeyType>&, const Var<KeyType>&) -> Bool that returns true when a goes before b.
+/// Tiles are sorted with BlockMergeSort, then merged pairwise with merge-path partitioning
+/// in ceil(log2(num_tiles)) passes. The sort is always stable.
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+class DeviceMergeSort : public LuisaModule
+{
+  private:
+    uint m_block_size = BLOCK_SIZE;
+    uint m_warp_nums  = WARP_NUMS;
+
+    Device m_device;
+    bool   m_created = false;
+
+    static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+  public:
+    DeviceMergeSort()  = default;
+    ~DeviceMergeSort() = default;
+
+#ifndef NDEBUG
+    Stream* m_debug_stream; // bind debug stream for sync
+#endif
+    inline Stream* debug_stream() noexcept
+    {
+#ifndef NDEBUG
+        return m_debug_stream;
+#else
+        return nullptr;
+#endif
+    }
+    void create(Device& device, Stream* debug_stream = nullptr)
+    {
+        m_device = device;
+        m_shader_cache.bind(device);
+#ifndef NDEBUG
+        m_debug_stream = debug_stream;
+#endif
+        m_created = true;
+    }
+
+    // ============================================================
+    // GetTempStorageBytes: compute required temp buffer size (in bytes)
+    // ============================================================
+
+    /// Temp storage bytes for SortPairs / StableSortPairs
+    template <typename KeyType, typename ValueType>
+    static size_t GetSortPairsTempStorageBytes(uint num_items)
+    {
+        return temp_storage_bytes<KeyType, ValueType, false>(num_items);
+    }
+
+    /// Temp storage bytes for SortKeys / StableSortKeys
+    template <typename KeyType>
+    static size_t GetSortKeysTempStorageBytes(uint num_items)
+    {
+        return temp_storage_bytes<KeyType, KeyType, true>(num_items);
+    }
+
+    // ============================================================
+    // Dispatch APIs (CUB-style: caller provides temp_storage)
+    // ============================================================
+
+    /// Sorts d_keys in place; d_values is permuted along with its key
+    template <typename KeyType, typename ValueType, typename CompareOp>
+    void SortPairs(CommandList&          cmdlist,
+                   BufferView<uint>      temp_storage,
+                   BufferView<KeyType>   d_keys,
+                   BufferView<ValueType> d_values,
+                   uint                  num_items,
+                   CompareOp             compare_op)
+    {
+        lcpp_check(merge_sort<KeyType, ValueType, false>(cmdlist, temp_storage, d_keys, d_values, num_items, compare_op),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// Sorts d_keys in place
+    template <typename KeyType, typename CompareOp>
+    void SortKeys(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<KeyType> d_keys, uint num_items, CompareOp compare_op)
+    {
+        lcpp_check(merge_sort<KeyType, KeyType, true>(
+                       cmdlist, temp_storage, d_keys, d_keys.subview(0, 0) /*dummy*/, num_items, compare_op),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// Same as SortPairs, which already keeps equal keys in input order
+    template <typename KeyType, typename ValueType, typename CompareOp>
+    void StableSortPairs(CommandList&          cmdlist,
+                         BufferView<uint>      temp_storage,
+                         BufferView<KeyType>   d_keys,
+                         BufferView<ValueType> d_values,
+                         uint                  num_items,
+                         CompareOp             compare_op)
+    {
+        SortPairs(cmdlist, temp_storage, d_keys, d_values, num_items, compare_op);
+    }
+
+    /// Same as SortKeys, which already keeps equal keys in input order
+    template <typename KeyType, typename CompareOp>
+    void StableSortKeys(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<KeyType> d_keys, uint num_items, CompareOp compare_op)
+    {
+        SortKeys(cmdlist, temp_storage, d_keys, num_items, compare_op);
+    }
+
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <typename KeyType, typename ValueType, typename CompareOp>
+    void SortPairs(CommandList&          cmdlist,
+                   CachingAllocator&     allocator,
+                   const Stream&         stream,
+                   BufferView<KeyType>   d_keys,
+                   BufferView<ValueType> d_values,
+                   uint                  num_items,
+                   CompareOp             compare_op)
+    {
+        auto temp = allocator.allocate(stream, GetSortPairsTempStorageBytes<KeyType, ValueType>(num_items));
+        SortPairs(cmdlist, temp.view(), d_keys, d_values, num_items, compare_op);
+    }
+
+    template <typename KeyType, typename CompareOp>
+    void SortKeys(CommandList& cmdlist, CachingAllocator& allocator, const Stream& stream, BufferView<KeyType> d_keys, uint num_items, CompareOp compare_op)
+    {
+        auto temp = allocator.allocate(stream, GetSortKeysTempStorageBytes<KeyType>(num_items));
+        SortKeys(cmdlist, temp.view(), d_keys, num_items, compare_op);
+    }
+
+  private:
+    // [merge partitions | key buffer | value buffer]
+    template <typename KeyType, typename ValueType, bool KEY_ONLY>
+    static size_t temp_storage_bytes(uint num_items)
+    {
+        uint num_tiles = std::max(1u, ceil_div(num_items, TILE_ITEMS));
+
+        size_t bytes = (size_t)(num_tiles + 1) * sizeof(uint);
+        bytes        = align_up_uint(bytes, alignof(KeyType));
+        bytes += bytes_to_uint_count((size_t)num_items * sizeof(KeyType)) * sizeof(uint);
+        if constexpr(!KEY_ONLY)
+        {
+            bytes = align_up_uint(bytes, alignof(ValueType));
+            bytes += bytes_to_uint_count((size_t)num_items * sizeof(ValueType)) * sizeof(uint);
+        }
+        return bytes;
+    }
+
+    template <typename KeyType, typename ValueType, bool KEY_ONLY, typename CompareOp>
+    [[nodiscard]] int merge_sort(CommandList&          cmdlist,
+                                 BufferView<uint>      temp_storage,
+                                 BufferView<KeyType>   d_keys,
+                                 BufferView<ValueType> d_values,
+                                 uint                  num_items,
+                                 CompareOp             compare_op) noexcept
+    {
+        using MergeSort            = details::MergeSortModule<KeyType, ValueType, KEY_ONLY, BLOCK_SIZE, ITEMS_PER_THREAD>;
+        using BlockSortKernel      = MergeSort::BlockSortKernel;
+        using MergePartitionKernel = MergeSort::MergePartitionKernel;
+        using MergeKernel          = MergeSort::MergeKernel;
+
+        if(num_items == 0) { return 0; }
+
+        uint num_tiles      = ceil_div(num_items, TILE_ITEMS);
+        uint num_partitions = num_tiles + 1;
+        uint num_passes     = 0;
+        for(uint merged = 1; merged < num_tiles; merged *= 2) { ++num_passes; }
+
+        size_t offset_bytes       = 0;
+        auto   d_merge_partitions = temp_storage.subview(0, num_partitions);
+        offset_bytes += num_partitions * sizeof(uint);
+
+        offset_bytes           = align_up_uint(offset_bytes, alignof(KeyType));
+        size_t keys_uint_count = bytes_to_uint_count((size_t)num_items * sizeof(KeyType));
+        auto   d_keys_tmp = temp_storage.subview(offset_bytes / sizeof(uint), keys_uint_count).template as<KeyType>();
+        offset_bytes += keys_uint_count * sizeof(uint);
+
+        auto d_values_tmp = d_values;
+        if constexpr(!KEY_ONLY)
+        {
+            offset_bytes             = align_up_uint(offset_bytes, alignof(ValueType));
+            size_t values_uint_count = bytes_to_uint_count((size_t)num_items * sizeof(ValueType));
+            d_values_tmp = temp_storage.subview(offset_bytes / sizeof(uint), values_uint_count).template as<ValueType>();
+        }
+
+        auto ms_block_sort_ptr = m_shader_cache.get_or_compile<BlockSortKernel, MergeSort, CompareOp>(
+            [&] { return MergeSort().compile_block_sort(m_device, compare_op); });
+        if(!ms_block_sort_ptr) { return -1; }
+
+        auto ms_merge_partition_ptr = m_shader_cache.get_or_compile<MergePartitionKernel, MergeSort, CompareOp>(
+            [&] { return MergeSort().compile_merge_partition(m_device, compare_op); });
+        if(!ms_merge_partition_ptr) { return -1; }
+
+        auto ms_merge_ptr = m_shader_cache.get_or_compile<MergeKernel, MergeSort, CompareOp>(
+            [&] { return MergeSort().compile_merge(m_device, compare_op); });
+        if(!ms_merge_ptr) { return -1; }
+
+        // every pass flips the buffers, so start in the one that makes the last pass land in d_keys;
+        // the block sort loads its whole tile before storing, so sorting d_keys onto itself is safe
+        bool ping = num_passes % 2 == 0;
+        cmdlist << (*ms_block_sort_ptr)(d_keys,
+                                        ping ? d_keys : d_keys_tmp,
+                                        d_values,
+                                        ping ? d_values : d_values_tmp,
+                                        num_items)
+                       .dispatch(num_tiles * m_block_size);
+
+        for(uint target_merged_tiles = 2; target_merged_tiles < 2 * num_tiles; target_merged_tiles *= 2)
+        {
+            auto keys_in    = ping ? d_keys : d_keys_tmp;
+            auto keys_out   = ping ? d_keys_tmp : d_keys;
+            auto values_in  = ping ? d_values : d_values_tmp;
+            auto values_out = ping ? d_values_tmp : d_values;
+
+            cmdlist << (*ms_merge_partition_ptr)(keys_in, d_merge_partitions, num_items, num_partitions, target_merged_tiles)
+                           .dispatch(ceil_div(num_partitions, m_block_size) * m_block_size);
+            cmdlist << (*ms_merge_ptr)(keys_in, keys_out, values_in, values_out, d_merge_partitions, num_items, target_merged_tiles)
+                           .dispatch(num_tiles * m_block_size);
+            ping = !ping;
+        }
+        return 0;
+    }
+
+    ShaderCache m_shader_cache{make_kernel_name("DeviceMergeSort", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
+};
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,330 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-13 11:52:30
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-07 10:46:02
+ */
+#pragma once
+
+#include <algorithm>
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/memory.h>
+#include <luisa/runtime/stream.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <cstddef>
+#include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/device/details/select.h>
+#include <lcpp/device/details/three_way_partition.h>
+
+namespace luisa::parallel_primitive
+{
+using namespace luisa::compute;
+/// DelayPolicy paces the decoupled look-back of the two-way and three-way partitions, see DeviceScan
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
+class DevicePartition : public LuisaModule
+{
+  private:
+    uint m_block_size = BLOCK_SIZE;
+    uint m_warp_nums  = WARP_NUMS;
+
+    Device m_device;
+    bool   m_created = false;
+
+    using SelectMode = details::SelectMode;
+
+  public:
+    DevicePartition()  = default;
+    ~DevicePartition() = default;
+
+#ifndef NDEBUG
+    Stream* m_debug_stream; // bind debug stream for sync
+#endif
+    inline Stream* debug_stream() noexcept
+    {
+#ifndef NDEBUG
+        return m_debug_stream;
+#else
+        return nullptr;
+#endif
+    }
+    void create(Device& device, Stream* debug_stream = nullptr)
+    {
+        m_device = device;
+        m_shader_cache.bind(device);
+#ifndef NDEBUG
+        m_debug_stream = debug_stream;
+#endif
+        m_created = true;
+    }
+
+    // ============================================================
+    // GetTempStorageBytes: compute required temp buffer size (in bytes)
+    // ============================================================
+
+    /// Temp storage bytes for the two-way Flagged / If
+    static size_t GetTempStorageBytes(size_t num_items)
+    {
+        size_t num_tiles  = std::max<size_t>(1, ceil_div<size_t>(num_items, ITEMS_PER_THREAD * BLOCK_SIZE));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
+
+        size_t bytes = 0;
+        bytes += tile_count * sizeof(uint);  // tile_status
+        bytes += tile_count * sizeof(uint);  // tile_partial
+        bytes += tile_count * sizeof(uint);  // tile_inclusive
+        return bytes;
+    }
+
+    /// Temp storage bytes for the three-way If
+    static size_t GetThreeWayTempStorageBytes(size_t num_items)
+    {
+        using AccumPackT  = KeyValuePair<uint, uint>;
+        size_t num_tiles  = std::max<size_t>(1, ceil_div<size_t>(num_items, ITEMS_PER_THREAD * BLOCK_SIZE));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
+
+        size_t bytes = 0;
+        bytes += tile_count * sizeof(uint);        // tile_status
+        bytes  = align_up_uint(bytes, alignof(AccumPackT));
+        bytes += tile_count * sizeof(AccumPackT);  // tile_partial
+        bytes  = align_up_uint(bytes, alignof(AccumPackT));
+        bytes += tile_count * sizeof(AccumPackT);  // tile_inclusive
+        return bytes;
+    }
+
+    // ============================================================
+    // Dispatch APIs (CUB-style: caller provides temp_storage)
+    // ============================================================
+
+    /// Items with d_flags[i] != 0 go to the front of d_out in input order, the rest fill the
+    /// back of d_out in reverse order; the number of selected items is written to d_num_selected_out[0]
+    template <NumericT Type, NumericT FlagT>
+    void Flagged(CommandList&      cmdlist,
+                 BufferView<uint>  temp_storage,
+                 BufferView<Type>  d_in,
+                 BufferView<FlagT> d_flags,
+                 BufferView<Type>  d_out,
+                 BufferView<uint>  d_num_selected_out,
+                 uint              num_items)
+    {
+        lcpp_check(partition_array<SelectMode::Flagged, Type, FlagT>(
+                       cmdlist, temp_storage, d_in, d_flags, d_out, d_num_selected_out, num_items, IdentityOp()),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// Same layout as Flagged with select_op(d_in[i]) deciding the split
+    template <NumericT Type, typename SelectOp>
+    void If(CommandList&     cmdlist,
+            BufferView<uint> temp_storage,
+            BufferView<Type> d_in,
+            BufferView<Type> d_out,
+            BufferView<uint> d_num_selected_out,
+            uint             num_items,
+            SelectOp         select_op)
+    {
+        lcpp_check(partition_array<SelectMode::If, Type, uint>(
+                       cmdlist, temp_storage, d_in, temp_storage.subview(0, 1), d_out, d_num_selected_out, num_items, select_op),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// Three-way split, e.g. less / equal / greater than a pivot: items passing select_first_part_op go to
+    /// d_first_part_out, the remaining ones passing select_second_part_op go to d_second_part_out and the
+    /// rest to d_unselected_out, each in input order. d_num_selected_out[0..1] receive the first two sizes
+    template <NumericT Type, typename SelectFirstPartOp, typename SelectSecondPartOp>
+    void If(CommandList&       cmdlist,
+            BufferView<uint>   temp_storage,
+            BufferView<Type>   d_in,
+            BufferView<Type>   d_first_part_out,
+            BufferView<Type>   d_second_part_out,
+            BufferView<Type>   d_unselected_out,
+            BufferView<uint>   d_num_selected_out,
+            uint               num_items,
+            SelectFirstPartOp  select_first_part_op,
+            SelectSecondPartOp select_second_part_op)
+    {
+        lcpp_check(three_way_partition_array<Type>(cmdlist,
+                                                   temp_storage,
+                                                   d_in,
+                                                   d_first_part_out,
+                                                   d_second_part_out,
+                                                   d_unselected_out,
+                                                   d_num_selected_out,
+                                                   num_items,
+                                                   select_first_part_op,
+                                                   select_second_part_op),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT Type, NumericT FlagT>
+    void Flagged(CommandList&      cmdlist,
+                 CachingAllocator& allocator,
+                 const Stream&     stream,
+                 BufferView<Type>  d_in,
+                 BufferView<FlagT> d_flags,
+                 BufferView<Type>  d_out,
+                 BufferView<uint>  d_num_selected_out,
+                 uint              num_items)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes(num_items));
+        Flagged(cmdlist, temp.view(), d_in, d_flags, d_out, d_num_selected_out, num_items);
+    }
+
+    template <NumericT Type, typename SelectOp>
+    void If(CommandList&      cmdlist,
+            CachingAllocator& allocator,
+            const Stream&     stream,
+            BufferView<Type>  d_in,
+            BufferView<Type>  d_out,
+            BufferView<uint>  d_num_selected_out,
+            uint              num_items,
+            SelectOp          select_op)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes(num_items));
+        If(cmdlist, temp.view(), d_in, d_out, d_num_selected_out, num_items, select_op);
+    }
+
+    template <NumericT Type, typename SelectFirstPartOp, typename SelectSecondPartOp>
+    void If(CommandList&       cmdlist,
+            CachingAllocator&  allocator,
+            const Stream&      stream,
+            BufferView<Type>   d_in,
+            BufferView<Type>   d_first_part_out,
+            BufferView<Type>   d_second_part_out,
+            BufferView<Type>   d_unselected_out,
+            BufferView<uint>   d_num_selected_out,
+            uint               num_items,
+            SelectFirstPartOp  select_first_part_op,
+            SelectSecondPartOp select_second_part_op)
+    {
+        auto temp = allocator.allocate(stream, GetThreeWayTempStorageBytes(num_items));
+        If(cmdlist,
+           temp.view(),
+           d_in,
+           d_first_part_out,
+           d_second_part_out,
+           d_unselected_out,
+           d_num_selected_out,
+           num_items,
+           select_first_part_op,
+           select_second_part_op);
+    }
+
+  private:
+    template <typename Module>
+    [[nodiscard]] int init_tile_state(CommandList& cmdlist, BufferView<uint> tile_status, uint num_tiles) noexcept
+    {
+        using ScanTileStateInitKernel = Module::ScanTileStateInitKernel;
+
+        // the init kernel only depends on BLOCK_SIZE, one instance serves both partition flavours
+        auto ms_scan_tile_state_init_ptr =
+            m_shader_cache.get_or_compile<ScanTileStateInitKernel, std::integral_constant<size_t, BLOCK_SIZE>>(
+                [&] { return Module().compile_scan_tile_state_init(m_device); });
+        if(!ms_scan_tile_state_init_ptr) { return -1; }
+        cmdlist << (*ms_scan_tile_state_init_ptr)(tile_status, num_tiles).dispatch(num_tiles * m_block_size);
+        return 0;
+    }
+
+    template <SelectMode MODE, NumericT Type, NumericT FlagT, typename SelectOp>
+    [[nodiscard]] int partition_array(CommandList&      cmdlist,
+                                      BufferView<uint>  temp_storage,
+                                      BufferView<Type>  d_in,
+                                      BufferView<FlagT> d_flags,
+                                      BufferView<Type>  d_out,
+                                      BufferView<uint>  d_num_selected_out,
+                                      uint              num_items,
+                                      SelectOp          select_op) noexcept
+    {
+        using Select       = details::SelectModule<Type, FlagT, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
+        using SelectKernel = Select::SelectKernel;
+
+        uint   tile_items = m_block_size * ITEMS_PER_THREAD;
+        uint   num_tiles  = std::max(1u, ceil_div(num_items, tile_items));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
+
+        auto tile_status    = temp_storage.subview(0, tile_count);
+        auto tile_partial   = temp_storage.subview(tile_count, tile_count);
+        auto tile_inclusive = temp_storage.subview(2 * tile_count, tile_count);
+
+        if(init_tile_state<Select>(cmdlist, tile_status, num_tiles) != 0) { return -1; }
+
+        auto ms_partition_ptr = m_shader_cache.get_or_compile<SelectKernel, Select, std::integral_constant<SelectMode, MODE>, SelectOp>(
+            [&] { return Select().template compile<MODE, true>(m_device, select_op); });
+        if(!ms_partition_ptr) { return -1; }
+        cmdlist << (*ms_partition_ptr)(
+                       tile_status, tile_partial, tile_inclusive, d_in, d_flags, d_out, d_num_selected_out, num_items)
+                       .dispatch(num_tiles * m_block_size);
+        return 0;
+    }
+
+    template <NumericT Type, typename SelectFirstPartOp, typename SelectSecondPartOp>
+    [[nodiscard]] int three_way_partition_array(CommandList&       cmdlist,
+                                                BufferView<uint>   temp_storage,
+                                                BufferView<Type>   d_in,
+                                                BufferView<Type>   d_first_part_out,
+                                                BufferView<Type>   d_second_part_out,
+                                                BufferView<Type>   d_unselected_out,
+                                                BufferView<uint>   d_num_selected_out,
+                                                uint               num_items,
+                                                SelectFirstPartOp  select_first_part_op,
+                                                SelectSecondPartOp select_second_part_op) noexcept
+    {
+        using ThreeWayPartition       = details::ThreeWayPartitionModule<Type, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
+        using ThreeWayPartitionKernel = ThreeWayPartition::ThreeWayPartitionKernel;
+        using AccumPackT              = ThreeWayPartition::AccumPackT;
+
+        uint   tile_items = m_block_size * ITEMS_PER_THREAD;
+        uint   num_tiles  = std::max(1u, ceil_div(num_items, tile_items));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
+
+        size_t offset_bytes = 0;
+        // tile_status: tile_count * uint
+        auto tile_status = temp_storage.subview(offset_bytes / sizeof(uint), tile_count);
+        offset_bytes += tile_count * sizeof(uint);
+        offset_bytes = align_up_uint(offset_bytes, alignof(AccumPackT));
+
+        // tile_partial: tile_count * AccumPackT
+        size_t partial_uint_count = tile_count * sizeof(AccumPackT) / sizeof(uint);
+        auto tile_partial = temp_storage.subview(offset_bytes / sizeof(uint), partial_uint_count).template as<AccumPackT>();
+        offset_bytes += partial_uint_count * sizeof(uint);
+        offset_bytes = align_up_uint(offset_bytes, alignof(AccumPackT));
+
+        // tile_inclusive: tile_count * AccumPackT
+        size_t inclusive_uint_count = tile_count * sizeof(AccumPackT) / sizeof(uint);
+        auto tile_inclusive = temp_storage.subview(offset_bytes / sizeof(uint), inclusive_uint_count).template as<AccumPackT>();
+
+        if(init_tile_state<ThreeWayPartition>(cmdlist, tile_status, num_tiles) != 0) { return -1; }
+
+        auto ms_three_way_partition_ptr = m_shader_cache.get_or_compile<ThreeWayPartitionKernel, ThreeWayPartition, SelectFirstPartOp, SelectSecondPartOp>(
+            [&] { return ThreeWayPartition().compile(m_device, select_first_part_op, select_second_part_op); });
+        if(!ms_three_way_partition_ptr) { return -1; }
+        cmdlist << (*ms_three_way_partition_ptr)(tile_status,
+                                                 tile_partial,
+                                                 tile_inclusive,
+                                                 d_in,
+                                                 d_first_part_out,
+                                                 d_second_part_out,
+                                                 d_unselected_out,
+                                                 d_num_selected_out,
+                                                 num_items)
+                       .dispatch(num_tiles * m_block_size);
+        return 0;
+    }
+
+    ShaderCache m_shader_cache{make_kernel_name("DevicePartition", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
+};
+}  // namespace luisa::parallel_primitive
@@ -2,7 +2,7 @@
  * @Author: Ligo 
  * @Date: 2025-11-12 11:08:07 
  * @Last Modified by: Ligo
- * @Last Modified time: 2026-02-06 15:50:13
+ * @Last Modified time: 2026-03-07 09:14:22
  */
 
 
@@ -23,12 +23,17 @@
 #include <luisa/dsl/var.h>
 #include <cstddef>
 #include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/runtime/warmup.h>
 #include <lcpp/common/type_trait.h>
 #include <lcpp/common/util_type.h>
 #include <lcpp/common/thread_operators.h>
 #include <lcpp/common/utils.h>
 #include <lcpp/agent/policy.h>
 #include <lcpp/device/details/radix_sort.h>
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
 
 namespace luisa::parallel_primitive
 {
@@ -67,6 +72,7 @@ class DeviceRadixSort : public LuisaModule
     void create(Device& device, Stream* debug_stream = nullptr)
     {
         m_device                   = device;
+        m_shader_cache.bind(device);
 #ifndef NDEBUG
         m_debug_stream = debug_stream;
 #endif
@@ -80,45 +86,33 @@ class DeviceRadixSort : public LuisaModule
     // ============================================================
 
     /// Temp storage bytes for SortPairs / SortPairsDescending
+    /// Only the passes over [begin_bit, end_bit) are paid for, plus N-sized key/value ping buffers
     template <typename KeyType, typename ValueType>
-    static size_t GetSortPairsTempStorageBytes(uint num_items)
+    static size_t GetSortPairsTempStorageBytes(uint num_items, uint begin_bit = 0, uint end_bit = sizeof(KeyType) * 8)
     {
-        const uint RADIX_BITS   = OneSweepSmallKeyTunedPolicy<KeyType>::ONESWEEP_RADIX_BITS;
-        const uint RADIX_DIGITS = 1 << RADIX_BITS;
-        const uint ONESWEEP_TILE_ITEMS = ITEMS_PER_THREAD * BLOCK_SIZE;
-        const auto PORTION_SIZE = ((1u << 28u) - 1u) / ONESWEEP_TILE_ITEMS * ONESWEEP_TILE_ITEMS;
+        return temp_storage_bytes<KeyType, ValueType>(num_items, begin_bit, end_bit, false);
+    }
 
-        auto num_passes     = ceil_div((uint)(sizeof(KeyType) * 8), RADIX_BITS);
-        auto num_portions   = ceil_div(num_items, PORTION_SIZE);
-        auto max_num_blocks = ceil_div(std::min(num_items, PORTION_SIZE), ONESWEEP_TILE_ITEMS);
+    /// Temp storage bytes for SortKeys / SortKeysDescending
+    template <typename KeyType>
+    static size_t GetSortKeysTempStorageBytes(uint num_items, uint begin_bit = 0, uint end_bit = sizeof(KeyType) * 8)
+    {
+        return GetSortPairsTempStorageBytes<KeyType, KeyType>(num_items, begin_bit, end_bit);
+    }
 
-        size_t bytes = 0;
-        // d_bins: num_portions * num_passes * RADIX_DIGITS * uint
-        size_t bins_count = (size_t)num_portions * num_passes * RADIX_DIGITS;
-        bytes += bins_count * sizeof(uint);
-        // d_lookback: max_num_blocks * RADIX_DIGITS * uint
-        size_t lookback_count = (size_t)max_num_blocks * RADIX_DIGITS;
-        bytes += lookback_count * sizeof(uint);
-        // extra key buffer (for multi-pass): num_items * sizeof(KeyType)
-        if(num_passes > 1)
-        {
-            bytes = align_up_uint(bytes, alignof(KeyType));
-            bytes += (size_t)num_items * sizeof(KeyType);
-            // extra value buffer
-            bytes = align_up_uint(bytes, alignof(ValueType));
-            bytes += (size_t)num_items * sizeof(ValueType);
-        }
-        // d_ctrs: num_portions * num_passes * uint
-        size_t ctrs_count = (size_t)num_portions * num_passes;
-        bytes += ctrs_count * sizeof(uint);
-        return bytes;
+    /// Temp storage bytes for the DoubleBuffer SortPairs / SortPairsDescending
+    /// The sort ping-pongs between the two halves of the DoubleBuffers, so no N-sized buffers
+    template <typename KeyType, typename ValueType>
+    static size_t GetSortPairsDoubleBufferTempStorageBytes(uint num_items, uint begin_bit = 0, uint end_bit = sizeof(KeyType) * 8)
+    {
+        return temp_storage_bytes<KeyType, ValueType>(num_items, begin_bit, end_bit, true);
     }
 
-    /// Temp storage bytes for SortKeys / SortKeysDescending
+    /// Temp storage bytes for the DoubleBuffer SortKeys / SortKeysDescending
     template <typename KeyType>
-    static size_t GetSortKeysTempStorageBytes(uint num_items)
+    static size_t GetSortKeysDoubleBufferTempStorageBytes(uint num_items, uint begin_bit = 0, uint end_bit = sizeof(KeyType) * 8)
     {
-        return GetSortPairsTempStorageBytes<KeyType, KeyType>(num_items);
+        return GetSortPairsDoubleBufferTempStorageBytes<KeyType, KeyType>(num_items, begin_bit, end_bit);
     }
 
 
@@ -126,6 +120,7 @@ class DeviceRadixSort : public LuisaModule
     // Dispatch APIs (CUB-style: caller provides temp_storage)
     // ============================================================
 
+    /// Keys are compared on the bits [begin_bit, end_bit) only; a narrower range runs fewer passes
     template <NumericT KeyType, NumericT ValueType>
     void SortPairs(CommandList&          cmdlist,
                    BufferView<uint>      temp_storage,
@@ -133,22 +128,81 @@ class DeviceRadixSort : public LuisaModule
                    BufferView<KeyType>   d_keys_out,
                    BufferView<ValueType> d_values_in,
                    BufferView<ValueType> d_values_out,
-                   uint                  num_items)
+                   uint                  num_items,
+                   uint                  begin_bit = 0,
+                   uint                  end_bit   = sizeof(KeyType) * 8)
     {
         DoubleBuffer<KeyType>   d_keys(d_keys_in, d_keys_out);
         DoubleBuffer<ValueType> d_values(d_values_in, d_values_out);
         lcpp_check(onesweep_radix_sort<KeyType, ValueType, false, false>(
-            cmdlist, temp_storage, d_keys, d_values, 0, sizeof(KeyType) * 8, num_items, false),
+            cmdlist, temp_storage, d_keys, d_values, begin_bit, end_bit, num_items, false),
+            cmdlist, debug_stream());
+    };
+
+    /// d_values_in may be any iterator, e.g. a CountingIterator<uint> sorts the indices of the
+    /// keys without a sequence buffer; only the first pass reads it, the temp storage is the same
+    template <NumericT KeyType, IteratorT ValuesInIt>
+    void SortPairs(CommandList&                                    cmdlist,
+                   BufferView<uint>                                temp_storage,
+                   BufferView<KeyType>                             d_keys_in,
+                   BufferView<KeyType>                             d_keys_out,
+                   ValuesInIt                                      d_values_in,
+                   BufferView<typename ValuesInIt::value_type>     d_values_out,
+                   uint                                            num_items,
+                   uint                                            begin_bit = 0,
+                   uint                                            end_bit   = sizeof(KeyType) * 8)
+    {
+        using ValueType = typename ValuesInIt::value_type;
+        DoubleBuffer<KeyType>   d_keys(d_keys_in, d_keys_out);
+        DoubleBuffer<ValueType> d_values(d_values_out, d_values_out);  // current is never read
+        lcpp_check(onesweep_radix_sort<KeyType, ValueType, false, false>(
+            cmdlist, temp_storage, d_keys, d_values, d_values_in, begin_bit, end_bit, num_items, false),
+            cmdlist, debug_stream());
+    };
+
+    /// Ping-pongs between the two halves of d_keys / d_values, both of which may be overwritten;
+    /// on return d_keys.current() / d_values.current() hold the result
+    template <NumericT KeyType, NumericT ValueType>
+    void SortPairs(CommandList&             cmdlist,
+                   BufferView<uint>         temp_storage,
+                   DoubleBuffer<KeyType>&   d_keys,
+                   DoubleBuffer<ValueType>& d_values,
+                   uint                     num_items,
+                   uint                     begin_bit = 0,
+                   uint                     end_bit   = sizeof(KeyType) * 8)
+    {
+        lcpp_check(onesweep_radix_sort<KeyType, ValueType, false, false>(
+            cmdlist, temp_storage, d_keys, d_values, begin_bit, end_bit, num_items, true),
             cmdlist, debug_stream());
     };
 
     template <NumericT KeyType>
-    void SortKeys(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<KeyType> d_keys_in, BufferView<KeyType> d_keys_out, uint num_items)
+    void SortKeys(CommandList&        cmdlist,
+                  BufferView<uint>    temp_storage,
+                  BufferView<KeyType> d_keys_in,
+                  BufferView<KeyType> d_keys_out,
+                  uint                num_items,
+                  uint                begin_bit = 0,
+                  uint                end_bit   = sizeof(KeyType) * 8)
     {
         DoubleBuffer<KeyType> d_keys(d_keys_in, d_keys_out);
         DoubleBuffer<KeyType> d_values(d_keys_in, d_keys_out);  // dummy
         lcpp_check(onesweep_radix_sort<KeyType, KeyType, true, false>(
-            cmdlist, temp_storage, d_keys, d_values, 0, sizeof(KeyType) * 8, num_items, false),
+            cmdlist, temp_storage, d_keys, d_values, begin_bit, end_bit, num_items, false),
+            cmdlist, debug_stream());
+    };
+
+    template <NumericT KeyType>
+    void SortKeys(CommandList&           cmdlist,
+                  BufferView<uint>       temp_storage,
+                  DoubleBuffer<KeyType>& d_keys,
+                  uint                   num_items,
+                  uint                   begin_bit = 0,
+                  uint                   end_bit   = sizeof(KeyType) * 8)
+    {
+        DoubleBuffer<KeyType> d_values = d_keys;  // dummy
+        lcpp_check(onesweep_radix_sort<KeyType, KeyType, true, false>(
+            cmdlist, temp_storage, d_keys, d_values, begin_bit, end_bit, num_items, true),
             cmdlist, debug_stream());
     };
 
@@ -160,12 +214,47 @@ class DeviceRadixSort : public LuisaModule
                              BufferView<KeyType>   d_keys_out,
                              BufferView<ValueType> d_values_in,
                              BufferView<ValueType> d_values_out,
-                             uint                  num_items)
+                             uint                  num_items,
+                             uint                  begin_bit = 0,
+                             uint                  end_bit   = sizeof(KeyType) * 8)
     {
         DoubleBuffer<KeyType>   d_keys(d_keys_in, d_keys_out);
         DoubleBuffer<ValueType> d_values(d_values_in, d_values_out);
         lcpp_check(onesweep_radix_sort<KeyType, ValueType, false, true>(
-            cmdlist, temp_storage, d_keys, d_values, 0, sizeof(KeyType) * 8, num_items, false),
+            cmdlist, temp_storage, d_keys, d_values, begin_bit, end_bit, num_items, false),
+            cmdlist, debug_stream());
+    };
+
+    template <NumericT KeyType, IteratorT ValuesInIt>
+    void SortPairsDescending(CommandList&                                cmdlist,
+                             BufferView<uint>                            temp_storage,
+                             BufferView<KeyType>                         d_keys_in,
+                             BufferView<KeyType>                         d_keys_out,
+                             ValuesInIt                                  d_values_in,
+                             BufferView<typename ValuesInIt::value_type> d_values_out,
+                             uint                                        num_items,
+                             uint                                        begin_bit = 0,
+                             uint                                        end_bit   = sizeof(KeyType) * 8)
+    {
+        using ValueType = typename ValuesInIt::value_type;
+        DoubleBuffer<KeyType>   d_keys(d_keys_in, d_keys_out);
+        DoubleBuffer<ValueType> d_values(d_values_out, d_values_out);  // current is never read
+        lcpp_check(onesweep_radix_sort<KeyType, ValueType, false, true>(
+            cmdlist, temp_storage, d_keys, d_values, d_values_in, begin_bit, end_bit, num_items, false),
+            cmdlist, debug_stream());
+    };
+
+    template <NumericT KeyType, NumericT ValueType>
+    void SortPairsDescending(CommandList&             cmdlist,
+                             BufferView<uint>         temp_storage,
+                             DoubleBuffer<KeyType>&   d_keys,
+                             DoubleBuffer<ValueType>& d_values,
+                             uint                     num_items,
+                             uint                     begin_bit = 0,
+                             uint                     end_bit   = sizeof(KeyType) * 8)
+    {
+        lcpp_check(onesweep_radix_sort<KeyType, ValueType, false, true>(
+            cmdlist, temp_storage, d_keys, d_values, begin_bit, end_bit, num_items, true),
             cmdlist, debug_stream());
     };
 
@@ -174,16 +263,150 @@ class DeviceRadixSort : public LuisaModule
                             BufferView<uint>    temp_storage,
                             BufferView<KeyType> d_keys_in,
                             BufferView<KeyType> d_keys_out,
-                            uint                num_items)
+                            uint                num_items,
+                            uint                begin_bit = 0,
+                            uint                end_bit   = sizeof(KeyType) * 8)
     {
         DoubleBuffer<KeyType> d_keys(d_keys_in, d_keys_out);
         DoubleBuffer<KeyType> d_values(d_keys_in, d_keys_out);  // dummy
         lcpp_check(onesweep_radix_sort<KeyType, KeyType, true, true>(
-            cmdlist, temp_storage, d_keys, d_values, 0, sizeof(KeyType) * 8, num_items, false),
+            cmdlist, temp_storage, d_keys, d_values, begin_bit, end_bit, num_items, false),
             cmdlist, debug_stream());
     };
 
+    template <NumericT KeyType>
+    void SortKeysDescending(CommandList&           cmdlist,
+                            BufferView<uint>       temp_storage,
+                            DoubleBuffer<KeyType>& d_keys,
+                            uint                   num_items,
+                            uint                   begin_bit = 0,
+                            uint                   end_bit   = sizeof(KeyType) * 8)
+    {
+        DoubleBuffer<KeyType> d_values = d_keys;  // dummy
+        lcpp_check(onesweep_radix_sort<KeyType, KeyType, true, true>(
+            cmdlist, temp_storage, d_keys, d_values, begin_bit, end_bit, num_items, true),
+            cmdlist, debug_stream());
+    };
+
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT KeyType, NumericT ValueType>
+    void SortPairs(CommandList&          cmdlist,
+                   CachingAllocator&     allocator,
+                   const Stream&         stream,
+                   BufferView<KeyType>   d_keys_in,
+                   BufferView<KeyType>   d_keys_out,
+                   BufferView<ValueType> d_values_in,
+                   BufferView<ValueType> d_values_out,
+                   uint                  num_items,
+                   uint                  begin_bit = 0,
+                   uint                  end_bit   = sizeof(KeyType) * 8)
+    {
+        auto temp = allocator.allocate(stream, GetSortPairsTempStorageBytes<KeyType, ValueType>(num_items, begin_bit, end_bit));
+        SortPairs(cmdlist, temp.view(), d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, begin_bit, end_bit);
+    }
+
+    template <NumericT KeyType>
+    void SortKeys(CommandList&        cmdlist,
+                  CachingAllocator&   allocator,
+                  const Stream&       stream,
+                  BufferView<KeyType> d_keys_in,
+                  BufferView<KeyType> d_keys_out,
+                  uint                num_items,
+                  uint                begin_bit = 0,
+                  uint                end_bit   = sizeof(KeyType) * 8)
+    {
+        auto temp = allocator.allocate(stream, GetSortKeysTempStorageBytes<KeyType>(num_items, begin_bit, end_bit));
+        SortKeys(cmdlist, temp.view(), d_keys_in, d_keys_out, num_items, begin_bit, end_bit);
+    }
+
+    template <NumericT KeyType, NumericT ValueType>
+    void SortPairsDescending(CommandList&          cmdlist,
+                             CachingAllocator&     allocator,
+                             const Stream&         stream,
+                             BufferView<KeyType>   d_keys_in,
+                             BufferView<KeyType>   d_keys_out,
+                             BufferView<ValueType> d_values_in,
+                             BufferView<ValueType> d_values_out,
+                             uint                  num_items,
+                             uint                  begin_bit = 0,
+                             uint                  end_bit   = sizeof(KeyType) * 8)
+    {
+        auto temp = allocator.allocate(stream, GetSortPairsTempStorageBytes<KeyType, ValueType>(num_items, begin_bit, end_bit));
+        SortPairsDescending(cmdlist, temp.view(), d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, begin_bit, end_bit);
+    }
+
+    template <NumericT KeyType>
+    void SortKeysDescending(CommandList&        cmdlist,
+                            CachingAllocator&   allocator,
+                            const Stream&       stream,
+                            BufferView<KeyType> d_keys_in,
+                            BufferView<KeyType> d_keys_out,
+                            uint                num_items,
+                            uint                begin_bit = 0,
+                            uint                end_bit   = sizeof(KeyType) * 8)
+    {
+        auto temp = allocator.allocate(stream, GetSortKeysTempStorageBytes<KeyType>(num_items, begin_bit, end_bit));
+        SortKeysDescending(cmdlist, temp.view(), d_keys_in, d_keys_out, num_items, begin_bit, end_bit);
+    }
+
+    // ============================================================
+    // Warmup: compile ahead of the first call
+    // ============================================================
+
+    /// Compiles the kernels of SortKeys on KeyType keys, or of SortPairs for every one of
+    /// ValueTypes, in one direction, e.g. Warmup<uint, float>(), on host threads. Calls made before
+    /// the future is ready compile what they miss themselves. The module has to outlive the future
+    template <NumericT KeyType, NumericT... ValueTypes>
+    [[nodiscard]] WarmupFuture Warmup(bool is_descending = false)
+    {
+        luisa::vector<WarmupJob> jobs;
+        jobs.emplace_back([this] { return reset_shader() != nullptr; });
+        if(is_descending) { add_sort_warmups<KeyType, true, ValueTypes...>(jobs); }
+        else { add_sort_warmups<KeyType, false, ValueTypes...>(jobs); }
+        return details::compile_in_background(std::move(jobs));
+    }
+
   private:
+    // [bins | lookback | (key buffer | value buffer) | ctrs], must match the carving in onesweep_radix_sort
+    template <typename KeyType, typename ValueType>
+    static size_t temp_storage_bytes(uint num_items, uint begin_bit, uint end_bit, bool is_overwrite_okay)
+    {
+        using TilePolicy = OneSweepTilePolicy<KeyType, ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>;
+        const uint RADIX_BITS          = TilePolicy::RADIX_BITS;
+        const uint RADIX_DIGITS        = 1 << RADIX_BITS;
+        const uint ONESWEEP_TILE_ITEMS = TilePolicy::TILE_ITEMS;
+        const auto PORTION_SIZE        = TilePolicy::PORTION_SIZE;
+
+        auto num_passes     = ceil_div(end_bit - std::min(begin_bit, end_bit), RADIX_BITS);
+        auto num_portions   = ceil_div(num_items, PORTION_SIZE);
+        auto max_num_blocks = ceil_div(std::min(num_items, PORTION_SIZE), ONESWEEP_TILE_ITEMS);
+
+        size_t bytes = 0;
+        // d_bins: num_portions * num_passes * RADIX_DIGITS * uint
+        size_t bins_count = (size_t)num_portions * num_passes * RADIX_DIGITS;
+        bytes += bins_count * sizeof(uint);
+        // d_lookback: max_num_blocks * RADIX_DIGITS * uint
+        size_t lookback_count = (size_t)max_num_blocks * RADIX_DIGITS;
+        bytes += lookback_count * sizeof(uint);
+        // extra key buffer (for multi-pass): num_items * sizeof(KeyType)
+        if(!is_overwrite_okay && num_passes > 1)
+        {
+            bytes = align_up_uint(bytes, alignof(KeyType));
+            bytes += bytes_to_uint_count((size_t)num_items * sizeof(KeyType)) * sizeof(uint);
+            // extra value buffer
+            bytes = align_up_uint(bytes, alignof(ValueType));
+            bytes += bytes_to_uint_count((size_t)num_items * sizeof(ValueType)) * sizeof(uint);
+        }
+        // d_ctrs: num_portions * num_passes * uint
+        size_t ctrs_count = (size_t)num_portions * num_passes;
+        bytes += ctrs_count * sizeof(uint);
+        return bytes;
+    }
+
     template <NumericT KeyType, typename ValueType, bool KEY_ONLY, bool IS_DESCENDING>
     [[nodiscard]] int onesweep_radix_sort(CommandList&             cmdlist,
                              BufferView<uint>         temp_storage,
@@ -194,13 +417,42 @@ class DeviceRadixSort : public LuisaModule
                              uint                     num_items,
                              bool                     is_overwrite_okay)
     {
-        const uint RADIX_BITS   = OneSweepSmallKeyTunedPolicy<KeyType>::ONESWEEP_RADIX_BITS;
-        const uint RADIX_DIGITS = 1 << RADIX_BITS;
-        const uint ONESWEEP_ITMES_PER_THREADS = ITEMS_PER_THREAD;
-        const uint ONESWEEP_BLOCK_THREADS     = m_block_size;
-        const uint ONESWEEP_TILE_ITEMS        = ONESWEEP_ITMES_PER_THREADS * ONESWEEP_BLOCK_THREADS;
+        return onesweep_radix_sort<KeyType, ValueType, KEY_ONLY, IS_DESCENDING>(cmdlist,
+                                                                                temp_storage,
+                                                                                d_keys,
+                                                                                d_values,
+                                                                                BufferIterator<ValueType>(d_values.current()),
+                                                                                begin_bit,
+                                                                                end_bit,
+                                                                                num_items,
+                                                                                is_overwrite_okay);
+    }
+
+    // the first pass reads the values through d_values_in, the later ones ping-pong in d_values
+    template <NumericT KeyType, typename ValueType, bool KEY_ONLY, bool IS_DESCENDING, IteratorT ValuesInIt>
+    [[nodiscard]] int onesweep_radix_sort(CommandList&             cmdlist,
+                             BufferView<uint>         temp_storage,
+                             DoubleBuffer<KeyType>&   d_keys,
+                             DoubleBuffer<ValueType>& d_values,
+                             ValuesInIt               d_values_in,
+                             uint                     begin_bit,
+                             uint                     end_bit,
+                             uint                     num_items,
+                             bool                     is_overwrite_okay)
+    {
+        using TilePolicy = OneSweepTilePolicy<KeyType, ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>;
+        constexpr uint RADIX_BITS                 = TilePolicy::RADIX_BITS;
+        const uint     RADIX_DIGITS               = 1 << RADIX_BITS;
+        constexpr uint ONESWEEP_ITMES_PER_THREADS = TilePolicy::ITEMS_PER_THREAD;
+        const uint     ONESWEEP_BLOCK_THREADS     = m_block_size;
+        const uint     ONESWEEP_TILE_ITEMS        = ONESWEEP_ITMES_PER_THREADS * ONESWEEP_BLOCK_THREADS;
 
-        const auto PORTION_SIZE = ((1u << 28u) - 1u) / ONESWEEP_TILE_ITEMS * ONESWEEP_TILE_ITEMS;
+        const auto PORTION_SIZE = TilePolicy::PORTION_SIZE;
+
+        if(begin_bit >= end_bit || end_bit > sizeof(KeyType) * 8) { return -1; }
+        // key scatters address the output through 32-bit byte offsets
+        if(num_items > TilePolicy::MAX_NUM_ITEMS) { return -1; }
+        if(num_items == 0) { return 0; }
 
         auto num_passes     = ceil_div(end_bit - begin_bit, RADIX_BITS);
         auto num_portions   = ceil_div(num_items, PORTION_SIZE);
@@ -239,44 +491,15 @@ class DeviceRadixSort : public LuisaModule
         size_t ctrs_count = (size_t)num_portions * num_passes;
         auto d_ctrs_view = temp_storage.subview(offset_bytes / sizeof(uint), ctrs_count);
 
-        auto radix_sort_key = get_type_and_op_desc<KeyType, ValueType>()
-                              + luisa::string(IS_DESCENDING ? "_desc" : "_asc");
-
-
-        // reset keys
-        using RadixSortReset        = details::RadixSortResetModule<uint>;
-        using RadixSortResetKernel  = RadixSortReset::RadixSortResetKernel;
-        auto ms_radix_sort_reset_it = ms_radix_sort_reset_map.find(radix_sort_key);
-        if(ms_radix_sort_reset_it == ms_radix_sort_reset_map.end())
-        {
-            auto shader = RadixSortReset().compile(m_device);
-            if (!shader) { return -1; }
-            auto [it, inserted] = ms_radix_sort_reset_map.try_emplace(radix_sort_key, std::move(shader));
-            ms_radix_sort_reset_it = it;
-        }
-        if(ms_radix_sort_reset_it == ms_radix_sort_reset_map.end()) { return -1; }
-        auto ms_radix_sort_reset_ptr =
-            reinterpret_cast<RadixSortResetKernel*>(&(*ms_radix_sort_reset_it->second));
+        // reset keys, the same kernel for every key and value type
+        auto ms_radix_sort_reset_ptr = reset_shader();
         if(!ms_radix_sort_reset_ptr) { return -1; }
 
         cmdlist << (*ms_radix_sort_reset_ptr)(d_bins_view, 0u).dispatch(bins_count)
                 << (*ms_radix_sort_reset_ptr)(d_ctrs_view, 0u).dispatch(ctrs_count);
 
         // radix sort histogram
-        using RadixSortHistogram =
-            details::RadixSortHistogramModule<KeyType, IS_DESCENDING, RADIX_BITS, BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
-        using RadixSortHistogramKernel  = RadixSortHistogram::RadixSortHistogramKernel;
-        auto ms_radix_sort_histogram_it = ms_radix_sort_histogram_map.find(radix_sort_key);
-        if(ms_radix_sort_histogram_it == ms_radix_sort_histogram_map.end())
-        {
-            auto shader = RadixSortHistogram().compile(m_device);
-            if (!shader) { return -1; }
-            auto [it, inserted] = ms_radix_sort_histogram_map.try_emplace(radix_sort_key, std::move(shader));
-            ms_radix_sort_histogram_it = it;
-        }
-        if(ms_radix_sort_histogram_it == ms_radix_sort_histogram_map.end()) { return -1; }
-        auto ms_radix_sort_histogram_ptr =
-            reinterpret_cast<RadixSortHistogramKernel*>(&(*ms_radix_sort_histogram_it->second));
+        auto ms_radix_sort_histogram_ptr = histogram_shader<KeyType, IS_DESCENDING, RADIX_BITS>();
         if(!ms_radix_sort_histogram_ptr) { return -1; }
         const auto num_sms             = BLOCK_SIZE;
         const auto histo_blocks_per_sm = 1;
@@ -285,20 +508,7 @@ class DeviceRadixSort : public LuisaModule
                        .dispatch(num_sms * histo_blocks_per_sm * m_block_size);
 
         // exclusive scan
-        using RadixSortExclusiveSum = details::RadixSortExclusiveSumModule<RADIX_DIGITS, BLOCK_SIZE, WARP_NUMS>;
-        using RadixSortExclusiveSumKernel   = RadixSortExclusiveSum::RadixSortExclusiveSumKernel;
-        auto ms_radix_sort_exclusive_sum_it = ms_radix_sort_exclusive_sum_map.find(radix_sort_key);
-        if(ms_radix_sort_exclusive_sum_it == ms_radix_sort_exclusive_sum_map.end())
-        {
-            auto shader = RadixSortExclusiveSum().compile(m_device);
-            if (!shader) { return -1; }
-            auto [it, inserted] =
-                ms_radix_sort_exclusive_sum_map.try_emplace(radix_sort_key, std::move(shader));
-            ms_radix_sort_exclusive_sum_it = it;
-        }
-        if(ms_radix_sort_exclusive_sum_it == ms_radix_sort_exclusive_sum_map.end()) { return -1; }
-        auto ms_radix_sort_exclusive_sum_ptr =
-            reinterpret_cast<RadixSortExclusiveSumKernel*>(&(*ms_radix_sort_exclusive_sum_it->second));
+        auto ms_radix_sort_exclusive_sum_ptr = exclusive_sum_shader<RADIX_BITS>();
         if(!ms_radix_sort_exclusive_sum_ptr) { return -1; }
 
         cmdlist << (*ms_radix_sort_exclusive_sum_ptr)(d_bins_view).dispatch(num_passes * m_block_size);
@@ -312,22 +522,13 @@ class DeviceRadixSort : public LuisaModule
             d_values.d_buffer[1] = d_values_tmp2_view;
         }
 
-        using RadixSortOneSweep =
-            details::RadixSortOneSweepModule<KeyType, ValueType, KEY_ONLY, IS_DESCENDING, RADIX_BITS, BLOCK_SIZE, WARP_NUMS, ONESWEEP_ITMES_PER_THREADS>;
-        using RadixSortOneSweepKernel = RadixSortOneSweep::RadixSortOneSweepKernel;
-
-        auto ms_radix_sort_onesweep_it = ms_radix_sort_one_sweep_map.find(radix_sort_key);
-        if(ms_radix_sort_onesweep_it == ms_radix_sort_one_sweep_map.end())
-        {
-            auto shader = RadixSortOneSweep().compile(m_device);
-            if (!shader) { return -1; }
-            ms_radix_sort_one_sweep_map.try_emplace(radix_sort_key, std::move(shader));
-            ms_radix_sort_onesweep_it = ms_radix_sort_one_sweep_map.find(radix_sort_key);
-        }
-        if(ms_radix_sort_onesweep_it == ms_radix_sort_one_sweep_map.end()) { return -1; }
+        using BufferValuesIt = BufferIterator<ValueType>;
         auto ms_radix_sort_onesweep_ptr =
-            reinterpret_cast<RadixSortOneSweepKernel*>(&(*ms_radix_sort_onesweep_it->second));
+            onesweep_shader<KeyType, ValueType, KEY_ONLY, IS_DESCENDING, RADIX_BITS>(BufferValuesIt(d_values.alternate()));
         if(!ms_radix_sort_onesweep_ptr) { return -1; }
+        auto ms_radix_sort_first_pass_ptr =
+            onesweep_shader<KeyType, ValueType, KEY_ONLY, IS_DESCENDING, RADIX_BITS>(d_values_in);
+        if(!ms_radix_sort_first_pass_ptr) { return -1; }
 
         for(uint current_bit = begin_bit, pass = 0; current_bit < end_bit; current_bit += RADIX_BITS, ++pass)
         {
@@ -341,25 +542,42 @@ class DeviceRadixSort : public LuisaModule
                 cmdlist << (*ms_radix_sort_reset_ptr)(d_lookback_view, 0u)
                                .dispatch(lookback_count);
 
+                auto d_bins_in_view = d_bins_view.subview((portion * num_passes + pass) * RADIX_DIGITS, RADIX_DIGITS);
+                auto d_bins_out_view =
+                    portion < num_portions - 1 ?
+                        d_bins_view.subview(((portion + 1) * num_passes + pass) * RADIX_DIGITS, RADIX_DIGITS) :
+                        d_bins_view.subview(0, RADIX_DIGITS);  // dummy: last portion, bins_out unused but must be valid-sized
+                auto d_values_out_view = KEY_ONLY ? d_values.alternate().subview(0, 0) :
+                                                    d_values.alternate().subview(portion * PORTION_SIZE, portion_num_items);
+
                 // dispatch
-                cmdlist
-                    << (*ms_radix_sort_onesweep_ptr)(
-                           d_lookback_view,
-                           d_ctrs_view.subview(portion * num_passes + pass, 1),
-                           d_bins_view.subview((portion * num_passes + pass) * RADIX_DIGITS, RADIX_DIGITS),
-                           portion < num_portions - 1 ?
-                               d_bins_view.subview(((portion + 1) * num_passes + pass) * RADIX_DIGITS, RADIX_DIGITS) :
-                               d_bins_view.subview(0, RADIX_DIGITS),  // dummy: last portion, bins_out unused but must be valid-sized
-                           ByteBufferView{d_keys.current().subview(portion * PORTION_SIZE, portion_num_items)},
-                           ByteBufferView{d_keys.alternate()},
-                           KEY_ONLY ? d_values.current().subview(0, 0) :
-                                      d_values.current().subview(portion * PORTION_SIZE, portion_num_items),
-                           KEY_ONLY ? d_values.alternate().subview(0, 0) :
-                                      d_values.alternate().subview(portion * PORTION_SIZE, portion_num_items),
-                           portion_num_items,
-                           current_bit,
-                           num_bit)
-                           .dispatch(num_blocks * ONESWEEP_BLOCK_THREADS);
+                auto dispatch_onesweep = [&](auto& shader, const auto& values_in)
+                {
+                    details::dispatch_with_iterator_args(cmdlist,
+                                                         shader,
+                                                         num_blocks * ONESWEEP_BLOCK_THREADS,
+                                                         values_in.host_args(),
+                                                         d_lookback_view,
+                                                         d_ctrs_view.subview(portion * num_passes + pass, 1),
+                                                         d_bins_in_view,
+                                                         d_bins_out_view,
+                                                         ByteBufferView{d_keys.current().subview(portion * PORTION_SIZE, portion_num_items)},
+                                                         ByteBufferView{d_keys.alternate()},
+                                                         d_values_out_view,
+                                                         portion_num_items,
+                                                         current_bit,
+                                                         num_bit);
+                };
+                if(!KEY_ONLY && pass == 0)
+                {
+                    dispatch_onesweep(*ms_radix_sort_first_pass_ptr, d_values_in.advance(portion * PORTION_SIZE));
+                }
+                else
+                {
+                    dispatch_onesweep(*ms_radix_sort_onesweep_ptr,
+                                      BufferValuesIt(KEY_ONLY ? d_values.current().subview(0, 0) :
+                                                                d_values.current().subview(portion * PORTION_SIZE, portion_num_items)));
+                }
             }
             if(!is_overwrite_okay && pass == 0)
             {
@@ -377,10 +595,77 @@ class DeviceRadixSort : public LuisaModule
         return 0;
     }
 
+    // reset keys, the same kernel for every key and value type
+    [[nodiscard]] auto reset_shader()
+    {
+        using RadixSortReset       = details::RadixSortResetModule<uint>;
+        using RadixSortResetKernel = RadixSortReset::RadixSortResetKernel;
+
+        return m_shader_cache.get_or_compile<RadixSortResetKernel, RadixSortReset>(
+            [&] { return RadixSortReset().compile(m_device); });
+    }
+
+    template <NumericT KeyType, bool IS_DESCENDING, uint RADIX_BITS>
+    [[nodiscard]] auto histogram_shader()
+    {
+        using RadixSortHistogram =
+            details::RadixSortHistogramModule<KeyType, IS_DESCENDING, RADIX_BITS, BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+        using RadixSortHistogramKernel = RadixSortHistogram::RadixSortHistogramKernel;
+
+        return m_shader_cache.get_or_compile<RadixSortHistogramKernel, RadixSortHistogram>(
+            [&] { return RadixSortHistogram().compile(m_device); });
+    }
+
+    template <uint RADIX_BITS>
+    [[nodiscard]] auto exclusive_sum_shader()
+    {
+        using RadixSortExclusiveSum       = details::RadixSortExclusiveSumModule<1u << RADIX_BITS, BLOCK_SIZE, WARP_NUMS>;
+        using RadixSortExclusiveSumKernel = RadixSortExclusiveSum::RadixSortExclusiveSumKernel;
+
+        return m_shader_cache.get_or_compile<RadixSortExclusiveSumKernel, RadixSortExclusiveSum>(
+            [&] { return RadixSortExclusiveSum().compile(m_device); });
+    }
+
+    // the kernels of every pass of one sort direction; KEY_ONLY sorts carry KeyType as ValueType
+    template <NumericT KeyType, typename ValueType, bool KEY_ONLY, bool IS_DESCENDING>
+    void add_sort_warmup(luisa::vector<WarmupJob>& jobs)
+    {
+        constexpr uint RADIX_BITS = OneSweepTilePolicy<KeyType, ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>::RADIX_BITS;
+        jobs.emplace_back(
+            [this]
+            {
+                return onesweep_shader<KeyType, ValueType, KEY_ONLY, IS_DESCENDING, RADIX_BITS>(
+                           BufferIterator<ValueType>(BufferView<ValueType>{}))
+                       != nullptr;
+            });
+    }
+
+    // the histogram and the digit scan only depend on the key type, the values pick the onesweep kernel
+    template <NumericT KeyType, bool IS_DESCENDING, NumericT... ValueTypes>
+    void add_sort_warmups(luisa::vector<WarmupJob>& jobs)
+    {
+        constexpr uint RADIX_BITS = OneSweepSmallKeyTunedPolicy<KeyType>::ONESWEEP_RADIX_BITS;
+        jobs.emplace_back([this] { return histogram_shader<KeyType, IS_DESCENDING, RADIX_BITS>() != nullptr; });
+        jobs.emplace_back([this] { return exclusive_sum_shader<RADIX_BITS>() != nullptr; });
+        if constexpr(sizeof...(ValueTypes) == 0) { add_sort_warmup<KeyType, KeyType, true, IS_DESCENDING>(jobs); }
+        else { (add_sort_warmup<KeyType, ValueTypes, false, IS_DESCENDING>(jobs), ...); }
+    }
+
+    // one onesweep kernel per values iterator, the buffer one serves every pass but a fancy first one
+    template <NumericT KeyType, typename ValueType, bool KEY_ONLY, bool IS_DESCENDING, uint RADIX_BITS, IteratorT ValuesInIt>
+    [[nodiscard]] auto onesweep_shader(const ValuesInIt& d_values_in)
+    {
+        // the tile has to match the one onesweep_radix_sort sizes its blocks with
+        constexpr size_t ONESWEEP_ITEMS_PER_THREAD =
+            OneSweepTilePolicy<KeyType, ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>::ITEMS_PER_THREAD;
+        using RadixSortOneSweep = details::RadixSortOneSweepModule<KeyType, ValueType, KEY_ONLY, IS_DESCENDING, RADIX_BITS, BLOCK_SIZE, WARP_NUMS, ONESWEEP_ITEMS_PER_THREAD, ValuesInIt>;
+        using RadixSortOneSweepKernel = RadixSortOneSweep::RadixSortOneSweepKernel;
+
+        return m_shader_cache.get_or_compile<RadixSortOneSweepKernel, RadixSortOneSweep>(
+            [&] { return RadixSortOneSweep().compile(m_device, d_values_in); });
+    }
+
   private:
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_radix_sort_histogram_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_radix_sort_exclusive_sum_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_radix_sort_one_sweep_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_radix_sort_reset_map;
+    ShaderCache m_shader_cache{make_kernel_name("DeviceRadixSort", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
 };
 }  // namespace luisa::parallel_primitive
@@ -2,7 +2,7 @@
  * @Author: Ligo 
  * @Date: 2025-09-19 14:24:07 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-12 17:31:05
+ * @Last Modified time: 2026-03-05 16:31:40
  */
 
 #pragma once
@@ -10,6 +10,7 @@
 #include <luisa/core/mathematics.h>
 #include <luisa/dsl/local.h>
 #include <limits>
+#include <type_traits>
 #include <luisa/core/basic_traits.h>
 #include <luisa/ast/type.h>
 #include <luisa/runtime/stream.h>
@@ -22,6 +23,9 @@
 #include <luisa/dsl/var.h>
 #include <cstddef>
 #include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/runtime/warmup.h>
 #include <lcpp/common/type_trait.h>
 #include <lcpp/common/util_type.h>
 #include <lcpp/common/thread_operators.h>
@@ -33,12 +37,19 @@
 #include <lcpp/warp/warp_reduce.h>
 #include <lcpp/device/details/reduce.h>
 #include <lcpp/device/details/reduce_by_key.h>
+#include <lcpp/device/details/tile_status.h>
+#include <lcpp/device/details/deterministic.h>
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
+#include <lcpp/iterator/counting_iterator.h>
+#include <lcpp/iterator/zip_iterator.h>
 namespace luisa::parallel_primitive
 {
 
 using namespace luisa::compute;
 
-template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+/// DelayPolicy paces the decoupled look-back of ReduceByKey, see DeviceScan
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
 class DeviceReduce : public LuisaModule
 {
   private:
@@ -50,6 +61,9 @@ class DeviceReduce : public LuisaModule
 
     bool   m_created = false;
 
+    bool                                      m_persistent_tile_status = false;
+    details::PersistentTileStatus<BLOCK_SIZE> m_tile_status;
+
   public:
     DeviceReduce()  = default;
     ~DeviceReduce() = default;
@@ -68,6 +82,7 @@ class DeviceReduce : public LuisaModule
     void create(Device& device, Stream* debug_stream = nullptr)
     {
         m_device                   = device;
+        m_shader_cache.bind(device);
 #ifndef NDEBUG
         m_debug_stream = debug_stream;
 #endif
@@ -77,36 +92,53 @@ class DeviceReduce : public LuisaModule
         m_created                  = true;
     }
 
+    /// ReduceByKey keeps its look-back tile status in the module, tagged with a new epoch by
+    /// every call, and skips the initialization dispatch. Calls then have to run one after
+    /// another on a single stream
+    void SetPersistentTileStatus(bool enable) noexcept { m_persistent_tile_status = enable; }
+
     // ============================================================
     // GetTempStorageBytes: compute required temp buffer size (in bytes)
     // ============================================================
 
     /// Temp storage bytes for Reduce / Sum / Min / Max / TransformReduce
+    /// One partial per block of the persistent grid, independent of num_item past MAX_REDUCE_GRID tiles
+    /// Type4Byte is the accumulator type, the OutputT for Sum
     template <typename Type4Byte>
     static size_t GetTempStorageBytes(size_t num_item)
     {
-        size_t temp_count = 0;
-        get_temp_size_scan(temp_count, BLOCK_SIZE, ITEMS_PER_THREAD, num_item);
-        return temp_count * sizeof(Type4Byte);
+        return reduce_temp_count(num_item) * sizeof(Type4Byte);
     }
 
     /// Temp storage bytes for ArgMin / ArgMax
-    /// Needs: IndexValuePairT<Type4Byte> temp for reduce + d_in_kv(num_item) + d_out_kv(1)
+    /// Needs: IndexValuePairT<Type4Byte> temp for reduce + d_out_kv(1), the input pairs are zipped on the fly
     template <typename Type4Byte>
     static size_t GetArgTempStorageBytes(size_t num_item)
     {
         using IVP = IndexValuePairT<Type4Byte>;
-        size_t reduce_temp_count = 0;
-        get_temp_size_scan(reduce_temp_count, BLOCK_SIZE, ITEMS_PER_THREAD, num_item);
         size_t bytes = 0;
-        bytes += reduce_temp_count * sizeof(IVP);          // reduce temp
-        bytes  = align_up_uint(bytes, alignof(IVP));
-        bytes += num_item * sizeof(IVP);                   // d_in_kv
+        bytes += reduce_temp_count(num_item) * sizeof(IVP);  // reduce temp
         bytes  = align_up_uint(bytes, alignof(IVP));
         bytes += 1 * sizeof(IVP);                          // d_out_kv
         return bytes;
     }
 
+    /// Temp storage bytes for DeterministicReduce / DeterministicSum
+    /// One partial per chunk of DETERMINISTIC_CHUNK_ITEMS items, for every level of chunks
+    template <typename Type4Byte>
+    static size_t GetDeterministicTempStorageBytes(size_t num_item)
+    {
+        return details::deterministic_partial_count(num_item) * sizeof(Type4Byte);
+    }
+
+    /// Temp storage bytes for CompensatedSum
+    /// Same partial count as Sum, each partial holds a CompensatedSumT
+    template <typename Type4Byte>
+    static size_t GetCompensatedSumTempStorageBytes(size_t num_item)
+    {
+        return reduce_temp_count(num_item) * sizeof(CompensatedSumT<Type4Byte>);
+    }
+
     /// Temp storage bytes for ReduceByKey
     template <typename KeyType, typename ValueType>
     static size_t GetReduceByKeyTempStorageBytes(size_t num_elements)
@@ -128,21 +160,36 @@ class DeviceReduce : public LuisaModule
     // Dispatch APIs (CUB-style: caller provides temp_storage)
     // ============================================================
 
-    template <NumericT Type4Byte, typename ReduceOp>
-    void Reduce(CommandList&          cmdlist,
-                BufferView<uint>      temp_storage,
-                BufferView<Type4Byte> d_in,
-                BufferView<Type4Byte> d_out,
-                size_t                num_item,
-                ReduceOp              reduce_op,
-                Type4Byte             initial_value)
+    /// Accumulates in the type of initial_value: InputT items are converted to AccumT while they
+    /// are loaded, so narrow inputs are read at their own width, and the result is stored as OutputT
+    template <NumericT InputT, NumericT OutputT, NumericT AccumT, typename ReduceOp>
+    void Reduce(CommandList&        cmdlist,
+                BufferView<uint>    temp_storage,
+                BufferView<InputT>  d_in,
+                BufferView<OutputT> d_out,
+                size_t              num_item,
+                ReduceOp            reduce_op,
+                AccumT              initial_value)
     {
-        size_t temp_count = 0;
-        get_temp_size_scan(temp_count, m_block_size, ITEMS_PER_THREAD, num_item);
-        auto temp_view = temp_storage.subview(0, temp_count * sizeof(Type4Byte) / sizeof(uint)).template as<Type4Byte>();
+        Reduce(cmdlist, temp_storage, BufferIterator<InputT>(d_in), d_out, num_item, reduce_op, initial_value);
+    }
 
-        lcpp_check(reduce_array_recursive<Type4Byte>(
-            cmdlist, temp_view, d_in, d_out, num_item, 0, 0, reduce_op, initial_value, IdentityOp()),
+    /// Reduces the items of a fancy iterator, e.g. a TransformIterator or a PermutationIterator:
+    /// they are produced inside the reduce kernel, nothing is materialized
+    template <IteratorT InputIt, typename OutputT, NumericTOrKeyValuePairT AccumT, typename ReduceOp>
+    void Reduce(CommandList&        cmdlist,
+                BufferView<uint>    temp_storage,
+                InputIt             d_in,
+                BufferView<OutputT> d_out,
+                size_t              num_item,
+                ReduceOp            reduce_op,
+                AccumT              initial_value)
+    {
+        size_t temp_count = reduce_temp_count(num_item);
+        auto temp_view = temp_storage.subview(0, temp_count * sizeof(AccumT) / sizeof(uint)).template as<AccumT>();
+
+        lcpp_check(reduce_array_single_pass<AccumT>(
+            cmdlist, temp_view, d_in, d_out, num_item, reduce_op, initial_value, CastOp<AccumT>(), CastOp<OutputT>()),
         cmdlist, debug_stream());
     }
 
@@ -155,21 +202,70 @@ class DeviceReduce : public LuisaModule
                 ReduceOp                               reduce_op,
                 IndexValuePairT<Type4Byte>             initial_value)
     {
-        using IVP = IndexValuePairT<Type4Byte>;
-        size_t temp_count = 0;
-        get_temp_size_scan(temp_count, m_block_size, ITEMS_PER_THREAD, num_item);
-        auto temp_view = temp_storage.subview(0, temp_count * sizeof(IVP) / sizeof(uint)).template as<IVP>();
+        Reduce(cmdlist, temp_storage, BufferIterator<IndexValuePairT<Type4Byte>>(d_in), d_out, num_item, reduce_op, initial_value);
+    }
 
-        lcpp_check(reduce_array_recursive<IVP>(
-            cmdlist, temp_view, d_in, d_out, num_item, 0, 0, reduce_op, initial_value, IdentityOp()),
-        cmdlist, debug_stream());
+
+    /// Accumulates in OutputT, e.g. a uint8 mask into a uint count
+    template <NumericT InputT, NumericT OutputT>
+    void Sum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<InputT> d_in, BufferView<OutputT> d_out, size_t num_item)
+    {
+        Reduce(cmdlist, temp_storage, d_in, d_out, num_item, SumOp(), OutputT(0));
     }
 
+    template <IteratorT InputIt, NumericT OutputT>
+    void Sum(CommandList& cmdlist, BufferView<uint> temp_storage, InputIt d_in, BufferView<OutputT> d_out, size_t num_item)
+    {
+        Reduce(cmdlist, temp_storage, d_in, d_out, num_item, SumOp(), OutputT(0));
+    }
 
+    /// Neumaier compensated sum: every partial carries the rounding error of its own additions
+    /// next to the sum, so float input reaches close to double accuracy while the kernels still
+    /// read float items and only the partials are twice as wide
     template <NumericT Type4Byte>
-    void Sum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<Type4Byte> d_in, BufferView<Type4Byte> d_out, size_t num_item)
+        requires std::is_floating_point_v<Type4Byte>
+    void CompensatedSum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<Type4Byte> d_in, BufferView<Type4Byte> d_out, size_t num_item)
     {
-        Reduce(cmdlist, temp_storage, d_in, d_out, num_item, SumOp(), Type4Byte(0));
+        using AccumT      = CompensatedSumT<Type4Byte>;
+        size_t temp_count = reduce_temp_count(num_item);
+        auto temp_view = temp_storage.subview(0, temp_count * sizeof(AccumT) / sizeof(uint)).template as<AccumT>();
+
+        lcpp_check(reduce_array_single_pass<AccumT>(cmdlist,
+                                                    temp_view,
+                                                    BufferIterator<Type4Byte>(d_in),
+                                                    d_out,
+                                                    num_item,
+                                                    CompensatedSumOp(),
+                                                    AccumT{Type4Byte(0), Type4Byte(0)},
+                                                    ToCompensatedSumOp(),
+                                                    FromCompensatedSumOp()),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// Bit for bit reproducible reduction: the tree is fixed by the item indices, so the result
+    /// does not change with BLOCK_SIZE, ITEMS_PER_THREAD, the backend or the run
+    template <NumericT Type4Byte, typename ReduceOp>
+    void DeterministicReduce(CommandList&          cmdlist,
+                             BufferView<uint>      temp_storage,
+                             BufferView<Type4Byte> d_in,
+                             BufferView<Type4Byte> d_out,
+                             size_t                num_item,
+                             ReduceOp              reduce_op,
+                             Type4Byte             initial_value)
+    {
+        size_t temp_count = details::deterministic_partial_count(num_item);
+        auto temp_view = temp_storage.subview(0, temp_count * sizeof(Type4Byte) / sizeof(uint)).template as<Type4Byte>();
+
+        lcpp_check(deterministic_reduce_array<Type4Byte>(cmdlist, temp_view, d_in, d_out, num_item, reduce_op, initial_value),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    template <NumericT Type4Byte>
+    void DeterministicSum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<Type4Byte> d_in, BufferView<Type4Byte> d_out, size_t num_item)
+    {
+        DeterministicReduce(cmdlist, temp_storage, d_in, d_out, num_item, SumOp(), Type4Byte(0));
     }
 
     template <NumericT Type4Byte>
@@ -192,41 +288,27 @@ class DeviceReduce : public LuisaModule
                 BufferView<uint>      d_index_out,
                 size_t                num_item)
     {
-        using IVP = IndexValuePairT<Type4Byte>;
-        size_t reduce_temp_count = 0;
-        get_temp_size_scan(reduce_temp_count, m_block_size, ITEMS_PER_THREAD, num_item);
-
-        size_t offset_bytes = 0;
-        // reduce temp
-        size_t reduce_temp_uint_count = reduce_temp_count * sizeof(IVP) / sizeof(uint);
-        auto reduce_temp = temp_storage.subview(offset_bytes / sizeof(uint), reduce_temp_uint_count).template as<IVP>();
-        offset_bytes += reduce_temp_uint_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(IVP));
-
-        // d_in_kv
-        size_t in_kv_uint_count = num_item * sizeof(IVP) / sizeof(uint);
-        auto d_in_kv = temp_storage.subview(offset_bytes / sizeof(uint), in_kv_uint_count).template as<IVP>();
-        offset_bytes += in_kv_uint_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(IVP));
-
-        // d_out_kv
-        size_t out_kv_uint_count = 1 * sizeof(IVP) / sizeof(uint);
-        auto d_out_kv = temp_storage.subview(offset_bytes / sizeof(uint), out_kv_uint_count).template as<IVP>();
-
-        // construct key value pair
-        lcpp_check(arg_construct<Type4Byte>(cmdlist, d_in, d_in_kv), cmdlist, debug_stream());
-
-        Reduce(cmdlist,
-               temp_storage.subview(0, reduce_temp_uint_count),
-               d_in_kv,
-               d_out_kv,
-               num_item,
-               ArgMinOp(),
-               IVP{std::numeric_limits<uint>::max(),
-                   std::numeric_limits<Type4Byte>::max()});
+        ArgMin(cmdlist,
+               temp_storage,
+               BufferIterator<Type4Byte>(d_in),
+               BufferIterator<Type4Byte>(d_out),
+               BufferIterator<uint>(d_index_out),
+               num_item);
+    }
 
-        // copy result to d_out and d_index_out
-        lcpp_check(arg_assign<Type4Byte>(cmdlist, d_out_kv, d_out, d_index_out), cmdlist, debug_stream());
+    /// The items come from any iterator, either output may be a DiscardOutput
+    template <IteratorT InputIt, IteratorT ValueOutIt, IteratorT IndexOutIt>
+    void ArgMin(CommandList& cmdlist, BufferView<uint> temp_storage, InputIt d_in, ValueOutIt d_out, IndexOutIt d_index_out, size_t num_item)
+    {
+        using Type4Byte = typename InputIt::value_type;
+        arg_reduce(cmdlist,
+                   temp_storage,
+                   d_in,
+                   d_out,
+                   d_index_out,
+                   num_item,
+                   ArgMinOp(),
+                   IndexValuePairT<Type4Byte>{std::numeric_limits<uint>::max(), std::numeric_limits<Type4Byte>::max()});
     }
 
     template <NumericT Type4Byte>
@@ -237,40 +319,27 @@ class DeviceReduce : public LuisaModule
                 BufferView<uint>      d_index_out,
                 size_t                num_item)
     {
-        using IVP = IndexValuePairT<Type4Byte>;
-        size_t reduce_temp_count = 0;
-        get_temp_size_scan(reduce_temp_count, m_block_size, ITEMS_PER_THREAD, num_item);
-
-        size_t offset_bytes = 0;
-        // reduce temp
-        size_t reduce_temp_uint_count = reduce_temp_count * sizeof(IVP) / sizeof(uint);
-        auto reduce_temp = temp_storage.subview(offset_bytes / sizeof(uint), reduce_temp_uint_count).template as<IVP>();
-        offset_bytes += reduce_temp_uint_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(IVP));
-
-        // d_in_kv
-        size_t in_kv_uint_count = num_item * sizeof(IVP) / sizeof(uint);
-        auto d_in_kv = temp_storage.subview(offset_bytes / sizeof(uint), in_kv_uint_count).template as<IVP>();
-        offset_bytes += in_kv_uint_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(IVP));
-
-        // d_out_kv
-        size_t out_kv_uint_count = 1 * sizeof(IVP) / sizeof(uint);
-        auto d_out_kv = temp_storage.subview(offset_bytes / sizeof(uint), out_kv_uint_count).template as<IVP>();
-
-        // construct key value pair
-        lcpp_check(arg_construct<Type4Byte>(cmdlist, d_in, d_in_kv), cmdlist, debug_stream());
-
-        Reduce(cmdlist,
-               temp_storage.subview(0, reduce_temp_uint_count),
-               d_in_kv,
-               d_out_kv,
-               num_item,
-               ArgMaxOp(),
-               IVP{0, std::numeric_limits<Type4Byte>::min()});
+        ArgMax(cmdlist,
+               temp_storage,
+               BufferIterator<Type4Byte>(d_in),
+               BufferIterator<Type4Byte>(d_out),
+               BufferIterator<uint>(d_index_out),
+               num_item);
+    }
 
-        // copy result to d_out and d_index_out
-        lcpp_check(arg_assign<Type4Byte>(cmdlist, d_out_kv, d_out, d_index_out), cmdlist, debug_stream());
+    /// The items come from any iterator, either output may be a DiscardOutput
+    template <IteratorT InputIt, IteratorT ValueOutIt, IteratorT IndexOutIt>
+    void ArgMax(CommandList& cmdlist, BufferView<uint> temp_storage, InputIt d_in, ValueOutIt d_out, IndexOutIt d_index_out, size_t num_item)
+    {
+        using Type4Byte = typename InputIt::value_type;
+        arg_reduce(cmdlist,
+                   temp_storage,
+                   d_in,
+                   d_out,
+                   d_index_out,
+                   num_item,
+                   ArgMaxOp(),
+                   IndexValuePairT<Type4Byte>{0, std::numeric_limits<Type4Byte>::min()});
     }
 
 
@@ -328,136 +397,296 @@ class DeviceReduce : public LuisaModule
     }
 
 
-    template <typename Type4Byte, typename ReduceOp, typename TransformOp>
-    void TransformReduce(CommandList&          cmdlist,
-                         BufferView<uint>      temp_storage,
-                         BufferView<Type4Byte> d_in,
-                         BufferView<Type4Byte> d_out,
-                         size_t                num_item,
-                         ReduceOp              reduce_op,
-                         TransformOp           transform_op,
-                         Type4Byte             init)
+    /// transform_op maps an InputT item to the AccumT of init, the result is stored as OutputT
+    template <typename InputT, typename OutputT, typename AccumT, typename ReduceOp, typename TransformOp>
+    void TransformReduce(CommandList&        cmdlist,
+                         BufferView<uint>    temp_storage,
+                         BufferView<InputT>  d_in,
+                         BufferView<OutputT> d_out,
+                         size_t              num_item,
+                         ReduceOp            reduce_op,
+                         TransformOp         transform_op,
+                         AccumT              init)
     {
-        size_t temp_count = 0;
-        get_temp_size_scan(temp_count, m_block_size, ITEMS_PER_THREAD, num_item);
-        auto temp_view = temp_storage.subview(0, temp_count * sizeof(Type4Byte) / sizeof(uint)).template as<Type4Byte>();
+        size_t temp_count = reduce_temp_count(num_item);
+        auto temp_view = temp_storage.subview(0, temp_count * sizeof(AccumT) / sizeof(uint)).template as<AccumT>();
         lcpp_check(
-            reduce_array_recursive<Type4Byte, ReduceOp, TransformOp>(
-            cmdlist, temp_view, d_in, d_out, num_item, 0, 0, reduce_op, init, transform_op),
+            reduce_array_single_pass<AccumT>(
+            cmdlist, temp_view, BufferIterator<InputT>(d_in), d_out, num_item, reduce_op, init, transform_op, CastOp<OutputT>()),
         cmdlist, debug_stream());
     }
 
-  private:
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT InputT, NumericT OutputT, NumericT AccumT, typename ReduceOp>
+    void Reduce(CommandList&        cmdlist,
+                CachingAllocator&   allocator,
+                const Stream&       stream,
+                BufferView<InputT>  d_in,
+                BufferView<OutputT> d_out,
+                size_t              num_item,
+                ReduceOp            reduce_op,
+                AccumT              initial_value)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<AccumT>(num_item));
+        Reduce(cmdlist, temp.view(), d_in, d_out, num_item, reduce_op, initial_value);
+    }
+
+    template <NumericT InputT, NumericT OutputT>
+    void Sum(CommandList& cmdlist, CachingAllocator& allocator, const Stream& stream, BufferView<InputT> d_in, BufferView<OutputT> d_out, size_t num_item)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<OutputT>(num_item));
+        Sum(cmdlist, temp.view(), d_in, d_out, num_item);
+    }
+
     template <NumericT Type4Byte>
-    [[nodiscard]] int arg_construct(CommandList& cmdlist, BufferView<Type4Byte> d_in, BufferView<IndexValuePairT<Type4Byte>> d_kv_out) noexcept
+    void Min(CommandList& cmdlist, CachingAllocator& allocator, const Stream& stream, BufferView<Type4Byte> d_in, BufferView<Type4Byte> d_out, size_t num_item)
     {
-        using ArgReduce          = details::ArgReduce<Type4Byte, BLOCK_SIZE>;
-        using ArgConstructShader = ArgReduce::ArgConstructShaderT;
-        auto key = luisa::string{luisa::compute::Type::of<Type4Byte>()->description()};
-        auto ms_arg_construct_it = ms_arg_construct_map.find(key);
-        if(ms_arg_construct_it == ms_arg_construct_map.end())
-        {
-            auto shader = ArgReduce().compile_arg_construct_shader(m_device);
-            if(!shader) { return -1; }
-            ms_arg_construct_map.try_emplace(key, std::move(shader));
-            ms_arg_construct_it = ms_arg_construct_map.find(key);
-        }
-        if(ms_arg_construct_it == ms_arg_construct_map.end()) { return -1; }
-        auto ms_arg_construct_ptr = reinterpret_cast<ArgConstructShader*>(&(*ms_arg_construct_it->second));
-        if(!ms_arg_construct_ptr) { return -1; }
-        cmdlist << (*ms_arg_construct_ptr)(d_in, d_kv_out).dispatch(d_in.size());
-        return 0;
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<Type4Byte>(num_item));
+        Min(cmdlist, temp.view(), d_in, d_out, num_item);
+    }
+
+    template <NumericT Type4Byte>
+    void Max(CommandList& cmdlist, CachingAllocator& allocator, const Stream& stream, BufferView<Type4Byte> d_in, BufferView<Type4Byte> d_out, size_t num_item)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<Type4Byte>(num_item));
+        Max(cmdlist, temp.view(), d_in, d_out, num_item);
+    }
+
+    template <NumericT Type4Byte>
+    void ArgMin(CommandList&          cmdlist,
+                CachingAllocator&     allocator,
+                const Stream&         stream,
+                BufferView<Type4Byte> d_in,
+                BufferView<Type4Byte> d_out,
+                BufferView<uint>      d_index_out,
+                size_t                num_item)
+    {
+        auto temp = allocator.allocate(stream, GetArgTempStorageBytes<Type4Byte>(num_item));
+        ArgMin(cmdlist, temp.view(), d_in, d_out, d_index_out, num_item);
     }
 
     template <NumericT Type4Byte>
+    void ArgMax(CommandList&          cmdlist,
+                CachingAllocator&     allocator,
+                const Stream&         stream,
+                BufferView<Type4Byte> d_in,
+                BufferView<Type4Byte> d_out,
+                BufferView<uint>      d_index_out,
+                size_t                num_item)
+    {
+        auto temp = allocator.allocate(stream, GetArgTempStorageBytes<Type4Byte>(num_item));
+        ArgMax(cmdlist, temp.view(), d_in, d_out, d_index_out, num_item);
+    }
+
+    // ============================================================
+    // Warmup: compile ahead of the first call
+    // ============================================================
+
+    /// Compiles the kernels of Reduce on Types items, e.g. Warmup<uint, float>(MinOp(), MaxOp()),
+    /// on host threads; without ops it is Sum. Calls made before the future is ready compile
+    /// what they miss themselves. The module has to outlive the future
+    template <NumericT... Types, typename... ReduceOps>
+    [[nodiscard]] WarmupFuture Warmup(ReduceOps... reduce_ops)
+    {
+        luisa::vector<WarmupJob> jobs;
+        auto add_op = [&](auto reduce_op) { (add_reduce_warmup<Types>(jobs, reduce_op), ...); };
+        if constexpr(sizeof...(ReduceOps) == 0) { add_op(SumOp()); }
+        else { (add_op(reduce_ops), ...); }
+        return details::compile_in_background(std::move(jobs));
+    }
+
+  private:
+    // the index of every item is zipped with it on the fly, only the winning pair is stored
+    template <IteratorT InputIt, IteratorT ValueOutIt, IteratorT IndexOutIt, typename ArgOp>
+    void arg_reduce(CommandList&                                        cmdlist,
+                    BufferView<uint>                                    temp_storage,
+                    InputIt                                             d_in,
+                    ValueOutIt                                          d_out,
+                    IndexOutIt                                          d_index_out,
+                    size_t                                              num_item,
+                    ArgOp                                               arg_op,
+                    IndexValuePairT<typename InputIt::value_type>       initial_value)
+    {
+        using Type4Byte = typename InputIt::value_type;
+        using IVP       = IndexValuePairT<Type4Byte>;
+        size_t offset_bytes = 0;
+        // reduce temp
+        size_t reduce_temp_uint_count = reduce_temp_count(num_item) * sizeof(IVP) / sizeof(uint);
+        auto reduce_temp = temp_storage.subview(offset_bytes / sizeof(uint), reduce_temp_uint_count).template as<IVP>();
+        offset_bytes += reduce_temp_uint_count * sizeof(uint);
+        offset_bytes = align_up_uint(offset_bytes, alignof(IVP));
+
+        // d_out_kv
+        size_t out_kv_uint_count = 1 * sizeof(IVP) / sizeof(uint);
+        auto d_out_kv = temp_storage.subview(offset_bytes / sizeof(uint), out_kv_uint_count).template as<IVP>();
+
+        ZipIterator d_in_kv{CountingIterator<uint>(0u), d_in};
+        lcpp_check(reduce_array_single_pass<IVP>(cmdlist, reduce_temp, d_in_kv, d_out_kv, num_item, arg_op, initial_value),
+                   cmdlist,
+                   debug_stream());
+
+        // copy result to d_out and d_index_out
+        lcpp_check(arg_assign<Type4Byte>(cmdlist, d_out_kv, d_out, d_index_out), cmdlist, debug_stream());
+    }
+
+    template <NumericT Type4Byte, IteratorT ValueOutIt, IteratorT IndexOutIt>
     [[nodiscard]] int arg_assign(CommandList&                           cmdlist,
-                    BufferView<IndexValuePairT<Type4Byte>> d_kv_in,
-                    BufferView<Type4Byte>                  d_value_out,
-                    BufferView<uint>                       d_index_out) noexcept
+                                 BufferView<IndexValuePairT<Type4Byte>> d_kv_in,
+                                 ValueOutIt                             d_value_out,
+                                 IndexOutIt                             d_index_out) noexcept
     {
-        using ArgReduce       = details::ArgReduce<Type4Byte, BLOCK_SIZE>;
+        using ArgReduce       = details::ArgReduce<Type4Byte, BLOCK_SIZE, ValueOutIt, IndexOutIt>;
         using ArgAssignShader = ArgReduce::ArgAssignShaderT;
-        auto key              = luisa::string{luisa::compute::Type::of<Type4Byte>()->description()};
-        auto ms_arg_assign_it = ms_arg_assign_map.find(key);
-        if(ms_arg_assign_it == ms_arg_assign_map.end())
-        {
-            auto shader = ArgReduce().compile_arg_assign_shader(m_device);
-            if(!shader) { return -1; }
-            ms_arg_assign_map.try_emplace(key, std::move(shader));
-            ms_arg_assign_it = ms_arg_assign_map.find(key);
-        }
-        if(ms_arg_assign_it == ms_arg_assign_map.end()) { return -1; }
-        auto ms_arg_assign_ptr = reinterpret_cast<ArgAssignShader*>(&(*ms_arg_assign_it->second));
+        auto ms_arg_assign_ptr = m_shader_cache.get_or_compile<ArgAssignShader, ArgReduce>(
+            [&] { return ArgReduce().compile_arg_assign_shader(m_device, d_value_out, d_index_out); });
         if(!ms_arg_assign_ptr) { return -1; }
-        cmdlist << (*ms_arg_assign_ptr)(d_kv_in, d_value_out, d_index_out).dispatch(d_index_out.size());
+        details::dispatch_with_iterator_args(
+            cmdlist, *ms_arg_assign_ptr, 1u, std::tuple_cat(d_value_out.host_args(), d_index_out.host_args()), d_kv_in);
         return 0;
     }
 
-    template <NumericTOrKeyValuePairT Type, typename ReduceOp, typename TransformOp = IdentityOp>
-    [[nodiscard]] int reduce_array_recursive(luisa::compute::CommandList& cmdlist,
-                                BufferView<Type>             temp_storage,
-                                BufferView<Type>             arr_in,
-                                BufferView<Type>             arr_out,
-                                uint                         num_items,
-                                uint                         offset,
-                                uint                         level,
-                                ReduceOp                     reduce_op,
-                                Type                         init,
-                                TransformOp                  transform_op = IdentityOp()) noexcept
-    {
-        uint tile_items = m_block_size * ITEMS_PER_THREAD;
-        uint num_tiles  = imax(1, (uint)ceil((float)num_items / tile_items));
+    // reduce_device_occupancy × subscription_factor
+    // reduce_device_occupancy = sm_occupancy × sm_count
+    // sm_occupancy = 8 sm_count = 128, subscription_factor = 5
+    static constexpr uint MAX_REDUCE_GRID = BLOCK_SIZE * 8 * 5;
 
-        // reduce_device_occupancy × subscription_factor
-        // reduce_device_occupancy = sm_occupancy × sm_count
-        // sm_occupancy = 8 sm_count = 128, subscription_factor = 5
-        constexpr auto max_blocks = BLOCK_SIZE * 8 * 5;
+    // one partial per block of the persistent grid
+    static size_t reduce_temp_count(size_t num_items)
+    {
+        size_t num_tiles = ceil_div(num_items, BLOCK_SIZE * ITEMS_PER_THREAD);
+        return std::max<size_t>(1, std::min<size_t>(num_tiles, MAX_REDUCE_GRID));
+    }
 
-        using ReduceShader           = details::ReduceModule<Type, BLOCK_SIZE, ITEMS_PER_THREAD>;
-        using ReduceKernel           = ReduceShader::ReduceShaderKernel;
+    // the module carries the accumulator, the input iterator and the output type, every op is compiled in
+    template <NumericTOrKeyValuePairT Type, typename OutputT, typename ReduceOp, typename TransformOp, IteratorT InputIt, typename OutputOp>
+    [[nodiscard]] auto single_tile_shader(ReduceOp reduce_op, TransformOp transform_op, const InputIt& arr_in, OutputOp output_op)
+    {
+        using ReduceShader           = details::ReduceModule<Type, BLOCK_SIZE, ITEMS_PER_THREAD, InputIt, OutputT>;
         using ReduceSingleTileShader = ReduceShader::ReduceSingleTileShaderKernel;
 
-        size_t           size_elements     = temp_storage.size() - offset;
-        BufferView<Type> temp_buffer_level = temp_storage.subview(offset, size_elements);
+        return m_shader_cache.get_or_compile<ReduceSingleTileShader, ReduceShader, ReduceOp, TransformOp, OutputOp>(
+            [&] { return ReduceShader().compile_single_tile(m_device, m_shared_mem_size, reduce_op, transform_op, arr_in, output_op); });
+    }
+
+    template <NumericTOrKeyValuePairT Type, typename ReduceOp, typename TransformOp, IteratorT InputIt>
+    [[nodiscard]] auto reduce_shader(ReduceOp reduce_op, TransformOp transform_op, const InputIt& arr_in)
+    {
+        using ReduceShader = details::ReduceModule<Type, BLOCK_SIZE, ITEMS_PER_THREAD, InputIt>;
+        using ReduceKernel = ReduceShader::ReduceShaderKernel;
 
-        if(num_tiles > 1)
+        return m_shader_cache.get_or_compile<ReduceKernel, ReduceShader, ReduceOp, TransformOp>(
+            [&] { return ReduceShader().compile(m_device, m_shared_mem_size, reduce_op, transform_op, arr_in); });
+    }
+
+    // the kernels Reduce dispatches on Type items into a Type output: the single tile, the
+    // persistent grid and the fold of its partials
+    template <NumericT Type, typename ReduceOp>
+    void add_reduce_warmup(luisa::vector<WarmupJob>& jobs, ReduceOp reduce_op)
+    {
+        using ItemsIt = BufferIterator<Type>;
+        const ItemsIt items{BufferView<Type>{}};
+        jobs.emplace_back([this, reduce_op, items]
+                          { return single_tile_shader<Type, Type>(reduce_op, CastOp<Type>(), items, CastOp<Type>()) != nullptr; });
+        jobs.emplace_back([this, reduce_op, items] { return reduce_shader<Type>(reduce_op, CastOp<Type>(), items) != nullptr; });
+        jobs.emplace_back([this, reduce_op, items]
+                          { return single_tile_shader<Type, Type>(reduce_op, IdentityOp(), items, CastOp<Type>()) != nullptr; });
+    }
+
+    template <NumericTOrKeyValuePairT Type, typename ReduceOp, typename TransformOp, IteratorT InputIt, typename OutputT = Type, typename OutputOp = IdentityOp>
+    [[nodiscard]] int single_tile_reduce(luisa::compute::CommandList& cmdlist,
+                                         InputIt                      arr_in,
+                                         BufferView<OutputT>          arr_out,
+                                         uint                         num_items,
+                                         ReduceOp                     reduce_op,
+                                         Type                         init,
+                                         TransformOp                  transform_op,
+                                         OutputOp                     output_op = IdentityOp()) noexcept
+    {
+        auto ms_reduce_ptr = single_tile_shader<Type, OutputT>(reduce_op, transform_op, arr_in, output_op);
+        if(!ms_reduce_ptr) { return -1; }
+
+        details::dispatch_with_iterator_args(cmdlist, *ms_reduce_ptr, m_block_size, arr_in.host_args(), arr_out, num_items, init);
+        return 0;
+    }
+
+    /// At most two dispatches for any size: a persistent grid of MAX_REDUCE_GRID blocks at most
+    /// takes even shares of the tiles and writes one partial each, then one block folds the
+    /// partials with the initial value straight into arr_out.
+    /// transform_op widens InputT items to the Type accumulator as they are loaded, output_op
+    /// narrows the final Type aggregate to the OutputT written to arr_out. arr_in is any iterator,
+    /// a BufferIterator for plain buffers
+    template <NumericTOrKeyValuePairT Type, typename ReduceOp, typename TransformOp = IdentityOp, IteratorT InputIt = BufferIterator<Type>, typename OutputT = Type, typename OutputOp = IdentityOp>
+    [[nodiscard]] int reduce_array_single_pass(luisa::compute::CommandList& cmdlist,
+                                               BufferView<Type>             d_partials,
+                                               InputIt                      arr_in,
+                                               BufferView<OutputT>          arr_out,
+                                               uint                         num_items,
+                                               ReduceOp                     reduce_op,
+                                               Type                         init,
+                                               TransformOp                  transform_op = IdentityOp(),
+                                               OutputOp                     output_op    = IdentityOp()) noexcept
+    {
+        uint tile_items = m_block_size * ITEMS_PER_THREAD;
+        uint num_tiles  = ceil_div(num_items, tile_items);
+
+        // a single tile needs no partials
+        if(num_tiles <= 1)
         {
-            auto key          = get_type_and_op_desc<Type>(reduce_op, transform_op);
-            auto ms_reduce_it = ms_reduce_map.find(key);
-            if(ms_reduce_it == ms_reduce_map.end())
-            {
-                auto shader = ReduceShader().compile(m_device, m_shared_mem_size, reduce_op, transform_op);
-                ms_reduce_map.try_emplace(key, std::move(shader));
-                ms_reduce_it = ms_reduce_map.find(key);
-            }
-            auto ms_reduce_ptr = reinterpret_cast<ReduceKernel*>(&(*ms_reduce_it->second));
-
-            GridEvenShared even_share;
-            even_share.DispatchInit(num_items, max_blocks, tile_items);
-            cmdlist << (*ms_reduce_ptr)(arr_in, temp_buffer_level, num_items, even_share).dispatch(m_block_size * num_tiles);
-            lcpp_check(
-                reduce_array_recursive<Type>(
-                    cmdlist, temp_buffer_level, temp_buffer_level, arr_out, num_tiles, num_tiles, level + 1, reduce_op, init, transform_op),
-                cmdlist, debug_stream());
+            return single_tile_reduce<Type>(cmdlist, arr_in, arr_out, num_items, reduce_op, init, transform_op, output_op);
         }
-        else
+
+        auto ms_reduce_ptr = reduce_shader<Type>(reduce_op, transform_op, arr_in);
+        if(!ms_reduce_ptr) { return -1; }
+
+        GridEvenShared even_share;
+        even_share.DispatchInit(num_items, MAX_REDUCE_GRID, tile_items);
+        if(d_partials.size() < even_share.grid_size) { return -1; }
+
+        details::dispatch_with_iterator_args(
+            cmdlist, *ms_reduce_ptr, m_block_size * even_share.grid_size, arr_in.host_args(), d_partials, num_items, even_share);
+
+        // the partials are already transformed
+        return single_tile_reduce<Type>(
+            cmdlist, BufferIterator<Type>(d_partials), arr_out, even_share.grid_size, reduce_op, init, IdentityOp(), output_op);
+    };
+
+
+    // chunks of chunks until one is left, the last level folds in the initial value
+    template <NumericT Type, typename ReduceOp>
+    [[nodiscard]] int deterministic_reduce_array(luisa::compute::CommandList& cmdlist,
+                                                 BufferView<Type>             d_partials,
+                                                 BufferView<Type>             arr_in,
+                                                 BufferView<Type>             arr_out,
+                                                 uint                         num_items,
+                                                 ReduceOp                     reduce_op,
+                                                 Type                         init) noexcept
+    {
+        using Deterministic      = details::DeterministicModule<Type, BLOCK_SIZE>;
+        using ReduceChunksKernel = Deterministic::ReduceChunksKernel;
+
+        auto ms_deterministic_reduce_ptr = m_shader_cache.get_or_compile<ReduceChunksKernel, Deterministic, ReduceOp>(
+            [&] { return Deterministic().compile_reduce_chunks(m_device, reduce_op); });
+        if(!ms_deterministic_reduce_ptr) { return -1; }
+
+        BufferView<Type> level_in     = arr_in;
+        size_t           level_offset = 0;
+        while(num_items > details::DETERMINISTIC_CHUNK_ITEMS)
         {
-            auto key          = get_type_and_op_desc<Type>(reduce_op, IdentityOp());
-            auto ms_reduce_it = ms_single_reduce_map.find(key);
-            if(ms_reduce_it == ms_single_reduce_map.end())
-            {
-                auto shader =
-                    ReduceShader().compile_single_tile(m_device, m_shared_mem_size, reduce_op, IdentityOp());
-                ms_single_reduce_map.try_emplace(key, std::move(shader));
-                ms_reduce_it = ms_single_reduce_map.find(key);
-            }
-            auto ms_reduce_ptr = reinterpret_cast<ReduceSingleTileShader*>(&(*ms_reduce_it->second));
-            // non-recursive
-            cmdlist << (*ms_reduce_ptr)(arr_in, temp_buffer_level, num_items, init).dispatch(m_block_size);
-            cmdlist << arr_out.copy_from(temp_buffer_level);
+            uint num_chunks = ceil_div(num_items, details::DETERMINISTIC_CHUNK_ITEMS);
+            if(level_offset + num_chunks > d_partials.size()) { return -1; }
+            auto level_out = d_partials.subview(level_offset, num_chunks);
+            cmdlist << (*ms_deterministic_reduce_ptr)(level_in, level_out, num_items, init, 0u).dispatch(num_chunks * m_block_size);
+            level_in = level_out;
+            level_offset += num_chunks;
+            num_items = num_chunks;
         }
+        cmdlist << (*ms_deterministic_reduce_ptr)(level_in, arr_out, num_items, init, 1u).dispatch(m_block_size);
         return 0;
-    };
+    }
 
 
     template <NumericT KeyType, NumericT ValueType, typename ReduceOp, typename FlagValuePairT = KeyValuePair<int, ValueType>>
@@ -477,52 +706,44 @@ class DeviceReduce : public LuisaModule
         uint num_tiles  = imax(1, (uint)ceil((float)num_items / tile_items));
 
 
-        using ReduceByKey = details::ReduceByKeyModule<KeyType, ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>;
+        using ReduceByKey = details::ReduceByKeyModule<KeyType, ValueType, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
         using ReduceByKeyTileStateInitKernel = ReduceByKey::ScanTileStateInitKernel;
         using ReduceByKeyKernel              = ReduceByKey::ReduceByKeyKernel;
 
         // init
-        auto init_key                   = get_type_and_op_desc<KeyType, ValueType>();
-        auto ms_scan_tile_state_init_it = ms_scan_tile_state_init_map.find(init_key);
-        if(ms_scan_tile_state_init_it == ms_scan_tile_state_init_map.end())
+        uint epoch = 0;
+        if(m_persistent_tile_status)
         {
-            auto shader = ReduceByKey().compile_scan_tile_state_init(m_device);
-            if (!shader) {
-                return -1; // shader create failed
-            }
-            ms_scan_tile_state_init_map.try_emplace(init_key, std::move(shader));
-            ms_scan_tile_state_init_it = ms_scan_tile_state_init_map.find(init_key);
+            using TileStatus           = details::PersistentTileStatus<BLOCK_SIZE>;
+            using TileStatusInitKernel = TileStatus::TileStatusInitKernel;
+
+            auto ms_tile_status_init_ptr = m_shader_cache.get_or_compile<TileStatusInitKernel, TileStatus>(
+                [&] { return TileStatus::compile_init(m_device); });
+            if(!ms_tile_status_init_ptr) { return -1; }
+            auto lease  = m_tile_status.acquire(m_device, cmdlist, *ms_tile_status_init_ptr, num_tiles);
+            tile_states = lease.tile_status;
+            epoch       = lease.epoch;
         }
-        auto ms_scan_tile_state_init_ptr =
-            reinterpret_cast<ReduceByKeyTileStateInitKernel*>(&(*ms_scan_tile_state_init_it->second));
-        cmdlist << (*ms_scan_tile_state_init_ptr)(tile_states, num_tiles)
-                       .dispatch(num_tiles * m_block_size);
-        // reduce by key
-        auto key                 = get_type_and_op_desc<KeyType, ValueType>(reduce_op);
-        auto ms_reduce_by_key_it = ms_reduce_by_key_map.find(key);
-        if(ms_reduce_by_key_it == ms_reduce_by_key_map.end())
+        else
         {
-            auto shader = ReduceByKey().compile(m_device, m_shared_mem_size, reduce_op);
-            ms_reduce_by_key_map.try_emplace(key, std::move(shader));
-            ms_reduce_by_key_it = ms_reduce_by_key_map.find(key);
+            auto ms_scan_tile_state_init_ptr = m_shader_cache.get_or_compile<ReduceByKeyTileStateInitKernel, ReduceByKey>(
+                [&] { return ReduceByKey().compile_scan_tile_state_init(m_device); });
+            if(!ms_scan_tile_state_init_ptr) { return -1; }
+            cmdlist << (*ms_scan_tile_state_init_ptr)(tile_states, num_tiles)
+                           .dispatch(num_tiles * m_block_size);
         }
-        auto ms_reduce_by_key_ptr = reinterpret_cast<ReduceByKeyKernel*>(&(*ms_reduce_by_key_it->second));
+        // reduce by key
+        auto ms_reduce_by_key_ptr = m_shader_cache.get_or_compile<ReduceByKeyKernel, ReduceByKey, ReduceOp>(
+            [&] { return ReduceByKey().compile(m_device, m_shared_mem_size, reduce_op); });
+        if(!ms_reduce_by_key_ptr) { return -1; }
 
         cmdlist << (*ms_reduce_by_key_ptr)(
-                       tile_states, tile_partial, tile_inclusive, keys_in, values_in, unique_out, aggregated_out, num_runs_out, num_items)
+                       tile_states, tile_partial, tile_inclusive, keys_in, values_in, unique_out, aggregated_out, num_runs_out, num_items, epoch)
                        .dispatch(m_block_size * num_tiles);
         return 0;
     };
 
 
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_reduce_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_single_reduce_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_transform_reduce_map;
-    // for arg reduce
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_arg_construct_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_arg_assign_map;
-    // for reduce by key
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_reduce_by_key_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_scan_tile_state_init_map;
+    ShaderCache m_shader_cache{make_kernel_name("DeviceReduce", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
 };
 }  // namespace luisa::parallel_primitive
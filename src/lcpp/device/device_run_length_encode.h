@@ -0,0 +1,220 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-14 11:36:05
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-07 10:52:30
+ */
+#pragma once
+
+#include <algorithm>
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/memory.h>
+#include <luisa/runtime/stream.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <cstddef>
+#include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/device/details/run_length_encode.h>
+
+namespace luisa::parallel_primitive
+{
+using namespace luisa::compute;
+/// DelayPolicy paces the decoupled look-back of the run scan, see DeviceScan
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
+class DeviceRunLengthEncode : public LuisaModule
+{
+  private:
+    uint m_block_size = BLOCK_SIZE;
+    uint m_warp_nums  = WARP_NUMS;
+
+    Device m_device;
+    bool   m_created = false;
+
+    using RleMode = details::RleMode;
+
+  public:
+    DeviceRunLengthEncode()  = default;
+    ~DeviceRunLengthEncode() = default;
+
+#ifndef NDEBUG
+    Stream* m_debug_stream; // bind debug stream for sync
+#endif
+    inline Stream* debug_stream() noexcept
+    {
+#ifndef NDEBUG
+        return m_debug_stream;
+#else
+        return nullptr;
+#endif
+    }
+    void create(Device& device, Stream* debug_stream = nullptr)
+    {
+        m_device = device;
+        m_shader_cache.bind(device);
+#ifndef NDEBUG
+        m_debug_stream = debug_stream;
+#endif
+        m_created = true;
+    }
+
+    // ============================================================
+    // GetTempStorageBytes: compute required temp buffer size (in bytes)
+    // ============================================================
+
+    /// Temp storage bytes for Encode / NonTrivialRuns
+    static size_t GetTempStorageBytes(size_t num_items)
+    {
+        using RunPairT    = KeyValuePair<uint, uint>;
+        size_t num_tiles  = std::max<size_t>(1, ceil_div<size_t>(num_items, ITEMS_PER_THREAD * BLOCK_SIZE));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
+
+        size_t bytes = 0;
+        bytes += tile_count * sizeof(uint);      // tile_status
+        bytes  = align_up_uint(bytes, alignof(RunPairT));
+        bytes += tile_count * sizeof(RunPairT);  // tile_partial
+        bytes  = align_up_uint(bytes, alignof(RunPairT));
+        bytes += tile_count * sizeof(RunPairT);  // tile_inclusive
+        return bytes;
+    }
+
+    // ============================================================
+    // Dispatch APIs (CUB-style: caller provides temp_storage)
+    // ============================================================
+
+    /// Writes the first key and the length of every run of equal consecutive keys;
+    /// the number of runs is written to d_num_runs_out[0]
+    template <NumericT KeyType, typename EqualityOpT = EqualityOp>
+    void Encode(CommandList&        cmdlist,
+                BufferView<uint>    temp_storage,
+                BufferView<KeyType> d_in,
+                BufferView<KeyType> d_unique_out,
+                BufferView<uint>    d_counts_out,
+                BufferView<uint>    d_num_runs_out,
+                uint                num_items,
+                EqualityOpT         equality_op = {})
+    {
+        // the offsets output is unused by Encode
+        lcpp_check(rle_array<RleMode::Encode, KeyType>(
+                       cmdlist, temp_storage, d_in, d_unique_out, d_num_runs_out, d_counts_out, d_num_runs_out, num_items, equality_op),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// Writes the start offset and the length of every run longer than one item;
+    /// the number of such runs is written to d_num_runs_out[0]
+    template <NumericT KeyType, typename EqualityOpT = EqualityOp>
+    void NonTrivialRuns(CommandList&        cmdlist,
+                        BufferView<uint>    temp_storage,
+                        BufferView<KeyType> d_in,
+                        BufferView<uint>    d_offsets_out,
+                        BufferView<uint>    d_lengths_out,
+                        BufferView<uint>    d_num_runs_out,
+                        uint                num_items,
+                        EqualityOpT         equality_op = {})
+    {
+        // the unique keys output is unused by NonTrivialRuns, d_in is never written through it
+        lcpp_check(rle_array<RleMode::NonTrivialRuns, KeyType>(
+                       cmdlist, temp_storage, d_in, d_in, d_offsets_out, d_lengths_out, d_num_runs_out, num_items, equality_op),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT KeyType, typename EqualityOpT = EqualityOp>
+    void Encode(CommandList&        cmdlist,
+                CachingAllocator&   allocator,
+                const Stream&       stream,
+                BufferView<KeyType> d_in,
+                BufferView<KeyType> d_unique_out,
+                BufferView<uint>    d_counts_out,
+                BufferView<uint>    d_num_runs_out,
+                uint                num_items,
+                EqualityOpT         equality_op = {})
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes(num_items));
+        Encode(cmdlist, temp.view(), d_in, d_unique_out, d_counts_out, d_num_runs_out, num_items, equality_op);
+    }
+
+    template <NumericT KeyType, typename EqualityOpT = EqualityOp>
+    void NonTrivialRuns(CommandList&        cmdlist,
+                        CachingAllocator&   allocator,
+                        const Stream&       stream,
+                        BufferView<KeyType> d_in,
+                        BufferView<uint>    d_offsets_out,
+                        BufferView<uint>    d_lengths_out,
+                        BufferView<uint>    d_num_runs_out,
+                        uint                num_items,
+                        EqualityOpT         equality_op = {})
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes(num_items));
+        NonTrivialRuns(cmdlist, temp.view(), d_in, d_offsets_out, d_lengths_out, d_num_runs_out, num_items, equality_op);
+    }
+
+  private:
+    template <RleMode MODE, NumericT KeyType, typename EqualityOpT>
+    [[nodiscard]] int rle_array(CommandList&        cmdlist,
+                                BufferView<uint>    temp_storage,
+                                BufferView<KeyType> d_in,
+                                BufferView<KeyType> d_unique_out,
+                                BufferView<uint>    d_offsets_out,
+                                BufferView<uint>    d_lengths_out,
+                                BufferView<uint>    d_num_runs_out,
+                                uint                num_items,
+                                EqualityOpT         equality_op) noexcept
+    {
+        using RunLengthEncode         = details::RunLengthEncodeModule<KeyType, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
+        using ScanTileStateInitKernel = RunLengthEncode::ScanTileStateInitKernel;
+        using RunLengthEncodeKernel   = RunLengthEncode::RunLengthEncodeKernel;
+        using RunPairT                = RunLengthEncode::RunPairT;
+
+        uint   tile_items = m_block_size * ITEMS_PER_THREAD;
+        uint   num_tiles  = std::max(1u, ceil_div(num_items, tile_items));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
+
+        size_t offset_bytes = 0;
+        // tile_status: tile_count * uint
+        auto tile_status = temp_storage.subview(offset_bytes / sizeof(uint), tile_count);
+        offset_bytes += tile_count * sizeof(uint);
+        offset_bytes = align_up_uint(offset_bytes, alignof(RunPairT));
+
+        // tile_partial: tile_count * RunPairT
+        size_t partial_uint_count = tile_count * sizeof(RunPairT) / sizeof(uint);
+        auto tile_partial = temp_storage.subview(offset_bytes / sizeof(uint), partial_uint_count).template as<RunPairT>();
+        offset_bytes += partial_uint_count * sizeof(uint);
+        offset_bytes = align_up_uint(offset_bytes, alignof(RunPairT));
+
+        // tile_inclusive: tile_count * RunPairT
+        size_t inclusive_uint_count = tile_count * sizeof(RunPairT) / sizeof(uint);
+        auto tile_inclusive = temp_storage.subview(offset_bytes / sizeof(uint), inclusive_uint_count).template as<RunPairT>();
+
+        // init
+        auto ms_scan_tile_state_init_ptr = m_shader_cache.get_or_compile<ScanTileStateInitKernel, RunLengthEncode>(
+            [&] { return RunLengthEncode().compile_scan_tile_state_init(m_device); });
+        if(!ms_scan_tile_state_init_ptr) { return -1; }
+        cmdlist << (*ms_scan_tile_state_init_ptr)(tile_status, num_tiles).dispatch(num_tiles * m_block_size);
+
+        // encode
+        auto ms_rle_ptr = m_shader_cache.get_or_compile<RunLengthEncodeKernel, RunLengthEncode, std::integral_constant<RleMode, MODE>, EqualityOpT>(
+            [&] { return RunLengthEncode().template compile<MODE>(m_device, equality_op); });
+        if(!ms_rle_ptr) { return -1; }
+        cmdlist << (*ms_rle_ptr)(
+                       tile_status, tile_partial, tile_inclusive, d_in, d_unique_out, d_offsets_out, d_lengths_out, d_num_runs_out, num_items)
+                       .dispatch(num_tiles * m_block_size);
+        return 0;
+    }
+
+    ShaderCache m_shader_cache{make_kernel_name("DeviceRunLengthEncode", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
+};
+}  // namespace luisa::parallel_primitive
@@ -2,12 +2,14 @@
  * @Author: Ligo 
  * @Date: 2025-10-09 09:52:40 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-07 00:12:25
+ * @Last Modified time: 2026-03-07 11:36:27
  */
 
 
 #pragma once
+#include <algorithm>
 #include <cstddef>
+#include <type_traits>
 #include <luisa/runtime/stream.h>
 #include <luisa/dsl/struct.h>
 #include <luisa/core/logging.h>
@@ -17,20 +19,36 @@
 #include <luisa/dsl/sugar.h>
 #include <luisa/dsl/var.h>
 #include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/runtime/warmup.h>
 #include <lcpp/common/type_trait.h>
 #include <lcpp/common/util_type.h>
 #include <lcpp/common/utils.h>
+#include <lcpp/common/thread_operators.h>
 #include <lcpp/block/block_reduce.h>
 #include <lcpp/warp/warp_reduce.h>
 #include <lcpp/device/details/scan.h>
 #include <lcpp/device/details/single_pass_scan_operator.h>
 #include <lcpp/device/details/scan_by_key.h>
+#include <lcpp/device/details/tile_status.h>
+#include <lcpp/device/details/deterministic.h>
+#include <lcpp/device/details/reduce_then_scan.h>
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
 
 namespace luisa::parallel_primitive
 {
 
 using namespace luisa::compute;
-template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+
+/// DelayPolicy paces the decoupled look-back of the single-pass scans and scans by key:
+/// NoDelayPolicy polls the predecessor tiles back to back, FixedDelayPolicy,
+/// ExponentialBackoffPolicy and JitteredBackoffPolicy spin between polls and leave memory
+/// bandwidth to the tiles being waited on.
+/// On backends that do not promise the tiles waited on ever run, the scans take reduce-then-scan
+/// instead, see SetScanAlgorithm
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
 class DeviceScan : public LuisaModule
 {
   private:
@@ -41,6 +59,13 @@ class DeviceScan : public LuisaModule
     Device m_device;
     bool   m_created = false;
 
+    bool                                             m_persistent_tile_status = false;
+    details::PersistentTileStatus<BLOCK_SIZE>        m_tile_status;
+    details::PersistentTileStatus<BLOCK_SIZE, ulong> m_tile_descriptors;
+
+    ScanAlgorithm m_scan_algorithm   = ScanAlgorithm::AUTO;
+    bool          m_forward_progress = true;
+
   public:
     DeviceScan()  = default;
     ~DeviceScan() = default;
@@ -59,33 +84,59 @@ class DeviceScan : public LuisaModule
     void create(Device& device, Stream* debug_stream = nullptr)
     {
         m_device                   = device;
+        m_shader_cache.bind(device);
 #ifndef NDEBUG
         m_debug_stream = debug_stream;
 #endif
         int num_elements_per_block = m_block_size * ITEMS_PER_THREAD;
         int extra_space            = num_elements_per_block / m_warp_nums;
         m_shared_mem_size          = (num_elements_per_block + extra_space);
+        m_forward_progress         = details::backend_has_forward_progress(device.backend_name());
         m_created                  = true;
     }
 
+    /// The single-pass scans keep their look-back tile status in the module, tagged with a new
+    /// epoch by every call, instead of initializing it in temp storage first: one dispatch per
+    /// scan instead of two. The scans of the module then share it and have to run one after
+    /// another on a single stream
+    void SetPersistentTileStatus(bool enable) noexcept { m_persistent_tile_status = enable; }
+
+    /// How ExclusiveScan / InclusiveScan, the Sum variants and the scans by key pass prefixes
+    /// between tiles. The decoupled look-back is one pass but has a tile wait on the ones before
+    /// it, which only terminates if those are scheduled; REDUCE_THEN_SCAN reads the input twice
+    /// and waits on nothing. AUTO, the default, takes the look-back unless the backend of
+    /// create() makes no forward progress promise (CPU, Metal). The delay policy and the
+    /// persistent tile status only concern the look-back
+    void SetScanAlgorithm(ScanAlgorithm algorithm) noexcept { m_scan_algorithm = algorithm; }
+
     // ============================================================
     // GetTempStorageBytes: compute required temp buffer size (in bytes)
     // ============================================================
 
     /// Temp storage bytes for ExclusiveScan / InclusiveScan / ExclusiveSum / InclusiveSum
+    /// Type4Byte is the accumulator type, the OutputT for the Sum variants; 4-byte accumulators
+    /// take one packed 64-bit descriptor per tile. Enough for either ScanAlgorithm
     template <typename Type4Byte>
     static size_t GetTempStorageBytes(size_t num_items)
     {
-        int num_tiles = imax(1, (int)ceil((float)num_items / (ITEMS_PER_THREAD * BLOCK_SIZE)));
-        size_t tile_count = details::WARP_SIZE + num_tiles;
+        return std::max(look_back_temp_storage_bytes<Type4Byte>(num_items),
+                        details::reduce_then_scan_partial_count(num_items, ITEMS_PER_THREAD * BLOCK_SIZE) * sizeof(Type4Byte));
+    }
 
-        size_t bytes = 0;
-        bytes += tile_count * sizeof(uint);               // tile_status
-        bytes  = align_up_uint(bytes, alignof(Type4Byte));
-        bytes += tile_count * sizeof(Type4Byte);          // tile_partial
-        bytes  = align_up_uint(bytes, alignof(Type4Byte));
-        bytes += tile_count * sizeof(Type4Byte);          // tile_inclusive
-        return bytes;
+    /// Temp storage bytes for DeterministicInclusiveScan / DeterministicInclusiveSum
+    /// The scanned totals of every level of chunks, no tile states
+    template <typename Type4Byte>
+    static size_t GetDeterministicTempStorageBytes(size_t num_items)
+    {
+        return details::deterministic_partial_count(num_items) * sizeof(Type4Byte);
+    }
+
+    /// Temp storage bytes for CompensatedInclusiveSum
+    /// The deterministic chunk totals, each one a CompensatedSumT
+    template <typename Type4Byte>
+    static size_t GetCompensatedSumTempStorageBytes(size_t num_items)
+    {
+        return details::deterministic_partial_count(num_items) * sizeof(CompensatedSumT<Type4Byte>);
     }
 
     /// Temp storage bytes for ExclusiveScanByKey / InclusiveScanByKey
@@ -102,8 +153,6 @@ class DeviceScan : public LuisaModule
         bytes += tile_count * sizeof(FlagValuePairT);        // tile_partial
         bytes  = align_up_uint(bytes, alignof(FlagValuePairT));
         bytes += tile_count * sizeof(FlagValuePairT);        // tile_inclusive
-        bytes  = align_up_uint(bytes, alignof(KeyType));
-        bytes += num_tiles * sizeof(KeyType);                // d_prev_keys_in
         return bytes;
     }
 
@@ -111,96 +160,131 @@ class DeviceScan : public LuisaModule
     // Dispatch APIs (CUB-style: caller provides temp_storage)
     // ============================================================
 
-    template <NumericT Type4Byte, typename ScanOp>
-    void ExclusiveScan(CommandList&          cmdlist,
-                       BufferView<uint>      temp_storage,
-                       BufferView<Type4Byte> d_in,
-                       BufferView<Type4Byte> d_out,
-                       size_t                num_items,
-                       ScanOp                scan_op,
-                       Type4Byte             initial_value)
-    {
-        int  num_tiles   = imax(1, (int)ceil((float)num_items / (ITEMS_PER_THREAD * m_block_size)));
-        size_t tile_count = details::WARP_SIZE + num_tiles;
+    /// The scan accumulates in the type of initial_value: InputT items are widened to AccumT as
+    /// the tile is loaded and every prefix is converted to OutputT as it is stored
+    template <NumericT InputT, NumericT OutputT, NumericT AccumT, typename ScanOp>
+    void ExclusiveScan(CommandList&        cmdlist,
+                       BufferView<uint>    temp_storage,
+                       BufferView<InputT>  d_in,
+                       BufferView<OutputT> d_out,
+                       size_t              num_items,
+                       ScanOp              scan_op,
+                       AccumT              initial_value)
+    {
+        ExclusiveScan(cmdlist, temp_storage, BufferIterator<InputT>(d_in), d_out, num_items, scan_op, initial_value);
+    }
 
-        size_t offset_bytes = 0;
-        // tile_status
-        auto tile_status = temp_storage.subview(offset_bytes / sizeof(uint), tile_count);
-        offset_bytes += tile_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(Type4Byte));
+    /// Scans the items of a fancy iterator, they are produced by the tile load of the scan kernel
+    template <IteratorT InputIt, NumericT OutputT, NumericT AccumT, typename ScanOp>
+    void ExclusiveScan(CommandList&        cmdlist,
+                       BufferView<uint>    temp_storage,
+                       InputIt             d_in,
+                       BufferView<OutputT> d_out,
+                       size_t              num_items,
+                       ScanOp              scan_op,
+                       AccumT              initial_value)
+    {
+        lcpp_check(scan_array<AccumT>(cmdlist, temp_storage, d_in, d_out, num_items, scan_op, initial_value, false),
+                   cmdlist, debug_stream());
+    }
 
-        // tile_partial
-        size_t partial_uint_count = tile_count * sizeof(Type4Byte) / sizeof(uint);
-        auto tile_partial = temp_storage.subview(offset_bytes / sizeof(uint), partial_uint_count).template as<Type4Byte>();
-        offset_bytes += partial_uint_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(Type4Byte));
+    template <NumericT InputT, NumericT OutputT, NumericT AccumT, typename ScanOp>
+    void InclusiveScan(CommandList&        cmdlist,
+                       BufferView<uint>    temp_storage,
+                       BufferView<InputT>  d_in,
+                       BufferView<OutputT> d_out,
+                       size_t              num_items,
+                       ScanOp              scan_op,
+                       AccumT              initial_value)
+    {
+        InclusiveScan(cmdlist, temp_storage, BufferIterator<InputT>(d_in), d_out, num_items, scan_op, initial_value);
+    }
 
-        // tile_inclusive
-        size_t inclusive_uint_count = tile_count * sizeof(Type4Byte) / sizeof(uint);
-        auto tile_inclusive = temp_storage.subview(offset_bytes / sizeof(uint), inclusive_uint_count).template as<Type4Byte>();
+    template <IteratorT InputIt, NumericT OutputT, NumericT AccumT, typename ScanOp>
+    void InclusiveScan(CommandList&        cmdlist,
+                       BufferView<uint>    temp_storage,
+                       InputIt             d_in,
+                       BufferView<OutputT> d_out,
+                       size_t              num_items,
+                       ScanOp              scan_op,
+                       AccumT              initial_value)
+    {
+        lcpp_check(scan_array<AccumT>(cmdlist, temp_storage, d_in, d_out, num_items, scan_op, initial_value, true),
+                   cmdlist, debug_stream());
+    }
 
-        lcpp_check(scan_array<Type4Byte>(
-            cmdlist, tile_status, tile_partial, tile_inclusive, d_in, d_out, num_items, scan_op, initial_value, false),
-            cmdlist, debug_stream());
+    /// Accumulates in OutputT, e.g. uint8 flags into uint counts
+    template <NumericT InputT, NumericT OutputT>
+    void ExclusiveSum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<InputT> d_in, BufferView<OutputT> d_out, size_t num_items)
+    {
+        ExclusiveScan(cmdlist, temp_storage, d_in, d_out, num_items, SumOp(), OutputT(0));
     }
 
-    template <NumericT Type4Byte, typename ScanOp>
-    void InclusiveScan(CommandList&          cmdlist,
-                       BufferView<uint>      temp_storage,
-                       BufferView<Type4Byte> d_in,
-                       BufferView<Type4Byte> d_out,
-                       size_t                num_items,
-                       ScanOp                scan_op,
-                       Type4Byte             initial_value)
-    {
-        int  num_tiles   = imax(1, (int)ceil((float)num_items / (ITEMS_PER_THREAD * m_block_size)));
-        size_t tile_count = details::WARP_SIZE + num_tiles;
+    /// Accumulates in OutputT, e.g. uint8 flags into uint counts
+    template <NumericT InputT, NumericT OutputT>
+    void InclusiveSum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<InputT> d_in, BufferView<OutputT> d_out, size_t num_items)
+    {
+        InclusiveScan(cmdlist, temp_storage, d_in, d_out, num_items, SumOp(), OutputT(0));
+    }
 
-        size_t offset_bytes = 0;
-        // tile_status
-        auto tile_status = temp_storage.subview(offset_bytes / sizeof(uint), tile_count);
-        offset_bytes += tile_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(Type4Byte));
+    template <IteratorT InputIt, NumericT OutputT>
+    void ExclusiveSum(CommandList& cmdlist, BufferView<uint> temp_storage, InputIt d_in, BufferView<OutputT> d_out, size_t num_items)
+    {
+        ExclusiveScan(cmdlist, temp_storage, d_in, d_out, num_items, SumOp(), OutputT(0));
+    }
 
-        // tile_partial
-        size_t partial_uint_count = tile_count * sizeof(Type4Byte) / sizeof(uint);
-        auto tile_partial = temp_storage.subview(offset_bytes / sizeof(uint), partial_uint_count).template as<Type4Byte>();
-        offset_bytes += partial_uint_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(Type4Byte));
+    template <IteratorT InputIt, NumericT OutputT>
+    void InclusiveSum(CommandList& cmdlist, BufferView<uint> temp_storage, InputIt d_in, BufferView<OutputT> d_out, size_t num_items)
+    {
+        InclusiveScan(cmdlist, temp_storage, d_in, d_out, num_items, SumOp(), OutputT(0));
+    }
 
-        // tile_inclusive
-        size_t inclusive_uint_count = tile_count * sizeof(Type4Byte) / sizeof(uint);
-        auto tile_inclusive = temp_storage.subview(offset_bytes / sizeof(uint), inclusive_uint_count).template as<Type4Byte>();
+    /// Bit for bit reproducible inclusive scan: chunk totals, run prefixes and in-run folds all
+    /// follow the item indices, so the output does not change with the tile size, the backend or
+    /// the run. d_out may alias d_in.
+    template <NumericT Type4Byte, typename ScanOp>
+    void DeterministicInclusiveScan(CommandList&          cmdlist,
+                                    BufferView<uint>      temp_storage,
+                                    BufferView<Type4Byte> d_in,
+                                    BufferView<Type4Byte> d_out,
+                                    size_t                num_items,
+                                    ScanOp                scan_op,
+                                    Type4Byte             initial_value)
+    {
+        size_t temp_count = details::deterministic_partial_count(num_items);
+        auto temp_view = temp_storage.subview(0, temp_count * sizeof(Type4Byte) / sizeof(uint)).template as<Type4Byte>();
 
-        lcpp_check(scan_array<Type4Byte>(
-            cmdlist, tile_status, tile_partial, tile_inclusive, d_in, d_out, num_items, scan_op, initial_value, true),
-            cmdlist, debug_stream());
+        lcpp_check(deterministic_scan_array<Type4Byte>(cmdlist, temp_view, d_in, d_out, num_items, scan_op, initial_value),
+                   cmdlist,
+                   debug_stream());
     }
 
     template <NumericT Type4Byte>
-    void ExclusiveSum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<Type4Byte> d_in, BufferView<Type4Byte> d_out, size_t num_items)
+    void DeterministicInclusiveSum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<Type4Byte> d_in, BufferView<Type4Byte> d_out, size_t num_items)
     {
-        ExclusiveScan(
+        DeterministicInclusiveScan(
             cmdlist,
             temp_storage,
             d_in,
             d_out,
             num_items,
-            [](const Var<Type4Byte>& a, const Var<Type4Byte>& b) { return a + b; },
+            SumOp(),
             Type4Byte(0));
     }
 
+    /// Neumaier compensated inclusive sum of float items: the prefixes are carried as
+    /// CompensatedSumT and rounded to Type4Byte only when written, so every output is close to
+    /// the double precision prefix. Runs on the deterministic chunk scheme, so it is bit for bit
+    /// reproducible as well. d_out may alias d_in.
     template <NumericT Type4Byte>
-    void InclusiveSum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<Type4Byte> d_in, BufferView<Type4Byte> d_out, size_t num_items)
+        requires std::is_floating_point_v<Type4Byte>
+    void CompensatedInclusiveSum(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<Type4Byte> d_in, BufferView<Type4Byte> d_out, size_t num_items)
     {
-        InclusiveScan(
-            cmdlist,
-            temp_storage,
-            d_in,
-            d_out,
-            num_items,
-            [](const Var<Type4Byte>& a, const Var<Type4Byte>& b) { return a + b; },
-            Type4Byte(0));
+        using AccumT      = CompensatedSumT<Type4Byte>;
+        size_t temp_count = details::deterministic_partial_count(num_items);
+        auto temp_view = temp_storage.subview(0, temp_count * sizeof(AccumT) / sizeof(uint)).template as<AccumT>();
+
+        lcpp_check(compensated_scan_array<Type4Byte>(cmdlist, temp_view, d_in, d_out, num_items), cmdlist, debug_stream());
     }
 
     template <NumericT KeyType, NumericT ValueType, typename ScanOp>
@@ -232,19 +316,12 @@ class DeviceScan : public LuisaModule
         // tile_inclusive
         size_t inclusive_uint_count = tile_count * sizeof(FlagValuePairT) / sizeof(uint);
         auto tile_inclusive = temp_storage.subview(offset_bytes / sizeof(uint), inclusive_uint_count).template as<FlagValuePairT>();
-        offset_bytes += inclusive_uint_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(KeyType));
-
-        // d_prev_keys_in
-        size_t prev_keys_uint_count = bytes_to_uint_count(num_tiles * sizeof(KeyType));
-        auto d_prev_keys_in = temp_storage.subview(offset_bytes / sizeof(uint), prev_keys_uint_count).template as<KeyType>();
 
         lcpp_check(scan_by_key_array<KeyType, ValueType>(cmdlist,
                                               tile_status,
                                               tile_partial,
                                               tile_inclusive,
                                               d_keys_in,
-                                              d_prev_keys_in,
                                               d_values_in,
                                               d_values_out,
                                               num_items,
@@ -283,19 +360,12 @@ class DeviceScan : public LuisaModule
         // tile_inclusive
         size_t inclusive_uint_count = tile_count * sizeof(FlagValuePairT) / sizeof(uint);
         auto tile_inclusive = temp_storage.subview(offset_bytes / sizeof(uint), inclusive_uint_count).template as<FlagValuePairT>();
-        offset_bytes += inclusive_uint_count * sizeof(uint);
-        offset_bytes = align_up_uint(offset_bytes, alignof(KeyType));
-
-        // d_prev_keys_in
-        size_t prev_keys_uint_count = num_tiles * sizeof(KeyType) / sizeof(uint);
-        auto d_prev_keys_in = temp_storage.subview(offset_bytes / sizeof(uint), prev_keys_uint_count).template as<KeyType>();
 
         lcpp_check(scan_by_key_array<KeyType, ValueType>(cmdlist,
                                               tile_status,
                                               tile_partial,
                                               tile_inclusive,
                                               d_keys_in,
-                                              d_prev_keys_in,
                                               d_values_in,
                                               d_values_out,
                                               num_items,
@@ -320,7 +390,7 @@ class DeviceScan : public LuisaModule
             d_keys_in,
             d_values_in,
             d_values_out,
-            [](const Var<Type4Byte>& a, const Var<Type4Byte>& b) { return a + b; },
+            SumOp(),
             num_items,
             Type4Byte(0));
     }
@@ -339,77 +409,437 @@ class DeviceScan : public LuisaModule
             d_keys_in,
             d_values_in,
             d_values_out,
-            [](const Var<Type4Byte>& a, const Var<Type4Byte>& b) { return a + b; },
+            SumOp(),
             num_items,
             Type4Byte(0));
     }
 
 
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT InputT, NumericT OutputT, NumericT AccumT, typename ScanOp>
+    void ExclusiveScan(CommandList&        cmdlist,
+                       CachingAllocator&   allocator,
+                       const Stream&       stream,
+                       BufferView<InputT>  d_in,
+                       BufferView<OutputT> d_out,
+                       size_t              num_items,
+                       ScanOp              scan_op,
+                       AccumT              initial_value)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<AccumT>(num_items));
+        ExclusiveScan(cmdlist, temp.view(), d_in, d_out, num_items, scan_op, initial_value);
+    }
+
+    template <NumericT InputT, NumericT OutputT, NumericT AccumT, typename ScanOp>
+    void InclusiveScan(CommandList&        cmdlist,
+                       CachingAllocator&   allocator,
+                       const Stream&       stream,
+                       BufferView<InputT>  d_in,
+                       BufferView<OutputT> d_out,
+                       size_t              num_items,
+                       ScanOp              scan_op,
+                       AccumT              initial_value)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<AccumT>(num_items));
+        InclusiveScan(cmdlist, temp.view(), d_in, d_out, num_items, scan_op, initial_value);
+    }
+
+    template <NumericT InputT, NumericT OutputT>
+    void ExclusiveSum(CommandList& cmdlist, CachingAllocator& allocator, const Stream& stream, BufferView<InputT> d_in, BufferView<OutputT> d_out, size_t num_items)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<OutputT>(num_items));
+        ExclusiveSum(cmdlist, temp.view(), d_in, d_out, num_items);
+    }
+
+    template <NumericT InputT, NumericT OutputT>
+    void InclusiveSum(CommandList& cmdlist, CachingAllocator& allocator, const Stream& stream, BufferView<InputT> d_in, BufferView<OutputT> d_out, size_t num_items)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<OutputT>(num_items));
+        InclusiveSum(cmdlist, temp.view(), d_in, d_out, num_items);
+    }
+
+    // ============================================================
+    // Warmup: compile ahead of the first call
+    // ============================================================
+
+    /// Compiles the kernels of InclusiveScan and ExclusiveScan on Types items, e.g.
+    /// Warmup<uint, float>(MaxOp()), on host threads; without ops it is the Sum scans. Calls made
+    /// before the future is ready compile what they miss themselves. The module has to outlive
+    /// the future
+    template <NumericT... Types, typename... ScanOps>
+    [[nodiscard]] WarmupFuture Warmup(ScanOps... scan_ops)
+    {
+        luisa::vector<WarmupJob> jobs;
+        auto add_op = [&](auto scan_op) { (add_scan_warmup<Types>(jobs, scan_op), ...); };
+        if constexpr(sizeof...(ScanOps) == 0) { add_op(SumOp()); }
+        else { (add_op(scan_ops), ...); }
+        return details::compile_in_background(std::move(jobs));
+    }
+
   private:
-    template <NumericT Type4Byte, typename ScanOp>
-    [[nodiscard]] int scan_array(CommandList&          cmdlist,
-                    BufferView<uint>      tile_states,
-                    BufferView<Type4Byte> tile_partial,
-                    BufferView<Type4Byte> tile_inclusive,
-                    BufferView<Type4Byte> d_in,
-                    BufferView<Type4Byte> d_out,
-                    size_t                num_items,
-                    ScanOp                scan_op,
-                    Type4Byte             initial_value,
-                    bool                  is_inclusive)
+    // the tile states of the decoupled look-back
+    template <typename Type4Byte>
+    static size_t look_back_temp_storage_bytes(size_t num_items)
     {
-        uint num_tiles = imax(1, ceil_div(num_items, (ITEMS_PER_THREAD * m_block_size)));
+        int num_tiles = imax(1, (int)ceil((float)num_items / (ITEMS_PER_THREAD * BLOCK_SIZE)));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
 
-        using ScanShader = details::ScanModule<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>;
-        using ScanTileStateInitKernel = ScanShader::ScanTileStateInitKernel;
-        using ScanShaderKernel        = ScanShader::ScanKernel;
+        if constexpr(is_packed_tile_state_v<Type4Byte>)
+        {
+            return tile_count * sizeof(ulong);                // tile_descriptor
+        }
+        size_t bytes = 0;
+        bytes += tile_count * sizeof(uint);               // tile_status
+        bytes  = align_up_uint(bytes, alignof(Type4Byte));
+        bytes += tile_count * sizeof(Type4Byte);          // tile_partial
+        bytes  = align_up_uint(bytes, alignof(Type4Byte));
+        bytes += tile_count * sizeof(Type4Byte);          // tile_inclusive
+        return bytes;
+    }
 
+    [[nodiscard]] bool use_reduce_then_scan() const noexcept
+    {
+        return m_scan_algorithm == ScanAlgorithm::REDUCE_THEN_SCAN
+               || (m_scan_algorithm == ScanAlgorithm::AUTO && !m_forward_progress);
+    }
 
-        size_t init_num_blocks = ceil_div(num_tiles, m_block_size);
-        auto   init_key = luisa::string{luisa::compute::Type::of<Type4Byte>()->description()};
-        auto   ms_tile_state_init_it = ms_scan_key.find(init_key);
-        if(ms_tile_state_init_it == ms_scan_key.end())
+    // the tile states only depend on the accumulator, every input and output type shares them
+    template <NumericT Type4Byte>
+    [[nodiscard]] auto scan_tile_state_init_shader()
+    {
+        using ScanTileState           = details::ScanModule<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD>;
+        using ScanTileStateInitKernel = ScanTileState::ScanTileStateInitKernel;
+
+        return m_shader_cache.get_or_compile<ScanTileStateInitKernel, ScanTileState>(
+            [&] { return ScanTileState().compile_scan_tile_state_init(m_device); });
+    }
+
+    // the input iterator and the output type pick the kernel as much as the accumulator does
+    template <bool IS_INCLUSIVE, NumericT Type4Byte, NumericT OutputT, typename ScanOp, IteratorT InputIt>
+    [[nodiscard]] auto scan_shader(ScanOp scan_op, const InputIt& d_in)
+    {
+        using ScanShader       = details::ScanModule<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD, InputIt, OutputT, DelayPolicy>;
+        using ScanShaderKernel = ScanShader::ScanKernel;
+
+        return m_shader_cache.get_or_compile<ScanShaderKernel, ScanShader, ScanOp, std::bool_constant<IS_INCLUSIVE>>(
+            [&] { return ScanShader().template compile<IS_INCLUSIVE>(m_device, m_shared_mem_size, scan_op, d_in); });
+    }
+
+    template <NumericT Type4Byte, NumericT OutputT, typename ScanOp, IteratorT InputIt>
+    [[nodiscard]] auto reduce_then_scan_upsweep_shader(ScanOp scan_op, const InputIt& d_in)
+    {
+        using ReduceThenScan = details::ReduceThenScanModule<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD, InputIt, OutputT>;
+        using UpsweepKernel  = ReduceThenScan::UpsweepKernel;
+
+        return m_shader_cache.get_or_compile<UpsweepKernel, ReduceThenScan, ScanOp>(
+            [&] { return ReduceThenScan().compile_upsweep(m_device, m_shared_mem_size, scan_op, d_in); });
+    }
+
+    template <bool IS_INCLUSIVE, NumericT Type4Byte, NumericT OutputT, typename ScanOp, IteratorT InputIt>
+    [[nodiscard]] auto reduce_then_scan_downsweep_shader(ScanOp scan_op, const InputIt& d_in)
+    {
+        using ReduceThenScan  = details::ReduceThenScanModule<Type4Byte, BLOCK_SIZE, ITEMS_PER_THREAD, InputIt, OutputT>;
+        using DownsweepKernel = ReduceThenScan::DownsweepKernel;
+
+        return m_shader_cache.get_or_compile<DownsweepKernel, ReduceThenScan, ScanOp, std::bool_constant<IS_INCLUSIVE>>(
+            [&] { return ReduceThenScan().template compile_downsweep<IS_INCLUSIVE>(m_device, m_shared_mem_size, scan_op, d_in); });
+    }
+
+    // the kernels InclusiveScan and ExclusiveScan dispatch on Type items into a Type output
+    template <NumericT Type, typename ScanOp>
+    void add_scan_warmup(luisa::vector<WarmupJob>& jobs, ScanOp scan_op)
+    {
+        const BufferIterator<Type> items{BufferView<Type>{}};
+        if(use_reduce_then_scan())
+        {
+            // the spine scans the tile totals in place, from and into Type buffers as well
+            jobs.emplace_back([this, scan_op, items] { return reduce_then_scan_upsweep_shader<Type, Type>(scan_op, items) != nullptr; });
+            jobs.emplace_back([this, scan_op, items]
+                              { return reduce_then_scan_downsweep_shader<true, Type, Type>(scan_op, items) != nullptr; });
+            jobs.emplace_back([this, scan_op, items]
+                              { return reduce_then_scan_downsweep_shader<false, Type, Type>(scan_op, items) != nullptr; });
+            return;
+        }
+        if(m_persistent_tile_status)
+        {
+            using WordT = std::conditional_t<is_packed_tile_state_v<Type>, ulong, uint>;
+            jobs.emplace_back([this] { return tile_status_init_shader<WordT>() != nullptr; });
+        }
+        else { jobs.emplace_back([this] { return scan_tile_state_init_shader<Type>() != nullptr; }); }
+        jobs.emplace_back([this, scan_op, items] { return scan_shader<true, Type, Type>(scan_op, items) != nullptr; });
+        jobs.emplace_back([this, scan_op, items] { return scan_shader<false, Type, Type>(scan_op, items) != nullptr; });
+    }
+
+    template <typename WordT>
+    [[nodiscard]] auto tile_status_init_shader()
+    {
+        using TileStatus           = details::PersistentTileStatus<BLOCK_SIZE, WordT>;
+        using TileStatusInitKernel = TileStatus::TileStatusInitKernel;
+
+        return m_shader_cache.get_or_compile<TileStatusInitKernel, TileStatus>([&] { return TileStatus::compile_init(m_device); });
+    }
+
+    // the status words (or packed descriptors) of the module and the epoch of this call,
+    // initialized first when they grow
+    template <typename WordT = uint>
+    [[nodiscard]] bool acquire_tile_status(CommandList& cmdlist, uint num_tiles, BufferView<WordT>& tile_status, uint& epoch)
+    {
+        using TileStatus = details::PersistentTileStatus<BLOCK_SIZE, WordT>;
+
+        auto ms_tile_status_init_ptr = tile_status_init_shader<WordT>();
+        if(!ms_tile_status_init_ptr) { return false; }
+        auto& words = [this]() -> TileStatus&
+        {
+            if constexpr(std::is_same_v<WordT, ulong>) { return m_tile_descriptors; }
+            else { return m_tile_status; }
+        }();
+        auto lease  = words.acquire(m_device, cmdlist, *ms_tile_status_init_ptr, num_tiles);
+        tile_status = lease.tile_status;
+        epoch       = lease.epoch;
+        return true;
+    }
+
+    // the tile states are carved from temp_storage, laid out as GetTempStorageBytes<Type4Byte> sizes them
+    template <NumericT Type4Byte, typename ScanOp, IteratorT InputIt, NumericT OutputT = Type4Byte>
+    [[nodiscard]] int scan_array(CommandList&        cmdlist,
+                    BufferView<uint>    temp_storage,
+                    InputIt             d_in,
+                    BufferView<OutputT> d_out,
+                    size_t              num_items,
+                    ScanOp              scan_op,
+                    Type4Byte           initial_value,
+                    bool                is_inclusive)
+    {
+        if(use_reduce_then_scan())
         {
-            auto shader = ScanShader().compile_scan_tile_state_init(m_device);
-            if (!shader) { return -1; }
-            ms_scan_key.try_emplace(init_key, std::move(shader));
-            ms_tile_state_init_it = ms_scan_key.find(init_key);
+            size_t partial_count = details::reduce_then_scan_partial_count(num_items, ITEMS_PER_THREAD * m_block_size);
+            auto   d_partials =
+                temp_storage.subview(0, bytes_to_uint_count(partial_count * sizeof(Type4Byte))).template as<Type4Byte>();
+            return reduce_then_scan_array<Type4Byte>(
+                cmdlist, d_partials, d_in, d_out, num_items, scan_op, initial_value, is_inclusive);
         }
-        if(ms_tile_state_init_it == ms_scan_key.end()) { return -1; }
-        auto ms_scan_tile_state_init_ptr =
-            reinterpret_cast<ScanTileStateInitKernel*>(&(*ms_tile_state_init_it->second));
-        if(!ms_scan_tile_state_init_ptr) { return -1; }
-        cmdlist << (*ms_scan_tile_state_init_ptr)(tile_states, tile_partial, tile_inclusive, uint(num_tiles))
-                       .dispatch(m_block_size * init_num_blocks);
 
-        // scan
-        auto key = get_type_and_op_desc<Type4Byte>(scan_op);
-        auto ms_scan_it = is_inclusive ? ms_inclusive_scan_map.find(key) : ms_exclusive_scan_map.find(key);
-        if(ms_scan_it == (is_inclusive ? ms_inclusive_scan_map : ms_exclusive_scan_map).end())
+        uint   num_tiles  = imax(1, ceil_div(num_items, (ITEMS_PER_THREAD * m_block_size)));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
+
+        auto ms_scan_ptr = is_inclusive ? scan_shader<true, Type4Byte, OutputT>(scan_op, d_in) :
+                                          scan_shader<false, Type4Byte, OutputT>(scan_op, d_in);
+        if(!ms_scan_ptr) { return -1; }
+
+        uint   epoch           = 0;
+        size_t init_num_blocks = ceil_div(num_tiles, m_block_size);
+        if constexpr(is_packed_tile_state_v<Type4Byte>)
         {
-            if(is_inclusive)
+            // tile_descriptor
+            auto tile_descriptors = temp_storage.subview(0, tile_count * sizeof(ulong) / sizeof(uint)).template as<ulong>();
+            if(m_persistent_tile_status)
             {
-                auto shader = ScanShader().template compile<true>(m_device, m_shared_mem_size, scan_op);
-                if (!shader) { return -1; }
-                ms_inclusive_scan_map.try_emplace(key, std::move(shader));
-                ms_scan_it = ms_inclusive_scan_map.find(key);
+                if(!acquire_tile_status(cmdlist, num_tiles, tile_descriptors, epoch)) { return -1; }
             }
             else
             {
-                auto shader = ScanShader().template compile<false>(m_device, m_shared_mem_size, scan_op);
-                if (!shader) { return -1; }
-                ms_exclusive_scan_map.try_emplace(key, std::move(shader));
-                ms_scan_it = ms_exclusive_scan_map.find(key);
+                auto ms_scan_tile_state_init_ptr = scan_tile_state_init_shader<Type4Byte>();
+                if(!ms_scan_tile_state_init_ptr) { return -1; }
+                cmdlist << (*ms_scan_tile_state_init_ptr)(tile_descriptors, uint(num_tiles)).dispatch(m_block_size * init_num_blocks);
             }
+
+            details::dispatch_with_iterator_args(
+                cmdlist, *ms_scan_ptr, m_block_size * num_tiles, d_in.host_args(), tile_descriptors, d_out, initial_value, uint(num_items), epoch);
+        }
+        else
+        {
+            size_t offset_bytes = 0;
+            // tile_status
+            auto tile_states = temp_storage.subview(offset_bytes / sizeof(uint), tile_count);
+            offset_bytes += tile_count * sizeof(uint);
+            offset_bytes = align_up_uint(offset_bytes, alignof(Type4Byte));
+
+            // tile_partial
+            size_t partial_uint_count = tile_count * sizeof(Type4Byte) / sizeof(uint);
+            auto tile_partial = temp_storage.subview(offset_bytes / sizeof(uint), partial_uint_count).template as<Type4Byte>();
+            offset_bytes += partial_uint_count * sizeof(uint);
+            offset_bytes = align_up_uint(offset_bytes, alignof(Type4Byte));
+
+            // tile_inclusive
+            size_t inclusive_uint_count = tile_count * sizeof(Type4Byte) / sizeof(uint);
+            auto tile_inclusive = temp_storage.subview(offset_bytes / sizeof(uint), inclusive_uint_count).template as<Type4Byte>();
+
+            if(m_persistent_tile_status)
+            {
+                if(!acquire_tile_status(cmdlist, num_tiles, tile_states, epoch)) { return -1; }
+            }
+            else
+            {
+                auto ms_scan_tile_state_init_ptr = scan_tile_state_init_shader<Type4Byte>();
+                if(!ms_scan_tile_state_init_ptr) { return -1; }
+                cmdlist << (*ms_scan_tile_state_init_ptr)(tile_states, tile_partial, tile_inclusive, uint(num_tiles))
+                               .dispatch(m_block_size * init_num_blocks);
+            }
+
+            details::dispatch_with_iterator_args(cmdlist,
+                                                 *ms_scan_ptr,
+                                                 m_block_size * num_tiles,
+                                                 d_in.host_args(),
+                                                 tile_states,
+                                                 tile_partial,
+                                                 tile_inclusive,
+                                                 d_out,
+                                                 initial_value,
+                                                 uint(num_items),
+                                                 epoch);
         }
-        if(ms_scan_it == (is_inclusive ? ms_inclusive_scan_map : ms_exclusive_scan_map).end()) { return -1; }
-        auto ms_scan_ptr = reinterpret_cast<ScanShaderKernel*>(&(*ms_scan_it->second));
-        if(!ms_scan_ptr) { return -1; }
-        cmdlist << (*ms_scan_ptr)(tile_states, tile_partial, tile_inclusive, d_in, d_out, initial_value, num_items)
-                       .dispatch(m_block_size * num_tiles);
         return 0;
     };
 
+    // tile totals, exclusive scanned in place on top of initial_value by the same scheme one
+    // level up, then every tile scans itself on top of its scanned total. No tile waits on another,
+    // so it holds on backends that run the tiles of a dispatch in any order or one after another
+    template <NumericT Type4Byte, typename ScanOp, IteratorT InputIt, NumericT OutputT>
+    [[nodiscard]] int reduce_then_scan_array(CommandList&          cmdlist,
+                                             BufferView<Type4Byte> d_partials,
+                                             InputIt               d_in,
+                                             BufferView<OutputT>   d_out,
+                                             size_t                num_items,
+                                             ScanOp                scan_op,
+                                             Type4Byte             initial_value,
+                                             bool                  is_inclusive)
+    {
+        auto ms_downsweep_ptr = is_inclusive ?
+                                    reduce_then_scan_downsweep_shader<true, Type4Byte, OutputT>(scan_op, d_in) :
+                                    reduce_then_scan_downsweep_shader<false, Type4Byte, OutputT>(scan_op, d_in);
+        if(!ms_downsweep_ptr) { return -1; }
+
+        const size_t tile_items = ITEMS_PER_THREAD * m_block_size;
+        if(num_items <= tile_items)
+        {
+            // one tile starts from the initial value, d_tile_prefix is never read
+            details::dispatch_with_iterator_args(
+                cmdlist, *ms_downsweep_ptr, m_block_size, d_in.host_args(), d_out, d_partials, initial_value, uint(num_items), 0u);
+            return 0;
+        }
+
+        auto ms_upsweep_ptr = reduce_then_scan_upsweep_shader<Type4Byte, OutputT>(scan_op, d_in);
+        if(!ms_upsweep_ptr) { return -1; }
+
+        uint num_tiles = ceil_div(num_items, tile_items);
+        if(num_tiles > d_partials.size()) { return -1; }
+        auto d_totals = d_partials.subview(0, num_tiles);
+        details::dispatch_with_iterator_args(
+            cmdlist, *ms_upsweep_ptr, m_block_size * num_tiles, d_in.host_args(), d_totals, uint(num_items));
+        // the level above has no partials of its own once its totals fit in one tile
+        auto d_upper_partials =
+            num_tiles < d_partials.size() ? d_partials.subview(num_tiles, d_partials.size() - num_tiles) : d_totals;
+        int result = reduce_then_scan_array<Type4Byte>(
+            cmdlist, d_upper_partials, BufferIterator<Type4Byte>(d_totals), d_totals, num_tiles, scan_op, initial_value, false);
+        if(result != 0) { return result; }
+        details::dispatch_with_iterator_args(
+            cmdlist, *ms_downsweep_ptr, m_block_size * num_tiles, d_in.host_args(), d_out, d_totals, initial_value, uint(num_items), 1u);
+        return 0;
+    }
+
+
+    // chunk totals, scanned in place by the same scheme one level up, then every chunk scans
+    // itself on top of the total before it
+    template <NumericTOrKeyValuePairT Type4Byte, typename ScanOp>
+    [[nodiscard]] int deterministic_scan_array(CommandList&          cmdlist,
+                                               BufferView<Type4Byte> d_partials,
+                                               BufferView<Type4Byte> d_in,
+                                               BufferView<Type4Byte> d_out,
+                                               uint                  num_items,
+                                               ScanOp                scan_op,
+                                               Type4Byte             initial_value)
+    {
+        using Deterministic      = details::DeterministicModule<Type4Byte, BLOCK_SIZE>;
+        using ReduceChunksKernel = Deterministic::ReduceChunksKernel;
+        using ScanChunksKernel   = Deterministic::ScanChunksKernel;
+
+        auto ms_deterministic_reduce_ptr = m_shader_cache.get_or_compile<ReduceChunksKernel, Deterministic, ScanOp>(
+            [&] { return Deterministic().compile_reduce_chunks(m_device, scan_op); });
+        if(!ms_deterministic_reduce_ptr) { return -1; }
+
+        auto ms_deterministic_scan_ptr = m_shader_cache.get_or_compile<ScanChunksKernel, Deterministic, ScanOp>(
+            [&] { return Deterministic().compile_scan_chunks(m_device, scan_op); });
+        if(!ms_deterministic_scan_ptr) { return -1; }
+
+        if(num_items <= details::DETERMINISTIC_CHUNK_ITEMS)
+        {
+            // one chunk starts from the initial value, d_prefix is never read
+            cmdlist << (*ms_deterministic_scan_ptr)(d_in, d_out, d_out, num_items, initial_value).dispatch(m_block_size);
+            return 0;
+        }
+
+        uint num_chunks = ceil_div(num_items, details::DETERMINISTIC_CHUNK_ITEMS);
+        if(num_chunks > d_partials.size()) { return -1; }
+        auto d_totals = d_partials.subview(0, num_chunks);
+        cmdlist << (*ms_deterministic_reduce_ptr)(d_in, d_totals, num_items, initial_value, 0u).dispatch(num_chunks * m_block_size);
+        // the level above has no partials of its own once its totals fit in one chunk
+        auto d_upper_partials =
+            num_chunks < d_partials.size() ? d_partials.subview(num_chunks, d_partials.size() - num_chunks) : d_totals;
+        int result = deterministic_scan_array<Type4Byte>(cmdlist,
+                                                         d_upper_partials,
+                                                         d_totals,
+                                                         d_totals,
+                                                         num_chunks,
+                                                         scan_op,
+                                                         initial_value);
+        if(result != 0) { return result; }
+        cmdlist << (*ms_deterministic_scan_ptr)(d_in, d_out, d_totals, num_items, initial_value).dispatch(num_chunks * m_block_size);
+        return 0;
+    }
+
+    // the items are widened on load and rounded on store, the chunk totals stay CompensatedSumT
+    // and go through deterministic_scan_array like any other type
+    template <NumericT Type4Byte>
+    [[nodiscard]] int compensated_scan_array(CommandList&                           cmdlist,
+                                             BufferView<CompensatedSumT<Type4Byte>> d_partials,
+                                             BufferView<Type4Byte>                  d_in,
+                                             BufferView<Type4Byte>                  d_out,
+                                             uint                                   num_items)
+    {
+        using AccumT             = CompensatedSumT<Type4Byte>;
+        using Compensated        = details::DeterministicModule<AccumT, BLOCK_SIZE, Type4Byte, Type4Byte>;
+        using ReduceChunksKernel = Compensated::ReduceChunksKernel;
+        using ScanChunksKernel   = Compensated::ScanChunksKernel;
+
+        const AccumT init{Type4Byte(0), Type4Byte(0)};
+
+        auto ms_compensated_reduce_ptr =
+            m_shader_cache.get_or_compile<ReduceChunksKernel, Compensated, CompensatedSumOp, ToCompensatedSumOp>(
+                [&] { return Compensated().compile_reduce_chunks(m_device, CompensatedSumOp(), ToCompensatedSumOp()); });
+        if(!ms_compensated_reduce_ptr) { return -1; }
+
+        auto ms_compensated_scan_ptr =
+            m_shader_cache.get_or_compile<ScanChunksKernel, Compensated, CompensatedSumOp, ToCompensatedSumOp, FromCompensatedSumOp>(
+                [&] {
+                    return Compensated().compile_scan_chunks(
+                        m_device, CompensatedSumOp(), ToCompensatedSumOp(), FromCompensatedSumOp());
+                });
+        if(!ms_compensated_scan_ptr) { return -1; }
+
+        if(num_items <= details::DETERMINISTIC_CHUNK_ITEMS)
+        {
+            // one chunk starts from zero, d_prefix is never read
+            cmdlist << (*ms_compensated_scan_ptr)(d_in, d_out, d_partials, num_items, init).dispatch(m_block_size);
+            return 0;
+        }
+
+        uint num_chunks = ceil_div(num_items, details::DETERMINISTIC_CHUNK_ITEMS);
+        if(num_chunks > d_partials.size()) { return -1; }
+        auto d_totals = d_partials.subview(0, num_chunks);
+        cmdlist << (*ms_compensated_reduce_ptr)(d_in, d_totals, num_items, init, 0u).dispatch(num_chunks * m_block_size);
+        auto d_upper_partials =
+            num_chunks < d_partials.size() ? d_partials.subview(num_chunks, d_partials.size() - num_chunks) : d_totals;
+        int result = deterministic_scan_array<AccumT>(
+            cmdlist, d_upper_partials, d_totals, d_totals, num_chunks, CompensatedSumOp(), init);
+        if(result != 0) { return result; }
+        cmdlist << (*ms_compensated_scan_ptr)(d_in, d_out, d_totals, num_items, init).dispatch(num_chunks * m_block_size);
+        return 0;
+    }
+
 
     template <NumericT KeyValue, NumericT ValueType, typename ScanOp, typename FlagValueT = KeyValuePair<int, ValueType>>
     [[nodiscard]] int scan_by_key_array(CommandList&           cmdlist,
@@ -417,7 +847,6 @@ class DeviceScan : public LuisaModule
                            BufferView<FlagValueT> tile_partial,
                            BufferView<FlagValueT> tile_inclusive,
                            BufferView<KeyValue>   d_keys_in,
-                           BufferView<KeyValue>   d_prev_keys_in,
                            BufferView<ValueType>  d_values_in,
                            BufferView<ValueType>  d_values_out,
                            size_t                 num_items,
@@ -427,66 +856,90 @@ class DeviceScan : public LuisaModule
     {
         uint num_tiles = imax(1, ceil_div(num_items, (ITEMS_PER_THREAD * m_block_size)));
 
-        using ScanByKeyShader = details::ScanByKeyModule<KeyValue, ValueType, BLOCK_SIZE, ITEMS_PER_THREAD>;
+        using ScanByKeyShader = details::ScanByKeyModule<KeyValue, ValueType, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
         using ScanByKeyTileStateInitKernel = ScanByKeyShader::ScanTileStateInitKernel;
         using ScanByKeyShaderKernel        = ScanByKeyShader::ScanByKeyKernel;
 
-        size_t init_num_blocks                 = ceil_div(num_tiles, m_block_size);
-        auto   init_key                        = get_type_and_op_desc<KeyValue, ValueType>();
-        auto ms_scan_by_key_tile_state_init_it = ms_scan_by_key_tile_state_init_map.find(init_key);
-        if(ms_scan_by_key_tile_state_init_it == ms_scan_by_key_tile_state_init_map.end())
+        if(use_reduce_then_scan())
         {
-            auto shader = ScanByKeyShader().compile_scan_tile_state_init(m_device);
-            if (!shader) { return -1; }
-            ms_scan_by_key_tile_state_init_map.try_emplace(init_key, std::move(shader));
-            ms_scan_by_key_tile_state_init_it = ms_scan_by_key_tile_state_init_map.find(init_key);
+            // the tile totals take the place of the partial tile states
+            return reduce_then_scan_by_key_array<KeyValue, ValueType>(
+                cmdlist, tile_partial.subview(0, num_tiles), d_keys_in, d_values_in, d_values_out, num_items, scan_op, initial_value, is_inclusive);
         }
-        if(ms_scan_by_key_tile_state_init_it == ms_scan_by_key_tile_state_init_map.end()) { return -1; }
-        auto ms_scan_by_key_tile_state_init_ptr =
-            reinterpret_cast<ScanByKeyTileStateInitKernel*>(&(*ms_scan_by_key_tile_state_init_it->second));
-        if(!ms_scan_by_key_tile_state_init_ptr) { return -1; }
-        cmdlist << (*ms_scan_by_key_tile_state_init_ptr)(
-                       tile_states, tile_partial, tile_inclusive, d_keys_in, d_prev_keys_in, uint(num_tiles))
-                       .dispatch(m_block_size * init_num_blocks);
 
-        // scan
-        auto key           = get_type_and_op_desc<KeyValue, ValueType>(scan_op);
-        auto ms_scan_by_it = is_inclusive ? ms_inclusive_scan_by_key_map.find(key) :
-                                            ms_exclusive_scan_by_key_map.find(key);
-        if(ms_scan_by_it
-           == (is_inclusive ? ms_inclusive_scan_by_key_map : ms_exclusive_scan_by_key_map).end())
+        uint epoch = 0;
+        if(m_persistent_tile_status)
         {
-            LUISA_INFO("Compiling Scan By Key shader for key: {}", key);
-            if(is_inclusive)
-            {
-                auto shader = ScanByKeyShader().template compile<true>(m_device, m_shared_mem_size, scan_op);
-                if (!shader) { return -1; }
-                ms_inclusive_scan_by_key_map.try_emplace(key, std::move(shader));
-                ms_scan_by_it = ms_inclusive_scan_by_key_map.find(key);
-            }
-            else
-            {
-                auto shader = ScanByKeyShader().template compile<false>(m_device, m_shared_mem_size, scan_op);
-                if (!shader) { return -1; }
-                ms_exclusive_scan_by_key_map.try_emplace(key, std::move(shader));
-                ms_scan_by_it = ms_exclusive_scan_by_key_map.find(key);
-            }
+            if(!acquire_tile_status(cmdlist, num_tiles, tile_states, epoch)) { return -1; }
+        }
+        else
+        {
+            size_t init_num_blocks                 = ceil_div(num_tiles, m_block_size);
+            auto   ms_scan_by_key_tile_state_init_ptr =
+                m_shader_cache.get_or_compile<ScanByKeyTileStateInitKernel, ScanByKeyShader>(
+                    [&] { return ScanByKeyShader().compile_scan_tile_state_init(m_device); });
+            if(!ms_scan_by_key_tile_state_init_ptr) { return -1; }
+            cmdlist << (*ms_scan_by_key_tile_state_init_ptr)(tile_states, uint(num_tiles)).dispatch(m_block_size * init_num_blocks);
         }
-        if(ms_scan_by_it == (is_inclusive ? ms_inclusive_scan_by_key_map : ms_exclusive_scan_by_key_map).end()) { return -1; }
-        auto ms_scan_by_key_ptr = reinterpret_cast<ScanByKeyShaderKernel*>(&(*ms_scan_by_it->second));
+
+        // scan
+        auto ms_scan_by_key_ptr =
+            is_inclusive ?
+                m_shader_cache.get_or_compile<ScanByKeyShaderKernel, ScanByKeyShader, ScanOp, std::true_type>(
+                    [&] { return ScanByKeyShader().template compile<true>(m_device, m_shared_mem_size, scan_op); }) :
+                m_shader_cache.get_or_compile<ScanByKeyShaderKernel, ScanByKeyShader, ScanOp, std::false_type>(
+                    [&] { return ScanByKeyShader().template compile<false>(m_device, m_shared_mem_size, scan_op); });
         if(!ms_scan_by_key_ptr) { return -1; }
         cmdlist << (*ms_scan_by_key_ptr)(
-                       tile_states, tile_partial, tile_inclusive, d_keys_in, d_prev_keys_in, d_values_in, d_values_out, initial_value, num_items)
+                       tile_states, tile_partial, tile_inclusive, d_keys_in, d_values_in, d_values_out, initial_value, num_items, epoch)
                        .dispatch(m_block_size * num_tiles);
         return 0;
     }
 
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_scan_key;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_exclusive_scan_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_inclusive_scan_map;
+    // segment aggregates of the tiles, their scan by one block, then every tile on top of the
+    // aggregate before it; like reduce_then_scan_array no tile waits on another
+    template <NumericT KeyValue, NumericT ValueType, typename ScanOp, typename FlagValueT = KeyValuePair<int, ValueType>>
+    [[nodiscard]] int reduce_then_scan_by_key_array(CommandList&           cmdlist,
+                                                    BufferView<FlagValueT> d_tile_totals,
+                                                    BufferView<KeyValue>   d_keys_in,
+                                                    BufferView<ValueType>  d_values_in,
+                                                    BufferView<ValueType>  d_values_out,
+                                                    size_t                 num_items,
+                                                    ScanOp                 scan_op,
+                                                    ValueType              initial_value,
+                                                    bool                   is_inclusive)
+    {
+        using ScanByKeyShader = details::ScanByKeyModule<KeyValue, ValueType, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
+        using UpsweepKernel   = ScanByKeyShader::UpsweepKernel;
+        using SpineKernel     = ScanByKeyShader::SpineKernel;
+        using DownsweepKernel = ScanByKeyShader::DownsweepKernel;
+
+        auto ms_downsweep_ptr =
+            is_inclusive ?
+                m_shader_cache.get_or_compile<DownsweepKernel, ScanByKeyShader, ScanOp, std::true_type>(
+                    [&] { return ScanByKeyShader().template compile_downsweep<true>(m_device, m_shared_mem_size, scan_op); }) :
+                m_shader_cache.get_or_compile<DownsweepKernel, ScanByKeyShader, ScanOp, std::false_type>(
+                    [&] { return ScanByKeyShader().template compile_downsweep<false>(m_device, m_shared_mem_size, scan_op); });
+        if(!ms_downsweep_ptr) { return -1; }
+
+        uint num_tiles = d_tile_totals.size();
+        if(num_tiles > 1)
+        {
+            auto ms_upsweep_ptr = m_shader_cache.get_or_compile<UpsweepKernel, ScanByKeyShader, ScanOp>(
+                [&] { return ScanByKeyShader().compile_upsweep(m_device, m_shared_mem_size, scan_op); });
+            auto ms_spine_ptr = m_shader_cache.get_or_compile<SpineKernel, ScanByKeyShader, ScanOp>(
+                [&] { return ScanByKeyShader().compile_spine(m_device, scan_op); });
+            if(!ms_upsweep_ptr || !ms_spine_ptr) { return -1; }
+
+            cmdlist << (*ms_upsweep_ptr)(d_keys_in, d_values_in, d_tile_totals, uint(num_items)).dispatch(m_block_size * num_tiles);
+            cmdlist << (*ms_spine_ptr)(d_tile_totals, num_tiles).dispatch(m_block_size);
+        }
+        // a single tile never reads d_tile_totals
+        cmdlist << (*ms_downsweep_ptr)(d_tile_totals, d_keys_in, d_values_in, d_values_out, initial_value, uint(num_items))
+                       .dispatch(m_block_size * num_tiles);
+        return 0;
+    }
 
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_scan_by_key_tile_state_init_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_exclusive_scan_by_key_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_inclusive_scan_by_key_map;
+    ShaderCache m_shader_cache{make_kernel_name("DeviceScan", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
 };
 }  // namespace luisa::parallel_primitive
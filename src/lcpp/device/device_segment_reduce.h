@@ -2,7 +2,7 @@
  * @Author: Ligo 
  * @Date: 2025-11-07 14:17:58 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-10 21:27:54
+ * @Last Modified time: 2026-02-26 17:20:46
  */
 #pragma once
 
@@ -17,8 +17,15 @@
 #include <lcpp/common/util_type.h>
 #include <lcpp/common/thread_operators.h>
 #include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/runtime/warmup.h>
 #include <lcpp/device/details/segment_reduce.h>
 #include <lcpp/common/utils.h>
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
+#include <lcpp/iterator/counting_iterator.h>
+#include <lcpp/iterator/zip_iterator.h>
 
 namespace luisa::parallel_primitive
 {
@@ -52,6 +59,7 @@ class DeviceSegmentReduce : public LuisaModule
     void create(Device& device, Stream* debug_stream = nullptr)
     {
         m_device                   = device;
+        m_shader_cache.bind(device);
 #ifndef NDEBUG
         m_debug_stream = debug_stream;
 #endif
@@ -75,14 +83,12 @@ class DeviceSegmentReduce : public LuisaModule
     }
 
     /// Temp storage bytes for ArgMin / ArgMax
-    /// Needs: d_in_kv(num_item) + d_out_kv(num_segments)
+    /// Needs: d_out_kv(num_segments), the input pairs are zipped on the fly
     template <typename Type4Byte>
-    static size_t GetArgTempStorageBytes(size_t num_item, size_t num_segments)
+    static size_t GetArgTempStorageBytes(size_t /*num_item*/, size_t num_segments)
     {
         using IVP = IndexValuePairT<Type4Byte>;
         size_t bytes = 0;
-        bytes += num_item * sizeof(IVP);            // d_in_kv
-        bytes  = align_up_uint(bytes, alignof(IVP));
         bytes += num_segments * sizeof(IVP);        // d_out_kv
         return bytes;
     }
@@ -93,7 +99,7 @@ class DeviceSegmentReduce : public LuisaModule
 
     template <typename Type4Byte, typename ReduceOp>
     void Reduce(CommandList&          cmdlist,
-                BufferView<uint>      /*temp_storage*/,
+                BufferView<uint>      temp_storage,
                 BufferView<Type4Byte> d_in,
                 BufferView<Type4Byte> d_out,
                 uint                  num_segments,
@@ -102,22 +108,50 @@ class DeviceSegmentReduce : public LuisaModule
                 ReduceOp              reduce_op,
                 Type4Byte             initial_value)
     {
-        lcpp_check(segment_reduce_array_recursive<Type4Byte>(
+        Reduce(cmdlist, temp_storage, BufferIterator<Type4Byte>(d_in), d_out, num_segments, d_begin_offsets, d_end_offsets, reduce_op, initial_value);
+    }
+
+    /// d_in may be any iterator, the offsets index into it
+    template <IteratorT InputIt, typename ReduceOp>
+    void Reduce(CommandList&                            cmdlist,
+                BufferView<uint>                        /*temp_storage*/,
+                InputIt                                 d_in,
+                BufferView<typename InputIt::value_type> d_out,
+                uint                                    num_segments,
+                BufferView<uint>                        d_begin_offsets,
+                BufferView<uint>                        d_end_offsets,
+                ReduceOp                                reduce_op,
+                typename InputIt::value_type            initial_value)
+    {
+        lcpp_check(segment_reduce_array_recursive<typename InputIt::value_type>(
             cmdlist, d_in, d_out, num_segments, d_begin_offsets, d_end_offsets, reduce_op, initial_value), cmdlist, debug_stream());
     }
 
     template <typename Type4Byte, typename ReduceOp>
     void Reduce(CommandList&          cmdlist,
-                BufferView<uint>      /*temp_storage*/,
+                BufferView<uint>      temp_storage,
                 BufferView<Type4Byte> d_in,
                 BufferView<Type4Byte> d_out,
                 uint                  num_segments,
                 uint                  segment_size,
                 ReduceOp              reduce_op,
                 Type4Byte             initial_value)
+    {
+        Reduce(cmdlist, temp_storage, BufferIterator<Type4Byte>(d_in), d_out, num_segments, segment_size, reduce_op, initial_value);
+    }
+
+    template <IteratorT InputIt, typename ReduceOp>
+    void Reduce(CommandList&                             cmdlist,
+                BufferView<uint>                         /*temp_storage*/,
+                InputIt                                  d_in,
+                BufferView<typename InputIt::value_type> d_out,
+                uint                                     num_segments,
+                uint                                     segment_size,
+                ReduceOp                                 reduce_op,
+                typename InputIt::value_type             initial_value)
     {
         lcpp_check(
-            fixed_segment_reduce_array_recursive<Type4Byte>(
+            fixed_segment_reduce_array_recursive<typename InputIt::value_type>(
             cmdlist, d_in, d_out, num_segments, segment_size, reduce_op, initial_value)   ,
         cmdlist, debug_stream());
     }
@@ -140,6 +174,26 @@ class DeviceSegmentReduce : public LuisaModule
         Reduce(cmdlist, temp_storage, d_in, d_out, num_segments, segment_size, SumOp(), Type4Byte(0));
     }
 
+    template <IteratorT InputIt>
+    void Sum(CommandList&                             cmdlist,
+             BufferView<uint>                         temp_storage,
+             InputIt                                  d_in,
+             BufferView<typename InputIt::value_type> d_out,
+             uint                                     num_segments,
+             BufferView<uint>                         d_begin_offsets,
+             BufferView<uint>                         d_end_offsets)
+    {
+        using Type4Byte = typename InputIt::value_type;
+        Reduce(cmdlist, temp_storage, d_in, d_out, num_segments, d_begin_offsets, d_end_offsets, SumOp(), Type4Byte(0));
+    }
+
+    template <IteratorT InputIt>
+    void Sum(CommandList& cmdlist, BufferView<uint> temp_storage, InputIt d_in, BufferView<typename InputIt::value_type> d_out, uint num_segments, uint segment_size)
+    {
+        using Type4Byte = typename InputIt::value_type;
+        Reduce(cmdlist, temp_storage, d_in, d_out, num_segments, segment_size, SumOp(), Type4Byte(0));
+    }
+
 
     template <NumericT Type4Byte>
     void Min(CommandList&          cmdlist,
@@ -207,16 +261,12 @@ class DeviceSegmentReduce : public LuisaModule
         using IVP = IndexValuePairT<ValueType>;
 
         // slice kv buffers from temp_storage
-        size_t offset_uint = 0;
-        size_t in_kv_uint_count  = bytes_to_uint_count(d_in.size() * sizeof(IVP));
-        auto   d_in_kv           = temp_storage.subview(offset_uint, in_kv_uint_count).template as<IVP>();
-        offset_uint += in_kv_uint_count;
         size_t out_kv_uint_count = bytes_to_uint_count(num_segments * sizeof(IVP));
-        auto   d_out_kv          = temp_storage.subview(offset_uint, out_kv_uint_count).template as<IVP>();
+        auto   d_out_kv          = temp_storage.subview(0, out_kv_uint_count).template as<IVP>();
+        // key value pairs are built while loading
+        ZipIterator d_in_kv{CountingIterator<uint>(0u), BufferIterator<ValueType>(d_in)};
 
-        // construct key value pair
-        lcpp_check(arg_construct(cmdlist, d_in, d_in_kv, num_segments), cmdlist, debug_stream());
-        Reduce<IVP>(
+        Reduce(
             cmdlist,
             BufferView<uint>{},
             d_in_kv,
@@ -245,17 +295,12 @@ class DeviceSegmentReduce : public LuisaModule
         using IVP = IndexValuePairT<ValueType>;
 
         // slice kv buffers from temp_storage
-        size_t offset_uint = 0;
-        size_t in_kv_uint_count  = bytes_to_uint_count(d_in.size() * sizeof(IVP));
-        auto   d_in_kv           = temp_storage.subview(offset_uint, in_kv_uint_count).template as<IVP>();
-        offset_uint += in_kv_uint_count;
         size_t out_kv_uint_count = bytes_to_uint_count(num_segments * sizeof(IVP));
-        auto   d_out_kv          = temp_storage.subview(offset_uint, out_kv_uint_count).template as<IVP>();
-
-        // construct key value pair
-        lcpp_check(arg_construct(cmdlist, d_in, d_in_kv, num_segments), cmdlist, debug_stream());
+        auto   d_out_kv          = temp_storage.subview(0, out_kv_uint_count).template as<IVP>();
+        // key value pairs are built while loading
+        ZipIterator d_in_kv{CountingIterator<uint>(0u), BufferIterator<ValueType>(d_in)};
 
-        Reduce<IVP>(
+        Reduce(
             cmdlist,
             BufferView<uint>{},
             d_in_kv,
@@ -284,17 +329,12 @@ class DeviceSegmentReduce : public LuisaModule
         using IVP = IndexValuePairT<ValueType>;
 
         // slice kv buffers from temp_storage
-        size_t offset_uint = 0;
-        size_t in_kv_uint_count  = bytes_to_uint_count(d_in.size() * sizeof(IVP));
-        auto   d_in_kv           = temp_storage.subview(offset_uint, in_kv_uint_count).template as<IVP>();
-        offset_uint += in_kv_uint_count;
         size_t out_kv_uint_count = bytes_to_uint_count(num_segments * sizeof(IVP));
-        auto   d_out_kv          = temp_storage.subview(offset_uint, out_kv_uint_count).template as<IVP>();
+        auto   d_out_kv          = temp_storage.subview(0, out_kv_uint_count).template as<IVP>();
+        // key value pairs are built while loading
+        ZipIterator d_in_kv{CountingIterator<uint>(0u), BufferIterator<ValueType>(d_in)};
 
-        // construct key value pair
-        lcpp_check(arg_construct(cmdlist, d_in, d_in_kv, num_segments), cmdlist, debug_stream());
-
-        Reduce<IVP>(
+        Reduce(
             cmdlist,
             BufferView<uint>{},
             d_in_kv,
@@ -323,17 +363,12 @@ class DeviceSegmentReduce : public LuisaModule
         using IVP = IndexValuePairT<ValueType>;
 
         // slice kv buffers from temp_storage
-        size_t offset_uint = 0;
-        size_t in_kv_uint_count  = bytes_to_uint_count(d_in.size() * sizeof(IVP));
-        auto   d_in_kv           = temp_storage.subview(offset_uint, in_kv_uint_count).template as<IVP>();
-        offset_uint += in_kv_uint_count;
         size_t out_kv_uint_count = bytes_to_uint_count(num_segments * sizeof(IVP));
-        auto   d_out_kv          = temp_storage.subview(offset_uint, out_kv_uint_count).template as<IVP>();
-
-        // construct key value pair
-        lcpp_check(arg_construct(cmdlist, d_in, d_in_kv, num_segments), cmdlist, debug_stream());
+        auto   d_out_kv          = temp_storage.subview(0, out_kv_uint_count).template as<IVP>();
+        // key value pairs are built while loading
+        ZipIterator d_in_kv{CountingIterator<uint>(0u), BufferIterator<ValueType>(d_in)};
 
-        Reduce<IVP>(
+        Reduce(
             cmdlist,
                 BufferView<uint>{},
                 d_in_kv,
@@ -349,10 +384,121 @@ class DeviceSegmentReduce : public LuisaModule
     }
 
 
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT ValueType>
+    void ArgMax(CommandList&          cmdlist,
+                CachingAllocator&     allocator,
+                const Stream&         stream,
+                BufferView<ValueType> d_in,
+                BufferView<ValueType> d_out,
+                BufferView<uint>      d_index_out,
+                uint                  num_segments,
+                BufferView<uint>      d_begin_offsets,
+                BufferView<uint>      d_end_offsets)
+    {
+        auto temp = allocator.allocate(stream, GetArgTempStorageBytes<ValueType>(d_in.size(), num_segments));
+        ArgMax(cmdlist, temp.view(), d_in, d_out, d_index_out, num_segments, d_begin_offsets, d_end_offsets);
+    }
+
+    template <NumericT ValueType>
+    void ArgMax(CommandList&          cmdlist,
+                CachingAllocator&     allocator,
+                const Stream&         stream,
+                BufferView<ValueType> d_in,
+                BufferView<ValueType> d_out,
+                BufferView<uint>      d_index_out,
+                uint                  num_segments,
+                uint                  segment_size)
+    {
+        auto temp = allocator.allocate(stream, GetArgTempStorageBytes<ValueType>(d_in.size(), num_segments));
+        ArgMax(cmdlist, temp.view(), d_in, d_out, d_index_out, num_segments, segment_size);
+    }
+
+    template <NumericT ValueType>
+    void ArgMin(CommandList&          cmdlist,
+                CachingAllocator&     allocator,
+                const Stream&         stream,
+                BufferView<ValueType> d_in,
+                BufferView<ValueType> d_out,
+                BufferView<uint>      d_index_out,
+                uint                  num_segments,
+                BufferView<uint>      d_begin_offsets,
+                BufferView<uint>      d_end_offsets)
+    {
+        auto temp = allocator.allocate(stream, GetArgTempStorageBytes<ValueType>(d_in.size(), num_segments));
+        Argmin(cmdlist, temp.view(), d_in, d_out, d_index_out, num_segments, d_begin_offsets, d_end_offsets);
+    }
+
+    template <NumericT ValueType>
+    void ArgMin(CommandList&          cmdlist,
+                CachingAllocator&     allocator,
+                const Stream&         stream,
+                BufferView<ValueType> d_in,
+                BufferView<ValueType> d_out,
+                BufferView<uint>      d_index_out,
+                uint                  num_segments,
+                uint                  segment_size)
+    {
+        auto temp = allocator.allocate(stream, GetArgTempStorageBytes<ValueType>(d_in.size(), num_segments));
+        ArgMin(cmdlist, temp.view(), d_in, d_out, d_index_out, num_segments, segment_size);
+    }
+
+
+    // ============================================================
+    // Warmup: compile ahead of the first call
+    // ============================================================
+
+    /// Compiles the kernels of Reduce on Types items for offset and fixed size segments, for every
+    /// op as Reduce is given it, on host threads; without ops it is Sum, e.g. Warmup<float, uint>().
+    /// Calls made before the future is ready compile what they miss themselves. The module has to
+    /// outlive the future
+    template <NumericT... Types, typename... ReduceOps>
+    [[nodiscard]] WarmupFuture Warmup(ReduceOps... reduce_ops)
+    {
+        luisa::vector<WarmupJob> jobs;
+        auto add_op = [&](auto reduce_op) { (add_segment_reduce_warmup<Types>(jobs, reduce_op), ...); };
+        if constexpr(sizeof...(ReduceOps) == 0) { add_op(SumOp()); }
+        else { (add_op(reduce_ops), ...); }
+        return details::compile_in_background(std::move(jobs));
+    }
+
   private:
+    template <typename Type, typename ReduceOp, IteratorT InputIt>
+    [[nodiscard]] auto segment_reduce_shader(ReduceOp reduce_op, const InputIt& arr_in)
+    {
+        using SegmentReduce       = details::SegmentReduceModule<Type, BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD, InputIt>;
+        using SegmentReduceKernel = SegmentReduce::SegmentReduceKernel;
+
+        return m_shader_cache.get_or_compile<SegmentReduceKernel, SegmentReduce, ReduceOp>(
+            [&] { return SegmentReduce().compile(m_device, m_shared_mem_size, reduce_op, arr_in); });
+    }
+
+    template <typename Type, typename ReduceOp, IteratorT InputIt>
+    [[nodiscard]] auto fixed_size_segment_reduce_shader(ReduceOp reduce_op, const InputIt& arr_in)
+    {
+        using SegmentReduce = details::SegmentReduceModule<Type, BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD, InputIt>;
+        using FixedSizeSegmentReduceKernel = SegmentReduce::FixedSizeSegmentReduceKernel;
+
+        return m_shader_cache.get_or_compile<FixedSizeSegmentReduceKernel, SegmentReduce, ReduceOp>(
+            [&] { return SegmentReduce().compile_fixed_size(m_device, m_shared_mem_size, reduce_op, arr_in); });
+    }
+
+    // the offset and the fixed size segment kernels on Type items
     template <typename Type, typename ReduceOp>
+    void add_segment_reduce_warmup(luisa::vector<WarmupJob>& jobs, ReduceOp reduce_op)
+    {
+        const BufferIterator<Type> items{BufferView<Type>{}};
+        jobs.emplace_back([this, reduce_op, items] { return segment_reduce_shader<Type>(reduce_op, items) != nullptr; });
+        jobs.emplace_back([this, reduce_op, items] { return fixed_size_segment_reduce_shader<Type>(reduce_op, items) != nullptr; });
+    }
+
+    template <typename Type, IteratorT InputIt, typename ReduceOp>
     [[nodiscard]] int segment_reduce_array_recursive(luisa::compute::CommandList& cmdlist,
-                                        BufferView<Type>             arr_in,
+                                        InputIt                      arr_in,
                                         BufferView<Type>             arr_out,
                                         size_t                       num_segments,
                                         BufferView<uint>             d_begin_offsets,
@@ -360,29 +506,23 @@ class DeviceSegmentReduce : public LuisaModule
                                         ReduceOp                     reduce_op,
                                         Type                         initial_value)
     {
-        using SegmentReduce = details::SegmentReduceModule<Type, BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
-        using SegmentReduceKernel = SegmentReduce::SegmentReduceKernel;
-
-        auto key                  = get_type_and_op_desc<Type>(reduce_op);
-        auto ms_segment_reduce_it = ms_segment_reduce_map.find(key);
-        if(ms_segment_reduce_it == ms_segment_reduce_map.end())
-        {
-            auto shader = SegmentReduce().compile(m_device, m_shared_mem_size, reduce_op);
-            if (!shader) { return -1; }
-            ms_segment_reduce_map.try_emplace(key, std::move(shader));
-            ms_segment_reduce_it = ms_segment_reduce_map.find(key);
-        }
-        if(ms_segment_reduce_it == ms_segment_reduce_map.end()) { return -1; }
-        auto ms_segment_reduce_ptr = reinterpret_cast<SegmentReduceKernel*>(&(*ms_segment_reduce_it->second));
+        auto ms_segment_reduce_ptr = segment_reduce_shader<Type>(reduce_op, arr_in);
         if(!ms_segment_reduce_ptr) { return -1; }
-        cmdlist << (*ms_segment_reduce_ptr)(arr_in, arr_out, d_begin_offsets, d_end_offsets, num_segments, initial_value)
-                       .dispatch(num_segments * m_block_size);
+        details::dispatch_with_iterator_args(cmdlist,
+                                             *ms_segment_reduce_ptr,
+                                             num_segments * m_block_size,
+                                             arr_in.host_args(),
+                                             arr_out,
+                                             d_begin_offsets,
+                                             d_end_offsets,
+                                             uint(num_segments),
+                                             initial_value);
         return 0;
     }
 
-    template <typename Type4Byte, typename ReduceOp>
+    template <typename Type4Byte, IteratorT InputIt, typename ReduceOp>
     [[nodiscard]] int fixed_segment_reduce_array_recursive(luisa::compute::CommandList& cmdlist,
-                                              BufferView<Type4Byte>        arr_in,
+                                              InputIt                      arr_in,
                                               BufferView<Type4Byte>        arr_out,
                                               uint                         num_segments,
                                               uint                         segment_size,
@@ -390,8 +530,7 @@ class DeviceSegmentReduce : public LuisaModule
                                               Type4Byte                    initial_value)
     {
 
-        using SegmentReduce = details::SegmentReduceModule<Type4Byte, BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
-        using FixedSizeSegmentReduceKernel = SegmentReduce::FixedSizeSegmentReduceKernel;
+        using SegmentReduce = details::SegmentReduceModule<Type4Byte, BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD, InputIt>;
 
         uint segment_per_block = 1;
         if(segment_size <= SegmentReduce::small_items_per_tile)
@@ -402,18 +541,7 @@ class DeviceSegmentReduce : public LuisaModule
         const auto num_segments_per_invocation = static_cast<uint>(std::numeric_limits<int32_t>::max());
         const auto num_invocations = ceil_div(num_segments, num_segments_per_invocation);
 
-        auto key                             = get_type_and_op_desc<Type4Byte>(reduce_op);
-        auto ms_fixed_size_segment_reduce_it = ms_fixed_segment_reduce_map.find(key);
-        if(ms_fixed_size_segment_reduce_it == ms_fixed_segment_reduce_map.end())
-        {
-            auto shader = SegmentReduce().compile_fixed_size(m_device, m_shared_mem_size, reduce_op);
-            if (!shader) { return -1; }
-            ms_fixed_segment_reduce_map.try_emplace(key, std::move(shader));
-            ms_fixed_size_segment_reduce_it = ms_fixed_segment_reduce_map.find(key);
-        }
-        if(ms_fixed_size_segment_reduce_it == ms_fixed_segment_reduce_map.end()) { return -1; }
-        auto ms_fixed_size_segment_reduce_ptr =
-            reinterpret_cast<FixedSizeSegmentReduceKernel*>(&(*ms_fixed_size_segment_reduce_it->second));
+        auto ms_fixed_size_segment_reduce_ptr = fixed_size_segment_reduce_shader<Type4Byte>(reduce_op, arr_in);
         if(!ms_fixed_size_segment_reduce_ptr) { return -1; }
         for(auto invocation_index = 0u; invocation_index < num_invocations; invocation_index++)
         {
@@ -422,39 +550,19 @@ class DeviceSegmentReduce : public LuisaModule
                 std::min(num_segments - current_seg_offset, num_segments_per_invocation);
 
             const auto num_current_blocks = ceil_div(num_current_segments, segment_per_block);
-            cmdlist << (*ms_fixed_size_segment_reduce_ptr)(arr_in, arr_out, num_current_segments, segment_size, initial_value)
-                           .dispatch(num_current_blocks * m_block_size);
+            details::dispatch_with_iterator_args(cmdlist,
+                                                 *ms_fixed_size_segment_reduce_ptr,
+                                                 num_current_blocks * m_block_size,
+                                                 arr_in.host_args(),
+                                                 arr_out,
+                                                 num_current_segments,
+                                                 segment_size,
+                                                 initial_value);
         }
         return 0;
     }
 
 
-    template <NumericT Type4Byte>
-    [[nodiscard]] int arg_construct(CommandList&                           cmdlist,
-                       BufferView<Type4Byte>                  d_in,
-                       BufferView<IndexValuePairT<Type4Byte>> d_kv_out,
-                       uint                                   num_segments)
-    {
-        using ArgReduce          = details::ArgSegmentReduceModule<Type4Byte, BLOCK_SIZE>;
-        using ArgConstructShader = ArgReduce::ArgConstructShaderT;
-        auto key = luisa::string{luisa::compute::Type::of<Type4Byte>()->description()};
-        auto ms_arg_construct_it = ms_arg_construct_map.find(key);
-        if(ms_arg_construct_it == ms_arg_construct_map.end())
-        {
-            auto shader = ArgReduce().compile_arg_construct_shader(m_device);
-            if (!shader) { return -1; }
-            ms_arg_construct_map.try_emplace(key, std::move(shader));
-            ms_arg_construct_it = ms_arg_construct_map.find(key);
-        }
-        if(ms_arg_construct_it == ms_arg_construct_map.end()) { return -1; }
-        auto ms_arg_construct_ptr = reinterpret_cast<ArgConstructShader*>(&(*ms_arg_construct_it->second));
-        if(!ms_arg_construct_ptr) { return -1; }
-
-        auto num_tiles = ceil_div(num_segments, m_block_size);
-        cmdlist << (*ms_arg_construct_ptr)(d_in, d_kv_out).dispatch(d_in.size());
-        return 0;
-    }
-
     template <NumericT Type4Byte>
     [[nodiscard]] int arg_assign(CommandList&                           cmdlist,
                     BufferView<IndexValuePairT<Type4Byte>> d_kv_in,
@@ -465,17 +573,8 @@ class DeviceSegmentReduce : public LuisaModule
     {
         using ArgReduce       = details::ArgSegmentReduceModule<Type4Byte, WARP_NUMS>;
         using ArgAssignShader = ArgReduce::ArgAssignShaderT;
-        auto key              = luisa::string{luisa::compute::Type::of<Type4Byte>()->description()};
-        auto ms_arg_assign_it = ms_arg_assign_map.find(key);
-        if(ms_arg_assign_it == ms_arg_assign_map.end())
-        {
-            auto shader = ArgReduce().compile_arg_assign_shader(m_device);
-            if (!shader) { return -1; }
-            ms_arg_assign_map.try_emplace(key, std::move(shader));
-            ms_arg_assign_it = ms_arg_assign_map.find(key);
-        }
-        if(ms_arg_assign_it == ms_arg_assign_map.end()) { return -1; }
-        auto ms_arg_assign_ptr = reinterpret_cast<ArgAssignShader*>(&(*ms_arg_assign_it->second));
+        auto ms_arg_assign_ptr = m_shader_cache.get_or_compile<ArgAssignShader, ArgReduce>(
+            [&] { return ArgReduce().compile_arg_assign_shader(m_device); });
         if(!ms_arg_assign_ptr) { return -1; }
         cmdlist << (*ms_arg_assign_ptr)(d_kv_in, d_begin_offset, d_index_out, d_value_out).dispatch(num_segments * WARP_NUMS);
         return 0;
@@ -495,28 +594,14 @@ class DeviceSegmentReduce : public LuisaModule
         const auto num_segments_per_invocation = static_cast<uint>(std::numeric_limits<int32_t>::max());
         const auto num_invocations = ceil_div(num_segments, num_segments_per_invocation);
 
-        auto key              = luisa::string{luisa::compute::Type::of<Type4Byte>()->description()};
-        auto ms_arg_assign_it = ms_arg_fixed_size_assign_map.find(key);
-        if(ms_arg_assign_it == ms_arg_fixed_size_assign_map.end())
-        {
-            auto shader = ArgReduce().compile_arg_fixed_size_assign_shader(m_device);
-            if (!shader) { return -1; }
-            ms_arg_fixed_size_assign_map.try_emplace(key, std::move(shader));
-            ms_arg_assign_it = ms_arg_fixed_size_assign_map.find(key);
-        }
-        if(ms_arg_assign_it == ms_arg_fixed_size_assign_map.end()) { return -1; }
-        auto ms_arg_assign_ptr = reinterpret_cast<ArgAssignShader*>(&(*ms_arg_assign_it->second));
+        auto ms_arg_assign_ptr = m_shader_cache.get_or_compile<ArgAssignShader, ArgReduce>(
+            [&] { return ArgReduce().compile_arg_fixed_size_assign_shader(m_device); });
         if(!ms_arg_assign_ptr) { return -1; }
         cmdlist << (*ms_arg_assign_ptr)(d_kv_in, segment_size, d_index_out, d_value_out).dispatch(num_segments * WARP_NUMS);
         return 0;
     }
 
   private:
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_segment_reduce_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_fixed_segment_reduce_map;
-
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_arg_construct_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_arg_assign_map;
-    luisa::unordered_map<luisa::string, luisa::shared_ptr<luisa::compute::Resource>> ms_arg_fixed_size_assign_map;
+    ShaderCache m_shader_cache{make_kernel_name("DeviceSegmentReduce", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
 };
 }  // namespace luisa::parallel_primitive
@@ -0,0 +1,482 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-16 15:02:51
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-04 15:42:10
+ */
+#pragma once
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/memory.h>
+#include <luisa/runtime/stream.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/agent/policy.h>
+#include <lcpp/device/details/radix_sort.h>
+#include <lcpp/device/details/segmented_radix_sort.h>
+
+namespace luisa::parallel_primitive
+{
+using namespace luisa::compute;
+
+/// Sorts num_segments independent ranges [d_begin_offsets[i], d_end_offsets[i]) of the input,
+/// every segment stays where it is and is sorted stably on the bits [begin_bit, end_bit) of its keys.
+/// Segments are binned by size on the device and every bin gets a worker that fits it:
+/// a warp for segments up to WARP_SIZE * ITEMS_PER_THREAD keys, a block for segments up to
+/// one tile, and ceil((end_bit - begin_bit) / RADIX_BITS) digit passes for larger ones, each pass
+/// a block per tile counting digits, a block per segment scanning the counts and a block per tile
+/// scattering, so one large segment is spread over as many blocks as it has tiles.
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+class DeviceSegmentedRadixSort : public LuisaModule
+{
+  private:
+    uint m_block_size = BLOCK_SIZE;
+    uint m_warp_nums  = WARP_NUMS;
+
+    Device m_device;
+    bool   m_created = false;
+
+    static constexpr uint NUM_GROUPS   = details::NUM_SEGMENT_GROUPS;
+    static constexpr uint NUM_COUNTERS = details::NUM_GROUP_COUNTERS;
+    static constexpr uint TILE_ITEMS   = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+  public:
+    DeviceSegmentedRadixSort()  = default;
+    ~DeviceSegmentedRadixSort() = default;
+
+#ifndef NDEBUG
+    Stream* m_debug_stream; // bind debug stream for sync
+#endif
+    inline Stream* debug_stream() noexcept
+    {
+#ifndef NDEBUG
+        return m_debug_stream;
+#else
+        return nullptr;
+#endif
+    }
+    void create(Device& device, Stream* debug_stream = nullptr)
+    {
+        m_device = device;
+        m_shader_cache.bind(device);
+#ifndef NDEBUG
+        m_debug_stream = debug_stream;
+#endif
+        m_created = true;
+    }
+
+    // ============================================================
+    // GetTempStorageBytes: compute required temp buffer size (in bytes)
+    // ============================================================
+
+    /// Temp storage bytes for SortPairs / SortPairsDescending
+    template <typename KeyType, typename ValueType>
+    static size_t GetSortPairsTempStorageBytes(uint num_items, uint num_segments)
+    {
+        return temp_storage_bytes<KeyType, ValueType, false>(num_items, num_segments);
+    }
+
+    /// Temp storage bytes for SortKeys / SortKeysDescending
+    template <typename KeyType>
+    static size_t GetSortKeysTempStorageBytes(uint num_items, uint num_segments)
+    {
+        return temp_storage_bytes<KeyType, KeyType, true>(num_items, num_segments);
+    }
+
+    // ============================================================
+    // Dispatch APIs (CUB-style: caller provides temp_storage)
+    // ============================================================
+
+    template <NumericT KeyType, NumericT ValueType>
+    void SortPairs(CommandList&          cmdlist,
+                   BufferView<uint>      temp_storage,
+                   BufferView<KeyType>   d_keys_in,
+                   BufferView<KeyType>   d_keys_out,
+                   BufferView<ValueType> d_values_in,
+                   BufferView<ValueType> d_values_out,
+                   uint                  num_items,
+                   uint                  num_segments,
+                   BufferView<uint>      d_begin_offsets,
+                   BufferView<uint>      d_end_offsets,
+                   uint                  begin_bit = 0,
+                   uint                  end_bit   = sizeof(KeyType) * 8)
+    {
+        lcpp_check(segmented_radix_sort<KeyType, ValueType, false, false>(
+                       cmdlist, temp_storage, d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, num_segments, d_begin_offsets, d_end_offsets, begin_bit, end_bit),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    template <NumericT KeyType>
+    void SortKeys(CommandList&        cmdlist,
+                  BufferView<uint>    temp_storage,
+                  BufferView<KeyType> d_keys_in,
+                  BufferView<KeyType> d_keys_out,
+                  uint                num_items,
+                  uint                num_segments,
+                  BufferView<uint>    d_begin_offsets,
+                  BufferView<uint>    d_end_offsets,
+                  uint                begin_bit = 0,
+                  uint                end_bit   = sizeof(KeyType) * 8)
+    {
+        lcpp_check(segmented_radix_sort<KeyType, KeyType, true, false>(
+                       cmdlist, temp_storage, d_keys_in, d_keys_out, d_keys_in, d_keys_out /*dummy*/, num_items, num_segments, d_begin_offsets, d_end_offsets, begin_bit, end_bit),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    template <NumericT KeyType, NumericT ValueType>
+    void SortPairsDescending(CommandList&          cmdlist,
+                             BufferView<uint>      temp_storage,
+                             BufferView<KeyType>   d_keys_in,
+                             BufferView<KeyType>   d_keys_out,
+                             BufferView<ValueType> d_values_in,
+                             BufferView<ValueType> d_values_out,
+                             uint                  num_items,
+                             uint                  num_segments,
+                             BufferView<uint>      d_begin_offsets,
+                             BufferView<uint>      d_end_offsets,
+                             uint                  begin_bit = 0,
+                             uint                  end_bit   = sizeof(KeyType) * 8)
+    {
+        lcpp_check(segmented_radix_sort<KeyType, ValueType, false, true>(
+                       cmdlist, temp_storage, d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, num_segments, d_begin_offsets, d_end_offsets, begin_bit, end_bit),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    template <NumericT KeyType>
+    void SortKeysDescending(CommandList&        cmdlist,
+                            BufferView<uint>    temp_storage,
+                            BufferView<KeyType> d_keys_in,
+                            BufferView<KeyType> d_keys_out,
+                            uint                num_items,
+                            uint                num_segments,
+                            BufferView<uint>    d_begin_offsets,
+                            BufferView<uint>    d_end_offsets,
+                            uint                begin_bit = 0,
+                            uint                end_bit   = sizeof(KeyType) * 8)
+    {
+        lcpp_check(segmented_radix_sort<KeyType, KeyType, true, true>(
+                       cmdlist, temp_storage, d_keys_in, d_keys_out, d_keys_in, d_keys_out /*dummy*/, num_items, num_segments, d_begin_offsets, d_end_offsets, begin_bit, end_bit),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT KeyType, NumericT ValueType>
+    void SortPairs(CommandList&          cmdlist,
+                   CachingAllocator&     allocator,
+                   const Stream&         stream,
+                   BufferView<KeyType>   d_keys_in,
+                   BufferView<KeyType>   d_keys_out,
+                   BufferView<ValueType> d_values_in,
+                   BufferView<ValueType> d_values_out,
+                   uint                  num_items,
+                   uint                  num_segments,
+                   BufferView<uint>      d_begin_offsets,
+                   BufferView<uint>      d_end_offsets,
+                   uint                  begin_bit = 0,
+                   uint                  end_bit   = sizeof(KeyType) * 8)
+    {
+        auto temp = allocator.allocate(stream, GetSortPairsTempStorageBytes<KeyType, ValueType>(num_items, num_segments));
+        SortPairs(cmdlist, temp.view(), d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, num_segments, d_begin_offsets, d_end_offsets, begin_bit, end_bit);
+    }
+
+    template <NumericT KeyType>
+    void SortKeys(CommandList&        cmdlist,
+                  CachingAllocator&   allocator,
+                  const Stream&       stream,
+                  BufferView<KeyType> d_keys_in,
+                  BufferView<KeyType> d_keys_out,
+                  uint                num_items,
+                  uint                num_segments,
+                  BufferView<uint>    d_begin_offsets,
+                  BufferView<uint>    d_end_offsets,
+                  uint                begin_bit = 0,
+                  uint                end_bit   = sizeof(KeyType) * 8)
+    {
+        auto temp = allocator.allocate(stream, GetSortKeysTempStorageBytes<KeyType>(num_items, num_segments));
+        SortKeys(cmdlist, temp.view(), d_keys_in, d_keys_out, num_items, num_segments, d_begin_offsets, d_end_offsets, begin_bit, end_bit);
+    }
+
+    template <NumericT KeyType, NumericT ValueType>
+    void SortPairsDescending(CommandList&          cmdlist,
+                             CachingAllocator&     allocator,
+                             const Stream&         stream,
+                             BufferView<KeyType>   d_keys_in,
+                             BufferView<KeyType>   d_keys_out,
+                             BufferView<ValueType> d_values_in,
+                             BufferView<ValueType> d_values_out,
+                             uint                  num_items,
+                             uint                  num_segments,
+                             BufferView<uint>      d_begin_offsets,
+                             BufferView<uint>      d_end_offsets,
+                             uint                  begin_bit = 0,
+                             uint                  end_bit   = sizeof(KeyType) * 8)
+    {
+        auto temp = allocator.allocate(stream, GetSortPairsTempStorageBytes<KeyType, ValueType>(num_items, num_segments));
+        SortPairsDescending(cmdlist, temp.view(), d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, num_segments, d_begin_offsets, d_end_offsets, begin_bit, end_bit);
+    }
+
+    template <NumericT KeyType>
+    void SortKeysDescending(CommandList&        cmdlist,
+                            CachingAllocator&   allocator,
+                            const Stream&       stream,
+                            BufferView<KeyType> d_keys_in,
+                            BufferView<KeyType> d_keys_out,
+                            uint                num_items,
+                            uint                num_segments,
+                            BufferView<uint>    d_begin_offsets,
+                            BufferView<uint>    d_end_offsets,
+                            uint                begin_bit = 0,
+                            uint                end_bit   = sizeof(KeyType) * 8)
+    {
+        auto temp = allocator.allocate(stream, GetSortKeysTempStorageBytes<KeyType>(num_items, num_segments));
+        SortKeysDescending(cmdlist, temp.view(), d_keys_in, d_keys_out, num_items, num_segments, d_begin_offsets, d_end_offsets, begin_bit, end_bit);
+    }
+
+  private:
+    // the three size classes share one shader signature, these tell their cache slots apart
+    struct SmallSegmentsKey
+    {
+        static luisa::string kernel_name() noexcept { return "small_segments"; }
+    };
+    struct MediumSegmentsKey
+    {
+        static luisa::string kernel_name() noexcept { return "medium_segments"; }
+    };
+    // and so do the steps of a large segment pass
+    struct LargeTileMapKey
+    {
+        static luisa::string kernel_name() noexcept { return "large_tile_map"; }
+    };
+    struct LargeCountKey
+    {
+        static luisa::string kernel_name() noexcept { return "large_count"; }
+    };
+    struct LargeScanKey
+    {
+        static luisa::string kernel_name() noexcept { return "large_scan"; }
+    };
+    struct LargeScatterKey
+    {
+        static luisa::string kernel_name() noexcept { return "large_scatter"; }
+    };
+
+    // every large segment has more than one tile of keys, so its tiles are fewer than twice its
+    // keys / TILE_ITEMS; the gaps between segments only make the bound looser
+    static size_t max_large_tiles(uint num_items) { return 2 * ceil_div<size_t>(num_items, TILE_ITEMS); }
+
+    // [group counters | group lists | large tile base | large tile map | tile digits | key buffer | value buffer]
+    template <typename KeyType, typename ValueType, bool KEY_ONLY>
+    static size_t temp_storage_bytes(uint num_items, uint num_segments)
+    {
+        constexpr uint RADIX_DIGITS = 1u << OneSweepSmallKeyTunedPolicy<KeyType>::ONESWEEP_RADIX_BITS;
+
+        size_t bytes = (size_t)NUM_COUNTERS * sizeof(uint);
+        bytes += (size_t)NUM_GROUPS * num_segments * sizeof(uint);
+        bytes += (size_t)num_segments * sizeof(uint);
+        bytes += max_large_tiles(num_items) * sizeof(uint);
+        bytes += max_large_tiles(num_items) * RADIX_DIGITS * sizeof(uint);
+        bytes = align_up_uint(bytes, alignof(KeyType));
+        bytes += bytes_to_uint_count((size_t)num_items * sizeof(KeyType)) * sizeof(uint);
+        if constexpr(!KEY_ONLY)
+        {
+            bytes = align_up_uint(bytes, alignof(ValueType));
+            bytes += bytes_to_uint_count((size_t)num_items * sizeof(ValueType)) * sizeof(uint);
+        }
+        return bytes;
+    }
+
+    // same grid budget as DeviceFor, the kernels stride over their segment group
+    static uint grid_blocks(uint num_blocks) { return std::max(1u, std::min(num_blocks, (uint)(BLOCK_SIZE * 8 * 5))); }
+
+    template <NumericT KeyType, typename ValueType, bool KEY_ONLY, bool IS_DESCENDING>
+    [[nodiscard]] int segmented_radix_sort(CommandList&          cmdlist,
+                                           BufferView<uint>      temp_storage,
+                                           BufferView<KeyType>   d_keys_in,
+                                           BufferView<KeyType>   d_keys_out,
+                                           BufferView<ValueType> d_values_in,
+                                           BufferView<ValueType> d_values_out,
+                                           uint                  num_items,
+                                           uint                  num_segments,
+                                           BufferView<uint>      d_begin_offsets,
+                                           BufferView<uint>      d_end_offsets,
+                                           uint                  begin_bit,
+                                           uint                  end_bit) noexcept
+    {
+        constexpr uint RADIX_BITS = OneSweepSmallKeyTunedPolicy<KeyType>::ONESWEEP_RADIX_BITS;
+        using SegmentedRadixSort =
+            details::SegmentedRadixSortModule<KeyType, ValueType, KEY_ONLY, IS_DESCENDING, RADIX_BITS, BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+        using ClassifyKernel    = SegmentedRadixSort::ClassifyKernel;
+        using SegmentSortKernel = SegmentedRadixSort::SegmentSortKernel;
+        using LargeSegmentKernel = SegmentedRadixSort::LargeSegmentKernel;
+        using RadixSortReset       = details::RadixSortResetModule<uint>;
+        using RadixSortResetKernel = RadixSortReset::RadixSortResetKernel;
+
+        if(num_items == 0 || num_segments == 0) { return 0; }
+        if(begin_bit > end_bit || end_bit > sizeof(KeyType) * 8) { return -1; }
+
+        // carve temp storage
+        constexpr uint RADIX_DIGITS = 1u << RADIX_BITS;
+        size_t         offset_bytes = 0;
+        auto           d_group_sizes = temp_storage.subview(0, NUM_COUNTERS);
+        offset_bytes += NUM_COUNTERS * sizeof(uint);
+        auto d_group_lists = temp_storage.subview(offset_bytes / sizeof(uint), (size_t)NUM_GROUPS * num_segments);
+        offset_bytes += (size_t)NUM_GROUPS * num_segments * sizeof(uint);
+        auto d_large_tile_base = temp_storage.subview(offset_bytes / sizeof(uint), num_segments);
+        offset_bytes += (size_t)num_segments * sizeof(uint);
+        size_t num_large_tiles  = max_large_tiles(num_items);
+        auto   d_large_tile_map = temp_storage.subview(offset_bytes / sizeof(uint), num_large_tiles);
+        offset_bytes += num_large_tiles * sizeof(uint);
+        auto d_tile_digits = temp_storage.subview(offset_bytes / sizeof(uint), num_large_tiles * RADIX_DIGITS);
+        offset_bytes += num_large_tiles * RADIX_DIGITS * sizeof(uint);
+
+        offset_bytes           = align_up_uint(offset_bytes, alignof(KeyType));
+        size_t keys_uint_count = bytes_to_uint_count((size_t)num_items * sizeof(KeyType));
+        auto   d_keys_tmp = temp_storage.subview(offset_bytes / sizeof(uint), keys_uint_count).template as<KeyType>();
+        offset_bytes += keys_uint_count * sizeof(uint);
+
+        auto d_values_tmp = d_values_out;
+        if constexpr(!KEY_ONLY)
+        {
+            offset_bytes             = align_up_uint(offset_bytes, alignof(ValueType));
+            size_t values_uint_count = bytes_to_uint_count((size_t)num_items * sizeof(ValueType));
+            d_values_tmp = temp_storage.subview(offset_bytes / sizeof(uint), values_uint_count).template as<ValueType>();
+        }
+
+        auto ms_reset_ptr = m_shader_cache.get_or_compile<RadixSortResetKernel, RadixSortReset>(
+            [&] { return RadixSortReset().compile(m_device); });
+        if(!ms_reset_ptr) { return -1; }
+
+        auto ms_classify_ptr = m_shader_cache.get_or_compile<ClassifyKernel, SegmentedRadixSort>(
+            [&] { return SegmentedRadixSort().compile_classify(m_device); });
+        if(!ms_classify_ptr) { return -1; }
+
+        auto ms_small_ptr = m_shader_cache.get_or_compile<SegmentSortKernel, SegmentedRadixSort, SmallSegmentsKey>(
+            [&] { return SegmentedRadixSort().compile_small(m_device); });
+        if(!ms_small_ptr) { return -1; }
+
+        auto ms_medium_ptr = m_shader_cache.get_or_compile<SegmentSortKernel, SegmentedRadixSort, MediumSegmentsKey>(
+            [&] { return SegmentedRadixSort().compile_medium(m_device); });
+        if(!ms_medium_ptr) { return -1; }
+
+        auto ms_large_tile_map_ptr = m_shader_cache.get_or_compile<LargeSegmentKernel, SegmentedRadixSort, LargeTileMapKey>(
+            [&] { return SegmentedRadixSort().compile_large_tile_map(m_device); });
+        if(!ms_large_tile_map_ptr) { return -1; }
+
+        auto ms_large_count_ptr = m_shader_cache.get_or_compile<LargeSegmentKernel, SegmentedRadixSort, LargeCountKey>(
+            [&] { return SegmentedRadixSort().compile_large_count(m_device); });
+        if(!ms_large_count_ptr) { return -1; }
+
+        auto ms_large_scan_ptr = m_shader_cache.get_or_compile<LargeSegmentKernel, SegmentedRadixSort, LargeScanKey>(
+            [&] { return SegmentedRadixSort().compile_large_scan(m_device); });
+        if(!ms_large_scan_ptr) { return -1; }
+
+        auto ms_large_scatter_ptr = m_shader_cache.get_or_compile<LargeSegmentKernel, SegmentedRadixSort, LargeScatterKey>(
+            [&] { return SegmentedRadixSort().compile_large_scatter(m_device); });
+        if(!ms_large_scatter_ptr) { return -1; }
+
+        // bin the segments by size
+        cmdlist << (*ms_reset_ptr)(d_group_sizes, 0u).dispatch(NUM_COUNTERS);
+        cmdlist << (*ms_classify_ptr)(d_begin_offsets, d_end_offsets, d_group_sizes, d_group_lists, d_large_tile_base, num_segments)
+                       .dispatch(ceil_div(num_segments, m_block_size) * m_block_size);
+
+        // small and medium segments go straight from keys_in to keys_out in one launch each
+        uint warps_per_block = m_block_size / m_warp_nums;
+        cmdlist << (*ms_small_ptr)(ByteBufferView{d_keys_in},
+                                   ByteBufferView{d_keys_out},
+                                   d_values_in,
+                                   d_values_out,
+                                   d_begin_offsets,
+                                   d_end_offsets,
+                                   d_group_sizes,
+                                   d_group_lists,
+                                   num_segments,
+                                   begin_bit,
+                                   end_bit)
+                       .dispatch(grid_blocks(ceil_div(num_segments, warps_per_block)) * m_block_size);
+        cmdlist << (*ms_medium_ptr)(ByteBufferView{d_keys_in},
+                                    ByteBufferView{d_keys_out},
+                                    d_values_in,
+                                    d_values_out,
+                                    d_begin_offsets,
+                                    d_end_offsets,
+                                    d_group_sizes,
+                                    d_group_lists,
+                                    num_segments,
+                                    begin_bit,
+                                    end_bit)
+                       .dispatch(grid_blocks(num_segments) * m_block_size);
+
+        // large segments ping-pong one digit pass at a time, starting in the buffer that makes
+        // the last pass land in keys_out; an empty bit range still needs one pass to copy them.
+        // The tiles of all large segments are spread over the grid, a segment is only one block
+        // for the scan of its digit counts
+        auto large_pass = [&](const LargeSegmentKernel& shader,
+                              BufferView<KeyType>       keys_in,
+                              BufferView<KeyType>       keys_out,
+                              BufferView<ValueType>     values_in,
+                              BufferView<ValueType>     values_out,
+                              uint                      pass_begin_bit,
+                              uint                      pass_end_bit,
+                              uint                      num_blocks)
+        {
+            cmdlist << shader(ByteBufferView{keys_in},
+                              ByteBufferView{keys_out},
+                              values_in,
+                              values_out,
+                              d_begin_offsets,
+                              d_end_offsets,
+                              d_group_sizes,
+                              d_group_lists,
+                              d_large_tile_base,
+                              d_large_tile_map,
+                              d_tile_digits,
+                              num_segments,
+                              pass_begin_bit,
+                              pass_end_bit)
+                           .dispatch(grid_blocks(num_blocks) * m_block_size);
+        };
+        const uint tile_blocks = static_cast<uint>(std::min<size_t>(num_large_tiles, std::numeric_limits<uint>::max()));
+        large_pass(*ms_large_tile_map_ptr, d_keys_in, d_keys_out, d_values_in, d_values_out, begin_bit, end_bit, num_segments);
+
+        uint num_passes = std::max(1u, ceil_div(end_bit - begin_bit, RADIX_BITS));
+        for(uint pass = 0; pass < num_passes; ++pass)
+        {
+            uint pass_begin_bit = std::min(end_bit, begin_bit + pass * RADIX_BITS);
+            uint pass_end_bit   = std::min(end_bit, pass_begin_bit + RADIX_BITS);
+            bool to_out         = (num_passes - 1 - pass) % 2 == 0;
+
+            auto keys_in    = pass == 0 ? d_keys_in : (to_out ? d_keys_tmp : d_keys_out);
+            auto values_in  = pass == 0 ? d_values_in : (to_out ? d_values_tmp : d_values_out);
+            auto keys_out   = to_out ? d_keys_out : d_keys_tmp;
+            auto values_out = to_out ? d_values_out : d_values_tmp;
+
+            large_pass(*ms_large_count_ptr, keys_in, keys_out, values_in, values_out, pass_begin_bit, pass_end_bit, tile_blocks);
+            large_pass(*ms_large_scan_ptr, keys_in, keys_out, values_in, values_out, pass_begin_bit, pass_end_bit, num_segments);
+            large_pass(*ms_large_scatter_ptr, keys_in, keys_out, values_in, values_out, pass_begin_bit, pass_end_bit, tile_blocks);
+        }
+        return 0;
+    }
+
+    ShaderCache m_shader_cache{make_kernel_name("DeviceSegmentedRadixSort", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
+};
+}  // namespace luisa::parallel_primitive
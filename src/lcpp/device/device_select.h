@@ -0,0 +1,232 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-12 11:40:26
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-07 10:41:16
+ */
+#pragma once
+
+#include <algorithm>
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/memory.h>
+#include <luisa/runtime/stream.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <cstddef>
+#include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/common/thread_operators.h>
+#include <lcpp/device/details/select.h>
+
+namespace luisa::parallel_primitive
+{
+using namespace luisa::compute;
+/// DelayPolicy paces the decoupled look-back of the selection scan, see DeviceScan
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD, typename DelayPolicy = NoDelayPolicy>
+class DeviceSelect : public LuisaModule
+{
+  private:
+    uint m_block_size = BLOCK_SIZE;
+    uint m_warp_nums  = WARP_NUMS;
+
+    Device m_device;
+    bool   m_created = false;
+
+    using SelectMode = details::SelectMode;
+
+  public:
+    DeviceSelect()  = default;
+    ~DeviceSelect() = default;
+
+#ifndef NDEBUG
+    Stream* m_debug_stream; // bind debug stream for sync
+#endif
+    inline Stream* debug_stream() noexcept
+    {
+#ifndef NDEBUG
+        return m_debug_stream;
+#else
+        return nullptr;
+#endif
+    }
+    void create(Device& device, Stream* debug_stream = nullptr)
+    {
+        m_device = device;
+        m_shader_cache.bind(device);
+#ifndef NDEBUG
+        m_debug_stream = debug_stream;
+#endif
+        m_created = true;
+    }
+
+    // ============================================================
+    // GetTempStorageBytes: compute required temp buffer size (in bytes)
+    // ============================================================
+
+    /// Temp storage bytes for Flagged / If / Unique
+    static size_t GetTempStorageBytes(size_t num_items)
+    {
+        size_t num_tiles  = std::max<size_t>(1, ceil_div<size_t>(num_items, ITEMS_PER_THREAD * BLOCK_SIZE));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
+
+        size_t bytes = 0;
+        bytes += tile_count * sizeof(uint);  // tile_status
+        bytes += tile_count * sizeof(uint);  // tile_partial
+        bytes += tile_count * sizeof(uint);  // tile_inclusive
+        return bytes;
+    }
+
+    // ============================================================
+    // Dispatch APIs (CUB-style: caller provides temp_storage)
+    // ============================================================
+
+    /// Copies d_in[i] with d_flags[i] != 0 to d_out, keeping their relative order;
+    /// the number of selected items is written to d_num_selected_out[0]
+    template <NumericT Type, NumericT FlagT>
+    void Flagged(CommandList&      cmdlist,
+                 BufferView<uint>  temp_storage,
+                 BufferView<Type>  d_in,
+                 BufferView<FlagT> d_flags,
+                 BufferView<Type>  d_out,
+                 BufferView<uint>  d_num_selected_out,
+                 uint              num_items)
+    {
+        lcpp_check(select_array<SelectMode::Flagged, Type, FlagT>(
+                       cmdlist, temp_storage, d_in, d_flags, d_out, d_num_selected_out, num_items, IdentityOp()),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// Copies d_in[i] with select_op(d_in[i]) == true to d_out, keeping their relative order
+    template <NumericT Type, typename SelectOp>
+    void If(CommandList&     cmdlist,
+            BufferView<uint> temp_storage,
+            BufferView<Type> d_in,
+            BufferView<Type> d_out,
+            BufferView<uint> d_num_selected_out,
+            uint             num_items,
+            SelectOp         select_op)
+    {
+        lcpp_check(select_array<SelectMode::If, Type, uint>(
+                       cmdlist, temp_storage, d_in, dummy_flags(temp_storage), d_out, d_num_selected_out, num_items, select_op),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// Keeps the first item of every run of consecutive items that compare equal
+    template <NumericT Type, typename EqualityOpT = EqualityOp>
+    void Unique(CommandList&     cmdlist,
+                BufferView<uint> temp_storage,
+                BufferView<Type> d_in,
+                BufferView<Type> d_out,
+                BufferView<uint> d_num_selected_out,
+                uint             num_items,
+                EqualityOpT      equality_op = {})
+    {
+        lcpp_check(select_array<SelectMode::Unique, Type, uint>(
+                       cmdlist, temp_storage, d_in, dummy_flags(temp_storage), d_out, d_num_selected_out, num_items, equality_op),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT Type, NumericT FlagT>
+    void Flagged(CommandList&      cmdlist,
+                 CachingAllocator& allocator,
+                 const Stream&     stream,
+                 BufferView<Type>  d_in,
+                 BufferView<FlagT> d_flags,
+                 BufferView<Type>  d_out,
+                 BufferView<uint>  d_num_selected_out,
+                 uint              num_items)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes(num_items));
+        Flagged(cmdlist, temp.view(), d_in, d_flags, d_out, d_num_selected_out, num_items);
+    }
+
+    template <NumericT Type, typename SelectOp>
+    void If(CommandList&      cmdlist,
+            CachingAllocator& allocator,
+            const Stream&     stream,
+            BufferView<Type>  d_in,
+            BufferView<Type>  d_out,
+            BufferView<uint>  d_num_selected_out,
+            uint              num_items,
+            SelectOp          select_op)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes(num_items));
+        If(cmdlist, temp.view(), d_in, d_out, d_num_selected_out, num_items, select_op);
+    }
+
+    template <NumericT Type, typename EqualityOpT = EqualityOp>
+    void Unique(CommandList&      cmdlist,
+                CachingAllocator& allocator,
+                const Stream&     stream,
+                BufferView<Type>  d_in,
+                BufferView<Type>  d_out,
+                BufferView<uint>  d_num_selected_out,
+                uint              num_items,
+                EqualityOpT       equality_op = {})
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes(num_items));
+        Unique(cmdlist, temp.view(), d_in, d_out, d_num_selected_out, num_items, equality_op);
+    }
+
+  private:
+    // If / Unique never read the flags buffer, any uint view satisfies the shared kernel signature
+    static BufferView<uint> dummy_flags(BufferView<uint> temp_storage) noexcept
+    {
+        return temp_storage.subview(0, 1);
+    }
+
+    template <SelectMode MODE, NumericT Type, NumericT FlagT, typename SelectOp>
+    [[nodiscard]] int select_array(CommandList&      cmdlist,
+                                   BufferView<uint>  temp_storage,
+                                   BufferView<Type>  d_in,
+                                   BufferView<FlagT> d_flags,
+                                   BufferView<Type>  d_out,
+                                   BufferView<uint>  d_num_selected_out,
+                                   uint              num_items,
+                                   SelectOp          select_op) noexcept
+    {
+        using Select                  = details::SelectModule<Type, FlagT, BLOCK_SIZE, ITEMS_PER_THREAD, DelayPolicy>;
+        using ScanTileStateInitKernel = Select::ScanTileStateInitKernel;
+        using SelectKernel            = Select::SelectKernel;
+
+        uint   tile_items = m_block_size * ITEMS_PER_THREAD;
+        uint   num_tiles  = std::max(1u, ceil_div(num_items, tile_items));
+        size_t tile_count = details::WARP_SIZE + num_tiles;
+
+        auto tile_status    = temp_storage.subview(0, tile_count);
+        auto tile_partial   = temp_storage.subview(tile_count, tile_count);
+        auto tile_inclusive = temp_storage.subview(2 * tile_count, tile_count);
+
+        // init
+        auto ms_scan_tile_state_init_ptr = m_shader_cache.get_or_compile<ScanTileStateInitKernel, Select>(
+            [&] { return Select().compile_scan_tile_state_init(m_device); });
+        if(!ms_scan_tile_state_init_ptr) { return -1; }
+        cmdlist << (*ms_scan_tile_state_init_ptr)(tile_status, num_tiles).dispatch(num_tiles * m_block_size);
+
+        // select
+        auto ms_select_ptr = m_shader_cache.get_or_compile<SelectKernel, Select, std::integral_constant<SelectMode, MODE>, SelectOp>(
+            [&] { return Select().template compile<MODE, false>(m_device, select_op); });
+        if(!ms_select_ptr) { return -1; }
+        cmdlist << (*ms_select_ptr)(
+                       tile_status, tile_partial, tile_inclusive, d_in, d_flags, d_out, d_num_selected_out, num_items)
+                       .dispatch(num_tiles * m_block_size);
+        return 0;
+    }
+
+    ShaderCache m_shader_cache{make_kernel_name("DeviceSelect", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
+};
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,283 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-17 12:30:14
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-26 17:20:46
+ */
+#pragma once
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/memory.h>
+#include <luisa/runtime/stream.h>
+#include <luisa/dsl/builtin.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/dsl/sugar.h>
+#include <luisa/dsl/var.h>
+#include <algorithm>
+#include <cstddef>
+#include <lcpp/runtime/core.h>
+#include <lcpp/runtime/shader_cache.h>
+#include <lcpp/runtime/caching_allocator.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/common/utils.h>
+#include <lcpp/agent/policy.h>
+#include <lcpp/device/details/radix_sort.h>
+#include <lcpp/device/details/radix_select.h>
+
+namespace luisa::parallel_primitive
+{
+using namespace luisa::compute;
+
+/// The k largest (Max*) or smallest (Min*) keys of the input, without sorting it.
+/// A radix select narrows to the k-th key one digit per pass, most significant digit first,
+/// with a filtered histogram and a one block digit pick; a last pass compacts the winners.
+/// That is ceil(key bits / RADIX_BITS) histogram passes over the keys plus one compaction,
+/// against one histogram plus a full scatter of keys and values per digit for a sort.
+/// The k outputs come out in no particular order; among keys equal to the k-th key,
+/// which ones make the cut is not specified.
+template <size_t BLOCK_SIZE = details::BLOCK_SIZE, size_t WARP_NUMS = details::WARP_SIZE, size_t ITEMS_PER_THREAD = details::ITEMS_PER_THREAD>
+class DeviceTopK : public LuisaModule
+{
+  private:
+    uint m_block_size = BLOCK_SIZE;
+    uint m_warp_nums  = WARP_NUMS;
+
+    Device m_device;
+    bool   m_created = false;
+
+    static constexpr uint TILE_ITEMS = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+  public:
+    DeviceTopK()  = default;
+    ~DeviceTopK() = default;
+
+#ifndef NDEBUG
+    Stream* m_debug_stream; // bind debug stream for sync
+#endif
+    inline Stream* debug_stream() noexcept
+    {
+#ifndef NDEBUG
+        return m_debug_stream;
+#else
+        return nullptr;
+#endif
+    }
+    void create(Device& device, Stream* debug_stream = nullptr)
+    {
+        m_device = device;
+        m_shader_cache.bind(device);
+#ifndef NDEBUG
+        m_debug_stream = debug_stream;
+#endif
+        m_created = true;
+    }
+
+    // ============================================================
+    // GetTempStorageBytes: compute required temp buffer size (in bytes)
+    // ============================================================
+
+    /// Temp storage bytes for MaxPairs / MaxKeys / MinPairs / MinKeys
+    /// Needs: the k-th key prefix + select state + one digit histogram, independent of num_items
+    template <typename KeyType>
+    static size_t GetTempStorageBytes(uint /*num_items*/)
+    {
+        constexpr uint RADIX_DIGITS = 1u << OneSweepSmallKeyTunedPolicy<KeyType>::ONESWEEP_RADIX_BITS;
+        size_t         bytes        = bytes_to_uint_count(sizeof(KeyType)) * sizeof(uint);
+        bytes += details::SELECT_STATE_SIZE * sizeof(uint);
+        bytes += RADIX_DIGITS * sizeof(uint);
+        return bytes;
+    }
+
+    // ============================================================
+    // Dispatch APIs (CUB-style: caller provides temp_storage)
+    // ============================================================
+
+    /// The k largest keys and their values
+    template <NumericT KeyType, NumericT ValueType>
+    void MaxPairs(CommandList&          cmdlist,
+                  BufferView<uint>      temp_storage,
+                  BufferView<KeyType>   d_keys_in,
+                  BufferView<KeyType>   d_keys_out,
+                  BufferView<ValueType> d_values_in,
+                  BufferView<ValueType> d_values_out,
+                  uint                  num_items,
+                  uint                  k)
+    {
+        lcpp_check(radix_select<KeyType, ValueType, false, true>(
+                       cmdlist, temp_storage, d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, k),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// The k largest keys
+    template <NumericT KeyType>
+    void MaxKeys(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<KeyType> d_keys_in, BufferView<KeyType> d_keys_out, uint num_items, uint k)
+    {
+        lcpp_check(radix_select<KeyType, KeyType, true, true>(
+                       cmdlist, temp_storage, d_keys_in, d_keys_out, d_keys_in, d_keys_out /*dummy*/, num_items, k),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// The k smallest keys and their values
+    template <NumericT KeyType, NumericT ValueType>
+    void MinPairs(CommandList&          cmdlist,
+                  BufferView<uint>      temp_storage,
+                  BufferView<KeyType>   d_keys_in,
+                  BufferView<KeyType>   d_keys_out,
+                  BufferView<ValueType> d_values_in,
+                  BufferView<ValueType> d_values_out,
+                  uint                  num_items,
+                  uint                  k)
+    {
+        lcpp_check(radix_select<KeyType, ValueType, false, false>(
+                       cmdlist, temp_storage, d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, k),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    /// The k smallest keys
+    template <NumericT KeyType>
+    void MinKeys(CommandList& cmdlist, BufferView<uint> temp_storage, BufferView<KeyType> d_keys_in, BufferView<KeyType> d_keys_out, uint num_items, uint k)
+    {
+        lcpp_check(radix_select<KeyType, KeyType, true, false>(
+                       cmdlist, temp_storage, d_keys_in, d_keys_out, d_keys_in, d_keys_out /*dummy*/, num_items, k),
+                   cmdlist,
+                   debug_stream());
+    }
+
+    // ============================================================
+    // CachingAllocator overloads: the temp storage is taken from allocator for commands
+    // committed to stream, and handed back once the call has recorded them
+    // ============================================================
+
+    template <NumericT KeyType, NumericT ValueType>
+    void MaxPairs(CommandList&          cmdlist,
+                  CachingAllocator&     allocator,
+                  const Stream&         stream,
+                  BufferView<KeyType>   d_keys_in,
+                  BufferView<KeyType>   d_keys_out,
+                  BufferView<ValueType> d_values_in,
+                  BufferView<ValueType> d_values_out,
+                  uint                  num_items,
+                  uint                  k)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<KeyType>(num_items));
+        MaxPairs(cmdlist, temp.view(), d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, k);
+    }
+
+    template <NumericT KeyType>
+    void MaxKeys(CommandList& cmdlist, CachingAllocator& allocator, const Stream& stream, BufferView<KeyType> d_keys_in, BufferView<KeyType> d_keys_out, uint num_items, uint k)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<KeyType>(num_items));
+        MaxKeys(cmdlist, temp.view(), d_keys_in, d_keys_out, num_items, k);
+    }
+
+    template <NumericT KeyType, NumericT ValueType>
+    void MinPairs(CommandList&          cmdlist,
+                  CachingAllocator&     allocator,
+                  const Stream&         stream,
+                  BufferView<KeyType>   d_keys_in,
+                  BufferView<KeyType>   d_keys_out,
+                  BufferView<ValueType> d_values_in,
+                  BufferView<ValueType> d_values_out,
+                  uint                  num_items,
+                  uint                  k)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<KeyType>(num_items));
+        MinPairs(cmdlist, temp.view(), d_keys_in, d_keys_out, d_values_in, d_values_out, num_items, k);
+    }
+
+    template <NumericT KeyType>
+    void MinKeys(CommandList& cmdlist, CachingAllocator& allocator, const Stream& stream, BufferView<KeyType> d_keys_in, BufferView<KeyType> d_keys_out, uint num_items, uint k)
+    {
+        auto temp = allocator.allocate(stream, GetTempStorageBytes<KeyType>(num_items));
+        MinKeys(cmdlist, temp.view(), d_keys_in, d_keys_out, num_items, k);
+    }
+
+  private:
+    template <NumericT KeyType, typename ValueType, bool KEY_ONLY, bool SELECT_MAX>
+    [[nodiscard]] int radix_select(CommandList&          cmdlist,
+                                   BufferView<uint>      temp_storage,
+                                   BufferView<KeyType>   d_keys_in,
+                                   BufferView<KeyType>   d_keys_out,
+                                   BufferView<ValueType> d_values_in,
+                                   BufferView<ValueType> d_values_out,
+                                   uint                  num_items,
+                                   uint                  k) noexcept
+    {
+        constexpr uint RADIX_BITS   = OneSweepSmallKeyTunedPolicy<KeyType>::ONESWEEP_RADIX_BITS;
+        constexpr uint RADIX_DIGITS = 1u << RADIX_BITS;
+        constexpr uint KEY_BITS     = sizeof(KeyType) * 8;
+        using RadixSelect =
+            details::RadixSelectModule<KeyType, ValueType, KEY_ONLY, SELECT_MAX, RADIX_BITS, BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+        using HistogramKernel      = RadixSelect::HistogramKernel;
+        using SelectDigitKernel    = RadixSelect::SelectDigitKernel;
+        using CompactKernel        = RadixSelect::CompactKernel;
+        using RadixSortReset       = details::RadixSortResetModule<uint>;
+        using RadixSortResetKernel = RadixSortReset::RadixSortResetKernel;
+
+        k = std::min(k, num_items);
+        if(k == 0) { return 0; }
+
+        // carve temp storage: [k-th key prefix | select state | digit histogram]
+        size_t prefix_uint_count = bytes_to_uint_count(sizeof(KeyType));
+        size_t offset            = 0;
+        auto   d_prefix          = temp_storage.subview(offset, prefix_uint_count);
+        offset += prefix_uint_count;
+        auto d_state = temp_storage.subview(offset, details::SELECT_STATE_SIZE);
+        offset += details::SELECT_STATE_SIZE;
+        auto d_bins = temp_storage.subview(offset, RADIX_DIGITS);
+
+        auto ms_reset_ptr = m_shader_cache.get_or_compile<RadixSortResetKernel, RadixSortReset>(
+            [&] { return RadixSortReset().compile(m_device); });
+        if(!ms_reset_ptr) { return -1; }
+
+        auto ms_histogram_ptr = m_shader_cache.get_or_compile<HistogramKernel, RadixSelect>(
+            [&] { return RadixSelect().compile_histogram(m_device); });
+        if(!ms_histogram_ptr) { return -1; }
+
+        auto ms_select_digit_ptr = m_shader_cache.get_or_compile<SelectDigitKernel, RadixSelect>(
+            [&] { return RadixSelect().compile_select_digit(m_device); });
+        if(!ms_select_digit_ptr) { return -1; }
+
+        auto ms_compact_ptr = m_shader_cache.get_or_compile<CompactKernel, RadixSelect>(
+            [&] { return RadixSelect().compile_compact(m_device); });
+        if(!ms_compact_ptr) { return -1; }
+
+        cmdlist << (*ms_reset_ptr)(d_prefix, 0u).dispatch(prefix_uint_count)
+                << (*ms_reset_ptr)(d_state.subview(details::SELECT_REMAINING_K, 1), k).dispatch(1)
+                << (*ms_reset_ptr)(d_state.subview(details::SELECT_NUM_LESS, 2), 0u).dispatch(2);
+
+        // one block per SM for the histograms, as the radix sort histogram does
+        uint num_tiles        = ceil_div(num_items, TILE_ITEMS);
+        uint histogram_blocks = std::min(num_tiles, (uint)BLOCK_SIZE);
+        uint compact_blocks   = std::min(num_tiles, (uint)(BLOCK_SIZE * 8 * 5));
+
+        // narrow the prefix from the most significant digit down
+        for(uint hi_bit = KEY_BITS; hi_bit > 0; hi_bit -= std::min(hi_bit, RADIX_BITS))
+        {
+            uint current_bit = hi_bit - std::min(hi_bit, RADIX_BITS);
+            cmdlist << (*ms_reset_ptr)(d_bins, 0u).dispatch(RADIX_DIGITS);
+            cmdlist << (*ms_histogram_ptr)(ByteBufferView{d_keys_in}, d_bins, ByteBufferView{d_prefix}, num_items, current_bit, hi_bit - current_bit)
+                           .dispatch(histogram_blocks * m_block_size);
+            cmdlist << (*ms_select_digit_ptr)(d_bins, d_state, ByteBufferView{d_prefix}, current_bit).dispatch(m_block_size);
+        }
+
+        cmdlist << (*ms_compact_ptr)(ByteBufferView{d_keys_in},
+                                     d_values_in,
+                                     ByteBufferView{d_keys_out},
+                                     d_values_out,
+                                     d_state,
+                                     ByteBufferView{d_prefix},
+                                     num_items,
+                                     k)
+                       .dispatch(compact_blocks * m_block_size);
+        return 0;
+    }
+
+    ShaderCache m_shader_cache{make_kernel_name("DeviceTopK", BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD)};
+};
+}  // namespace luisa::parallel_primitive
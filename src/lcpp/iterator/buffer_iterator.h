@@ -0,0 +1,66 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-19 10:35:44
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-19 14:02:15
+ */
+
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/runtime/buffer.h>
+#include <lcpp/iterator/iterator_base.h>
+
+namespace luisa::parallel_primitive
+{
+/// A plain buffer seen as an iterator, every BufferView argument of a device algorithm goes
+/// through it so buffers and fancy iterators share one kernel path
+template <typename T>
+class BufferIterator
+{
+  public:
+    using value_type  = T;
+    using kernel_args = std::tuple<luisa::compute::Buffer<T>>;
+
+    struct DeviceIterator
+    {
+        const luisa::compute::BufferVar<T>& m_buffer;
+
+        luisa::compute::Var<T> read(const luisa::compute::UInt& index) const { return m_buffer.read(index); }
+        void write(const luisa::compute::UInt& index, const luisa::compute::Var<T>& value) const
+        {
+            m_buffer.write(index, value);
+        }
+    };
+
+    explicit BufferIterator(luisa::compute::BufferView<T> view) noexcept
+        : m_view(view)
+    {
+    }
+
+    auto host_args() const noexcept { return std::make_tuple(m_view); }
+
+    BufferIterator advance(size_t n) const noexcept
+    {
+        return BufferIterator{m_view.subview(n, m_view.size() - n)};
+    }
+
+    template <typename ArgTuple>
+    DeviceIterator make_device(const ArgTuple& args) const noexcept
+    {
+        return DeviceIterator{std::get<0>(args)};
+    }
+
+    static luisa::string description() noexcept
+    {
+        return "buffer<" + luisa::string{luisa::compute::Type::of<T>()->description()} + ">";
+    }
+
+    luisa::compute::BufferView<T> view() const noexcept { return m_view; }
+
+  private:
+    luisa::compute::BufferView<T> m_view;
+};
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,55 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-19 11:02:50
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-19 11:20:41
+ */
+
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/iterator/iterator_base.h>
+
+namespace luisa::parallel_primitive
+{
+/// Every item is the same value, passed as a kernel argument so changing it does not recompile
+template <NumericT T>
+class ConstantIterator
+{
+  public:
+    using value_type  = T;
+    using kernel_args = std::tuple<T>;
+
+    struct DeviceIterator
+    {
+        const luisa::compute::Var<T>& m_value;
+
+        luisa::compute::Var<T> read(const luisa::compute::UInt&) const { return m_value; }
+    };
+
+    explicit ConstantIterator(T value) noexcept
+        : m_value(value)
+    {
+    }
+
+    auto host_args() const noexcept { return std::make_tuple(m_value); }
+
+    ConstantIterator advance(size_t) const noexcept { return *this; }
+
+    template <typename ArgTuple>
+    DeviceIterator make_device(const ArgTuple& args) const noexcept
+    {
+        return DeviceIterator{std::get<0>(args)};
+    }
+
+    static luisa::string description() noexcept
+    {
+        return "constant<" + luisa::string{luisa::compute::Type::of<T>()->description()} + ">";
+    }
+
+  private:
+    T m_value;
+};
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,59 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-19 10:48:12
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-19 11:20:37
+ */
+
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <lcpp/common/type_trait.h>
+#include <lcpp/iterator/iterator_base.h>
+
+namespace luisa::parallel_primitive
+{
+/// Item i is base + i, computed in the kernel, e.g. the indices of ArgMin / ArgMax
+template <NumericT T>
+class CountingIterator
+{
+  public:
+    using value_type  = T;
+    using kernel_args = std::tuple<T>;
+
+    struct DeviceIterator
+    {
+        const luisa::compute::Var<T>& m_base;
+
+        luisa::compute::Var<T> read(const luisa::compute::UInt& index) const
+        {
+            return m_base + luisa::compute::cast<T>(index);
+        }
+    };
+
+    explicit CountingIterator(T base = T(0)) noexcept
+        : m_base(base)
+    {
+    }
+
+    auto host_args() const noexcept { return std::make_tuple(m_base); }
+
+    CountingIterator advance(size_t n) const noexcept { return CountingIterator{static_cast<T>(m_base + n)}; }
+
+    template <typename ArgTuple>
+    DeviceIterator make_device(const ArgTuple& args) const noexcept
+    {
+        return DeviceIterator{std::get<0>(args)};
+    }
+
+    static luisa::string description() noexcept
+    {
+        return "counting<" + luisa::string{luisa::compute::Type::of<T>()->description()} + ">";
+    }
+
+  private:
+    T m_base;
+};
+}  // namespace luisa::parallel_primitive
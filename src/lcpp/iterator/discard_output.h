@@ -0,0 +1,41 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-19 12:20:15
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-19 12:31:48
+ */
+
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <luisa/dsl/var.h>
+#include <lcpp/iterator/iterator_base.h>
+
+namespace luisa::parallel_primitive
+{
+/// An output nobody reads: the writes compile to nothing and no buffer is bound
+template <typename T>
+class DiscardOutput
+{
+  public:
+    using value_type  = T;
+    using kernel_args = std::tuple<>;
+
+    struct DeviceIterator
+    {
+        void write(const luisa::compute::UInt&, const luisa::compute::Var<T>&) const {}
+    };
+
+    auto host_args() const noexcept { return std::tuple<>{}; }
+
+    DiscardOutput advance(size_t) const noexcept { return *this; }
+
+    template <typename ArgTuple>
+    DeviceIterator make_device(const ArgTuple&) const noexcept
+    {
+        return DeviceIterator{};
+    }
+
+    static luisa::string description() noexcept { return "discard"; }
+};
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,90 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-19 10:21:08
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-24 11:18:09
+ */
+
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/resource.h>
+#include <luisa/runtime/shader.h>
+#include <luisa/runtime/command_list.h>
+#include <lcpp/runtime/core.h>
+
+namespace luisa::parallel_primitive
+{
+// A fancy iterator is a host object describing how item i is produced (or consumed) inside a
+// kernel, so nothing is materialized in a buffer:
+//   value_type          the item type
+//   kernel_args         std::tuple of the extra kernel argument types, e.g. Buffer<T> or T
+//   host_args()         the matching tuple of BufferViews / values bound at dispatch
+//   advance(n)          the same iterator starting n items later
+//   description()       stable name of the iterator in kernel identities, empty when one of its
+//                       parts has none (see kernel_name_of)
+//   make_device(args)   the DeviceIterator read (or written) by the kernel, built from its arguments
+template <typename It>
+concept IteratorT = requires(const It& it, size_t n) {
+    typename It::value_type;
+    typename It::kernel_args;
+    typename It::DeviceIterator;
+    it.host_args();
+    { it.advance(n) } -> std::same_as<It>;
+    It::description();
+};
+
+namespace details
+{
+    using namespace luisa::compute;
+
+    template <typename Args, typename... Leading>
+    struct shader_with_args;
+
+    template <typename... Args, typename... Leading>
+    struct shader_with_args<std::tuple<Args...>, Leading...>
+    {
+        using type = Shader<1, Leading..., Args...>;
+    };
+
+    /// Shader<1, Leading..., Args...>: iterator arguments always trail the fixed ones
+    template <typename Args, typename... Leading>
+    using shader_with_args_t = typename shader_with_args<Args, Leading...>::type;
+
+    template <typename... Tuples>
+    using tuple_cat_t = decltype(std::tuple_cat(std::declval<Tuples>()...));
+
+    /// Null pointer whose type carries the kernel arguments, lets a compile function expand
+    /// them as a parameter pack of its kernel lambda
+    template <typename Args>
+    constexpr Args* kernel_args_tag() noexcept
+    {
+        return nullptr;
+    }
+
+    /// References to Count arguments starting at Offset, splits the arguments of a composite iterator
+    template <size_t Offset, size_t Count, typename ArgTuple>
+    auto tuple_slice(const ArgTuple& args) noexcept
+    {
+        return [&]<size_t... I>(std::index_sequence<I...>)
+        {
+            return std::forward_as_tuple(std::get<Offset + I>(args)...);
+        }(std::make_index_sequence<Count>{});
+    }
+
+    /// Records shader(args..., iterator_args...) with the host arguments of the iterators appended
+    template <typename ShaderT, typename ArgTuple, typename... Args>
+    void dispatch_with_iterator_args(CommandList&    cmdlist,
+                                     ShaderT&        shader,
+                                     uint            dispatch_size,
+                                     const ArgTuple& iterator_args,
+                                     const Args&... args)
+    {
+        std::apply([&](const auto&... it_args) { cmdlist << shader(args..., it_args...).dispatch(dispatch_size); },
+                   iterator_args);
+    }
+}  // namespace details
+}  // namespace luisa::parallel_primitive
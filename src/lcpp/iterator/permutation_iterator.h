@@ -0,0 +1,68 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-19 12:06:33
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-24 11:18:09
+ */
+
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/builtin.h>
+#include <lcpp/iterator/iterator_base.h>
+
+namespace luisa::parallel_primitive
+{
+/// Item i is value_it[index_it[i]], a gather fused into the load instead of a gathered copy
+template <IteratorT ValueIt, IteratorT IndexIt>
+class PermutationIterator
+{
+  public:
+    using value_type  = typename ValueIt::value_type;
+    using kernel_args = details::tuple_cat_t<typename ValueIt::kernel_args, typename IndexIt::kernel_args>;
+
+    struct DeviceIterator
+    {
+        typename ValueIt::DeviceIterator m_value_it;
+        typename IndexIt::DeviceIterator m_index_it;
+
+        luisa::compute::Var<value_type> read(const luisa::compute::UInt& index) const
+        {
+            return m_value_it.read(luisa::compute::cast<luisa::uint>(m_index_it.read(index)));
+        }
+    };
+
+    PermutationIterator(ValueIt value_it, IndexIt index_it) noexcept
+        : m_value_it(value_it)
+        , m_index_it(index_it)
+    {
+    }
+
+    auto host_args() const noexcept { return std::tuple_cat(m_value_it.host_args(), m_index_it.host_args()); }
+
+    // only the indices move, they still address the whole of value_it
+    PermutationIterator advance(size_t n) const noexcept
+    {
+        return PermutationIterator{m_value_it, m_index_it.advance(n)};
+    }
+
+    template <typename ArgTuple>
+    DeviceIterator make_device(const ArgTuple& args) const noexcept
+    {
+        constexpr size_t VALUE_ARGS = std::tuple_size_v<typename ValueIt::kernel_args>;
+        constexpr size_t INDEX_ARGS = std::tuple_size_v<typename IndexIt::kernel_args>;
+        return DeviceIterator{m_value_it.make_device(details::tuple_slice<0, VALUE_ARGS>(args)),
+                              m_index_it.make_device(details::tuple_slice<VALUE_ARGS, INDEX_ARGS>(args))};
+    }
+
+    static luisa::string description() noexcept
+    {
+        return make_kernel_name<ValueIt, IndexIt>("permutation");
+    }
+
+  private:
+    ValueIt m_value_it;
+    IndexIt m_index_it;
+};
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,67 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-19 11:24:06
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-24 11:18:09
+ */
+
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <luisa/dsl/var.h>
+#include <luisa/dsl/expr_traits.h>
+#include <lcpp/iterator/iterator_base.h>
+
+namespace luisa::parallel_primitive
+{
+/// Item i is transform_op(it[i]), the op is compiled into the kernel that reads the item
+template <IteratorT InputIt, typename TransformOp>
+class TransformIterator
+{
+  public:
+    using value_type = luisa::compute::expr_value_t<
+        std::invoke_result_t<const TransformOp&, const luisa::compute::Var<typename InputIt::value_type>&>>;
+    using kernel_args = typename InputIt::kernel_args;
+
+    struct DeviceIterator
+    {
+        typename InputIt::DeviceIterator m_it;
+        TransformOp                      m_transform_op;
+
+        luisa::compute::Var<value_type> read(const luisa::compute::UInt& index) const
+        {
+            return m_transform_op(m_it.read(index));
+        }
+    };
+
+    TransformIterator(InputIt it, TransformOp transform_op) noexcept
+        : m_it(it)
+        , m_transform_op(transform_op)
+    {
+    }
+
+    auto host_args() const noexcept { return m_it.host_args(); }
+
+    TransformIterator advance(size_t n) const noexcept
+    {
+        return TransformIterator{m_it.advance(n), m_transform_op};
+    }
+
+    // the op is captured when the kernel is compiled, like the reduce and scan ops
+    template <typename ArgTuple>
+    DeviceIterator make_device(const ArgTuple& args) const noexcept
+    {
+        return DeviceIterator{m_it.make_device(args), m_transform_op};
+    }
+
+    static luisa::string description() noexcept
+    {
+        // empty unless the op has a stable kernel_name, e.g. a lambda
+        return make_kernel_name<InputIt, TransformOp>("transform");
+    }
+
+  private:
+    InputIt     m_it;
+    TransformOp m_transform_op;
+};
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,68 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-19 11:41:27
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-24 11:18:09
+ */
+
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <luisa/dsl/var.h>
+#include <lcpp/common/util_type.h>
+#include <lcpp/iterator/iterator_base.h>
+
+namespace luisa::parallel_primitive
+{
+/// Item i is the KeyValuePair {key_it[i], value_it[i]}, e.g. CountingIterator zipped with the
+/// data gives the IndexValuePairT items of ArgMin / ArgMax without building them in memory
+template <IteratorT KeyIt, IteratorT ValueIt>
+class ZipIterator
+{
+  public:
+    using value_type  = KeyValuePair<typename KeyIt::value_type, typename ValueIt::value_type>;
+    using kernel_args = details::tuple_cat_t<typename KeyIt::kernel_args, typename ValueIt::kernel_args>;
+
+    struct DeviceIterator
+    {
+        typename KeyIt::DeviceIterator   m_key_it;
+        typename ValueIt::DeviceIterator m_value_it;
+
+        luisa::compute::Var<value_type> read(const luisa::compute::UInt& index) const
+        {
+            luisa::compute::Var<value_type> item;
+            item.key   = m_key_it.read(index);
+            item.value = m_value_it.read(index);
+            return item;
+        }
+    };
+
+    ZipIterator(KeyIt key_it, ValueIt value_it) noexcept
+        : m_key_it(key_it)
+        , m_value_it(value_it)
+    {
+    }
+
+    auto host_args() const noexcept { return std::tuple_cat(m_key_it.host_args(), m_value_it.host_args()); }
+
+    ZipIterator advance(size_t n) const noexcept { return ZipIterator{m_key_it.advance(n), m_value_it.advance(n)}; }
+
+    template <typename ArgTuple>
+    DeviceIterator make_device(const ArgTuple& args) const noexcept
+    {
+        constexpr size_t KEY_ARGS   = std::tuple_size_v<typename KeyIt::kernel_args>;
+        constexpr size_t VALUE_ARGS = std::tuple_size_v<typename ValueIt::kernel_args>;
+        return DeviceIterator{m_key_it.make_device(details::tuple_slice<0, KEY_ARGS>(args)),
+                              m_value_it.make_device(details::tuple_slice<KEY_ARGS, VALUE_ARGS>(args))};
+    }
+
+    static luisa::string description() noexcept
+    {
+        return make_kernel_name<KeyIt, ValueIt>("zip");
+    }
+
+  private:
+    KeyIt   m_key_it;
+    ValueIt m_value_it;
+};
+}  // namespace luisa::parallel_primitive
@@ -2,7 +2,7 @@
  * @Author: Ligo 
  * @Date: 2025-09-19 16:05:47 
  * @Last Modified by: Ligo
- * @Last Modified time: 2026-02-06 15:37:20
+ * @Last Modified time: 2026-02-27 15:48:33
  */
 #pragma once
 //common
@@ -11,6 +11,15 @@
 #include <lcpp/common/utils.h>
 #include <lcpp/common/thread_operators.h>
 #include <lcpp/common/grid_even_shared.h>
+// iterator
+#include <lcpp/iterator/iterator_base.h>
+#include <lcpp/iterator/buffer_iterator.h>
+#include <lcpp/iterator/counting_iterator.h>
+#include <lcpp/iterator/constant_iterator.h>
+#include <lcpp/iterator/transform_iterator.h>
+#include <lcpp/iterator/zip_iterator.h>
+#include <lcpp/iterator/permutation_iterator.h>
+#include <lcpp/iterator/discard_output.h>
 // thread level
 #include <lcpp/thread/thread_reduce.h>
 #include <lcpp/thread/thread_scan.h>
@@ -25,10 +34,20 @@
 #include <lcpp/block/block_store.h>
 #include <lcpp/block/block_radix_rank.h>
 #include <lcpp/block/block_discontinuity.h>
+#include <lcpp/block/block_merge_sort.h>
 // device level
 #include <lcpp/device/device_for.h>
 #include <lcpp/device/device_histogram.h>
+#include <lcpp/device/device_merge_sort.h>
+#include <lcpp/device/device_segmented_radix_sort.h>
+#include <lcpp/device/device_topk.h>
+#include <lcpp/device/device_partition.h>
 #include <lcpp/device/device_radix_sort.h>
 #include <lcpp/device/device_reduce.h>
+#include <lcpp/device/device_run_length_encode.h>
 #include <lcpp/device/device_scan.h>
-#include <lcpp/device/device_segment_reduce.h>
\ No newline at end of file
+#include <lcpp/device/device_segment_reduce.h>
+#include <lcpp/device/device_select.h>
+
+// runtime
+#include <lcpp/runtime/temp_storage_planner.h>
\ No newline at end of file
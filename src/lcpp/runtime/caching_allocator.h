@@ -0,0 +1,278 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-26 09:52:31
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-05 14:06:12
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/core/stl/vector.h>
+#include <luisa/runtime/buffer.h>
+#include <luisa/runtime/device.h>
+#include <luisa/runtime/stream.h>
+
+namespace luisa::parallel_primitive
+{
+/// Device temp storage cached in geometric size classes (bin_growth^bin bytes), CUB's
+/// CachingDeviceAllocator on LC buffers.
+/// Stream ordered: a freed block is reused right away by later commands on the stream it was
+/// allocated for, other streams take it once that stream went through synchronize(). Cached
+/// blocks beyond max_cached_bytes are released as soon as no stream uses them; requests above
+/// the largest bin get a block of their own that is never cached
+class CachingAllocator
+{
+    using Buffer     = luisa::compute::Buffer<uint>;
+    using BufferView = luisa::compute::BufferView<uint>;
+
+    static constexpr uint64_t IDLE = ~uint64_t{0};
+
+    struct Block
+    {
+        Buffer   buffer;
+        size_t   bytes  = 0;
+        uint     bin    = 0;  // INVALID_BIN when the block is not cached
+        uint64_t stream = IDLE;
+    };
+
+  public:
+    static constexpr uint   INVALID_BIN              = ~0u;
+    static constexpr uint   DEFAULT_BIN_GROWTH       = 2;
+    static constexpr uint   DEFAULT_MIN_BIN          = 12;  // 4 KiB
+    static constexpr uint   DEFAULT_MAX_BIN          = 30;  // 1 GiB
+    static constexpr size_t DEFAULT_MAX_CACHED_BYTES = size_t{1} << 30;  // the high-water-mark cap
+
+    /// Temp storage of one call, handed back to its allocator when it goes out of scope. The
+    /// commands using it have to be committed to the stream it was allocated for
+    class TempStorage
+    {
+      public:
+        TempStorage() = default;
+        TempStorage(TempStorage&& other) noexcept
+            : m_allocator{std::exchange(other.m_allocator, nullptr)}
+            , m_handle{other.m_handle}
+            , m_view{other.m_view}
+        {
+        }
+        TempStorage& operator=(TempStorage&& other) noexcept
+        {
+            if(this != &other)
+            {
+                reset();
+                m_allocator = std::exchange(other.m_allocator, nullptr);
+                m_handle    = other.m_handle;
+                m_view      = other.m_view;
+            }
+            return *this;
+        }
+        ~TempStorage() noexcept { reset(); }
+
+        [[nodiscard]] BufferView view() const noexcept { return m_view; }
+
+        void reset() noexcept
+        {
+            if(m_allocator) { std::exchange(m_allocator, nullptr)->free(m_handle); }
+        }
+
+      private:
+        friend class CachingAllocator;
+        TempStorage(CachingAllocator* allocator, uint64_t handle, BufferView view) noexcept
+            : m_allocator{allocator}
+            , m_handle{handle}
+            , m_view{view}
+        {
+        }
+
+        CachingAllocator* m_allocator = nullptr;
+        uint64_t          m_handle    = 0;
+        BufferView        m_view;
+    };
+
+    explicit CachingAllocator(luisa::compute::Device& device,
+                              uint                    bin_growth       = DEFAULT_BIN_GROWTH,
+                              uint                    min_bin          = DEFAULT_MIN_BIN,
+                              uint                    max_bin          = DEFAULT_MAX_BIN,
+                              size_t                  max_cached_bytes = DEFAULT_MAX_CACHED_BYTES) noexcept
+        : m_device{device}
+        , m_bin_growth{bin_growth}
+        , m_min_bin{min_bin}
+        , m_max_bin{max_bin}
+        , m_max_cached_bytes{max_cached_bytes}
+    {
+        LUISA_ASSERT(bin_growth >= 2 && min_bin <= max_bin, "CachingAllocator: invalid bins");
+    }
+
+    CachingAllocator(const CachingAllocator&)            = delete;
+    CachingAllocator& operator=(const CachingAllocator&) = delete;
+
+    /// Every stream that used the allocator has to be synchronized before it is destroyed
+    ~CachingAllocator() noexcept
+    {
+        LUISA_ASSERT(m_live.empty(), "CachingAllocator: {} temp storages outlive their allocator", m_live.size());
+    }
+
+    /// At least bytes of temp storage for commands committed to stream, a cached block of the
+    /// same bin when one is free for stream, a new buffer otherwise
+    [[nodiscard]] TempStorage allocate(const luisa::compute::Stream& stream, size_t bytes)
+    {
+        const uint64_t stream_handle = stream.handle();
+        const size_t   uint_count    = std::max<size_t>((bytes + sizeof(uint) - 1) / sizeof(uint), 1);
+        const uint     bin           = bin_of(uint_count * sizeof(uint));
+
+        std::lock_guard lock{m_mutex};
+        Block           block;
+        if(auto cached = find_cached(bin, stream_handle); cached != m_cached.end())
+        {
+            block = std::move(*cached);
+            m_cached.erase(cached);
+            m_cached_bytes -= block.bytes;
+        }
+        else
+        {
+            block.bin   = bin;
+            block.bytes = bin == INVALID_BIN ? uint_count * sizeof(uint) : round_up_to_uint(bin_bytes(bin));
+            // over the cap, just enough idle cached blocks of other bins make room for the new one
+            const size_t needed_bytes = m_live_bytes + block.bytes;
+            if(m_cached_bytes + needed_bytes > m_max_cached_bytes)
+            {
+                trim(m_max_cached_bytes > needed_bytes ? m_max_cached_bytes - needed_bytes : 0);
+            }
+            block.buffer = m_device.create_buffer<uint>(block.bytes / sizeof(uint));
+        }
+        block.stream = stream_handle;
+
+        const uint64_t handle = block.buffer.handle();
+        BufferView     view   = block.buffer.view(0, uint_count);
+        m_live_bytes += block.bytes;
+        m_high_water_mark = std::max(m_high_water_mark, m_live_bytes + m_cached_bytes);
+        m_live.emplace(handle, std::move(block));
+        return TempStorage{this, handle, view};
+    }
+
+    /// Waits for stream, then every block freed on it is reusable by any stream and the cache
+    /// shrinks back to max_cached_bytes
+    void synchronize(luisa::compute::Stream& stream)
+    {
+        stream << luisa::compute::synchronize();
+
+        std::lock_guard lock{m_mutex};
+        for(auto& block : m_cached)
+        {
+            if(block.stream == stream.handle()) { block.stream = IDLE; }
+        }
+        m_retired.erase(std::remove_if(m_retired.begin(),
+                                       m_retired.end(),
+                                       [&](const Block& block) { return block.stream == stream.handle(); }),
+                        m_retired.end());
+        trim(m_max_cached_bytes);
+    }
+
+    /// Releases every cached block no stream is still using
+    void free_all_cached()
+    {
+        std::lock_guard lock{m_mutex};
+        trim(0);
+    }
+
+    [[nodiscard]] size_t live_bytes() const noexcept
+    {
+        std::lock_guard lock{m_mutex};
+        return m_live_bytes;
+    }
+
+    [[nodiscard]] size_t cached_bytes() const noexcept
+    {
+        std::lock_guard lock{m_mutex};
+        return m_cached_bytes;
+    }
+
+    /// Most bytes held at once, live and cached
+    [[nodiscard]] size_t high_water_mark() const noexcept
+    {
+        std::lock_guard lock{m_mutex};
+        return m_high_water_mark;
+    }
+
+  private:
+    [[nodiscard]] size_t bin_bytes(uint bin) const noexcept
+    {
+        size_t bytes = 1;
+        for(uint i = 0; i < bin; ++i) { bytes *= m_bin_growth; }
+        return bytes;
+    }
+
+    [[nodiscard]] static size_t round_up_to_uint(size_t bytes) noexcept
+    {
+        return (bytes + sizeof(uint) - 1) / sizeof(uint) * sizeof(uint);
+    }
+
+    // smallest bin holding bytes, INVALID_BIN above the largest one
+    [[nodiscard]] uint bin_of(size_t bytes) const noexcept
+    {
+        for(uint bin = m_min_bin; bin <= m_max_bin; ++bin)
+        {
+            if(bin_bytes(bin) >= bytes) { return bin; }
+        }
+        return INVALID_BIN;
+    }
+
+    [[nodiscard]] luisa::vector<Block>::iterator find_cached(uint bin, uint64_t stream_handle) noexcept
+    {
+        if(bin == INVALID_BIN) { return m_cached.end(); }
+        return std::find_if(m_cached.begin(),
+                            m_cached.end(),
+                            [&](const Block& block)
+                            { return block.bin == bin && (block.stream == stream_handle || block.stream == IDLE); });
+    }
+
+    void free(uint64_t handle) noexcept
+    {
+        std::lock_guard lock{m_mutex};
+        auto            iter = m_live.find(handle);
+        LUISA_ASSERT(iter != m_live.end(), "CachingAllocator: freeing an unknown block");
+        Block block = std::move(iter->second);
+        m_live.erase(iter);
+        m_live_bytes -= block.bytes;
+
+        // commands on block.stream may still read it, only that stream may take it until it is synchronized
+        if(block.bin == INVALID_BIN)
+        {
+            m_retired.emplace_back(std::move(block));
+            return;
+        }
+        m_cached_bytes += block.bytes;
+        m_cached.emplace_back(std::move(block));
+    }
+
+    // largest idle blocks first until at most max_bytes are cached
+    void trim(size_t max_bytes) noexcept
+    {
+        std::sort(m_cached.begin(), m_cached.end(), [](const Block& a, const Block& b) { return a.bytes < b.bytes; });
+        for(auto i = m_cached.size(); i > 0 && m_cached_bytes > max_bytes; --i)
+        {
+            if(m_cached[i - 1].stream != IDLE) { continue; }
+            m_cached_bytes -= m_cached[i - 1].bytes;
+            m_cached.erase(m_cached.begin() + (i - 1));
+        }
+    }
+
+    luisa::compute::Device                m_device;
+    uint                                  m_bin_growth;
+    uint                                  m_min_bin;
+    uint                                  m_max_bin;
+    size_t                                m_max_cached_bytes;
+    luisa::vector<Block>                  m_cached;
+    luisa::vector<Block>                  m_retired;
+    luisa::unordered_map<uint64_t, Block> m_live;
+    size_t                                m_live_bytes      = 0;
+    size_t                                m_cached_bytes    = 0;
+    size_t                                m_high_water_mark = 0;
+    mutable std::mutex                    m_mutex;
+};
+}  // namespace luisa::parallel_primitive
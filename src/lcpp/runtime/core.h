@@ -11,6 +11,7 @@
 #include <luisa/dsl/builtin.h>
 #include <luisa/dsl/var.h>
 #include <lcpp/common/type_trait.h>
+#include <lcpp/runtime/kernel_identity.h>
 
 namespace luisa::parallel_primitive
 {
@@ -45,6 +46,23 @@ inline void lazy_compile(luisa::compute::Device&                device,
     using S = luisa::compute::Shader<I, Args...>;
     if(!ushader)
     {
+        // inside ShaderCache::get_or_compile the shader gets its stable name, so the backend can
+        // load it from its shader cache directory after a restart
+        auto& cache_name = details::current_kernel_cache_name();
+        if(option.name.empty() && !cache_name.empty())
+        {
+            // the IR hash keeps a binary built from another version of the kernel from being
+            // loaded under the same name; debug info and fast math give another binary as well
+            luisa::compute::Kernel<I, Args...> kernel{std::forward<F>(func)};
+            auto named_option = option;
+            named_option.name = luisa::format("{}_{:016x}{}{}",
+                                              cache_name,
+                                              kernel.function()->hash(),
+                                              option.enable_debug_info ? "_g" : "",
+                                              option.enable_fast_math ? "_f" : "");
+            ushader = luisa::make_unique<S>(device.compile(kernel, named_option));
+            return;
+        }
         ushader = luisa::make_unique<S>(device.compile<I>(std::forward<F>(func), option));
     }
 }
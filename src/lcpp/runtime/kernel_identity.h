@@ -0,0 +1,167 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-24 09:41:26
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-05 09:48:31
+ */
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/stl/format.h>
+#include <luisa/core/stl/string.h>
+#include <luisa/ast/type.h>
+#include <luisa/runtime/buffer.h>
+#include <luisa/runtime/byte_buffer.h>
+#include <luisa/runtime/shader.h>
+#include <lcpp/common/util_type.h>
+
+namespace luisa::parallel_primitive
+{
+/// Part of every persisted kernel name. Keep in step with set_version in xmake.lua; binaries of
+/// a kernel whose IR changed are told apart by the IR hash lazy_compile appends either way
+inline constexpr luisa::string_view LCPP_VERSION = "0.0.1";
+
+template <typename T>
+luisa::string kernel_name_of() noexcept;
+
+/// "tag<Ts...,values...>", or empty as soon as one of Ts has no stable name
+template <typename... Ts, typename... Values>
+luisa::string make_kernel_name(luisa::string_view tag, Values... values) noexcept
+{
+    static_assert((std::is_integral_v<Values> && ...), "make_kernel_name: values must be integral");
+
+    std::array<luisa::string, sizeof...(Ts)> type_names{kernel_name_of<Ts>()...};
+    if(std::ranges::any_of(type_names, [](const luisa::string& name) { return name.empty(); }))
+    {
+        return {};
+    }
+
+    luisa::string name{tag};
+    name.push_back('<');
+    for(auto& type_name : type_names) { name.append(type_name).push_back(','); }
+    ((name.append(luisa::format("{}", values)).push_back(',')), ...);
+    if(name.back() == ',') { name.pop_back(); }
+    name.push_back('>');
+    return name;
+}
+
+namespace details
+{
+    // types that cannot carry a kernel_name() of their own
+    template <typename T>
+    struct KernelName
+    {
+        static luisa::string get() noexcept { return {}; }
+    };
+
+    template <typename K, typename V>
+    struct KernelName<KeyValuePair<K, V>>
+    {
+        static luisa::string get() noexcept { return make_kernel_name<K, V>("pair"); }
+    };
+
+    template <typename T, T VALUE>
+    struct KernelName<std::integral_constant<T, VALUE>>
+    {
+        static luisa::string get() noexcept
+        {
+            if constexpr(std::is_enum_v<T>) { return make_kernel_name("enum", static_cast<std::underlying_type_t<T>>(VALUE)); }
+            else { return make_kernel_name<T>("constant", VALUE); }
+        }
+    };
+
+    template <typename T>
+    struct KernelName<luisa::compute::Buffer<T>>
+    {
+        static luisa::string get() noexcept { return make_kernel_name<T>("buffer"); }
+    };
+
+    template <>
+    struct KernelName<luisa::compute::ByteBuffer>
+    {
+        static luisa::string get() noexcept { return "byte_buffer"; }
+    };
+
+    template <size_t DIMENSION, typename... Args>
+    struct KernelName<luisa::compute::Shader<DIMENSION, Args...>>
+    {
+        static luisa::string get() noexcept { return make_kernel_name<Args...>("shader", DIMENSION); }
+    };
+
+    inline luisa::string& current_kernel_cache_name() noexcept
+    {
+        static thread_local luisa::string name;
+        return name;
+    }
+
+    // FNV-1a, the same bits on every compiler, platform and run
+    [[nodiscard]] inline uint64_t stable_hash(luisa::string_view text) noexcept
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for(auto c : text)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+}  // namespace details
+
+/// Name of T that stays the same across builds and compilers: T::kernel_name() when T defines it
+/// (built-in ops and modules do, user ops may), the description of a fancy iterator, the LC type
+/// description of scalars and vectors. Empty for anything else, e.g. a lambda
+template <typename T>
+luisa::string kernel_name_of() noexcept
+{
+    if constexpr(requires { T::kernel_name(); }) { return luisa::string{T::kernel_name()}; }
+    else if constexpr(requires { T::description(); }) { return luisa::string{T::description()}; }
+    else if constexpr(luisa::is_basic_v<T>)
+    {
+        return luisa::string{luisa::compute::Type::of<T>()->description()};
+    }
+    else { return details::KernelName<T>::get(); }
+}
+
+/// Identity of the kernel KernelKey<ShaderT, KeyTs...> builds inside a Device module named owner:
+/// library version, the module policy, the shader signature, element types, iterators and ops.
+/// Empty when one of them has no stable name, the kernel is then only cached by its IR hash
+template <typename ShaderT, typename... KeyTs>
+luisa::string kernel_identity(luisa::string_view owner) noexcept
+{
+    auto kernel = make_kernel_name<ShaderT, KeyTs...>("kernel");
+    if(owner.empty() || kernel.empty()) { return {}; }
+    return luisa::format("lcpp-{}/{}/{}", LCPP_VERSION, owner, kernel);
+}
+
+/// Short file-safe name the backend stores the compiled shader under in its cache directory,
+/// lazy_compile adds the hash of the traced IR to it
+template <typename ShaderT, typename... KeyTs>
+luisa::string kernel_cache_name(luisa::string_view owner) noexcept
+{
+    auto identity = kernel_identity<ShaderT, KeyTs...>(owner);
+    if(identity.empty()) { return {}; }
+    return luisa::format("lcpp_{:016x}", details::stable_hash(identity));
+}
+
+/// While alive, shaders compiled on this thread by lazy_compile without a name of their own are
+/// cached on disk under name. Nests, the previous name comes back on exit
+class KernelCacheNameScope
+{
+  public:
+    explicit KernelCacheNameScope(luisa::string name) noexcept
+        : m_previous{std::exchange(details::current_kernel_cache_name(), std::move(name))}
+    {
+    }
+    KernelCacheNameScope(const KernelCacheNameScope&)            = delete;
+    KernelCacheNameScope& operator=(const KernelCacheNameScope&) = delete;
+    ~KernelCacheNameScope() noexcept { details::current_kernel_cache_name() = std::move(m_previous); }
+
+  private:
+    luisa::string m_previous;
+};
+}  // namespace luisa::parallel_primitive
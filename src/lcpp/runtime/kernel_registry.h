@@ -0,0 +1,123 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-25 10:16:40
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-05 11:20:54
+ */
+
+#pragma once
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <utility>
+#include <luisa/core/stl/format.h>
+#include <luisa/core/stl/memory.h>
+#include <luisa/core/stl/string.h>
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/runtime/device.h>
+#include <luisa/runtime/rhi/resource.h>
+
+namespace luisa::parallel_primitive
+{
+/// Shaders compiled by every Device module of the process, keyed by device, owner (the module
+/// and its policy) and kernel key slot: all instances of one configuration share a kernel, it is
+/// compiled once per process and the other callers wait for it.
+/// Shaders stay registered, and keep their device alive, until release() or clear()
+class KernelRegistry
+{
+    using SharedShader = luisa::shared_ptr<luisa::compute::Resource>;
+
+  public:
+    KernelRegistry(const KernelRegistry&)            = delete;
+    KernelRegistry& operator=(const KernelRegistry&) = delete;
+
+    [[nodiscard]] static KernelRegistry& instance() noexcept
+    {
+        static KernelRegistry registry;
+        return registry;
+    }
+
+    /// The shader registered for (device, owner, slot), compiled by compile() on the first call;
+    /// nullptr when compile() fails and rethrown when it throws, the next caller tries again
+    template <typename CompileF>
+    [[nodiscard]] SharedShader get_or_compile(const luisa::compute::DeviceInterface* device,
+                                              luisa::string_view                     owner,
+                                              size_t                                 slot,
+                                              CompileF&&                             compile)
+    {
+        auto key = make_key(device, owner, slot);
+
+        std::promise<SharedShader> compiled;
+        {
+            std::unique_lock lock{m_mutex};
+            if(auto iter = m_shaders.find(key); iter != m_shaders.end())
+            {
+                auto shader = iter->second;
+                lock.unlock();
+                return shader.get();
+            }
+            m_shaders.emplace(key, compiled.get_future().share());
+        }
+
+        // compiled outside the lock, other kernels keep going while this one builds
+        SharedShader shader;
+        try
+        {
+            shader = std::forward<CompileF>(compile)();
+        }
+        catch(...)
+        {
+            // waiting callers see the exception, the next caller tries again
+            {
+                std::lock_guard lock{m_mutex};
+                m_shaders.erase(key);
+            }
+            compiled.set_exception(std::current_exception());
+            throw;
+        }
+        if(!shader)
+        {
+            std::lock_guard lock{m_mutex};
+            m_shaders.erase(key);
+        }
+        compiled.set_value(shader);
+        return shader;
+    }
+
+    /// Drops the shaders of device, modules that use them keep their own reference
+    void release(const luisa::compute::Device& device) noexcept
+    {
+        auto            prefix = luisa::format("{}/", static_cast<const void*>(device.impl()));
+        std::lock_guard lock{m_mutex};
+        for(auto iter = m_shaders.begin(); iter != m_shaders.end();)
+        {
+            if(iter->first.starts_with(prefix)) { iter = m_shaders.erase(iter); }
+            else { ++iter; }
+        }
+    }
+
+    void clear() noexcept
+    {
+        std::lock_guard lock{m_mutex};
+        m_shaders.clear();
+    }
+
+    [[nodiscard]] size_t size() const noexcept
+    {
+        std::lock_guard lock{m_mutex};
+        return m_shaders.size();
+    }
+
+  private:
+    KernelRegistry() = default;
+
+    [[nodiscard]] static luisa::string make_key(const luisa::compute::DeviceInterface* device, luisa::string_view owner, size_t slot)
+    {
+        return luisa::format("{}/{}/{}", static_cast<const void*>(device), slot, owner);
+    }
+
+    luisa::unordered_map<luisa::string, std::shared_future<SharedShader>> m_shaders;
+    mutable std::mutex                                                    m_mutex;
+};
+}  // namespace luisa::parallel_primitive
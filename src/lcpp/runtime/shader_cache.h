@@ -0,0 +1,160 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-20 10:12:37
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-25 14:31:27
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/memory.h>
+#include <luisa/core/stl/string.h>
+#include <luisa/core/stl/vector.h>
+#include <luisa/runtime/rhi/resource.h>
+#include <lcpp/runtime/core.h>
+#include <lcpp/runtime/kernel_identity.h>
+#include <lcpp/runtime/kernel_registry.h>
+
+namespace luisa::parallel_primitive
+{
+/// Identity of a compiled kernel, made of types only: the shader signature, the module (element
+/// types, policy, iterators) and the ops. Ops are compiled in, so their type is their identity
+template <typename ShaderT, typename... KeyTs>
+struct KernelKey
+{
+};
+
+namespace details
+{
+    inline std::atomic<size_t>& kernel_slot_counter() noexcept
+    {
+        static std::atomic<size_t> counter{0};
+        return counter;
+    }
+
+    // every key type gets one dense index per process the first time it is looked up
+    template <typename Key>
+    inline size_t kernel_slot() noexcept
+    {
+        static const size_t slot = kernel_slot_counter().fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+}  // namespace details
+
+/// Compiled shaders of one Device module, indexed by the slot of their KernelKey: a hit is two
+/// loads, no key string is built and nothing is hashed, allocated or locked.
+/// Lookups may race with compiles from warmup threads: slots live in chunks that never move and
+/// are published with release stores, only inserting a compiled shader takes the mutex.
+/// A cache given its owner's name (the Device module and its policy) names every shader it
+/// compiles with kernel_cache_name, so the backend keeps them on disk across process restarts.
+/// Bound to a device, it takes its shaders from the KernelRegistry, shared by every cache of the
+/// same owner in the process
+class ShaderCache
+{
+    using SharedShader = luisa::shared_ptr<luisa::compute::Resource>;
+
+    static constexpr size_t SLOTS_PER_CHUNK = 64;
+    static constexpr size_t MAX_CHUNKS      = 64;
+
+    struct Chunk
+    {
+        std::array<std::atomic<luisa::compute::Resource*>, SLOTS_PER_CHUNK> shaders{};
+    };
+
+  public:
+    ShaderCache() = default;
+    explicit ShaderCache(luisa::string owner) noexcept
+        : m_owner{std::move(owner)}
+    {
+    }
+    ShaderCache(const ShaderCache&)            = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    /// Binding another device drops the shaders of the previous one
+    void bind(const luisa::compute::Device& device) noexcept
+    {
+        if(m_device && m_device != device.impl()) { clear(); }
+        m_device = device.impl();
+    }
+
+    /// Returns the shader of KernelKey<ShaderT, KeyTs...>, compiling it with compile() on the
+    /// first call; nullptr when compile() fails. Unbound or unnamed caches compile on their own,
+    /// threads missing the same slot may then compile it twice and the first one inserted wins
+    template <typename ShaderT, typename... KeyTs, typename CompileF>
+    [[nodiscard]] ShaderT* get_or_compile(CompileF&& compile)
+    {
+        const size_t slot = details::kernel_slot<KernelKey<ShaderT, KeyTs...>>();
+        if(auto shader = load(slot)) [[likely]]
+        {
+            return static_cast<ShaderT*>(shader);
+        }
+
+        // compiled outside the lock, warmup threads build different kernels side by side
+        auto compile_named = [&]() -> SharedShader
+        {
+            KernelCacheNameScope name_scope{kernel_cache_name<ShaderT, KeyTs...>(m_owner)};
+            return std::forward<CompileF>(compile)();
+        };
+        SharedShader shader = m_device && !m_owner.empty() ?
+                                  KernelRegistry::instance().get_or_compile(m_device, m_owner, slot, compile_named) :
+                                  compile_named();
+        if(!shader) { return nullptr; }
+        return static_cast<ShaderT*>(insert(slot, std::move(shader)));
+    }
+
+    template <typename ShaderT, typename... KeyTs>
+    [[nodiscard]] ShaderT* find() const noexcept
+    {
+        return static_cast<ShaderT*>(load(details::kernel_slot<KernelKey<ShaderT, KeyTs...>>()));
+    }
+
+    [[nodiscard]] luisa::string_view owner() const noexcept { return m_owner; }
+
+    /// Drops every shader, no lookup may be in flight
+    void clear() noexcept
+    {
+        std::lock_guard lock{m_mutex};
+        for(auto& chunk : m_chunks) { chunk.store(nullptr, std::memory_order_relaxed); }
+        m_owned_chunks.clear();
+        m_shaders.clear();
+    }
+
+  private:
+    [[nodiscard]] luisa::compute::Resource* load(size_t slot) const noexcept
+    {
+        if(slot >= SLOTS_PER_CHUNK * MAX_CHUNKS) { return nullptr; }
+        auto chunk = m_chunks[slot / SLOTS_PER_CHUNK].load(std::memory_order_acquire);
+        return chunk ? chunk->shaders[slot % SLOTS_PER_CHUNK].load(std::memory_order_acquire) : nullptr;
+    }
+
+    [[nodiscard]] luisa::compute::Resource* insert(size_t slot, SharedShader shader)
+    {
+        LUISA_ASSERT(slot < SLOTS_PER_CHUNK * MAX_CHUNKS, "ShaderCache: more than {} kernel keys", SLOTS_PER_CHUNK * MAX_CHUNKS);
+
+        std::lock_guard lock{m_mutex};
+        if(auto cached = load(slot)) { return cached; }
+
+        auto& chunk = m_chunks[slot / SLOTS_PER_CHUNK];
+        if(!chunk.load(std::memory_order_relaxed))
+        {
+            chunk.store(m_owned_chunks.emplace_back(luisa::make_unique<Chunk>()).get(), std::memory_order_release);
+        }
+        luisa::compute::Resource* resource = shader.get();
+        m_shaders.emplace_back(std::move(shader));
+        chunk.load(std::memory_order_relaxed)->shaders[slot % SLOTS_PER_CHUNK].store(resource, std::memory_order_release);
+        return resource;
+    }
+
+    luisa::string                                              m_owner;
+    const luisa::compute::DeviceInterface*                     m_device = nullptr;
+    std::array<std::atomic<Chunk*>, MAX_CHUNKS>                m_chunks{};
+    luisa::vector<U<Chunk>>                                    m_owned_chunks;
+    luisa::vector<SharedShader>                                m_shaders;
+    std::mutex                                                 m_mutex;
+};
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,164 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-27 10:21:07
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-27 15:48:33
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/vector.h>
+#include <luisa/runtime/buffer.h>
+#include <lcpp/common/utils.h>
+
+namespace luisa::parallel_primitive
+{
+/// Lays the temp storage of a chain of primitive calls out in one arena. Every request lives from
+/// its first to its last stage (both included); requests whose lifetimes do not overlap share
+/// bytes, so the arena is close to the largest stage instead of the sum of all of them.
+/// Intermediate buffers passed between stages can be planned the same way, e.g.
+///     TempStoragePlanner planner;
+///     auto sort_temp   = planner.add(DeviceRadixSort<>::GetSortKeysTempStorageBytes<uint>(n), 0);
+///     auto sorted_keys = planner.add<uint>(n, 0, 1);
+///     auto rle_temp    = planner.add(DeviceRunLengthEncode<>::GetTempStorageBytes(n), 1);
+///     auto arena       = device.create_buffer<uint>(planner.uint_count());
+///     radix_sort.SortKeys(cmdlist, planner.view(arena.view(), sort_temp), d_keys, planner.view<uint>(arena.view(), sorted_keys, n), n);
+class TempStoragePlanner
+{
+    struct Request
+    {
+        size_t bytes       = 0;
+        uint   first_stage = 0;
+        uint   last_stage  = 0;
+        size_t offset      = 0;
+    };
+
+  public:
+    using Slot = uint;
+
+    /// Offsets of every request, enough for any element type a primitive carves from its temp storage
+    static constexpr size_t ALIGN_BYTES = 256;
+
+    /// bytes needed from first_stage to last_stage
+    Slot add(size_t bytes, uint first_stage, uint last_stage)
+    {
+        LUISA_ASSERT(first_stage <= last_stage, "TempStoragePlanner: stage {} ends before it starts at {}", last_stage, first_stage);
+        // empty requests still get a valid one uint view, as from a temp buffer of GetTempStorageBytes() == 0
+        m_requests.push_back(Request{std::max(align_up_uint(bytes, sizeof(uint)), sizeof(uint)), first_stage, last_stage});
+        m_planned = false;
+        return static_cast<Slot>(m_requests.size() - 1);
+    }
+
+    /// bytes only needed during stage, e.g. the temp storage of a single call
+    Slot add(size_t bytes, uint stage) { return add(bytes, stage, stage); }
+
+    /// count items of T from first_stage to last_stage
+    template <typename T>
+    Slot add(size_t count, uint first_stage, uint last_stage)
+    {
+        return add(count * sizeof(T), first_stage, last_stage);
+    }
+
+    /// Arena bytes the requests fit in
+    [[nodiscard]] size_t bytes()
+    {
+        plan();
+        return m_bytes;
+    }
+
+    /// Arena size for create_buffer<uint>
+    [[nodiscard]] size_t uint_count() { return bytes_to_uint_count(bytes()); }
+
+    /// Bytes the same requests take back to back, for comparison
+    [[nodiscard]] size_t unaliased_bytes() const noexcept
+    {
+        return std::accumulate(m_requests.begin(),
+                               m_requests.end(),
+                               size_t{0},
+                               [](size_t total, const Request& request)
+                               { return align_up_uint(total, ALIGN_BYTES) + request.bytes; });
+    }
+
+    [[nodiscard]] size_t offset(Slot slot)
+    {
+        plan();
+        return m_requests[slot].offset;
+    }
+
+    /// The part of arena given to slot, arena holds at least uint_count() items
+    [[nodiscard]] luisa::compute::BufferView<uint> view(luisa::compute::BufferView<uint> arena, Slot slot)
+    {
+        plan();
+        LUISA_ASSERT(arena.size() >= bytes_to_uint_count(m_bytes), "TempStoragePlanner: arena of {} uints, {} planned", arena.size(), bytes_to_uint_count(m_bytes));
+        auto& request = m_requests[slot];
+        return arena.subview(request.offset / sizeof(uint), request.bytes / sizeof(uint));
+    }
+
+    /// The first count items of T in the part of arena given to slot
+    template <typename T>
+    [[nodiscard]] luisa::compute::BufferView<T> view(luisa::compute::BufferView<uint> arena, Slot slot, size_t count)
+    {
+        LUISA_ASSERT(count * sizeof(T) <= m_requests[slot].bytes, "TempStoragePlanner: {} items do not fit slot {}", count, slot);
+        return view(arena, slot).subview(0, bytes_to_uint_count(count * sizeof(T))).template as<T>().subview(0, count);
+    }
+
+    void clear() noexcept
+    {
+        m_requests.clear();
+        m_bytes   = 0;
+        m_planned = true;
+    }
+
+  private:
+    // greedy by size: largest requests first, each at the lowest aligned offset that overlaps no placed
+    // request alive at the same time
+    void plan()
+    {
+        if(m_planned) { return; }
+
+        luisa::vector<uint> order(m_requests.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(),
+                         order.end(),
+                         [&](uint a, uint b) { return m_requests[a].bytes > m_requests[b].bytes; });
+
+        luisa::vector<uint> placed;
+        luisa::vector<uint> alive;
+        m_bytes = 0;
+        for(auto index : order)
+        {
+            auto& request = m_requests[index];
+
+            alive.clear();
+            for(auto other : placed)
+            {
+                auto& o = m_requests[other];
+                if(o.first_stage <= request.last_stage && request.first_stage <= o.last_stage) { alive.push_back(other); }
+            }
+            std::sort(alive.begin(),
+                      alive.end(),
+                      [&](uint a, uint b) { return m_requests[a].offset < m_requests[b].offset; });
+
+            size_t offset = 0;
+            for(auto other : alive)
+            {
+                auto& o = m_requests[other];
+                if(o.offset >= offset + request.bytes) { break; }
+                offset = std::max(offset, align_up_uint(o.offset + o.bytes, ALIGN_BYTES));
+            }
+
+            request.offset = offset;
+            m_bytes        = std::max(m_bytes, offset + request.bytes);
+            placed.push_back(index);
+        }
+        m_planned = true;
+    }
+
+    luisa::vector<Request> m_requests;
+    size_t                 m_bytes   = 0;
+    bool                   m_planned = true;
+};
+}  // namespace luisa::parallel_primitive
@@ -0,0 +1,58 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-23 10:05:18
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-23 15:42:09
+ */
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <luisa/core/stl/functional.h>
+#include <luisa/core/stl/vector.h>
+
+namespace luisa::parallel_primitive
+{
+/// Readiness of a background warmup: true once every kernel is compiled and cached, false when
+/// any of them failed to compile
+using WarmupFuture = std::shared_future<bool>;
+
+/// One kernel to compile, true when it ended up in the cache
+using WarmupJob = luisa::function<bool()>;
+
+namespace details
+{
+    /// Runs the jobs on a pool of host threads, at most one per hardware thread, and returns
+    /// right away. Everything the jobs capture has to outlive the future
+    [[nodiscard]] inline WarmupFuture compile_in_background(luisa::vector<WarmupJob> jobs)
+    {
+        return std::async(std::launch::async,
+                          [jobs = std::move(jobs)]() mutable
+                          {
+                              const size_t num_threads =
+                                  std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(jobs.size(), 1));
+
+                              std::atomic<size_t> next{0};
+                              std::atomic<bool>   all_compiled{true};
+                              auto                worker = [&]
+                              {
+                                  for(size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < jobs.size();)
+                                  {
+                                      if(!jobs[i]()) { all_compiled.store(false, std::memory_order_relaxed); }
+                                  }
+                              };
+
+                              luisa::vector<std::thread> pool;
+                              pool.reserve(num_threads - 1);
+                              for(size_t t = 1; t < num_threads; ++t) { pool.emplace_back(worker); }
+                              worker();
+                              for(auto& thread : pool) { thread.join(); }
+                              return all_compiled.load();
+                          })
+            .share();
+    }
+}  // namespace details
+}  // namespace luisa::parallel_primitive
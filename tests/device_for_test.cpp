@@ -0,0 +1,185 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-11 14:12:09
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-07 10:19:53
+ */
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/vstl/config.h>
+#include <algorithm>
+#include <cstdint>
+#include <lcpp/parallel_primitive.h>
+#include <numeric>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+
+int main(int argc, char* argv[])
+{
+    log_level_verbose();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "cuda";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for(int i = 1; i < argc; ++i)
+    {
+        luisa::string_view arg(argv[i]);
+        if(arg.starts_with("--ctx="))
+        {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        }
+        else if(arg.starts_with("--backend="))
+        {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context     context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device      device = context.create_device(backend_name);
+    Stream      stream = device.create_stream();
+    CommandList cmdlist;
+
+    constexpr int32_t BLOCK_SIZE       = 256;
+    constexpr int32_t ITEMS_PER_THREAD = 4;
+    constexpr int32_t WARP_NUMS        = 32;
+
+    using ForT = DeviceFor<BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+    ForT device_for;
+    device_for.create(device, &stream);
+
+    "for_each"_test = [&]
+    {
+        auto affine_op = [](Var<uint>& x) noexcept { x = x * 2u + 1u; };
+        for(uint loop = 0; loop < 25; loop += 2)
+        {
+            const uint          num_items = (1u << loop) + 3u;
+            luisa::vector<uint> input(num_items);
+            std::iota(input.begin(), input.end(), 0u);
+
+            auto d_data = device.create_buffer<uint>(num_items);
+            stream << d_data.copy_from(input.data()) << synchronize();
+
+            // leave the last element untouched to check the ForEachN bound
+            device_for.ForEachN(cmdlist, d_data.view(), num_items - 1, affine_op);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> result(num_items);
+            stream << d_data.copy_to(result.data()) << synchronize();
+
+            bool pass = result.back() == input.back();
+            for(uint i = 0; i + 1 < num_items; ++i)
+            {
+                pass &= result[i] == input[i] * 2u + 1u;
+            }
+            expect(pass) << "ForEachN failed for size " << num_items;
+        }
+    };
+
+    "bulk"_test = [&]
+    {
+        const uint num_items = (1u << 22) + 5u;
+        auto       d_out     = device.create_buffer<uint>(num_items);
+
+        device_for.Bulk(cmdlist, num_items, [&](UInt idx) noexcept { d_out->write(idx, idx * idx); });
+        stream << cmdlist.commit() << synchronize();
+
+        luisa::vector<uint> result(num_items);
+        stream << d_out.copy_to(result.data()) << synchronize();
+
+        bool pass = true;
+        for(uint i = 0; i < num_items; ++i)
+        {
+            pass &= result[i] == i * i;
+        }
+        expect(pass) << "Bulk failed";
+    };
+
+    "for_each_in_extents"_test = [&]
+    {
+        const uint3 extents   = make_uint3(37u, 129u, 5u);
+        const uint  num_items = extents.x * extents.y * extents.z;
+        auto        d_out     = device.create_buffer<uint>(num_items);
+
+        device_for.ForEachInExtents(cmdlist,
+                                    extents,
+                                    [&](UInt idx, UInt3 coord) noexcept
+                                    { d_out->write(idx, coord.x + coord.y * 1000u + coord.z * 1000000u); });
+        stream << cmdlist.commit() << synchronize();
+
+        luisa::vector<uint> result(num_items);
+        stream << d_out.copy_to(result.data()) << synchronize();
+
+        bool pass = true;
+        for(uint z = 0; z < extents.z; ++z)
+        {
+            for(uint y = 0; y < extents.y; ++y)
+            {
+                for(uint x = 0; x < extents.x; ++x)
+                {
+                    uint idx = (z * extents.y + y) * extents.x + x;
+                    pass &= result[idx] == x + y * 1000u + z * 1000000u;
+                }
+            }
+        }
+        expect(pass) << "ForEachInExtents failed";
+    };
+
+    // one cached kernel serves buffers passed as arguments, ops with captures compile per buffer
+    "bulk buffer arguments"_test = [&]
+    {
+        const uint num_items = 1000u;
+        auto       d_a       = device.create_buffer<uint>(num_items);
+        auto       d_b       = device.create_buffer<uint>(num_items);
+
+        auto square_op = [](UInt idx, BufferVar<uint>& out) noexcept { out.write(idx, idx * idx); };
+        device_for.Bulk(cmdlist, num_items, square_op, d_a.view());
+        device_for.Bulk(cmdlist, num_items, square_op, d_b.view());
+        stream << cmdlist.commit() << synchronize();
+
+        luisa::vector<uint> result_a(num_items);
+        luisa::vector<uint> result_b(num_items);
+        stream << d_a.copy_to(result_a.data()) << d_b.copy_to(result_b.data()) << synchronize();
+        bool pass = true;
+        for(uint i = 0; i < num_items; ++i) { pass &= result_a[i] == i * i && result_b[i] == i * i; }
+        expect(pass) << "Bulk with buffer arguments failed";
+
+        // the same op type capturing another buffer must not reuse the kernel of the first one
+        for(auto* d_out : {&d_a, &d_b})
+        {
+            uint tag = d_out == &d_a ? 1u : 2u;
+            device_for.Bulk(cmdlist, num_items, [&](UInt idx) noexcept { (*d_out)->write(idx, idx + tag); });
+        }
+        stream << cmdlist.commit() << d_a.copy_to(result_a.data()) << d_b.copy_to(result_b.data()) << synchronize();
+        pass = true;
+        for(uint i = 0; i < num_items; ++i) { pass &= result_a[i] == i + 1u && result_b[i] == i + 2u; }
+        expect(pass) << "Bulk reused a kernel with another captured buffer";
+
+        const uint2 extents = make_uint2(25u, 40u);
+        device_for.ForEachInExtents(
+            cmdlist,
+            extents,
+            [](UInt idx, UInt3 coord, BufferVar<uint>& out) noexcept { out.write(idx, coord.y * 100u + coord.x); },
+            d_b.view());
+        stream << cmdlist.commit() << d_b.copy_to(result_b.data()) << synchronize();
+        pass = true;
+        for(uint i = 0; i < num_items; ++i) { pass &= result_b[i] == (i / extents.x) * 100u + i % extents.x; }
+        expect(pass) << "ForEachInExtents with buffer arguments failed";
+    };
+
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-10 16:20:44
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-10 17:58:03
+ */
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/vstl/config.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <lcpp/parallel_primitive.h>
+#include <random>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+
+int main(int argc, char* argv[])
+{
+    log_level_verbose();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "cuda";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for(int i = 1; i < argc; ++i)
+    {
+        luisa::string_view arg(argv[i]);
+        if(arg.starts_with("--ctx="))
+        {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        }
+        else if(arg.starts_with("--backend="))
+        {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context     context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device      device = context.create_device(backend_name);
+    Stream      stream = device.create_stream();
+    CommandList cmdlist;
+
+    using HistogramT = DeviceHistogram<>;
+    HistogramT histogram;
+    histogram.create(device, &stream);
+
+    "histogram even uint"_test = [&]
+    {
+        for(uint loop = 0; loop < 24; loop += 3)
+        {
+            const uint num_samples = (1u << loop) + 7u;
+            // more than 256 bins exercises the global-atomic path as well
+            for(uint num_levels : {17u, 257u, 301u})
+            {
+                const uint num_bins = num_levels - 1;
+                const uint lower    = 0u;
+                const uint upper    = 1000u;
+
+                luisa::vector<uint> samples(num_samples);
+                std::mt19937        rng(114521);
+                std::uniform_int_distribution<uint> dist(0u, 1100u);  // some samples fall outside
+                for(auto& s : samples) { s = dist(rng) / 8u * 8u; }  // repeated values hit RLE runs
+
+                auto d_samples   = device.create_buffer<uint>(num_samples);
+                auto d_histogram = device.create_buffer<uint>(num_bins);
+                stream << d_samples.copy_from(samples.data()) << synchronize();
+
+                size_t temp_bytes  = HistogramT::GetTempStorageBytes<uint>(num_levels);
+                auto   temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(temp_bytes));
+
+                histogram.HistogramEven(
+                    cmdlist, temp_buffer.view(), d_samples.view(), d_histogram.view(), num_levels, lower, upper, num_samples);
+                stream << cmdlist.commit() << synchronize();
+
+                luisa::vector<uint> result(num_bins);
+                stream << d_histogram.copy_to(result.data()) << synchronize();
+
+                luisa::vector<uint> expected(num_bins, 0u);
+                for(auto s : samples)
+                {
+                    if(s >= lower && s < upper)
+                    {
+                        expected[(uint64_t)(s - lower) * num_bins / (upper - lower)]++;
+                    }
+                }
+                expect(std::equal(result.begin(), result.end(), expected.begin()))
+                    << "HistogramEven failed for " << num_samples << " samples, " << num_levels << " levels";
+            }
+        }
+    };
+
+    "histogram range float"_test = [&]
+    {
+        const uint            num_samples = 1u << 20;
+        luisa::vector<float>  levels      = {0.0f, 0.1f, 0.25f, 0.3f, 0.5f, 0.75f, 0.9f, 1.0f};
+        const uint            num_levels  = static_cast<uint>(levels.size());
+        luisa::vector<float>  samples(num_samples);
+        std::mt19937          rng(114521);
+        std::uniform_real_distribution<float> dist(-0.1f, 1.1f);
+        for(auto& s : samples) { s = dist(rng); }
+
+        auto d_samples   = device.create_buffer<float>(num_samples);
+        auto d_levels    = device.create_buffer<float>(num_levels);
+        auto d_histogram = device.create_buffer<uint>(num_levels - 1);
+        stream << d_samples.copy_from(samples.data()) << d_levels.copy_from(levels.data()) << synchronize();
+
+        size_t temp_bytes  = HistogramT::GetTempStorageBytes<float>(num_levels);
+        auto   temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(temp_bytes));
+
+        histogram.HistogramRange(
+            cmdlist, temp_buffer.view(), d_samples.view(), d_histogram.view(), num_levels, d_levels.view(), num_samples);
+        stream << cmdlist.commit() << synchronize();
+
+        luisa::vector<uint> result(num_levels - 1);
+        stream << d_histogram.copy_to(result.data()) << synchronize();
+
+        luisa::vector<uint> expected(num_levels - 1, 0u);
+        for(auto s : samples)
+        {
+            auto it = std::upper_bound(levels.begin(), levels.end(), s);
+            if(it != levels.begin() && it != levels.end())
+            {
+                expected[std::distance(levels.begin(), it) - 1]++;
+            }
+        }
+        expect(std::equal(result.begin(), result.end(), expected.begin())) << "HistogramRange failed";
+    };
+
+    "multi histogram even rgba"_test = [&]
+    {
+        constexpr uint NUM_CHANNELS        = 4;
+        constexpr uint NUM_ACTIVE_CHANNELS = 3;
+        const uint     num_pixels          = (1u << 18) + 13u;
+
+        luisa::vector<uint> samples(num_pixels * NUM_CHANNELS);
+        std::mt19937        rng(114521);
+        std::uniform_int_distribution<uint> dist(0u, 255u);
+        for(auto& s : samples) { s = dist(rng); }
+
+        std::array<uint, NUM_ACTIVE_CHANNELS> num_levels = {257u, 65u, 17u};
+        std::array<uint, NUM_ACTIVE_CHANNELS> lower      = {0u, 0u, 0u};
+        std::array<uint, NUM_ACTIVE_CHANNELS> upper      = {256u, 256u, 256u};
+
+        auto d_samples = device.create_buffer<uint>(samples.size());
+        stream << d_samples.copy_from(samples.data()) << synchronize();
+
+        luisa::vector<Buffer<uint>>                       d_histograms;
+        std::array<BufferView<uint>, NUM_ACTIVE_CHANNELS> d_histogram_views;
+        for(auto c = 0u; c < NUM_ACTIVE_CHANNELS; ++c)
+        {
+            d_histograms.emplace_back(device.create_buffer<uint>(num_levels[c] - 1));
+            d_histogram_views[c] = d_histograms.back().view();
+        }
+
+        size_t temp_bytes =
+            HistogramT::GetMultiTempStorageBytes<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, uint>(num_levels);
+        auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(temp_bytes));
+
+        histogram.MultiHistogramEven<NUM_CHANNELS, NUM_ACTIVE_CHANNELS, uint>(
+            cmdlist, temp_buffer.view(), d_samples.view(), d_histogram_views, num_levels, lower, upper, num_pixels);
+        stream << cmdlist.commit() << synchronize();
+
+        for(auto c = 0u; c < NUM_ACTIVE_CHANNELS; ++c)
+        {
+            const uint          num_bins = num_levels[c] - 1;
+            luisa::vector<uint> result(num_bins);
+            stream << d_histograms[c].copy_to(result.data()) << synchronize();
+
+            luisa::vector<uint> expected(num_bins, 0u);
+            for(auto p = 0u; p < num_pixels; ++p)
+            {
+                uint s = samples[p * NUM_CHANNELS + c];
+                expected[(uint64_t)(s - lower[c]) * num_bins / (upper[c] - lower[c])]++;
+            }
+            expect(std::equal(result.begin(), result.end(), expected.begin()))
+                << "MultiHistogramEven failed for channel " << c;
+        }
+    };
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-15 15:12:09
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-15 17:20:44
+ */
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/vstl/config.h>
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <lcpp/parallel_primitive.h>
+#include <random>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+
+int main(int argc, char* argv[])
+{
+    log_level_verbose();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "cuda";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for(int i = 1; i < argc; ++i)
+    {
+        luisa::string_view arg(argv[i]);
+        if(arg.starts_with("--ctx="))
+        {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        }
+        else if(arg.starts_with("--backend="))
+        {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context     context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device      device = context.create_device(backend_name);
+    Stream      stream = device.create_stream();
+    CommandList cmdlist;
+
+    constexpr int32_t BLOCK_SIZE       = 256;
+    constexpr int32_t ITEMS_PER_THREAD = 4;
+    constexpr int32_t WARP_NUMS        = 32;
+
+    using MergeSortT = DeviceMergeSort<BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+    MergeSortT merge_sort;
+    merge_sort.create(device, &stream);
+
+    using DistanceIdT = KeyValuePair<float, uint>;
+
+    // composite key a radix sort cannot take: distance first, id breaks ties
+    "sort_keys_composite"_test = [&]
+    {
+        auto distance_then_id = [](const Var<DistanceIdT>& a, const Var<DistanceIdT>& b) noexcept
+        { return a.key < b.key | (a.key == b.key & a.value < b.value); };
+
+        for(uint loop = 0; loop < 22; loop += 3)
+        {
+            const uint                 num_items = (1u << loop) + 5u;
+            luisa::vector<DistanceIdT> input(num_items);
+            std::mt19937               rng(114521 + loop);
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                // few distinct distances, so the id decides often
+                input[i] = DistanceIdT{static_cast<float>(rng() % 97) * 0.5f, rng() % num_items};
+            }
+
+            auto d_keys = device.create_buffer<DistanceIdT>(num_items);
+            stream << d_keys.copy_from(input.data()) << synchronize();
+
+            auto temp_buffer = device.create_buffer<uint>(
+                bytes_to_uint_count(MergeSortT::GetSortKeysTempStorageBytes<DistanceIdT>(num_items)));
+            merge_sort.SortKeys(cmdlist, temp_buffer.view(), d_keys.view(), num_items, distance_then_id);
+            stream << cmdlist.commit() << synchronize();
+
+            auto expected = input;
+            std::sort(expected.begin(),
+                      expected.end(),
+                      [](const DistanceIdT& a, const DistanceIdT& b)
+                      { return a.key < b.key || (a.key == b.key && a.value < b.value); });
+
+            luisa::vector<DistanceIdT> result(num_items);
+            stream << d_keys.copy_to(result.data()) << synchronize();
+
+            expect(std::equal(expected.begin(),
+                              expected.end(),
+                              result.begin(),
+                              [](const DistanceIdT& a, const DistanceIdT& b)
+                              { return a.key == b.key && a.value == b.value; }))
+                << "SortKeys failed for size " << num_items;
+        }
+    };
+
+    // descending with many equal keys: values carry the input position, so stability is visible
+    "stable_sort_pairs"_test = [&]
+    {
+        auto greater = [](const Var<uint>& a, const Var<uint>& b) noexcept { return a > b; };
+
+        for(uint loop = 0; loop < 22; loop += 3)
+        {
+            const uint          num_items = (1u << loop) + 5u;
+            luisa::vector<uint> keys(num_items);
+            luisa::vector<uint> values(num_items);
+            std::mt19937        rng(114521 + loop);
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                keys[i]   = rng() % 64;
+                values[i] = i;
+            }
+
+            auto d_keys   = device.create_buffer<uint>(num_items);
+            auto d_values = device.create_buffer<uint>(num_items);
+            stream << d_keys.copy_from(keys.data()) << d_values.copy_from(values.data()) << synchronize();
+
+            auto temp_buffer = device.create_buffer<uint>(
+                bytes_to_uint_count(MergeSortT::GetSortPairsTempStorageBytes<uint, uint>(num_items)));
+            merge_sort.StableSortPairs(cmdlist, temp_buffer.view(), d_keys.view(), d_values.view(), num_items, greater);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> expected_values(num_items);
+            std::iota(expected_values.begin(), expected_values.end(), 0u);
+            std::stable_sort(expected_values.begin(),
+                             expected_values.end(),
+                             [&](uint a, uint b) { return keys[a] > keys[b]; });
+
+            luisa::vector<uint> result_keys(num_items), result_values(num_items);
+            stream << d_keys.copy_to(result_keys.data()) << d_values.copy_to(result_values.data()) << synchronize();
+
+            bool keys_ok = true;
+            for(auto i = 0u; i < num_items; ++i) { keys_ok &= result_keys[i] == keys[expected_values[i]]; }
+            expect(keys_ok) << "SortPairs keys failed for size " << num_items;
+            expect(std::equal(expected_values.begin(), expected_values.end(), result_values.begin()))
+                << "SortPairs is not stable for size " << num_items;
+        }
+    };
+
+    return 0;
+}
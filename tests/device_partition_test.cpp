@@ -0,0 +1,206 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-13 14:20:31
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-13 16:12:09
+ */
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/vstl/config.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <lcpp/parallel_primitive.h>
+#include <random>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+
+int main(int argc, char* argv[])
+{
+    log_level_verbose();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "cuda";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for(int i = 1; i < argc; ++i)
+    {
+        luisa::string_view arg(argv[i]);
+        if(arg.starts_with("--ctx="))
+        {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        }
+        else if(arg.starts_with("--backend="))
+        {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context     context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device      device = context.create_device(backend_name);
+    Stream      stream = device.create_stream();
+    CommandList cmdlist;
+
+    constexpr int32_t BLOCK_SIZE       = 256;
+    constexpr int32_t ITEMS_PER_THREAD = 4;
+    constexpr int32_t WARP_NUMS        = 32;
+
+    using PartitionT = DevicePartition<BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+    PartitionT device_partition;
+    device_partition.create(device, &stream);
+
+    auto d_num_selected = device.create_buffer<uint>(2);
+
+    "partition_if"_test = [&]
+    {
+        for(uint loop = 0; loop < 25; loop += 3)
+        {
+            const uint          num_items = (1u << loop) + 5u;
+            const uint          pivot     = 1u << 30;
+            luisa::vector<uint> input(num_items);
+            std::mt19937        rng(114521 + loop);
+            for(auto& v : input) { v = rng() >> 1; }
+
+            auto d_in  = device.create_buffer<uint>(num_items);
+            auto d_out = device.create_buffer<uint>(num_items);
+            stream << d_in.copy_from(input.data()) << synchronize();
+
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(PartitionT::GetTempStorageBytes(num_items)));
+            device_partition.If(cmdlist,
+                                temp_buffer.view(),
+                                d_in.view(),
+                                d_out.view(),
+                                d_num_selected.view(),
+                                num_items,
+                                [&](const Var<uint>& x) noexcept { return x < pivot; });
+            stream << cmdlist.commit() << synchronize();
+
+            // selected in order at the front, rejected in reverse order at the back
+            luisa::vector<uint> expected;
+            std::copy_if(input.begin(), input.end(), std::back_inserter(expected), [&](uint x) { return x < pivot; });
+            const uint num_expected = static_cast<uint>(expected.size());
+            std::copy_if(input.rbegin(), input.rend(), std::back_inserter(expected), [&](uint x) { return x >= pivot; });
+
+            uint                num_selected = 0;
+            luisa::vector<uint> result(num_items);
+            stream << d_num_selected.view(0, 1).copy_to(&num_selected) << d_out.copy_to(result.data()) << synchronize();
+
+            expect(num_selected == num_expected) << "If selected " << num_selected << " of " << num_items;
+            expect(std::equal(expected.begin(), expected.end(), result.begin())) << "If failed for size " << num_items;
+        }
+    };
+
+    "partition_flagged"_test = [&]
+    {
+        for(uint loop = 0; loop < 25; loop += 3)
+        {
+            const uint          num_items = (1u << loop) + 5u;
+            luisa::vector<int>  input(num_items);
+            luisa::vector<uint> flags(num_items);
+            std::mt19937        rng(114521 + loop);
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                input[i] = static_cast<int>(i) - 7;
+                flags[i] = rng() % 3 == 0 ? 1u : 0u;
+            }
+
+            auto d_in    = device.create_buffer<int>(num_items);
+            auto d_flags = device.create_buffer<uint>(num_items);
+            auto d_out   = device.create_buffer<int>(num_items);
+            stream << d_in.copy_from(input.data()) << d_flags.copy_from(flags.data()) << synchronize();
+
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(PartitionT::GetTempStorageBytes(num_items)));
+            device_partition.Flagged(
+                cmdlist, temp_buffer.view(), d_in.view(), d_flags.view(), d_out.view(), d_num_selected.view(), num_items);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<int> expected;
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                if(flags[i]) { expected.push_back(input[i]); }
+            }
+            const uint num_expected = static_cast<uint>(expected.size());
+            for(auto i = num_items; i-- > 0;)
+            {
+                if(!flags[i]) { expected.push_back(input[i]); }
+            }
+
+            uint               num_selected = 0;
+            luisa::vector<int> result(num_items);
+            stream << d_num_selected.view(0, 1).copy_to(&num_selected) << d_out.copy_to(result.data()) << synchronize();
+
+            expect(num_selected == num_expected) << "Flagged selected " << num_selected << " of " << num_items;
+            expect(std::equal(expected.begin(), expected.end(), result.begin())) << "Flagged failed for size " << num_items;
+        }
+    };
+
+    "three_way_partition"_test = [&]
+    {
+        for(uint loop = 0; loop < 25; loop += 3)
+        {
+            const uint           num_items = (1u << loop) + 5u;
+            const float          pivot     = 0.5f;
+            luisa::vector<float> input(num_items);
+            std::mt19937         rng(114521 + loop);
+            // a coarse grid so that plenty of items compare equal to the pivot
+            for(auto& v : input) { v = static_cast<float>(rng() % 16) / 8.0f; }
+
+            auto d_in      = device.create_buffer<float>(num_items);
+            auto d_less    = device.create_buffer<float>(num_items);
+            auto d_equal   = device.create_buffer<float>(num_items);
+            auto d_greater = device.create_buffer<float>(num_items);
+            stream << d_in.copy_from(input.data()) << synchronize();
+
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(PartitionT::GetThreeWayTempStorageBytes(num_items)));
+            device_partition.If(cmdlist,
+                                temp_buffer.view(),
+                                d_in.view(),
+                                d_less.view(),
+                                d_equal.view(),
+                                d_greater.view(),
+                                d_num_selected.view(),
+                                num_items,
+                                [&](const Var<float>& x) noexcept { return x < pivot; },
+                                [&](const Var<float>& x) noexcept { return x == pivot; });
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<float> expected_less, expected_equal, expected_greater;
+            for(auto v : input)
+            {
+                (v < pivot ? expected_less : v == pivot ? expected_equal : expected_greater).push_back(v);
+            }
+
+            std::array<uint, 2>  num_selected{};
+            luisa::vector<float> less(num_items), equal(num_items), greater(num_items);
+            stream << d_num_selected.copy_to(num_selected.data()) << d_less.copy_to(less.data())
+                   << d_equal.copy_to(equal.data()) << d_greater.copy_to(greater.data()) << synchronize();
+
+            expect(num_selected[0] == expected_less.size() && num_selected[1] == expected_equal.size())
+                << "three-way sizes " << num_selected[0] << ", " << num_selected[1] << " for size " << num_items;
+            expect(std::equal(expected_less.begin(), expected_less.end(), less.begin())
+                   && std::equal(expected_equal.begin(), expected_equal.end(), equal.begin())
+                   && std::equal(expected_greater.begin(), expected_greater.end(), greater.begin()))
+                << "three-way partition failed for size " << num_items;
+        }
+    };
+
+    return 0;
+}
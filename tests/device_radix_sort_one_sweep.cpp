@@ -2,7 +2,7 @@
  * @Author: Ligo
  * @Date: 2025-09-19 16:04:31
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-09-22 18:11:54
+ * @Last Modified time: 2026-03-07 11:58:31
  */
 
 #include <luisa/core/basic_traits.h>
@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <lcpp/parallel_primitive.h>
+#include <numeric>
 #include <random>
 #include <boost/ut.hpp>
 using namespace luisa;
@@ -278,5 +279,268 @@ int main(int argc, char* argv[])
             << "Radix sort uint-float pair descending key failed at size " << array_size;
     };
 
+    // 20 significant bits above 4 bits of noise: only [4, 24) takes part, equal codes keep input order
+    "radix sort pair bit range double buffer"_test = [&]
+    {
+        constexpr uint begin_bit = 4;
+        constexpr uint end_bit   = 24;
+        for(uint loop = 4; loop < 24; loop += 3)
+        {
+            uint                num_items = (1u << loop) + 3u;
+            luisa::vector<uint> keys(num_items);
+            luisa::vector<uint> values(num_items);
+            std::mt19937        rng(114521 + loop);
+            for(uint i = 0; i < num_items; ++i)
+            {
+                keys[i]   = rng() & ((1u << end_bit) - 1u);
+                values[i] = i;
+            }
+
+            auto d_keys_0   = device.create_buffer<uint>(num_items);
+            auto d_keys_1   = device.create_buffer<uint>(num_items);
+            auto d_values_0 = device.create_buffer<uint>(num_items);
+            auto d_values_1 = device.create_buffer<uint>(num_items);
+            stream << d_keys_0.copy_from(keys.data()) << d_values_0.copy_from(values.data()) << synchronize();
+
+            // no N-sized ping buffers: the sort ping-pongs inside the DoubleBuffers
+            size_t temp_bytes = RadixSorterT::GetSortPairsDoubleBufferTempStorageBytes<uint, uint>(num_items, begin_bit, end_bit);
+            auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(temp_bytes));
+
+            DoubleBuffer<uint> d_keys(d_keys_0.view(), d_keys_1.view());
+            DoubleBuffer<uint> d_values(d_values_0.view(), d_values_1.view());
+            radixsorter.SortPairs(cmdlist, temp_buffer.view(), d_keys, d_values, num_items, begin_bit, end_bit);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> expected_values = values;
+            std::stable_sort(expected_values.begin(),
+                             expected_values.end(),
+                             [&](uint a, uint b) { return (keys[a] >> begin_bit) < (keys[b] >> begin_bit); });
+
+            luisa::vector<uint> result_keys(num_items), result_values(num_items);
+            stream << d_keys.current().copy_to(result_keys.data()) << d_values.current().copy_to(result_values.data())
+                   << synchronize();
+
+            bool keys_pass = true;
+            for(uint i = 0; i < num_items; ++i) { keys_pass &= result_keys[i] == keys[expected_values[i]]; }
+            expect(keys_pass) << "Radix sort bit range keys failed at size " << num_items;
+            expect(std::equal(expected_values.begin(), expected_values.end(), result_values.begin()))
+                << "Radix sort bit range values failed at size " << num_items;
+        }
+    };
+
+
+    // 8-byte keys and values run the scaled onesweep tile, signed zeros and negatives included
+    "radix sort pair 64-bit (double-slong)"_test = [&]
+    {
+        for(uint loop = 4; loop < 23; loop += 3)
+        {
+            uint                  num_items = (1u << loop) + 5u;
+            luisa::vector<double> keys(num_items);
+            luisa::vector<slong>  values(num_items);
+            std::mt19937_64       rng(1919810 + loop);
+            for(uint i = 0; i < num_items; ++i)
+            {
+                // few distinct keys, so stability is visible through the values
+                keys[i]   = static_cast<double>(static_cast<slong>(rng() % 4097) - 2048) * 0.125;
+                keys[i]   = keys[i] == 0.0 && (rng() & 1u) ? -0.0 : keys[i];
+                values[i] = (static_cast<slong>(i) << 32) - 7;
+            }
+
+            auto d_keys_in    = device.create_buffer<double>(num_items);
+            auto d_keys_out   = device.create_buffer<double>(num_items);
+            auto d_values_in  = device.create_buffer<slong>(num_items);
+            auto d_values_out = device.create_buffer<slong>(num_items);
+            stream << d_keys_in.copy_from(keys.data()) << d_values_in.copy_from(values.data()) << synchronize();
+
+            size_t temp_bytes  = RadixSorterT::GetSortPairsTempStorageBytes<double, slong>(num_items);
+            auto   temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(temp_bytes));
+            radixsorter.SortPairs<double, slong>(cmdlist,
+                                                 temp_buffer.view(),
+                                                 d_keys_in.view(),
+                                                 d_keys_out.view(),
+                                                 d_values_in.view(),
+                                                 d_values_out.view(),
+                                                 num_items);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> order(num_items);
+            for(uint i = 0; i < num_items; ++i) { order[i] = i; }
+            std::stable_sort(order.begin(), order.end(), [&](uint a, uint b) { return keys[a] < keys[b]; });
+
+            luisa::vector<double> result_keys(num_items);
+            luisa::vector<slong>  result_values(num_items);
+            stream << d_keys_out.copy_to(result_keys.data()) << d_values_out.copy_to(result_values.data())
+                   << synchronize();
+
+            bool keys_pass   = true;
+            bool values_pass = true;
+            for(uint i = 0; i < num_items; ++i)
+            {
+                keys_pass &= result_keys[i] == keys[order[i]];
+                values_pass &= result_values[i] == values[order[i]];
+            }
+            expect(keys_pass) << "Radix sort double key failed at size " << num_items;
+            expect(values_pass) << "Radix sort slong value is not stable at size " << num_items;
+        }
+    };
+
+    "radix sort key ulong descending"_test = [&]
+    {
+        for(uint loop = 4; loop < 23; loop += 3)
+        {
+            uint                 num_items = (1u << loop) + 1u;
+            luisa::vector<ulong> keys(num_items);
+            std::mt19937_64      rng(114521 + loop);
+            // the high word decides most of the order, so every pass of the 64 bits matters
+            for(uint i = 0; i < num_items; ++i) { keys[i] = rng() & (rng() % 2 ? ~0ull : 0xffffffffull); }
+
+            auto d_keys_in  = device.create_buffer<ulong>(num_items);
+            auto d_keys_out = device.create_buffer<ulong>(num_items);
+            stream << d_keys_in.copy_from(keys.data()) << synchronize();
+
+            size_t temp_bytes  = RadixSorterT::GetSortKeysTempStorageBytes<ulong>(num_items);
+            auto   temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(temp_bytes));
+            radixsorter.SortKeysDescending<ulong>(cmdlist, temp_buffer.view(), d_keys_in.view(), d_keys_out.view(), num_items);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<ulong> result(num_items);
+            stream << d_keys_out.copy_to(result.data()) << synchronize();
+            std::sort(keys.begin(), keys.end(), std::greater<ulong>());
+            expect(std::equal(keys.begin(), keys.end(), result.begin()))
+                << "Radix sort ulong key descending failed at size " << num_items;
+        }
+    };
+
+    // counting values give the stable argsort of the keys without a sequence buffer
+    "radix sort argsort counting values"_test = [&]
+    {
+        for(uint loop = 4; loop < 23; loop += 3)
+        {
+            uint                num_items = (1u << loop) + 1u;
+            luisa::vector<uint> keys(num_items);
+            std::mt19937        rng(1919810 + loop);
+            for(uint i = 0; i < num_items; ++i) { keys[i] = rng() % 1000u; }
+
+            auto d_keys_in    = device.create_buffer<uint>(num_items);
+            auto d_keys_out   = device.create_buffer<uint>(num_items);
+            auto d_values_out = device.create_buffer<uint>(num_items);
+            stream << d_keys_in.copy_from(keys.data()) << synchronize();
+
+            size_t temp_bytes  = RadixSorterT::GetSortPairsTempStorageBytes<uint, uint>(num_items);
+            auto   temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(temp_bytes));
+
+            luisa::vector<uint> expected(num_items);
+            luisa::vector<uint> result(num_items);
+            std::iota(expected.begin(), expected.end(), 0u);
+            std::stable_sort(expected.begin(), expected.end(), [&](uint a, uint b) { return keys[a] < keys[b]; });
+            radixsorter.SortPairs<uint>(cmdlist,
+                                        temp_buffer.view(),
+                                        d_keys_in.view(),
+                                        d_keys_out.view(),
+                                        CountingIterator<uint>(0u),
+                                        d_values_out.view(),
+                                        num_items);
+            stream << cmdlist.commit() << d_values_out.copy_to(result.data()) << synchronize();
+            expect(std::equal(expected.begin(), expected.end(), result.begin()))
+                << "Radix sort argsort failed at size " << num_items;
+
+            std::stable_sort(expected.begin(), expected.end(), [&](uint a, uint b) { return keys[a] > keys[b]; });
+            radixsorter.SortPairsDescending<uint>(cmdlist,
+                                                  temp_buffer.view(),
+                                                  d_keys_in.view(),
+                                                  d_keys_out.view(),
+                                                  CountingIterator<uint>(0u),
+                                                  d_values_out.view(),
+                                                  num_items);
+            stream << cmdlist.commit() << d_values_out.copy_to(result.data()) << synchronize();
+            expect(std::equal(expected.begin(), expected.end(), result.begin()))
+                << "Radix sort descending argsort failed at size " << num_items;
+        }
+    };
+
+    // kernels compiled in the background serve the first calls of a fresh module
+    "radix sort warmup"_test = [&]
+    {
+        // the other instances of this process registered the same kernels already
+        KernelRegistry::instance().release(device);
+        RadixSorterT warm_sorter;
+        warm_sorter.create(device, &stream);
+        auto ready = warm_sorter.Warmup<uint, float>();
+        expect(ready.get()) << "Radix sort warmup failed to compile";
+        auto registered = KernelRegistry::instance().size();
+
+        const uint           num_items = 100000u;
+        luisa::vector<uint>  keys(num_items);
+        luisa::vector<float> values(num_items);
+        std::mt19937         rng(114514);
+        for(uint i = 0; i < num_items; ++i)
+        {
+            keys[i]   = rng();
+            values[i] = static_cast<float>(keys[i] % 1024u);
+        }
+
+        auto d_keys_in    = device.create_buffer<uint>(num_items);
+        auto d_keys_out   = device.create_buffer<uint>(num_items);
+        auto d_values_in  = device.create_buffer<float>(num_items);
+        auto d_values_out = device.create_buffer<float>(num_items);
+        auto temp_buffer  = device.create_buffer<uint>(
+            bytes_to_uint_count(RadixSorterT::GetSortPairsTempStorageBytes<uint, float>(num_items)));
+        stream << d_keys_in.copy_from(keys.data()) << d_values_in.copy_from(values.data()) << synchronize();
+
+        warm_sorter.SortPairs(
+            cmdlist, temp_buffer.view(), d_keys_in.view(), d_keys_out.view(), d_values_in.view(), d_values_out.view(), num_items);
+        expect(KernelRegistry::instance().size() == registered) << "Radix sort compiled after warmup";
+        luisa::vector<uint>  keys_out(num_items);
+        luisa::vector<float> values_out(num_items);
+        stream << cmdlist.commit() << d_keys_out.copy_to(keys_out.data()) << d_values_out.copy_to(values_out.data())
+               << synchronize();
+
+        bool pass = std::is_sorted(keys_out.begin(), keys_out.end());
+        for(uint i = 0; i < num_items; ++i) { pass &= values_out[i] == static_cast<float>(keys_out[i] % 1024u); }
+        expect(pass) << "Radix sort pairs after warmup failed";
+    };
+
+    // 8-byte keys and values run a scaled onesweep tile, the warmup has to build that one
+    "radix sort warmup 64-bit (double-slong)"_test = [&]
+    {
+        // the other sorters of this process registered the same kernels already
+        KernelRegistry::instance().release(device);
+        RadixSorterT warm_sorter;
+        warm_sorter.create(device, &stream);
+        auto ready = warm_sorter.Warmup<double, slong>();
+        expect(ready.get()) << "Radix sort 64-bit warmup failed to compile";
+        auto registered = KernelRegistry::instance().size();
+
+        const uint            num_items = 100000u;
+        luisa::vector<double> keys(num_items);
+        luisa::vector<slong>  values(num_items);
+        std::mt19937_64       rng(114514);
+        for(uint i = 0; i < num_items; ++i)
+        {
+            keys[i]   = static_cast<double>(static_cast<slong>(rng() % 65536) - 32768) * 0.5;
+            values[i] = static_cast<slong>(keys[i] * 2.0) << 20;
+        }
+
+        auto d_keys_in    = device.create_buffer<double>(num_items);
+        auto d_keys_out   = device.create_buffer<double>(num_items);
+        auto d_values_in  = device.create_buffer<slong>(num_items);
+        auto d_values_out = device.create_buffer<slong>(num_items);
+        auto temp_buffer  = device.create_buffer<uint>(
+            bytes_to_uint_count(RadixSorterT::GetSortPairsTempStorageBytes<double, slong>(num_items)));
+        stream << d_keys_in.copy_from(keys.data()) << d_values_in.copy_from(values.data()) << synchronize();
+
+        warm_sorter.SortPairs(
+            cmdlist, temp_buffer.view(), d_keys_in.view(), d_keys_out.view(), d_values_in.view(), d_values_out.view(), num_items);
+        expect(KernelRegistry::instance().size() == registered) << "Radix sort 64-bit compiled after warmup";
+        luisa::vector<double> keys_out(num_items);
+        luisa::vector<slong>  values_out(num_items);
+        stream << cmdlist.commit() << d_keys_out.copy_to(keys_out.data()) << d_values_out.copy_to(values_out.data())
+               << synchronize();
+
+        bool pass = std::is_sorted(keys_out.begin(), keys_out.end());
+        for(uint i = 0; i < num_items; ++i) { pass &= values_out[i] == (static_cast<slong>(keys_out[i] * 2.0) << 20); }
+        expect(pass) << "Radix sort 64-bit pairs after warmup failed";
+    };
+
     return 0;
 }
@@ -2,7 +2,7 @@
 //  * @Author: Ligo
 //  * @Date: 2025-09-19 16:04:31
 //  * @Last Modified by: Ligo
-//  * @Last Modified time: 2025-09-22 18:11:54
+//  * @Last Modified time: 2026-03-07 11:48:10
 //  */
 
 #include "luisa/dsl/var.h"
@@ -11,7 +11,11 @@
 #include <luisa/vstl/config.h>
 #include <algorithm>
 #include <cstdint>
+#include <cmath>
+#include <cstring>
 #include <lcpp/parallel_primitive.h>
+#include <limits>
+#include <numeric>
 #include <random>
 #include <vector>
 #include <boost/ut.hpp>
@@ -89,6 +93,220 @@ int main(int argc, char* argv[])
         }
     };
 
+    // the temp storage of every call comes from the allocator: a second round over the same sizes
+    // only reuses cached blocks, the high-water mark stays where the first round left it
+    "reduce caching allocator"_test = [&]
+    {
+        CachingAllocator       allocator{device};
+        const uint             max_items = 1u << 20;
+        Buffer<Type4Byte>      d_input   = device.create_buffer<Type4Byte>(max_items);
+        Buffer<Type4Byte>      d_output  = device.create_buffer<Type4Byte>(16);
+        std::vector<Type4Byte> host_input(max_items, 1);
+        stream << d_input.copy_from(host_input.data()) << synchronize();
+
+        size_t first_round_high_water_mark = 0;
+        for(uint round = 0; round < 2; ++round)
+        {
+            for(uint loop = 0; loop < 16; ++loop)
+            {
+                uint        num_items = (max_items >> loop) - loop;
+                CommandList cmdlist;
+                reducer.Sum(cmdlist, allocator, stream, d_input.view(0, num_items), d_output.view(loop, 1), num_items);
+                stream << cmdlist.commit();
+            }
+            expect(allocator.live_bytes() == 0);
+            expect(allocator.cached_bytes() > 0);
+            allocator.synchronize(stream);
+            if(round == 0) { first_round_high_water_mark = allocator.high_water_mark(); }
+        }
+        expect(allocator.high_water_mark() == first_round_high_water_mark) << "cached blocks were not reused";
+
+        std::vector<Type4Byte> host_output(16);
+        stream << d_output.copy_to(host_output.data()) << synchronize();
+        for(uint loop = 0; loop < 16; ++loop) { expect(host_output[loop] == (max_items >> loop) - loop); }
+
+        allocator.free_all_cached();
+        expect(allocator.cached_bytes() == 0);
+    };
+
+    // a new block over max_cached_bytes frees idle blocks until it fits, not the whole cache
+    "caching allocator cap"_test = [&]
+    {
+        CachingAllocator allocator{device, 2, 10, 20, 6144};
+        {
+            auto small = allocator.allocate(stream, 1024);
+            auto large = allocator.allocate(stream, 4096);
+        }
+        allocator.synchronize(stream);
+        expect(allocator.cached_bytes() == 5120u);
+
+        auto storage = allocator.allocate(stream, 2048);
+        expect(allocator.cached_bytes() == 1024u) << "more idle blocks were freed than the new one needs";
+        expect(allocator.live_bytes() == 2048u);
+        storage.reset();
+        allocator.synchronize(stream);
+        allocator.free_all_cached();
+    };
+
+    // past MAX_REDUCE_GRID tiles the persistent blocks take uneven shares, the temp stays one partial per block
+    "reduce single pass grid"_test = [&]
+    {
+        constexpr uint tile_items = details::BLOCK_SIZE * details::ITEMS_PER_THREAD;
+        constexpr uint max_grid   = details::BLOCK_SIZE * 8 * 5;
+        for(uint num_items : {1u, tile_items - 1u, tile_items + 1u, max_grid * tile_items + 3u, 3u * max_grid * tile_items / 2u + 7u})
+        {
+            std::vector<Type4Byte> host_input(num_items);
+            for(uint i = 0; i < num_items; ++i) { host_input[i] = i % 7u; }
+            Buffer<Type4Byte> d_input  = device.create_buffer<Type4Byte>(num_items);
+            Buffer<Type4Byte> d_output = device.create_buffer<Type4Byte>(1);
+            stream << d_input.copy_from(host_input.data()) << synchronize();
+
+            size_t temp_bytes = DeviceReduce<>::GetTempStorageBytes<Type4Byte>(num_items);
+            expect(temp_bytes <= max_grid * sizeof(Type4Byte)) << "temp storage grows past the grid at " << num_items;
+            auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(temp_bytes));
+
+            // a transform also has to run when everything fits in one tile
+            auto plus_one = [](const Var<Type4Byte>& x) noexcept { return x + 1u; };
+            CommandList cmdlist;
+            reducer.TransformReduce(
+                cmdlist, temp_buffer.view(), d_input.view(), d_output.view(), num_items, SumOp(), plus_one, Type4Byte(5));
+            stream << cmdlist.commit() << synchronize();
+            std::vector<Type4Byte> host_output(1);
+            stream << d_output.copy_to(host_output.data()) << synchronize();
+
+            Type4Byte expected = std::accumulate(host_input.begin(), host_input.end(), Type4Byte(5)) + num_items;
+            expect(host_output[0] == expected) << "single pass reduce failed at " << num_items;
+        }
+    };
+
+    // the host mirrors the fixed tree: the device sum has to match it, and itself across block sizes, bit for bit
+    // narrow items are widened while they are loaded, no conversion pass in between
+    "reduce widening accumulator"_test = [&]
+    {
+        std::mt19937 rng(1919810);
+        for(uint num_items : {1u, 1000u, 3000000u})
+        {
+            std::vector<luisa::ubyte> mask(num_items);
+            std::vector<int32>        values(num_items);
+            for(auto& m : mask) { m = static_cast<luisa::ubyte>(rng() % 2u); }
+            for(auto& v : values) { v = static_cast<int32>(rng() % 2000000000u); }
+            uint  expected_count = std::accumulate(mask.begin(), mask.end(), 0u);
+            slong expected_total = std::accumulate(values.begin(), values.end(), slong(0));
+
+            Buffer<luisa::ubyte> d_mask   = device.create_buffer<luisa::ubyte>(num_items);
+            Buffer<int32>        d_values = device.create_buffer<int32>(num_items);
+            Buffer<uint>         d_count  = device.create_buffer<uint>(1);
+            Buffer<slong>        d_total  = device.create_buffer<slong>(1);
+            stream << d_mask.copy_from(mask.data()) << d_values.copy_from(values.data()) << synchronize();
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(DeviceReduce<>::GetTempStorageBytes<slong>(num_items)));
+
+            uint        count = 0;
+            slong       total = 0;
+            CommandList cmdlist;
+            reducer.Sum(cmdlist, temp_buffer.view(), d_mask.view(), d_count.view(), num_items);
+            stream << cmdlist.commit() << d_count.copy_to(&count) << synchronize();
+            reducer.Reduce(cmdlist, temp_buffer.view(), d_values.view(), d_total.view(), num_items, SumOp(), slong(0));
+            stream << cmdlist.commit() << d_total.copy_to(&total) << synchronize();
+
+            expect(count == expected_count) << "uint8 mask into uint count failed at " << num_items;
+            expect(total == expected_total) << "int32 into int64 total failed at " << num_items;
+        }
+    };
+
+    "deterministic sum"_test = [&]
+    {
+        constexpr uint RUN_ITEMS   = details::DETERMINISTIC_RUN_ITEMS;
+        constexpr uint CHUNK_RUNS  = details::DETERMINISTIC_CHUNK_RUNS;
+        constexpr uint CHUNK_ITEMS = details::DETERMINISTIC_CHUNK_ITEMS;
+
+        auto host_chunk_sums = [&](const std::vector<float>& in)
+        {
+            std::vector<float> sums;
+            for(size_t chunk = 0; chunk * CHUNK_ITEMS < in.size(); ++chunk)
+            {
+                std::vector<float> runs;
+                size_t             chunk_end = std::min<size_t>(in.size(), (chunk + 1) * CHUNK_ITEMS);
+                for(size_t begin = chunk * CHUNK_ITEMS; begin < chunk_end; begin += RUN_ITEMS)
+                {
+                    float acc = in[begin];
+                    for(size_t i = begin + 1; i < std::min<size_t>(chunk_end, begin + RUN_ITEMS); ++i) { acc = acc + in[i]; }
+                    runs.push_back(acc);
+                }
+                for(uint stride = 1; stride < CHUNK_RUNS; stride *= 2)
+                {
+                    for(size_t left = 0; left + stride < runs.size(); left += 2 * stride) { runs[left] = runs[left] + runs[left + stride]; }
+                }
+                sums.push_back(runs[0]);
+            }
+            return sums;
+        };
+
+        using OtherReduceT = DeviceReduce<128, 32, 8>;
+        OtherReduceT other_reducer;
+        other_reducer.create(device, &stream);
+
+        std::mt19937                          rng(1919810);
+        std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+        for(uint num_items : {1u, 1000u, CHUNK_ITEMS, CHUNK_ITEMS + 1u, 100000u, 3000000u})
+        {
+            std::vector<float> input(num_items);
+            for(auto& x : input) { x = dist(rng); }
+            std::vector<float> level = input;
+            do
+            {
+                level = host_chunk_sums(level);
+            } while(level.size() > 1);
+            float expected = 0.0f + level[0];
+
+            Buffer<float> d_input  = device.create_buffer<float>(num_items);
+            Buffer<float> d_output = device.create_buffer<float>(1);
+            stream << d_input.copy_from(input.data()) << synchronize();
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(DeviceReduce<>::GetDeterministicTempStorageBytes<float>(num_items)));
+
+            float       result       = 0.0f;
+            float       other_result = 0.0f;
+            CommandList cmdlist;
+            reducer.DeterministicSum(cmdlist, temp_buffer.view(), d_input.view(), d_output.view(), num_items);
+            stream << cmdlist.commit() << d_output.copy_to(&result) << synchronize();
+            other_reducer.DeterministicSum(cmdlist, temp_buffer.view(), d_input.view(), d_output.view(), num_items);
+            stream << cmdlist.commit() << d_output.copy_to(&other_result) << synchronize();
+
+            expect(std::memcmp(&result, &expected, sizeof(float)) == 0) << "deterministic sum differs from the host tree at " << num_items;
+            expect(std::memcmp(&result, &other_result, sizeof(float)) == 0) << "deterministic sum depends on the block size at " << num_items;
+        }
+    };
+
+    "compensated sum"_test = [&]
+    {
+        // a large leading item makes a plain float sum drop most of the small ones
+        std::mt19937                          rng(114521);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for(uint num_items : {1u, 1000u, 100000u, 3000000u})
+        {
+            std::vector<float> input(num_items);
+            for(auto& x : input) { x = dist(rng); }
+            input[0] = 1.0e6f;
+            double expected = std::accumulate(input.begin(), input.end(), 0.0);
+
+            Buffer<float> d_input  = device.create_buffer<float>(num_items);
+            Buffer<float> d_output = device.create_buffer<float>(1);
+            stream << d_input.copy_from(input.data()) << synchronize();
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(DeviceReduce<>::GetCompensatedSumTempStorageBytes<float>(num_items)));
+
+            float       result = 0.0f;
+            CommandList cmdlist;
+            reducer.CompensatedSum(cmdlist, temp_buffer.view(), d_input.view(), d_output.view(), num_items);
+            stream << cmdlist.commit() << d_output.copy_to(&result) << synchronize();
+
+            // only the final rounding to float is left
+            expect(std::abs(result - expected) <= std::numeric_limits<float>::epsilon() * expected)
+                << "compensated sum " << result << " vs " << expected << " at " << num_items;
+        }
+    };
+
     "reduce_transform"_test = [&]
     {
         luisa::vector<int32> result(1);
@@ -224,6 +442,91 @@ int main(int argc, char* argv[])
         expect((std::max_element(input_data.begin(), input_data.end()) - input_data.begin()) == index_result[0]);
     };
 
+    // the items are generated, transformed or gathered while loading, no input is materialized
+    "reduce fancy iterators"_test = [&]
+    {
+        for(uint num_items : {1u, 1000u, 65537u})
+        {
+            Buffer<uint> d_sum = device.create_buffer<uint>(1);
+            auto         temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(DeviceReduce<>::GetTempStorageBytes<uint>(num_items)));
+            uint        sum = 0;
+            CommandList cmdlist;
+            reducer.Sum(cmdlist, temp_buffer.view(), CountingIterator<uint>(1u), d_sum.view(), num_items);
+            stream << cmdlist.commit() << d_sum.copy_to(&sum) << synchronize();
+            expect(sum == num_items * (num_items + 1u) / 2u) << "counting sum failed at " << num_items;
+        }
+
+        auto in_buffer = device.create_buffer<int32>(array_size);
+        stream << in_buffer.copy_from(input_data.data()) << synchronize();
+
+        // argmin of the negated items is the argmax, only the index is kept
+        auto index_out_buffer = device.create_buffer<uint>(1);
+        auto arg_temp_buffer =
+            device.create_buffer<uint>(bytes_to_uint_count(DeviceReduce<>::GetArgTempStorageBytes<int32>(array_size)));
+        auto        negate = [](const Var<int32>& x) noexcept { return -x; };
+        uint        index  = 0;
+        CommandList cmdlist;
+        reducer.ArgMin(cmdlist,
+                       arg_temp_buffer.view(),
+                       TransformIterator(BufferIterator<int32>(in_buffer.view()), negate),
+                       DiscardOutput<int32>(),
+                       BufferIterator<uint>(index_out_buffer.view()),
+                       array_size);
+        stream << cmdlist.commit() << index_out_buffer.copy_to(&index) << synchronize();
+        expect((std::max_element(input_data.begin(), input_data.end()) - input_data.begin()) == index);
+
+        // sum of every other item through an index buffer
+        luisa::vector<uint> indices(array_size / 2);
+        for(uint i = 0; i < indices.size(); ++i) { indices[i] = 2u * i; }
+        auto index_buffer = device.create_buffer<uint>(indices.size());
+        auto d_total      = device.create_buffer<int32>(1);
+        auto temp_buffer =
+            device.create_buffer<uint>(bytes_to_uint_count(DeviceReduce<>::GetTempStorageBytes<int32>(indices.size())));
+        stream << index_buffer.copy_from(indices.data()) << synchronize();
+        int32 total    = 0;
+        int32 expected = 0;
+        for(uint i : indices) { expected += input_data[i]; }
+        reducer.Reduce(cmdlist,
+                       temp_buffer.view(),
+                       PermutationIterator(BufferIterator<int32>(in_buffer.view()), BufferIterator<uint>(index_buffer.view())),
+                       d_total.view(),
+                       indices.size(),
+                       SumOp(),
+                       int32(0));
+        stream << cmdlist.commit() << d_total.copy_to(&total) << synchronize();
+        expect(total == expected);
+    };
+
+
+    // kernels compiled in the background serve the first calls of a fresh module
+    "reduce warmup"_test = [&]
+    {
+        // the other instances of this process registered the same kernels already
+        KernelRegistry::instance().release(device);
+        DeviceReduce<> warm_reducer;
+        warm_reducer.create(device, &stream);
+        auto ready = warm_reducer.Warmup<int32, float>(SumOp(), MinOp());
+        expect(ready.get()) << "reduce warmup failed to compile";
+        auto registered = KernelRegistry::instance().size();
+
+        constexpr uint       num_items  = 3 * details::BLOCK_SIZE * details::ITEMS_PER_THREAD + 5;
+        auto                 in_buffer  = device.create_buffer<int32>(num_items);
+        auto                 out_buffer = device.create_buffer<int32>(2);
+        luisa::vector<int32> host_input(input_data.begin(), input_data.begin() + num_items);
+        luisa::vector<int32> result(2);
+        auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(DeviceReduce<>::GetTempStorageBytes<int32>(num_items)));
+        stream << in_buffer.copy_from(host_input.data()) << synchronize();
+
+        CommandList cmdlist;
+        warm_reducer.Sum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view().subview(0, 1), num_items);
+        warm_reducer.Min(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view().subview(1, 1), num_items);
+        expect(KernelRegistry::instance().size() == registered) << "reduce compiled after warmup";
+        stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+
+        expect(result[0] == std::accumulate(host_input.begin(), host_input.end(), int32(0)));
+        expect(result[1] == *std::min_element(host_input.begin(), host_input.end()));
+    };
 
     // reduce by key
     "reduce_by_key"_test = [&]
@@ -287,4 +590,63 @@ int main(int argc, char* argv[])
             expect(expected_sum == aggregates[i]);
         }
     };
+
+    "reduce_by_key persistent tile status"_test = [&]
+    {
+        DeviceReduce<> persistent_reducer;
+        persistent_reducer.create(device, &stream);
+        persistent_reducer.SetPersistentTileStatus(true);
+
+        std::mt19937 rng(1919810);
+        for(uint num_items : {100000u, 1000u, 3000000u, 5u})
+        {
+            luisa::vector<int32> keys(num_items), values(num_items);
+            int32                key = 0;
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                key += rng() % 8 == 0 ? 1 : 0;
+                keys[i]   = key;
+                values[i] = static_cast<int32>(rng() % 16);
+            }
+            luisa::vector<int32> expected_keys, expected_sums;
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                if(i == 0 || keys[i] != keys[i - 1])
+                {
+                    expected_keys.push_back(keys[i]);
+                    expected_sums.push_back(0);
+                }
+                expected_sums.back() += values[i];
+            }
+
+            auto key_buffer    = device.create_buffer<int32>(num_items);
+            auto value_buffer  = device.create_buffer<int32>(num_items);
+            auto unique_buffer = device.create_buffer<int32>(num_items);
+            auto sum_buffer    = device.create_buffer<int32>(num_items);
+            auto runs_buffer   = device.create_buffer<luisa::uint>(1);
+            auto temp_buffer   = device.create_buffer<uint>(
+                bytes_to_uint_count(DeviceReduce<>::GetReduceByKeyTempStorageBytes<int32, int32>(num_items)));
+            stream << key_buffer.copy_from(keys.data()) << value_buffer.copy_from(values.data()) << synchronize();
+
+            CommandList cmdlist;
+            persistent_reducer.ReduceByKey(cmdlist,
+                                           temp_buffer.view(),
+                                           key_buffer.view(),
+                                           value_buffer.view(),
+                                           unique_buffer.view(),
+                                           sum_buffer.view(),
+                                           runs_buffer.view(),
+                                           [](const Var<int32>& a, const Var<int32>& b) { return a + b; },
+                                           num_items);
+            luisa::uint          num_runs = 0;
+            luisa::vector<int32> unique(num_items), sums(num_items);
+            stream << cmdlist.commit() << runs_buffer.copy_to(&num_runs) << unique_buffer.copy_to(unique.data())
+                   << sum_buffer.copy_to(sums.data()) << synchronize();
+
+            expect(num_runs == expected_keys.size()) << "ReduceByKey found " << num_runs << " runs for size " << num_items;
+            expect(std::equal(expected_keys.begin(), expected_keys.end(), unique.begin())
+                   && std::equal(expected_sums.begin(), expected_sums.end(), sums.begin()))
+                << "ReduceByKey with persistent tile status failed for size " << num_items;
+        }
+    };
 }
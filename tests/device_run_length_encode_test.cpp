@@ -0,0 +1,276 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-14 14:08:12
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-07 11:15:09
+ */
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/vstl/config.h>
+#include <algorithm>
+#include <cstdint>
+#include <lcpp/parallel_primitive.h>
+#include <random>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+
+int main(int argc, char* argv[])
+{
+    log_level_verbose();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "cuda";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for(int i = 1; i < argc; ++i)
+    {
+        luisa::string_view arg(argv[i]);
+        if(arg.starts_with("--ctx="))
+        {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        }
+        else if(arg.starts_with("--backend="))
+        {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context     context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device      device = context.create_device(backend_name);
+    Stream      stream = device.create_stream();
+    CommandList cmdlist;
+
+    constexpr int32_t BLOCK_SIZE       = 256;
+    constexpr int32_t ITEMS_PER_THREAD = 4;
+    constexpr int32_t WARP_NUMS        = 32;
+
+    using RunLengthEncodeT = DeviceRunLengthEncode<BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+    RunLengthEncodeT run_length_encode;
+    run_length_encode.create(device, &stream);
+
+    auto d_num_runs = device.create_buffer<uint>(1);
+
+    // sorted keys with runs of random length, long runs cross tile boundaries
+    auto make_sorted_keys = [](uint num_items, uint seed)
+    {
+        luisa::vector<uint> keys(num_items);
+        std::mt19937        rng(seed);
+        uint                value = 0;
+        for(auto& k : keys)
+        {
+            value += rng() % 3 == 0 ? 1u + rng() % 4 : 0u;
+            k = value;
+        }
+        return keys;
+    };
+
+    "run_length_encode"_test = [&]
+    {
+        for(uint loop = 0; loop < 25; loop += 3)
+        {
+            const uint num_items = (1u << loop) + 5u;
+            auto       input     = make_sorted_keys(num_items, 114521 + loop);
+
+            auto d_in     = device.create_buffer<uint>(num_items);
+            auto d_unique = device.create_buffer<uint>(num_items);
+            auto d_counts = device.create_buffer<uint>(num_items);
+            stream << d_in.copy_from(input.data()) << synchronize();
+
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(RunLengthEncodeT::GetTempStorageBytes(num_items)));
+            run_length_encode.Encode(
+                cmdlist, temp_buffer.view(), d_in.view(), d_unique.view(), d_counts.view(), d_num_runs.view(), num_items);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> expected_unique, expected_counts;
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                if(i == 0 || input[i] != input[i - 1])
+                {
+                    expected_unique.push_back(input[i]);
+                    expected_counts.push_back(0u);
+                }
+                expected_counts.back()++;
+            }
+
+            uint                num_runs = 0;
+            luisa::vector<uint> unique(num_items), counts(num_items);
+            stream << d_num_runs.copy_to(&num_runs) << d_unique.copy_to(unique.data())
+                   << d_counts.copy_to(counts.data()) << synchronize();
+
+            expect(num_runs == expected_unique.size()) << "Encode found " << num_runs << " runs for size " << num_items;
+            expect(std::equal(expected_unique.begin(), expected_unique.end(), unique.begin())
+                   && std::equal(expected_counts.begin(), expected_counts.end(), counts.begin()))
+                << "Encode failed for size " << num_items;
+        }
+    };
+
+    // keys equal under the op but not bitwise, the unique key has to be the head of its run
+    "run_length_encode_equality_op"_test = [&]
+    {
+        auto same_decade = [](const Var<uint>& a, const Var<uint>& b) { return a / 10u == b / 10u; };
+        for(uint loop = 0; loop < 25; loop += 3)
+        {
+            const uint num_items = (1u << loop) + 5u;
+            auto       input     = make_sorted_keys(num_items, 1919810 + loop);
+
+            auto d_in     = device.create_buffer<uint>(num_items);
+            auto d_unique = device.create_buffer<uint>(num_items);
+            auto d_counts = device.create_buffer<uint>(num_items);
+            stream << d_in.copy_from(input.data()) << synchronize();
+
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(RunLengthEncodeT::GetTempStorageBytes(num_items)));
+            run_length_encode.Encode(cmdlist,
+                                     temp_buffer.view(),
+                                     d_in.view(),
+                                     d_unique.view(),
+                                     d_counts.view(),
+                                     d_num_runs.view(),
+                                     num_items,
+                                     same_decade);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> expected_unique, expected_counts;
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                if(i == 0 || input[i] / 10u != input[i - 1] / 10u)
+                {
+                    expected_unique.push_back(input[i]);
+                    expected_counts.push_back(0u);
+                }
+                expected_counts.back()++;
+            }
+
+            uint                num_runs = 0;
+            luisa::vector<uint> unique(num_items), counts(num_items);
+            stream << d_num_runs.copy_to(&num_runs) << d_unique.copy_to(unique.data())
+                   << d_counts.copy_to(counts.data()) << synchronize();
+
+            expect(num_runs == expected_unique.size()) << "Encode found " << num_runs << " runs for size " << num_items;
+            expect(std::equal(expected_unique.begin(), expected_unique.end(), unique.begin())
+                   && std::equal(expected_counts.begin(), expected_counts.end(), counts.begin()))
+                << "Encode with an equality op failed for size " << num_items;
+        }
+    };
+
+    "non_trivial_runs"_test = [&]
+    {
+        for(uint loop = 0; loop < 25; loop += 3)
+        {
+            const uint num_items = (1u << loop) + 5u;
+            auto       input     = make_sorted_keys(num_items, 114521 + loop);
+
+            auto d_in      = device.create_buffer<uint>(num_items);
+            auto d_offsets = device.create_buffer<uint>(num_items);
+            auto d_lengths = device.create_buffer<uint>(num_items);
+            stream << d_in.copy_from(input.data()) << synchronize();
+
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(RunLengthEncodeT::GetTempStorageBytes(num_items)));
+            run_length_encode.NonTrivialRuns(
+                cmdlist, temp_buffer.view(), d_in.view(), d_offsets.view(), d_lengths.view(), d_num_runs.view(), num_items);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> expected_offsets, expected_lengths;
+            for(auto i = 0u; i < num_items;)
+            {
+                auto j = i + 1;
+                while(j < num_items && input[j] == input[i]) { ++j; }
+                if(j - i > 1)
+                {
+                    expected_offsets.push_back(i);
+                    expected_lengths.push_back(j - i);
+                }
+                i = j;
+            }
+
+            uint                num_runs = 0;
+            luisa::vector<uint> offsets(num_items), lengths(num_items);
+            stream << d_num_runs.copy_to(&num_runs) << d_offsets.copy_to(offsets.data())
+                   << d_lengths.copy_to(lengths.data()) << synchronize();
+
+            expect(num_runs == expected_offsets.size())
+                << "NonTrivialRuns found " << num_runs << " runs for size " << num_items;
+            expect(std::equal(expected_offsets.begin(), expected_offsets.end(), offsets.begin())
+                   && std::equal(expected_lengths.begin(), expected_lengths.end(), lengths.begin()))
+                << "NonTrivialRuns failed for size " << num_items;
+        }
+    };
+
+    // sort -> encode -> scan of the run lengths into run offsets, the temp storage and the intermediate
+    // buffers of all stages planned into one arena; stages that do not overlap share its bytes
+    "planned_pipeline"_test = [&]
+    {
+        DeviceRadixSort<> radix_sort;
+        DeviceScan<>      scan;
+        radix_sort.create(device, &stream);
+        scan.create(device, &stream);
+
+        for(uint loop = 0; loop < 25; loop += 6)
+        {
+            const uint num_items = (1u << loop) + 5u;
+            auto       input     = make_sorted_keys(num_items, 1919810 + loop);
+            std::shuffle(input.begin(), input.end(), std::mt19937(loop));
+
+            TempStoragePlanner planner;
+            auto sort_temp   = planner.add(DeviceRadixSort<>::GetSortKeysTempStorageBytes<uint>(num_items), 0);
+            auto sorted_keys = planner.add<uint>(num_items, 0, 1);
+            auto encode_temp = planner.add(RunLengthEncodeT::GetTempStorageBytes(num_items), 1);
+            auto counts      = planner.add<uint>(num_items, 1, 2);
+            auto scan_temp   = planner.add(DeviceScan<>::GetTempStorageBytes<uint>(num_items), 2);
+            expect(planner.bytes() < planner.unaliased_bytes()) << "stages were not aliased for size " << num_items;
+
+            auto d_in      = device.create_buffer<uint>(num_items);
+            auto d_unique  = device.create_buffer<uint>(num_items);
+            auto d_offsets = device.create_buffer<uint>(num_items);
+            auto arena     = device.create_buffer<uint>(planner.uint_count());
+            stream << d_in.copy_from(input.data()) << synchronize();
+
+            auto d_sorted = planner.view<uint>(arena.view(), sorted_keys, num_items);
+            auto d_counts = planner.view<uint>(arena.view(), counts, num_items);
+            radix_sort.SortKeys(cmdlist, planner.view(arena.view(), sort_temp), d_in.view(), d_sorted, num_items);
+            run_length_encode.Encode(
+                cmdlist, planner.view(arena.view(), encode_temp), d_sorted, d_unique.view(), d_counts, d_num_runs.view(), num_items);
+            scan.ExclusiveSum(cmdlist, planner.view(arena.view(), scan_temp), d_counts, d_offsets.view(), num_items);
+            stream << cmdlist.commit() << synchronize();
+
+            std::sort(input.begin(), input.end());
+            luisa::vector<uint> expected_unique, expected_offsets;
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                if(i == 0 || input[i] != input[i - 1])
+                {
+                    expected_unique.push_back(input[i]);
+                    expected_offsets.push_back(i);
+                }
+            }
+
+            uint                num_runs = 0;
+            luisa::vector<uint> unique(num_items), offsets(num_items);
+            stream << d_num_runs.copy_to(&num_runs) << d_unique.copy_to(unique.data())
+                   << d_offsets.copy_to(offsets.data()) << synchronize();
+
+            expect(num_runs == expected_unique.size()) << "pipeline found " << num_runs << " runs for size " << num_items;
+            expect(std::equal(expected_unique.begin(), expected_unique.end(), unique.begin())
+                   && std::equal(expected_offsets.begin(), expected_offsets.end(), offsets.begin()))
+                << "pipeline failed for size " << num_items;
+        }
+    };
+
+    return 0;
+}
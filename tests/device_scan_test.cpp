@@ -2,7 +2,7 @@
  * @Author: Ligo 
  * @Date: 2025-11-06 14:30:13 
  * @Last Modified by: Ligo
- * @Last Modified time: 2025-11-07 00:23:56
+ * @Last Modified time: 2026-03-07 11:51:42
  */
 
 
@@ -10,8 +10,12 @@
 #include <luisa/core/logging.h>
 #include <luisa/vstl/config.h>
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <functional>
+#include <cstring>
 #include <lcpp/parallel_primitive.h>
+#include <limits>
 #include <numeric>
 #include <random>
 
@@ -63,6 +67,9 @@ int main(int argc, char* argv[])
     using ScannerT = DeviceScan<BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
     ScannerT scanner;
     scanner.create(device, &stream);
+    // the tests below cover the look-back and its tile states on every backend, AUTO would take
+    // reduce-then-scan on the ones without forward progress; that one has a test of its own
+    scanner.SetScanAlgorithm(ScanAlgorithm::DECOUPLED_LOOK_BACK);
 
     "exclusive_scan"_test = [&]
     {
@@ -108,6 +115,125 @@ int main(int argc, char* argv[])
     };
 
 
+    "scan_widening_accumulator"_test = [&]
+    {
+        std::mt19937 rng(114521);
+        for(uint num_items : {1u, 1000u, 1000000u})
+        {
+            luisa::vector<luisa::ubyte> flags(num_items);
+            for(auto& f : flags) { f = static_cast<luisa::ubyte>(rng() % 2u); }
+
+            auto in_buffer  = device.create_buffer<luisa::ubyte>(num_items);
+            auto out_buffer = device.create_buffer<uint>(num_items);
+            stream << in_buffer.copy_from(flags.data()) << synchronize();
+            auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(ScannerT::GetTempStorageBytes<uint>(num_items)));
+
+            luisa::vector<uint> expected(num_items);
+            luisa::vector<uint> result(num_items);
+            std::exclusive_scan(flags.begin(), flags.end(), expected.begin(), 0u);
+            scanner.ExclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            expect(std::equal(expected.begin(), expected.end(), result.begin()))
+                << "uint8 flags into uint exclusive sum failed at size " << num_items;
+
+            std::inclusive_scan(flags.begin(), flags.end(), expected.begin(), std::plus<uint>(), 0u);
+            scanner.InclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            expect(std::equal(expected.begin(), expected.end(), result.begin()))
+                << "uint8 flags into uint inclusive sum failed at size " << num_items;
+        }
+    };
+
+    // 8-byte accumulators keep the status words and values apart, the 4-byte ones above are packed
+    "scan_split_tile_state"_test = [&]
+    {
+        std::mt19937 rng(810);
+        for(uint num_items : {1u, 1000u, 1000000u})
+        {
+            luisa::vector<uint> input(num_items);
+            for(auto& x : input) { x = rng(); }
+
+            auto in_buffer  = device.create_buffer<uint>(num_items);
+            auto out_buffer = device.create_buffer<luisa::ulong>(num_items);
+            stream << in_buffer.copy_from(input.data()) << synchronize();
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(ScannerT::GetTempStorageBytes<luisa::ulong>(num_items)));
+            expect(ScannerT::GetTempStorageBytes<luisa::ulong>(num_items) > ScannerT::GetTempStorageBytes<uint>(num_items));
+
+            luisa::vector<luisa::ulong> expected(num_items), result(num_items);
+            std::inclusive_scan(input.begin(), input.end(), expected.begin(), std::plus<luisa::ulong>(), luisa::ulong{0});
+            scanner.InclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            expect(result == expected) << "uint into ulong inclusive sum failed at size " << num_items;
+        }
+    };
+
+    // the scanned items are generated while loading: constant ones give the iota, squares go through a transform
+    "scan_fancy_iterators"_test = [&]
+    {
+        for(uint num_items : {1u, 1000u, 100000u})
+        {
+            auto out_buffer = device.create_buffer<uint>(num_items);
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(ScannerT::GetTempStorageBytes<uint>(num_items)));
+            luisa::vector<uint> result(num_items);
+
+            scanner.ExclusiveSum(cmdlist, temp_buffer.view(), ConstantIterator<uint>(1u), out_buffer.view(), num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            luisa::vector<uint> expected(num_items);
+            std::iota(expected.begin(), expected.end(), 0u);
+            expect(std::equal(expected.begin(), expected.end(), result.begin()))
+                << "constant exclusive sum failed at size " << num_items;
+
+            auto square = [](const Var<uint>& x) noexcept { return (x % 7u) * (x % 7u); };
+            scanner.InclusiveSum(
+                cmdlist, temp_buffer.view(), TransformIterator(CountingIterator<uint>(0u), square), out_buffer.view(), num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            uint running = 0;
+            for(uint i = 0; i < num_items; ++i)
+            {
+                running += (i % 7u) * (i % 7u);
+                expected[i] = running;
+            }
+            expect(std::equal(expected.begin(), expected.end(), result.begin()))
+                << "transform inclusive sum failed at size " << num_items;
+        }
+    };
+
+    // kernels compiled in the background serve the first calls of a fresh module
+    "scan_warmup"_test = [&]
+    {
+        // the other instances of this process registered the same kernels already
+        KernelRegistry::instance().release(device);
+        ScannerT warm_scanner;
+        warm_scanner.create(device, &stream);
+        auto ready = warm_scanner.Warmup<uint, float>();
+        expect(ready.get()) << "scan warmup failed to compile";
+        auto registered = KernelRegistry::instance().size();
+
+        const uint          num_items = 100000u;
+        luisa::vector<uint> input(num_items);
+        for(uint i = 0; i < num_items; ++i) { input[i] = i % 5u; }
+        auto in_buffer  = device.create_buffer<uint>(num_items);
+        auto out_buffer = device.create_buffer<uint>(num_items);
+        auto temp_buffer =
+            device.create_buffer<uint>(bytes_to_uint_count(ScannerT::GetTempStorageBytes<uint>(num_items)));
+        stream << in_buffer.copy_from(input.data()) << synchronize();
+
+        luisa::vector<uint> result(num_items);
+        luisa::vector<uint> expected(num_items);
+        warm_scanner.ExclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+        stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+        std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u);
+        expect(result == expected) << "exclusive sum after warmup failed";
+
+        warm_scanner.InclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+        expect(KernelRegistry::instance().size() == registered) << "scan compiled after warmup";
+        stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+        std::inclusive_scan(input.begin(), input.end(), expected.begin());
+        expect(result == expected) << "inclusive sum after warmup failed";
+    };
+
     "exclusive_scan_by_key"_test = [&]
     {
         for(auto i = 5; i < MAX_NUM_LOGIC; i++)
@@ -165,4 +291,287 @@ int main(int argc, char* argv[])
             }
         }
     };
+
+    // the host mirrors the fixed tree, so the device result has to match it bit for bit,
+    // whatever the block size and items per thread of the scanner
+    "deterministic_inclusive_sum"_test = [&]
+    {
+        constexpr uint RUN_ITEMS   = details::DETERMINISTIC_RUN_ITEMS;
+        constexpr uint CHUNK_RUNS  = details::DETERMINISTIC_CHUNK_RUNS;
+        constexpr uint CHUNK_ITEMS = details::DETERMINISTIC_CHUNK_ITEMS;
+
+        auto run_sums = [&](const luisa::vector<float>& in, uint chunk)
+        {
+            luisa::vector<float> runs;
+            for(uint begin = chunk * CHUNK_ITEMS; begin < std::min<size_t>(in.size(), (chunk + 1) * CHUNK_ITEMS); begin += RUN_ITEMS)
+            {
+                float acc = in[begin];
+                for(uint i = begin + 1; i < std::min<size_t>(in.size(), begin + RUN_ITEMS); ++i) { acc = acc + in[i]; }
+                runs.push_back(acc);
+            }
+            return runs;
+        };
+        auto chunk_total = [&](const luisa::vector<float>& in, uint chunk)
+        {
+            luisa::vector<float> runs = run_sums(in, chunk);
+            for(uint stride = 1; stride < CHUNK_RUNS; stride *= 2)
+            {
+                for(uint left = 0; left + stride < runs.size(); left += 2 * stride) { runs[left] = runs[left] + runs[left + stride]; }
+            }
+            return runs[0];
+        };
+        std::function<void(const luisa::vector<float>&, luisa::vector<float>&)> host_scan =
+            [&](const luisa::vector<float>& in, luisa::vector<float>& out)
+        {
+            uint                 num_chunks = (in.size() + CHUNK_ITEMS - 1) / CHUNK_ITEMS;
+            luisa::vector<float> totals(num_chunks);
+            if(num_chunks > 1)
+            {
+                for(uint c = 0; c < num_chunks; ++c) { totals[c] = chunk_total(in, c); }
+                host_scan(luisa::vector<float>(totals), totals);
+            }
+            out.resize(in.size());
+            for(uint c = 0; c < num_chunks; ++c)
+            {
+                luisa::vector<float> runs = run_sums(in, c);
+                for(uint offset = 1; offset < CHUNK_RUNS; offset *= 2)
+                {
+                    luisa::vector<float> next = runs;
+                    for(uint r = offset; r < runs.size(); ++r) { next[r] = runs[r - offset] + runs[r]; }
+                    runs = next;
+                }
+                for(uint r = 0; r < runs.size(); ++r)
+                {
+                    float acc = c > 0 ? totals[c - 1] : 0.0f;
+                    if(r > 0) { acc = acc + runs[r - 1]; }
+                    uint begin = c * CHUNK_ITEMS + r * RUN_ITEMS;
+                    for(uint i = begin; i < std::min<size_t>(in.size(), begin + RUN_ITEMS); ++i)
+                    {
+                        acc    = acc + in[i];
+                        out[i] = acc;
+                    }
+                }
+            }
+        };
+
+        using OtherScannerT = DeviceScan<128, WARP_NUMS, 8>;
+        OtherScannerT other_scanner;
+        other_scanner.create(device, &stream);
+
+        std::mt19937                          rng(114521);
+        std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+        for(uint num_items : {1u, 1000u, CHUNK_ITEMS, CHUNK_ITEMS + 1u, 100000u, 3000000u})
+        {
+            luisa::vector<float> input(num_items);
+            for(auto& x : input) { x = dist(rng); }
+            luisa::vector<float> expected;
+            host_scan(input, expected);
+
+            auto in_buffer  = device.create_buffer<float>(num_items);
+            auto out_buffer = device.create_buffer<float>(num_items);
+            stream << in_buffer.copy_from(input.data()) << synchronize();
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(ScannerT::GetDeterministicTempStorageBytes<float>(num_items)));
+
+            luisa::vector<float> result(num_items);
+            luisa::vector<float> other_result(num_items);
+            scanner.DeterministicInclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            other_scanner.DeterministicInclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(other_result.data()) << synchronize();
+
+            expect(std::memcmp(result.data(), expected.data(), num_items * sizeof(float)) == 0)
+                << "Deterministic inclusive sum differs from the host tree at size " << num_items;
+            expect(std::memcmp(result.data(), other_result.data(), num_items * sizeof(float)) == 0)
+                << "Deterministic inclusive sum depends on the block size at size " << num_items;
+        }
+    };
+
+
+    "compensated_inclusive_sum"_test = [&]
+    {
+        constexpr uint CHUNK_ITEMS = details::DETERMINISTIC_CHUNK_ITEMS;
+
+        std::mt19937                          rng(1919810);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        for(uint num_items : {1u, 1000u, CHUNK_ITEMS + 1u, 3000000u})
+        {
+            luisa::vector<float> input(num_items);
+            for(auto& x : input) { x = dist(rng); }
+            input[0] = 1.0e6f;
+
+            auto in_buffer  = device.create_buffer<float>(num_items);
+            auto out_buffer = device.create_buffer<float>(num_items);
+            stream << in_buffer.copy_from(input.data()) << synchronize();
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(ScannerT::GetCompensatedSumTempStorageBytes<float>(num_items)));
+
+            luisa::vector<float> result(num_items);
+            scanner.CompensatedInclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+
+            // every prefix is within the final rounding of the double precision prefix
+            double expected = 0.0;
+            bool   ok       = true;
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                expected += input[i];
+                ok &= std::abs(result[i] - expected) <= std::numeric_limits<float>::epsilon() * expected;
+            }
+            expect(ok) << "Compensated inclusive sum failed at size " << num_items;
+        }
+    };
+
+    // the scans of one command list share the status words of the module: every call has to
+    // ignore what the calls before it wrote, also across the growth of the words
+    "persistent_tile_status"_test = [&]
+    {
+        ScannerT persistent_scanner;
+        persistent_scanner.create(device, &stream);
+        persistent_scanner.SetPersistentTileStatus(true);
+        persistent_scanner.SetScanAlgorithm(ScanAlgorithm::DECOUPLED_LOOK_BACK);
+
+        std::mt19937 rng(114514);
+        for(uint round = 0; round < 2; ++round)
+        {
+            luisa::vector<Buffer<uint>>        buffers;
+            luisa::vector<luisa::vector<uint>> inputs;
+            const auto                         sizes = {5000u, 1u, 1u << 20, 777u, 3000000u, 4096u};
+            buffers.reserve(3 * sizes.size());
+            for(uint num_items : sizes)
+            {
+                auto& input = inputs.emplace_back(num_items);
+                for(auto& x : input) { x = rng() % 16; }
+
+                auto& in_buffer   = buffers.emplace_back(device.create_buffer<uint>(num_items));
+                auto& out_buffer  = buffers.emplace_back(device.create_buffer<uint>(num_items));
+                auto& temp_buffer = buffers.emplace_back(
+                    device.create_buffer<uint>(bytes_to_uint_count(ScannerT::GetTempStorageBytes<uint>(num_items))));
+                stream << in_buffer.copy_from(input.data()) << synchronize();
+                if(num_items % 2 == 0)
+                {
+                    persistent_scanner.InclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+                }
+                else
+                {
+                    persistent_scanner.ExclusiveSum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+                }
+            }
+            stream << cmdlist.commit() << synchronize();
+
+            for(auto i = 0u; i < inputs.size(); ++i)
+            {
+                const auto&         input = inputs[i];
+                luisa::vector<uint> result(input.size()), expected(input.size());
+                stream << buffers[3 * i + 1].copy_to(result.data()) << synchronize();
+                if(input.size() % 2 == 0) { std::inclusive_scan(input.begin(), input.end(), expected.begin()); }
+                else { std::exclusive_scan(input.begin(), input.end(), expected.begin(), 0u); }
+                expect(result == expected) << "persistent tile status scan failed for size " << input.size()
+                                           << " in round " << round;
+            }
+        }
+
+        // segments straddle the tiles, so every tile compares with the last key of the one before
+        for(uint num_items : {3000000u, 1000u, 1u << 16})
+        {
+            luisa::vector<int32> keys(num_items), values(num_items);
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                keys[i]   = static_cast<int32>(i / 1000u);
+                values[i] = static_cast<int32>(rng() % 16);
+            }
+            auto key_buffer   = device.create_buffer<int32>(num_items);
+            auto value_buffer = device.create_buffer<int32>(num_items);
+            auto out_buffer   = device.create_buffer<int32>(num_items);
+            auto temp_buffer  = device.create_buffer<uint>(
+                bytes_to_uint_count(ScannerT::GetScanByKeyTempStorageBytes<int32, int32>(num_items)));
+            stream << key_buffer.copy_from(keys.data()) << value_buffer.copy_from(values.data()) << synchronize();
+
+            persistent_scanner.InclusiveSumByKey(
+                cmdlist, temp_buffer.view(), key_buffer.view(), value_buffer.view(), out_buffer.view(), num_items);
+            luisa::vector<int32> result(num_items), expected(num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                expected[i] = (i > 0 && keys[i] == keys[i - 1] ? expected[i - 1] : 0) + values[i];
+            }
+            expect(result == expected) << "persistent tile status scan by key failed for size " << num_items;
+        }
+    };
+
+    // what AUTO picks on backends without forward progress; sizes around one tile and with a
+    // spine of two levels
+    "reduce_then_scan"_test = [&]
+    {
+        ScannerT rts_scanner;
+        rts_scanner.create(device, &stream);
+        rts_scanner.SetScanAlgorithm(ScanAlgorithm::REDUCE_THEN_SCAN);
+
+        std::mt19937 rng(1919);
+        for(uint num_items : {1u, 1000u, 1024u, 1025u, (1u << 20) + 3u, 3000000u})
+        {
+            luisa::vector<int32> input(num_items);
+            for(auto& x : input) { x = static_cast<int32>(rng() % 1000) - 500; }
+
+            auto in_buffer  = device.create_buffer<int32>(num_items);
+            auto out_buffer = device.create_buffer<int32>(num_items);
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(ScannerT::GetTempStorageBytes<int32>(num_items)));
+            stream << in_buffer.copy_from(input.data()) << synchronize();
+
+            luisa::vector<int32> result(num_items), expected(num_items);
+            rts_scanner.ExclusiveScan(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items, SumOp(), int32(7));
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            std::exclusive_scan(input.begin(), input.end(), expected.begin(), int32(7));
+            expect(result == expected) << "reduce-then-scan exclusive sum failed at size " << num_items;
+
+            const int32 lowest = std::numeric_limits<int32>::lowest();
+            rts_scanner.InclusiveScan(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_items, MaxOp(), lowest);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            std::inclusive_scan(
+                input.begin(), input.end(), expected.begin(), [](int32 a, int32 b) { return std::max(a, b); }, lowest);
+            expect(result == expected) << "reduce-then-scan inclusive max failed at size " << num_items;
+
+            // 8-byte tile totals
+            luisa::vector<uint> counts(num_items);
+            for(auto& x : counts) { x = rng(); }
+            auto count_buffer = device.create_buffer<uint>(num_items);
+            auto wide_buffer  = device.create_buffer<luisa::ulong>(num_items);
+            auto wide_temp    =
+                device.create_buffer<uint>(bytes_to_uint_count(ScannerT::GetTempStorageBytes<luisa::ulong>(num_items)));
+            stream << count_buffer.copy_from(counts.data()) << synchronize();
+
+            luisa::vector<luisa::ulong> wide_result(num_items), wide_expected(num_items);
+            rts_scanner.InclusiveSum(cmdlist, wide_temp.view(), count_buffer.view(), wide_buffer.view(), num_items);
+            stream << cmdlist.commit() << wide_buffer.copy_to(wide_result.data()) << synchronize();
+            std::inclusive_scan(counts.begin(), counts.end(), wide_expected.begin(), std::plus<luisa::ulong>(), luisa::ulong{0});
+            expect(wide_result == wide_expected) << "reduce-then-scan uint into ulong sum failed at size " << num_items;
+
+            // segments straddle the tiles, the spine of 3000000 items takes three passes of its block
+            luisa::vector<int32> keys(num_items);
+            for(auto i = 0u; i < num_items; ++i) { keys[i] = static_cast<int32>(i / 1000u); }
+            auto key_buffer = device.create_buffer<int32>(num_items);
+            auto key_temp   = device.create_buffer<uint>(
+                bytes_to_uint_count(ScannerT::GetScanByKeyTempStorageBytes<int32, int32>(num_items)));
+            stream << key_buffer.copy_from(keys.data()) << synchronize();
+
+            rts_scanner.InclusiveSumByKey(cmdlist, key_temp.view(), key_buffer.view(), in_buffer.view(), out_buffer.view(), num_items);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                expected[i] = (i > 0 && keys[i] == keys[i - 1] ? expected[i - 1] : 0) + input[i];
+            }
+            expect(result == expected) << "reduce-then-scan inclusive sum by key failed at size " << num_items;
+
+            rts_scanner.ExclusiveScanByKey(
+                cmdlist, key_temp.view(), key_buffer.view(), in_buffer.view(), out_buffer.view(), MaxOp(), num_items, lowest);
+            stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                expected[i] = i > 0 && keys[i] == keys[i - 1] ? std::max(expected[i - 1], input[i - 1]) : lowest;
+            }
+            expect(result == expected) << "reduce-then-scan exclusive max by key failed at size " << num_items;
+        }
+    };
 }
@@ -2,7 +2,7 @@
 //  * @Author: Ligo
 //  * @Date: 2025-09-19 16:04:31
 //  * @Last Modified by: Ligo
-//  * @Last Modified time: 2025-09-22 18:11:54
+//  * @Last Modified time: 2026-03-07 11:55:03
 //  */
 
 
@@ -175,6 +175,99 @@ int main(int argc, char* argv[])
         }
     };
 
+    // kernels compiled in the background serve the first calls of a fresh module
+    "segment_reduce_warmup"_test = [&]
+    {
+        // the other instances of this process registered the same kernels already
+        KernelRegistry::instance().release(device);
+        DeviceSegmentReduce<> warm_reducer;
+        warm_reducer.create(device, &stream);
+        auto ready = warm_reducer.Warmup<int32>();
+        expect(ready.get()) << "segment reduce warmup failed to compile";
+        auto registered = KernelRegistry::instance().size();
+
+        constexpr int32_t    array_size        = 1024;
+        constexpr uint       items_per_segment = 64;
+        constexpr uint       num_segments      = array_size / items_per_segment;
+        luisa::vector<int32> input_data(array_size);
+        std::iota(input_data.begin(), input_data.end(), 0);
+        luisa::vector<uint> begin_offsets_array(num_segments);
+        luisa::vector<uint> end_offsets_array(num_segments);
+        for(uint i = 0; i < num_segments; i++)
+        {
+            begin_offsets_array[i] = i * items_per_segment;
+            end_offsets_array[i]   = (i + 1) * items_per_segment;
+        }
+
+        auto in_buffer    = device.create_buffer<int32>(array_size);
+        auto out_buffer   = device.create_buffer<int32>(num_segments);
+        auto begin_buffer = device.create_buffer<uint>(num_segments);
+        auto end_buffer   = device.create_buffer<uint>(num_segments);
+        auto temp_buffer  = device.create_buffer<uint>(
+            std::max<size_t>(1, bytes_to_uint_count(DeviceSegmentReduce<>::GetTempStorageBytes<int32>(array_size))));
+        stream << in_buffer.copy_from(input_data.data()) << begin_buffer.copy_from(begin_offsets_array.data())
+               << end_buffer.copy_from(end_offsets_array.data()) << synchronize();
+
+        luisa::vector<int32> offset_result(num_segments);
+        luisa::vector<int32> fixed_result(num_segments);
+        warm_reducer.Sum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_segments, begin_buffer.view(), end_buffer.view());
+        stream << cmdlist.commit() << out_buffer.copy_to(offset_result.data()) << synchronize();
+        warm_reducer.Sum(cmdlist, temp_buffer.view(), in_buffer.view(), out_buffer.view(), num_segments, items_per_segment);
+        expect(KernelRegistry::instance().size() == registered) << "segment reduce compiled after warmup";
+        stream << cmdlist.commit() << out_buffer.copy_to(fixed_result.data()) << synchronize();
+
+        for(uint i = 0; i < num_segments; i++)
+        {
+            auto expected_sum = std::accumulate(input_data.begin() + begin_offsets_array[i], input_data.begin() + end_offsets_array[i], 0);
+            expect(offset_result[i] == expected_sum && fixed_result[i] == expected_sum)
+                << "segment sum after warmup failed at segment " << i;
+        }
+    };
+
+
+    // segment lengths from a constant iterator, fixed-size sums of a counting one
+    "segment_reduce_fancy_iterators"_test = [&]
+    {
+        luisa::vector<uint> begin_offsets_array{0u, 3u, 3u, 700u, 1000u};
+        luisa::vector<uint> end_offsets_array{3u, 3u, 700u, 1000u, 4097u};
+        const uint          num_segments = begin_offsets_array.size();
+
+        auto begin_offsets = device.create_buffer<uint>(num_segments);
+        auto end_offsets   = device.create_buffer<uint>(num_segments);
+        auto out_buffer    = device.create_buffer<int32>(num_segments);
+        stream << begin_offsets.copy_from(begin_offsets_array.data()) << end_offsets.copy_from(end_offsets_array.data())
+               << synchronize();
+        auto temp_buffer = device.create_buffer<uint>(1);
+
+        reducer.Sum(cmdlist,
+                    temp_buffer.view(),
+                    ConstantIterator<int32>(1),
+                    out_buffer.view(),
+                    num_segments,
+                    begin_offsets.view(),
+                    end_offsets.view());
+        luisa::vector<int32> result(num_segments);
+        stream << cmdlist.commit() << out_buffer.copy_to(result.data()) << synchronize();
+        for(uint i = 0; i < num_segments; ++i)
+        {
+            expect(result[i] == int32(end_offsets_array[i] - begin_offsets_array[i])) << "segment length " << i;
+        }
+
+        for(uint segment_size : {5u, 32u, 1000u})
+        {
+            const uint fixed_segments = 37;
+            auto       fixed_out      = device.create_buffer<uint>(fixed_segments);
+            reducer.Sum(cmdlist, temp_buffer.view(), CountingIterator<uint>(0u), fixed_out.view(), fixed_segments, segment_size);
+            luisa::vector<uint> fixed_result(fixed_segments);
+            stream << cmdlist.commit() << fixed_out.copy_to(fixed_result.data()) << synchronize();
+            for(uint i = 0; i < fixed_segments; ++i)
+            {
+                uint begin = i * segment_size;
+                expect(fixed_result[i] == segment_size * begin + segment_size * (segment_size - 1u) / 2u)
+                    << "fixed segment " << i << " of size " << segment_size;
+            }
+        }
+    };
 
     "segment_reduce_arg_max"_test = [&]
     {
@@ -0,0 +1,269 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-16 16:05:33
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-04 15:42:10
+ */
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/vstl/config.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <lcpp/parallel_primitive.h>
+#include <random>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+
+int main(int argc, char* argv[])
+{
+    log_level_verbose();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "cuda";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for(int i = 1; i < argc; ++i)
+    {
+        luisa::string_view arg(argv[i]);
+        if(arg.starts_with("--ctx="))
+        {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        }
+        else if(arg.starts_with("--backend="))
+        {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context     context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device      device = context.create_device(backend_name);
+    Stream      stream = device.create_stream();
+    CommandList cmdlist;
+
+    constexpr int32_t BLOCK_SIZE       = 256;
+    constexpr int32_t ITEMS_PER_THREAD = 4;
+    constexpr int32_t WARP_NUMS        = 32;
+    constexpr uint    WARP_TILE_ITEMS  = WARP_NUMS * ITEMS_PER_THREAD;
+    constexpr uint    TILE_ITEMS       = BLOCK_SIZE * ITEMS_PER_THREAD;
+
+    using SegmentedRadixSortT = DeviceSegmentedRadixSort<BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+    SegmentedRadixSortT segmented_radix_sort;
+    segmented_radix_sort.create(device, &stream);
+
+    // segment sizes cover every worker: empty, one warp, one block and several tiles
+    auto make_segments = [&](std::mt19937& rng, uint num_segments, luisa::vector<uint>& begin_offsets, luisa::vector<uint>& end_offsets)
+    {
+        const uint size_limits[] = {1u, WARP_TILE_ITEMS, TILE_ITEMS, TILE_ITEMS * 5u};
+        uint       offset        = 0;
+        begin_offsets.resize(num_segments);
+        end_offsets.resize(num_segments);
+        for(auto i = 0u; i < num_segments; ++i)
+        {
+            uint size        = rng() % (size_limits[rng() % 4] + 1u);
+            begin_offsets[i] = offset;
+            end_offsets[i]   = offset + size;
+            // leave a gap now and then, keys between segments must stay untouched
+            offset += size + (rng() % 8 == 0 ? 3u : 0u);
+        }
+        // one trailing gap item keeps the buffers non-empty
+        return offset + 1u;
+    };
+
+    "sort_pairs"_test = [&]
+    {
+        for(uint num_segments : {1u, 7u, 64u, 1000u})
+        {
+            std::mt19937        rng(114521 + num_segments);
+            luisa::vector<uint> begin_offsets, end_offsets;
+            const uint          num_items = make_segments(rng, num_segments, begin_offsets, end_offsets);
+
+            luisa::vector<float> keys(num_items);
+            luisa::vector<uint>  values(num_items);
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                // few distinct keys, so stability is visible through the values
+                keys[i]   = static_cast<float>(static_cast<int>(rng() % 199) - 99) * 0.25f;
+                values[i] = i;
+            }
+
+            auto d_keys_in       = device.create_buffer<float>(num_items);
+            auto d_keys_out      = device.create_buffer<float>(num_items);
+            auto d_values_in     = device.create_buffer<uint>(num_items);
+            auto d_values_out    = device.create_buffer<uint>(num_items);
+            auto d_begin_offsets = device.create_buffer<uint>(num_segments);
+            auto d_end_offsets   = device.create_buffer<uint>(num_segments);
+            stream << d_keys_in.copy_from(keys.data()) << d_keys_out.copy_from(keys.data())
+                   << d_values_in.copy_from(values.data()) << d_values_out.copy_from(values.data())
+                   << d_begin_offsets.copy_from(begin_offsets.data()) << d_end_offsets.copy_from(end_offsets.data())
+                   << synchronize();
+
+            auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(
+                SegmentedRadixSortT::GetSortPairsTempStorageBytes<float, uint>(num_items, num_segments)));
+            segmented_radix_sort.SortPairs(cmdlist,
+                                           temp_buffer.view(),
+                                           d_keys_in.view(),
+                                           d_keys_out.view(),
+                                           d_values_in.view(),
+                                           d_values_out.view(),
+                                           num_items,
+                                           num_segments,
+                                           d_begin_offsets.view(),
+                                           d_end_offsets.view());
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> expected_values = values;
+            for(auto s = 0u; s < num_segments; ++s)
+            {
+                std::stable_sort(expected_values.begin() + begin_offsets[s],
+                                 expected_values.begin() + end_offsets[s],
+                                 [&](uint a, uint b) { return keys[a] < keys[b]; });
+            }
+
+            luisa::vector<float> result_keys(num_items);
+            luisa::vector<uint>  result_values(num_items);
+            stream << d_keys_out.copy_to(result_keys.data()) << d_values_out.copy_to(result_values.data())
+                   << synchronize();
+
+            bool keys_ok = true;
+            for(auto i = 0u; i < num_items; ++i) { keys_ok &= result_keys[i] == keys[expected_values[i]]; }
+            expect(keys_ok) << "SortPairs keys failed for " << num_segments << " segments";
+            expect(std::equal(expected_values.begin(), expected_values.end(), result_values.begin()))
+                << "SortPairs is not stable for " << num_segments << " segments";
+        }
+    };
+
+    "sort_keys_descending"_test = [&]
+    {
+        for(uint num_segments : {1u, 7u, 64u, 1000u})
+        {
+            std::mt19937        rng(1919810 + num_segments);
+            luisa::vector<uint> begin_offsets, end_offsets;
+            const uint          num_items = make_segments(rng, num_segments, begin_offsets, end_offsets);
+
+            luisa::vector<uint> keys(num_items);
+            for(auto i = 0u; i < num_items; ++i) { keys[i] = rng(); }
+
+            auto d_keys_in       = device.create_buffer<uint>(num_items);
+            auto d_keys_out      = device.create_buffer<uint>(num_items);
+            auto d_begin_offsets = device.create_buffer<uint>(num_segments);
+            auto d_end_offsets   = device.create_buffer<uint>(num_segments);
+            stream << d_keys_in.copy_from(keys.data()) << d_keys_out.copy_from(keys.data())
+                   << d_begin_offsets.copy_from(begin_offsets.data()) << d_end_offsets.copy_from(end_offsets.data())
+                   << synchronize();
+
+            auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(
+                SegmentedRadixSortT::GetSortKeysTempStorageBytes<uint>(num_items, num_segments)));
+            segmented_radix_sort.SortKeysDescending(cmdlist,
+                                                    temp_buffer.view(),
+                                                    d_keys_in.view(),
+                                                    d_keys_out.view(),
+                                                    num_items,
+                                                    num_segments,
+                                                    d_begin_offsets.view(),
+                                                    d_end_offsets.view());
+            stream << cmdlist.commit() << synchronize();
+
+            auto expected = keys;
+            for(auto s = 0u; s < num_segments; ++s)
+            {
+                std::sort(expected.begin() + begin_offsets[s], expected.begin() + end_offsets[s], std::greater<uint>());
+            }
+
+            luisa::vector<uint> result(num_items);
+            stream << d_keys_out.copy_to(result.data()) << synchronize();
+            expect(std::equal(expected.begin(), expected.end(), result.begin()))
+                << "SortKeysDescending failed for " << num_segments << " segments";
+        }
+    };
+
+    // segments of many tiles next to small ones: the tiles of a large segment are spread over
+    // blocks, every tile has to land after the same digit of the tiles before it
+    "large_segments"_test = [&]
+    {
+        for(uint bits : {32u, 12u})
+        {
+            std::mt19937              rng(810 + bits);
+            const luisa::vector<uint> sizes = {3000000u, 17u, TILE_ITEMS + 1u, 0u, 250000u, TILE_ITEMS * 3u};
+            luisa::vector<uint>       begin_offsets, end_offsets;
+            uint                      num_items = 0;
+            for(auto size : sizes)
+            {
+                begin_offsets.push_back(num_items);
+                end_offsets.push_back(num_items + size);
+                num_items += size;
+            }
+            const uint num_segments = static_cast<uint>(sizes.size());
+
+            luisa::vector<uint> keys(num_items), values(num_items);
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                keys[i]   = rng();
+                values[i] = i;
+            }
+
+            auto d_keys_in       = device.create_buffer<uint>(num_items);
+            auto d_keys_out      = device.create_buffer<uint>(num_items);
+            auto d_values_in     = device.create_buffer<uint>(num_items);
+            auto d_values_out    = device.create_buffer<uint>(num_items);
+            auto d_begin_offsets = device.create_buffer<uint>(num_segments);
+            auto d_end_offsets   = device.create_buffer<uint>(num_segments);
+            stream << d_keys_in.copy_from(keys.data()) << d_values_in.copy_from(values.data())
+                   << d_begin_offsets.copy_from(begin_offsets.data()) << d_end_offsets.copy_from(end_offsets.data())
+                   << synchronize();
+
+            auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(
+                SegmentedRadixSortT::GetSortPairsTempStorageBytes<uint, uint>(num_items, num_segments)));
+            segmented_radix_sort.SortPairs(cmdlist,
+                                           temp_buffer.view(),
+                                           d_keys_in.view(),
+                                           d_keys_out.view(),
+                                           d_values_in.view(),
+                                           d_values_out.view(),
+                                           num_items,
+                                           num_segments,
+                                           d_begin_offsets.view(),
+                                           d_end_offsets.view(),
+                                           0u,
+                                           bits);
+            stream << cmdlist.commit() << synchronize();
+
+            // only the low bits are sorted on, equal ones keep their order
+            const uint          mask            = bits == 32u ? ~0u : (1u << bits) - 1u;
+            luisa::vector<uint> expected_values = values;
+            for(auto s = 0u; s < num_segments; ++s)
+            {
+                std::stable_sort(expected_values.begin() + begin_offsets[s],
+                                 expected_values.begin() + end_offsets[s],
+                                 [&](uint a, uint b) { return (keys[a] & mask) < (keys[b] & mask); });
+            }
+
+            luisa::vector<uint> result_keys(num_items), result_values(num_items);
+            stream << d_keys_out.copy_to(result_keys.data()) << d_values_out.copy_to(result_values.data())
+                   << synchronize();
+
+            bool keys_ok = true;
+            for(auto i = 0u; i < num_items; ++i) { keys_ok &= result_keys[i] == keys[expected_values[i]]; }
+            expect(keys_ok) << "large segment keys failed on " << bits << " bits";
+            expect(std::equal(expected_values.begin(), expected_values.end(), result_values.begin()))
+                << "large segments are not stable on " << bits << " bits";
+        }
+    };
+
+    return 0;
+}
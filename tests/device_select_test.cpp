@@ -0,0 +1,206 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-12 15:31:54
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-03-05 16:31:40
+ */
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/vstl/config.h>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <lcpp/parallel_primitive.h>
+#include <random>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+
+int main(int argc, char* argv[])
+{
+    log_level_verbose();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "cuda";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for(int i = 1; i < argc; ++i)
+    {
+        luisa::string_view arg(argv[i]);
+        if(arg.starts_with("--ctx="))
+        {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        }
+        else if(arg.starts_with("--backend="))
+        {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context     context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device      device = context.create_device(backend_name);
+    Stream      stream = device.create_stream();
+    CommandList cmdlist;
+
+    constexpr int32_t BLOCK_SIZE       = 256;
+    constexpr int32_t ITEMS_PER_THREAD = 4;
+    constexpr int32_t WARP_NUMS        = 32;
+
+    using SelectT = DeviceSelect<BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+    SelectT device_select;
+    device_select.create(device, &stream);
+
+    auto d_num_selected = device.create_buffer<uint>(1);
+
+    "select_if"_test = [&]
+    {
+        auto is_odd = [](const Var<uint>& x) noexcept { return (x & 1u) == 1u; };
+        for(uint loop = 0; loop < 25; loop += 3)
+        {
+            const uint          num_items = (1u << loop) + 5u;
+            luisa::vector<uint> input(num_items);
+            std::mt19937        rng(114521 + loop);
+            for(auto& v : input) { v = rng(); }
+
+            auto d_in  = device.create_buffer<uint>(num_items);
+            auto d_out = device.create_buffer<uint>(num_items);
+            stream << d_in.copy_from(input.data()) << synchronize();
+
+            auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(SelectT::GetTempStorageBytes(num_items)));
+            device_select.If(cmdlist, temp_buffer.view(), d_in.view(), d_out.view(), d_num_selected.view(), num_items, is_odd);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> expected;
+            std::copy_if(input.begin(), input.end(), std::back_inserter(expected), [](uint x) { return (x & 1u) == 1u; });
+
+            uint                num_selected = 0;
+            luisa::vector<uint> result(num_items);
+            stream << d_num_selected.copy_to(&num_selected) << d_out.copy_to(result.data()) << synchronize();
+
+            expect(num_selected == expected.size()) << "If selected " << num_selected << " of " << num_items;
+            expect(std::equal(expected.begin(), expected.end(), result.begin())) << "If failed for size " << num_items;
+        }
+    };
+
+    "select_flagged"_test = [&]
+    {
+        for(uint loop = 0; loop < 25; loop += 3)
+        {
+            const uint          num_items = (1u << loop) + 5u;
+            luisa::vector<int>  input(num_items);
+            luisa::vector<uint> flags(num_items);
+            std::mt19937        rng(114521 + loop);
+            // dense and sparse selections take the shared-memory and direct scatter paths
+            const uint density = loop % 2 == 0 ? 2u : 64u;
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                input[i] = static_cast<int>(i) - 7;
+                flags[i] = rng() % density == 0 ? 1u : 0u;
+            }
+
+            auto d_in    = device.create_buffer<int>(num_items);
+            auto d_flags = device.create_buffer<uint>(num_items);
+            auto d_out   = device.create_buffer<int>(num_items);
+            stream << d_in.copy_from(input.data()) << d_flags.copy_from(flags.data()) << synchronize();
+
+            auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(SelectT::GetTempStorageBytes(num_items)));
+            device_select.Flagged(
+                cmdlist, temp_buffer.view(), d_in.view(), d_flags.view(), d_out.view(), d_num_selected.view(), num_items);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<int> expected;
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                if(flags[i]) { expected.push_back(input[i]); }
+            }
+
+            uint               num_selected = 0;
+            luisa::vector<int> result(num_items);
+            stream << d_num_selected.copy_to(&num_selected) << d_out.copy_to(result.data()) << synchronize();
+
+            expect(num_selected == expected.size()) << "Flagged selected " << num_selected << " of " << num_items;
+            expect(std::equal(expected.begin(), expected.end(), result.begin())) << "Flagged failed for size " << num_items;
+        }
+    };
+
+    "select_unique"_test = [&]
+    {
+        for(uint loop = 0; loop < 25; loop += 3)
+        {
+            const uint          num_items = (1u << loop) + 5u;
+            luisa::vector<uint> input(num_items);
+            std::mt19937        rng(114521 + loop);
+            uint                value = 0;
+            for(auto& v : input)
+            {
+                value += rng() % 4 == 0 ? 1u : 0u;  // runs of random length, some crossing tiles
+                v = value;
+            }
+
+            auto d_in  = device.create_buffer<uint>(num_items);
+            auto d_out = device.create_buffer<uint>(num_items);
+            stream << d_in.copy_from(input.data()) << synchronize();
+
+            auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(SelectT::GetTempStorageBytes(num_items)));
+            device_select.Unique(cmdlist, temp_buffer.view(), d_in.view(), d_out.view(), d_num_selected.view(), num_items);
+            stream << cmdlist.commit() << synchronize();
+
+            luisa::vector<uint> expected(input.begin(), input.end());
+            expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+
+            uint                num_selected = 0;
+            luisa::vector<uint> result(num_items);
+            stream << d_num_selected.copy_to(&num_selected) << d_out.copy_to(result.data()) << synchronize();
+
+            expect(num_selected == expected.size()) << "Unique selected " << num_selected << " of " << num_items;
+            expect(std::equal(expected.begin(), expected.end(), result.begin())) << "Unique failed for size " << num_items;
+        }
+    };
+
+    // the look-back of a DeviceSelect polls through its DelayPolicy like DeviceScan's
+    "select_if_backoff"_test = [&]
+    {
+        using BackoffSelectT = DeviceSelect<BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD, JitteredBackoffPolicy<>>;
+        BackoffSelectT backoff_select;
+        backoff_select.create(device, &stream);
+
+        auto                is_odd    = [](const Var<uint>& x) noexcept { return (x & 1u) == 1u; };
+        const uint          num_items = (1u << 22) + 5u;
+        luisa::vector<uint> input(num_items);
+        std::mt19937        rng(114521);
+        for(auto& v : input) { v = rng(); }
+
+        auto d_in  = device.create_buffer<uint>(num_items);
+        auto d_out = device.create_buffer<uint>(num_items);
+        stream << d_in.copy_from(input.data()) << synchronize();
+
+        auto temp_buffer = device.create_buffer<uint>(bytes_to_uint_count(BackoffSelectT::GetTempStorageBytes(num_items)));
+        backoff_select.If(cmdlist, temp_buffer.view(), d_in.view(), d_out.view(), d_num_selected.view(), num_items, is_odd);
+        stream << cmdlist.commit() << synchronize();
+
+        luisa::vector<uint> expected;
+        std::copy_if(input.begin(), input.end(), std::back_inserter(expected), [](uint x) { return (x & 1u) == 1u; });
+
+        uint                num_selected = 0;
+        luisa::vector<uint> result(num_items);
+        stream << d_num_selected.copy_to(&num_selected) << d_out.copy_to(result.data()) << synchronize();
+
+        expect(num_selected == expected.size());
+        expect(std::equal(expected.begin(), expected.end(), result.begin())) << "If with backoff failed";
+    };
+
+    return 0;
+}
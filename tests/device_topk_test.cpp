@@ -0,0 +1,154 @@
+/*
+ * @Author: Ligo
+ * @Date: 2026-02-17 13:12:50
+ * @Last Modified by: Ligo
+ * @Last Modified time: 2026-02-17 14:40:27
+ */
+
+#include <luisa/core/basic_traits.h>
+#include <luisa/core/logging.h>
+#include <luisa/vstl/config.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <lcpp/parallel_primitive.h>
+#include <random>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+
+int main(int argc, char* argv[])
+{
+    log_level_verbose();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "cuda";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for(int i = 1; i < argc; ++i)
+    {
+        luisa::string_view arg(argv[i]);
+        if(arg.starts_with("--ctx="))
+        {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        }
+        else if(arg.starts_with("--backend="))
+        {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context     context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device      device = context.create_device(backend_name);
+    Stream      stream = device.create_stream();
+    CommandList cmdlist;
+
+    constexpr int32_t BLOCK_SIZE       = 256;
+    constexpr int32_t ITEMS_PER_THREAD = 4;
+    constexpr int32_t WARP_NUMS        = 32;
+
+    using TopKT = DeviceTopK<BLOCK_SIZE, WARP_NUMS, ITEMS_PER_THREAD>;
+    TopKT top_k;
+    top_k.create(device, &stream);
+
+    "max_keys"_test = [&]
+    {
+        for(uint loop = 0; loop < 22; loop += 3)
+        {
+            const uint          num_items = (1u << loop) + 5u;
+            luisa::vector<uint> keys(num_items);
+            std::mt19937        rng(114521 + loop);
+            // a narrow range, so the k-th key is tied most of the time
+            for(auto i = 0u; i < num_items; ++i) { keys[i] = rng() % (num_items / 2u + 1u); }
+
+            for(uint k : {1u, 5u, num_items / 3u + 1u, num_items})
+            {
+                auto d_keys_in  = device.create_buffer<uint>(num_items);
+                auto d_keys_out = device.create_buffer<uint>(k);
+                stream << d_keys_in.copy_from(keys.data()) << synchronize();
+
+                auto temp_buffer =
+                    device.create_buffer<uint>(bytes_to_uint_count(TopKT::GetTempStorageBytes<uint>(num_items)));
+                top_k.MaxKeys(cmdlist, temp_buffer.view(), d_keys_in.view(), d_keys_out.view(), num_items, k);
+                stream << cmdlist.commit() << synchronize();
+
+                auto expected = keys;
+                std::sort(expected.begin(), expected.end(), std::greater<uint>());
+                expected.resize(k);
+
+                luisa::vector<uint> result(k);
+                stream << d_keys_out.copy_to(result.data()) << synchronize();
+                std::sort(result.begin(), result.end(), std::greater<uint>());
+                expect(std::equal(expected.begin(), expected.end(), result.begin()))
+                    << "MaxKeys failed for size " << num_items << " k " << k;
+            }
+        }
+    };
+
+    "min_pairs"_test = [&]
+    {
+        for(uint loop = 0; loop < 22; loop += 3)
+        {
+            const uint           num_items = (1u << loop) + 5u;
+            const uint           k         = num_items / 7u + 1u;
+            luisa::vector<float> keys(num_items);
+            luisa::vector<uint>  values(num_items);
+            std::mt19937         rng(1919810 + loop);
+            for(auto i = 0u; i < num_items; ++i)
+            {
+                keys[i]   = static_cast<float>(static_cast<int>(rng() % 2001) - 1000) * 0.125f;
+                values[i] = i;
+            }
+
+            auto d_keys_in    = device.create_buffer<float>(num_items);
+            auto d_values_in  = device.create_buffer<uint>(num_items);
+            auto d_keys_out   = device.create_buffer<float>(k);
+            auto d_values_out = device.create_buffer<uint>(k);
+            stream << d_keys_in.copy_from(keys.data()) << d_values_in.copy_from(values.data()) << synchronize();
+
+            auto temp_buffer =
+                device.create_buffer<uint>(bytes_to_uint_count(TopKT::GetTempStorageBytes<float>(num_items)));
+            top_k.MinPairs(cmdlist, temp_buffer.view(), d_keys_in.view(), d_keys_out.view(), d_values_in.view(), d_values_out.view(), num_items, k);
+            stream << cmdlist.commit() << synchronize();
+
+            auto expected = keys;
+            std::sort(expected.begin(), expected.end());
+            expected.resize(k);
+
+            luisa::vector<float> result_keys(k);
+            luisa::vector<uint>  result_values(k);
+            stream << d_keys_out.copy_to(result_keys.data()) << d_values_out.copy_to(result_values.data())
+                   << synchronize();
+
+            // every value still points at its own key, and no input shows up twice
+            bool pairs_ok = true;
+            for(auto i = 0u; i < k; ++i)
+            {
+                pairs_ok &= result_values[i] < num_items && keys[result_values[i]] == result_keys[i];
+            }
+            auto unique_values = result_values;
+            std::sort(unique_values.begin(), unique_values.end());
+            pairs_ok &= std::adjacent_find(unique_values.begin(), unique_values.end()) == unique_values.end();
+            expect(pairs_ok) << "MinPairs values failed for size " << num_items;
+
+            std::sort(result_keys.begin(), result_keys.end());
+            expect(std::equal(expected.begin(), expected.end(), result_keys.begin()))
+                << "MinPairs keys failed for size " << num_items;
+        }
+    };
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+// /*
+//  * @Author: Ligo
+//  * @Date: 2026-03-02 10:48:19
+//  * @Last Modified by: Ligo
+//  * @Last Modified time: 2026-03-06 10:12:37
+//  */
+
+#include <luisa/core/logging.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <lcpp/parallel_primitive.h>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+// device time of single-pass InclusiveSum under every look-back delay policy, from a few tiles to
+// many contending ones. Build in Release, debug builds commit and synchronize after every call
+int main(int argc, char* argv[])
+{
+    log_level_info();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "dx";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for(int i = 1; i < argc; ++i)
+    {
+        luisa::string_view arg(argv[i]);
+        if(arg.starts_with("--ctx="))
+        {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        }
+        else if(arg.starts_with("--backend="))
+        {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context     context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device      device = context.create_device(backend_name);
+    Stream      stream = device.create_stream();
+    CommandList cmdlist;
+
+    using Clock                     = std::chrono::steady_clock;
+    constexpr uint BLOCK_SIZE       = 256;
+    constexpr uint ITEMS_PER_THREAD = 4;
+    constexpr uint TILE_ITEMS       = BLOCK_SIZE * ITEMS_PER_THREAD;
+    constexpr uint NUM_RUNS         = 20;
+
+    const luisa::vector<uint> tile_counts{16u, 256u, 4096u, 32768u, 131072u};
+    const uint                max_items = tile_counts.back() * TILE_ITEMS;
+
+    luisa::vector<uint> host_in(max_items);
+    std::mt19937        rng(114514);
+    for(auto& x : host_in) { x = rng() % 8u; }
+    luisa::vector<uint> expected(max_items);
+    std::inclusive_scan(host_in.begin(), host_in.end(), expected.begin());
+
+    auto d_in   = device.create_buffer<uint>(max_items);
+    auto d_out  = device.create_buffer<uint>(max_items);
+    auto d_temp = device.create_buffer<uint>(
+        bytes_to_uint_count(DeviceScan<BLOCK_SIZE, 32, ITEMS_PER_THREAD>::GetTempStorageBytes<uint>(max_items)));
+    stream << d_in.copy_from(host_in.data()) << synchronize();
+
+    // milliseconds per InclusiveSum for every tile count, each result checked once
+    auto bench = [&]<typename DelayPolicy>(luisa::string_view name)
+    {
+        DeviceScan<BLOCK_SIZE, 32, ITEMS_PER_THREAD, DelayPolicy> scanner;
+        scanner.create(device, &stream);
+        // the policies only pace the look-back, AUTO would skip it without forward progress
+        scanner.SetScanAlgorithm(ScanAlgorithm::DECOUPLED_LOOK_BACK);
+
+        luisa::string line{name};
+        for(auto num_tiles : tile_counts)
+        {
+            const uint num_items = num_tiles * TILE_ITEMS;
+
+            // first call compiles the kernel and checks the result
+            scanner.InclusiveSum(cmdlist, d_temp.view(), d_in.view(), d_out.view(), num_items);
+            luisa::vector<uint> result(num_items);
+            stream << cmdlist.commit() << d_out.view(0, num_items).copy_to(result.data()) << synchronize();
+            expect(std::equal(result.begin(), result.end(), expected.begin()))
+                << name << " InclusiveSum failed with " << num_tiles << " tiles";
+
+            auto start = Clock::now();
+            for(auto run = 0u; run < NUM_RUNS; ++run)
+            {
+                scanner.InclusiveSum(cmdlist, d_temp.view(), d_in.view(), d_out.view(), num_items);
+            }
+            stream << cmdlist.commit() << synchronize();
+            auto ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / NUM_RUNS;
+            line.append(luisa::format("  {:>7} tiles {:8.3f} ms", num_tiles, ms));
+        }
+        LUISA_INFO("{}", line);
+    };
+
+    "look-back delay policies"_test = [&]
+    {
+        bench.template operator()<NoDelayPolicy>("no delay          ");
+        bench.template operator()<FixedDelayPolicy<64>>("fixed 64          ");
+        bench.template operator()<FixedDelayPolicy<256>>("fixed 256         ");
+        bench.template operator()<ExponentialBackoffPolicy<32, 4096>>("exponential 32-4096");
+        bench.template operator()<JitteredBackoffPolicy<32, 4096>>("jittered 32-4096  ");
+    };
+}
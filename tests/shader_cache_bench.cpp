@@ -0,0 +1,254 @@
+// /*
+//  * @Author: Ligo
+//  * @Date: 2026-02-20 17:05:12
+//  * @Last Modified by: Ligo
+//  * @Last Modified time: 2026-03-05 11:20:54
+//  */
+
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/string.h>
+#include <luisa/core/stl/unordered_map.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <typeinfo>
+#include <lcpp/parallel_primitive.h>
+#include <boost/ut.hpp>
+using namespace luisa;
+using namespace luisa::compute;
+using namespace luisa::parallel_primitive;
+using namespace boost::ut;
+
+// host side cost of issuing a small primitive: key lookup, argument encoding and recording into a
+// CommandList. Build in Release, debug builds commit and synchronize after every call
+int main(int argc, char* argv[])
+{
+    log_level_info();
+
+    luisa::string_view ctx_dir;
+    luisa::string_view backend_name;
+#ifdef _WIN32
+    backend_name = "dx";
+#elif __APPLE__
+    backend_name = "metal";
+#else
+    backend_name = "cuda";
+#endif
+
+    // Parse command-line arguments: --ctx=./dir --backend=dx
+    for (int i = 1; i < argc; ++i) {
+        luisa::string_view arg(argv[i]);
+        if (arg.starts_with("--ctx=")) {
+            ctx_dir = arg.substr(6);
+            LUISA_INFO("Use context directory from command-line: {}", ctx_dir);
+        } else if (arg.starts_with("--backend=")) {
+            backend_name = arg.substr(10);
+            LUISA_INFO("Use backend from command-line: {}", backend_name);
+        }
+    }
+
+    Context context{ctx_dir.empty() ? argv[0] : ctx_dir};
+    Device device = context.create_device(backend_name);
+    Stream stream = device.create_stream();
+
+    using Clock                  = std::chrono::steady_clock;
+    constexpr uint num_calls     = 1 << 14;
+    constexpr uint calls_per_cmd = 256;
+    constexpr uint num_items     = 1024;
+
+    auto ns_per_call = [](Clock::duration elapsed, uint calls)
+    { return std::chrono::duration<double, std::nano>(elapsed).count() / calls; };
+
+    "cache lookup"_test = [&]
+    {
+        using ProbeKernel = Shader1D<Buffer<uint>, uint>;
+        auto compile_probe = [&]
+        {
+            U<ProbeKernel> shader = nullptr;
+            lazy_compile(device,
+                         shader,
+                         [](BufferVar<uint> buffer, UInt value) noexcept { buffer.write(dispatch_id().x, value); });
+            return shader;
+        };
+
+        // the lookup every Device module did before: format a key, hash it, find it
+        luisa::unordered_map<luisa::string, luisa::shared_ptr<Resource>> string_map;
+        auto make_key = [] { return luisa::format("{}+{}", Type::of<uint>()->description(), typeid(ProbeKernel).name()); };
+        string_map.try_emplace(make_key(), compile_probe());
+
+        ShaderCache cache;
+        auto        expected = cache.get_or_compile<ProbeKernel, uint>(compile_probe);
+        expect(expected != nullptr);
+
+        size_t string_hits = 0;
+        auto   start       = Clock::now();
+        for(auto i = 0u; i < num_calls; ++i)
+        {
+            auto it = string_map.find(make_key());
+            string_hits += it != string_map.end();
+        }
+        auto string_ns = ns_per_call(Clock::now() - start, num_calls);
+
+        size_t typed_hits = 0;
+        start             = Clock::now();
+        for(auto i = 0u; i < num_calls; ++i)
+        {
+            typed_hits += cache.get_or_compile<ProbeKernel, uint>(compile_probe) == expected;
+        }
+        auto typed_ns = ns_per_call(Clock::now() - start, num_calls);
+
+        expect(string_hits == num_calls && typed_hits == num_calls);
+        LUISA_INFO("lookup: string-keyed map {:.1f} ns/call, ShaderCache {:.1f} ns/call", string_ns, typed_ns);
+    };
+
+    "dispatch latency"_test = [&]
+    {
+        DeviceReduce<> reducer;
+        DeviceScan<>   scanner;
+        reducer.create(device, &stream);
+        scanner.create(device, &stream);
+
+        luisa::vector<uint> host_in(num_items, 1u);
+        auto                d_in      = device.create_buffer<uint>(num_items);
+        auto                d_sum     = device.create_buffer<uint>(1);
+        auto                d_scan    = device.create_buffer<uint>(num_items);
+        auto                d_reduce_temp =
+            device.create_buffer<uint>(bytes_to_uint_count(DeviceReduce<>::GetTempStorageBytes<uint>(num_items)));
+        auto d_scan_temp =
+            device.create_buffer<uint>(bytes_to_uint_count(DeviceScan<>::GetTempStorageBytes<uint>(num_items)));
+        stream << d_in.copy_from(host_in.data()) << synchronize();
+
+        // warm up: every shader is compiled here, the timed loops only hit the cache
+        CommandList cmdlist;
+        reducer.Sum(cmdlist, d_reduce_temp.view(), d_in.view(), d_sum.view(), num_items);
+        scanner.InclusiveSum(cmdlist, d_scan_temp.view(), d_in.view(), d_scan.view(), num_items);
+        stream << cmdlist.commit() << synchronize();
+
+        auto time_calls = [&](auto&& record)
+        {
+            Clock::duration recorded{};
+            for(auto i = 0u; i < num_calls; i += calls_per_cmd)
+            {
+                auto start = Clock::now();
+                for(auto j = 0u; j < calls_per_cmd; ++j) { record(); }
+                recorded += Clock::now() - start;
+                stream << cmdlist.commit();
+            }
+            stream << synchronize();
+            return ns_per_call(recorded, num_calls);
+        };
+
+        auto sum_ns = time_calls([&] { reducer.Sum(cmdlist, d_reduce_temp.view(), d_in.view(), d_sum.view(), num_items); });
+        auto scan_ns = time_calls(
+            [&] { scanner.InclusiveSum(cmdlist, d_scan_temp.view(), d_in.view(), d_scan.view(), num_items); });
+
+        uint                sum = 0;
+        luisa::vector<uint> scan(num_items);
+        stream << d_sum.copy_to(&sum) << d_scan.copy_to(scan.data()) << synchronize();
+        expect(sum == num_items && scan.back() == num_items);
+        LUISA_INFO("host dispatch latency: Sum {:.1f} ns/call, InclusiveSum {:.1f} ns/call", sum_ns, scan_ns);
+    };
+
+    // a second instance of the same configuration takes every kernel from the process registry
+    "shared registry"_test = [&]
+    {
+        luisa::vector<float> host_in(num_items, 1.0f);
+        auto                 d_in  = device.create_buffer<float>(num_items);
+        auto                 d_sum = device.create_buffer<float>(1);
+        auto                 d_temp =
+            device.create_buffer<uint>(bytes_to_uint_count(DeviceReduce<>::GetTempStorageBytes<float>(num_items)));
+        stream << d_in.copy_from(host_in.data()) << synchronize();
+
+        auto time_first_max = [&](DeviceReduce<>& reducer)
+        {
+            CommandList cmdlist;
+            auto        start = Clock::now();
+            reducer.Max(cmdlist, d_temp.view(), d_in.view(), d_sum.view(), num_items);
+            auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            stream << cmdlist.commit() << synchronize();
+            return elapsed;
+        };
+
+        DeviceReduce<> first;
+        first.create(device, &stream);
+        auto first_ms   = time_first_max(first);
+        auto registered = KernelRegistry::instance().size();
+
+        DeviceReduce<> second;
+        second.create(device, &stream);
+        auto second_ms = time_first_max(second);
+
+        float max = 0.0f;
+        stream << d_sum.copy_to(&max) << synchronize();
+        expect(max == 1.0f);
+        expect(KernelRegistry::instance().size() == registered);
+        LUISA_INFO("first Max: {:.2f} ms on the first instance, {:.2f} ms on the second", first_ms, second_ms);
+    };
+
+    "kernel identity"_test = [&]
+    {
+        using ReduceKernel = Shader1D<Buffer<uint>, Buffer<uint>, uint>;
+        using Reduce       = details::ReduceModule<uint>;
+        auto owner         = make_kernel_name("DeviceReduce", 256, 32, 4);
+
+        auto sum_name = kernel_cache_name<ReduceKernel, Reduce, SumOp, CastOp<uint>>(owner);
+        expect(!sum_name.empty() && sum_name.starts_with("lcpp_"));
+        expect(sum_name == kernel_cache_name<ReduceKernel, Reduce, SumOp, CastOp<uint>>(owner));
+        expect(kernel_identity<ReduceKernel, Reduce, SumOp, CastOp<uint>>(owner).starts_with(luisa::format("lcpp-{}/", LCPP_VERSION)));
+
+        // op, element type, policy and owner all take part
+        expect(sum_name != kernel_cache_name<ReduceKernel, Reduce, MaxOp, CastOp<uint>>(owner));
+        expect(sum_name != kernel_cache_name<ReduceKernel, Reduce, SumOp, CastOp<float>>(owner));
+        expect(sum_name != kernel_cache_name<ReduceKernel, details::ReduceModule<uint, 128>, SumOp, CastOp<uint>>(owner));
+        expect(sum_name != kernel_cache_name<ReduceKernel, Reduce, SumOp, CastOp<uint>>(make_kernel_name("DeviceReduce", 256, 16, 4)));
+
+        // a lambda has no name that survives a rebuild, its kernel is only cached by IR hash
+        auto lambda_op = [](const Var<uint>& a, const Var<uint>& b) { return a + b; };
+        expect(kernel_cache_name<ReduceKernel, Reduce, decltype(lambda_op)>(owner).empty());
+        expect(kernel_cache_name<ReduceKernel, Reduce, SumOp>("").empty());
+    };
+
+    // releasing the device from the KernelRegistry between the two runs drops every shader of the
+    // process, so the second run compiles again and the named kernels come back from the backend
+    // shader cache directory like after a restart. The first run after a clean build (or an
+    // emptied cache directory) is the real cold start, later runs already load both from disk
+    "cold start"_test = [&]
+    {
+        auto time_warmup = [&]
+        {
+            DeviceReduce<> reducer;
+            DeviceScan<>   scanner;
+            reducer.create(device, &stream);
+            scanner.create(device, &stream);
+
+            auto start         = Clock::now();
+            auto reduce_future = reducer.Warmup<uint, float>();
+            auto scan_future   = scanner.Warmup<uint, float>();
+            expect(reduce_future.get() && scan_future.get());
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        };
+
+        auto first_ms = time_warmup();
+        KernelRegistry::instance().release(device);
+        auto restart_ms = time_warmup();
+        LUISA_INFO("cold start: first Warmup {:.1f} ms, after restart {:.1f} ms ({:.1f}x)",
+                   first_ms,
+                   restart_ms,
+                   first_ms / std::max(restart_ms, 1e-3));
+
+        // a kernel that changed under the same name, like after an upgrade that left LCPP_VERSION
+        // alone, is compiled again instead of loading the stale binary from disk
+        auto d_value   = device.create_buffer<uint>(1);
+        auto run_named = [&](uint value)
+        {
+            KernelCacheNameScope      name_scope{"lcpp_cold_start_probe"};
+            U<Shader1D<Buffer<uint>>> shader = nullptr;
+            lazy_compile(device, shader, [&](BufferVar<uint> d_out) noexcept { d_out.write(0u, UInt(value)); });
+            uint result = 0u;
+            stream << (*shader)(d_value).dispatch(1) << d_value.copy_to(&result) << synchronize();
+            return result;
+        };
+        expect(run_named(1u) == 1u);
+        expect(run_named(2u) == 2u);
+    };
+}
@@ -44,4 +44,14 @@ add_test_target("decoupled_look_back")
 add_test_target("device_reduce_test")
 add_test_target("device_scan_test")
 add_test_target("device_segment_reduce")
-add_test_target("device_radix_sort_one_sweep")
\ No newline at end of file
+add_test_target("device_radix_sort_one_sweep")
+add_test_target("device_histogram_test")
+add_test_target("device_for_test")
+add_test_target("device_select_test")
+add_test_target("device_partition_test")
+add_test_target("device_run_length_encode_test")
+add_test_target("device_merge_sort_test")
+add_test_target("device_segmented_radix_sort_test")
+add_test_target("device_topk_test")
+add_test_target("shader_cache_bench")
+add_test_target("look_back_delay_bench")
\ No newline at end of file